@@ -0,0 +1,167 @@
+// Std
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Benchmark
+#include "benchmark/benchmark.h"
+
+// MAD
+#include "MAD/BreakpointsControl.hpp"
+#include "MAD/MachProcess.hpp"
+
+#include "FakeMach.hpp"
+#include "Image.hpp"
+
+using namespace mad;
+
+//-----------------------------------------------------------------------------
+// Fixture
+//-----------------------------------------------------------------------------
+
+#define IMAGE_COUNT 16
+#define IMAGE_SYMBOL_COUNT 20000
+
+// Every image is slid this much further than the one before
+#define IMAGE_STRIDE 0x10000000ull
+
+// A process with a few images loaded and a controller attached to it. Names
+// are unique to the image, symbols of the last one are found last.
+struct Session {
+  std::shared_ptr<MachProcess> Process;
+  BreakpointsControl Control;
+
+  Session() {
+    for (uint32_t i = 0; i < IMAGE_COUNT; ++i) {
+      auto &I = GetImage(IMAGE_SYMBOL_COUNT, 4, i);
+      fake::MapMemory(IMAGE_BASE + i * IMAGE_STRIDE, I.Data.data(),
+                      I.Data.size());
+      fake::AddImage("/usr/lib/libImage" + std::to_string(i) + ".dylib",
+                     IMAGE_BASE + i * IMAGE_STRIDE);
+    }
+    Process = std::make_shared<MachProcess>("bench");
+    Process->Execute();
+    Process->Attach();
+    Control.Attach(Process);
+  }
+  ~Session() {
+    Control.Detach(true);
+    Process->Detach();
+    fake::RemoveImages();
+    fake::UnmapMemory();
+  }
+
+  static std::string GetName(uint32_t Id, uint32_t Symbol) {
+    return Image::GetSymbolName(Id, Symbol);
+  }
+  static uint64_t GetAddress(uint32_t Id, uint32_t Symbol) {
+    return Image::GetSymbolAddress(Symbol) + Id * IMAGE_STRIDE;
+  }
+};
+
+static BreakpointCallbackReturn Continue(std::string) {
+  return BreakpointCallbackReturn::CONTINUE;
+}
+
+static std::vector<uint32_t> GetRandomSymbols(size_t Count) {
+  std::mt19937 Random(Count);
+  std::uniform_int_distribution<uint32_t> Symbol(0, IMAGE_SYMBOL_COUNT - 1);
+  std::vector<uint32_t> Symbols(Count);
+  for (auto &S : Symbols) {
+    S = Symbol(Random);
+  }
+  return Symbols;
+}
+
+//-----------------------------------------------------------------------------
+// Add and remove
+//-----------------------------------------------------------------------------
+
+// One breakpoint at a time in the image given, which is searched after all
+// the ones before it. Items are breakpoints.
+static void BM_AddRemoveBySymbolName(benchmark::State &State) {
+  Session S;
+  uint32_t Id = State.range(0);
+  std::vector<std::string> Names;
+  for (auto i : GetRandomSymbols(1024)) {
+    Names.push_back(Session::GetName(Id, i));
+  }
+
+  for (auto _ : State) {
+    for (auto &Name : Names) {
+      S.Control.AddBreakpointBySymbolName(Name, Continue);
+      S.Control.RemoveBreakpointBySymbolName(Name);
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_AddRemoveBySymbolName)->Arg(0)->Arg(IMAGE_COUNT - 1);
+
+// A pattern that matches one in 97 symbols of one image, or of every image.
+// Items are breakpoints.
+static void BM_AddRemoveByRegex(benchmark::State &State) {
+  Session S;
+  std::string Pattern = State.range(0) ? "^__ZN3mad\\d+Image42Namespace.*"
+                                       : "^__ZN3mad3Image42Namespace.*";
+
+  size_t Count = 0;
+  for (auto _ : State) {
+    S.Control.AddBreakpointByRegex(Pattern, false, Continue);
+    S.Control.RemoveBreakpointByRegex(Pattern);
+    ++Count;
+  }
+  State.SetItemsProcessed(Count * IMAGE_SYMBOL_COUNT / 97 *
+                          (State.range(0) ? IMAGE_COUNT - 1 : 1));
+}
+BENCHMARK(BM_AddRemoveByRegex)->Arg(0)->Arg(1);
+
+// Many breakpoints at once, then all of them gone, so that every map in the
+// controller has that many entries
+static void BM_AddManyRemoveMany(benchmark::State &State) {
+  Session S;
+  std::vector<std::string> Names;
+  for (uint32_t i = 0; i < State.range(0); ++i) {
+    Names.push_back(Session::GetName(i % IMAGE_COUNT, i));
+  }
+
+  for (auto _ : State) {
+    for (auto &Name : Names) {
+      S.Control.AddBreakpointBySymbolName(Name, Continue);
+    }
+    for (auto &Name : Names) {
+      S.Control.RemoveBreakpointBySymbolName(Name);
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_AddManyRemoveMany)->RangeMultiplier(8)->Range(8, 8 << 9);
+
+//-----------------------------------------------------------------------------
+// Hit
+//-----------------------------------------------------------------------------
+
+// What every stop on a breakpoint costs the controller: find the breakpoint,
+// run its callbacks and step over it. Items are hits.
+static void BM_HitBreakpoint(benchmark::State &State) {
+  Session S;
+  std::vector<uint64_t> Addresses;
+  for (uint32_t i = 0; i < State.range(0); ++i) {
+    auto Id = i % IMAGE_COUNT;
+    S.Control.AddBreakpointBySymbolName(Session::GetName(Id, i), Continue);
+    Addresses.push_back(Session::GetAddress(Id, i));
+  }
+
+  for (auto _ : State) {
+    for (auto Address : Addresses) {
+      // The trap has been executed
+      fake::SetPC(Address + 1);
+      benchmark::DoNotOptimize(S.Control.CheckBreakpoints());
+      S.Control.StepOverCurrentBreakpointIfAny();
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Addresses.size());
+}
+BENCHMARK(BM_HitBreakpoint)->RangeMultiplier(8)->Range(1, 1 << 12);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,126 @@
+// System
+#include <mach-o/nlist.h>
+
+// Std
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Benchmark
+#include "benchmark/benchmark.h"
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/DemangledNameIndex.hpp"
+
+using namespace mad;
+
+//-----------------------------------------------------------------------------
+// Fixture
+//-----------------------------------------------------------------------------
+
+// Methods of 97 classes in as many namespaces, every class has 23 methods
+// and the methods are overloaded on their parameters, e.g.
+// __ZN3ns43Class45method7Ei is ns4::Class4::method7(int)
+struct Store {
+  std::string Strings;
+  SymbolStore Symbols;
+
+  explicit Store(uint32_t Count) : Strings(1, '\0') {
+    static const char *Parameters[] = {"v", "i", "d", "Pc", "RKS0_"};
+    std::vector<uint32_t> Offsets;
+    for (uint32_t i = 0; i < Count; ++i) {
+      auto Space = "ns" + std::to_string(i % 97);
+      auto Class = "Class" + std::to_string(i % 97);
+      auto Method = "method" + std::to_string(i % 23);
+      Offsets.push_back(Strings.size());
+      Strings += "__ZN" + std::to_string(Space.size()) + Space +
+                 std::to_string(Class.size()) + Class +
+                 std::to_string(Method.size()) + Method + "E" +
+                 Parameters[i % 5];
+      Strings.push_back('\0');
+    }
+
+    Symbols.Reset(ByteView(Strings.data(), Strings.size()), Count, 0);
+    for (uint32_t i = 0; i < Count; ++i) {
+      struct nlist_64 Raw = {};
+      Raw.n_un.n_strx = Offsets[i];
+      Raw.n_type = N_SECT | N_EXT;
+      Raw.n_sect = 1;
+      Raw.n_value = 0x1000 + 16 * i;
+      Symbols.Set(i, Raw, false, true);
+    }
+  }
+};
+
+static const SymbolStore &GetStore(uint32_t Count) {
+  static std::map<uint32_t, std::unique_ptr<Store>> Cache;
+  auto &Entry = Cache[Count];
+  if (!Entry) {
+    Entry = std::make_unique<Store>(Count);
+  }
+  return Entry->Symbols;
+}
+
+#define QUERY "Class7::method3"
+
+//-----------------------------------------------------------------------------
+// Baseline
+//-----------------------------------------------------------------------------
+
+// Demangling every name for every query, items are symbols
+static void BM_DemangleEveryName(benchmark::State &State) {
+  auto &Symbols = GetStore(State.range(0));
+  QualifiedName Query;
+  QualifiedName::Split(QUERY, Query);
+  for (auto _ : State) {
+    std::vector<uint32_t> Rows;
+    for (uint32_t Row = 0; Row < Symbols.GetSize(); ++Row) {
+      DemangledName Name;
+      if (Name.Demangle(Symbols.GetName(Row)) &&
+          Name.GetParts().Matches(Query)) {
+        Rows.push_back(Row);
+      }
+    }
+    benchmark::DoNotOptimize(Rows.data());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_DemangleEveryName)
+    ->RangeMultiplier(8)
+    ->Range(4096, 1 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+//-----------------------------------------------------------------------------
+// Index
+//-----------------------------------------------------------------------------
+
+// Demangling once, on the thread pool, items are symbols
+static void BM_Build(benchmark::State &State) {
+  auto &Symbols = GetStore(State.range(0));
+  for (auto _ : State) {
+    DemangledNameIndex Index;
+    Index.Build(Symbols);
+    benchmark::DoNotOptimize(Index.GetSize());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_Build)
+    ->RangeMultiplier(8)
+    ->Range(4096, 1 << 20)
+    ->Unit(benchmark::kMillisecond);
+
+// Every overload of a method once the index is there
+static void BM_Find(benchmark::State &State) {
+  DemangledNameIndex Index;
+  Index.Build(GetStore(State.range(0)));
+  for (auto _ : State) {
+    std::vector<uint32_t> Rows;
+    Index.Find(QUERY, Rows);
+    benchmark::DoNotOptimize(Rows.data());
+  }
+}
+BENCHMARK(BM_Find)->RangeMultiplier(8)->Range(4096, 1 << 20);
+
+BENCHMARK_MAIN();
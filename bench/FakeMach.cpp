@@ -0,0 +1,152 @@
+// Std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <map>
+#include <vector>
+
+// MAD
+#include "MAD/MachMemory.hpp"
+#include "MAD/MachTask.hpp"
+#include "MAD/MachThread.hpp"
+
+#include "FakeMach.hpp"
+
+using namespace mad;
+
+namespace {
+std::map<uint64_t, std::vector<char>> FakePages;
+x86_thread_state64_t FakeThreadState = {};
+
+// Copies between Data and the pages from Address on, up to the first page that
+// is not mapped
+template <typename T>
+mach_vm_size_t CopyPages(mach_vm_address_t Address, mach_vm_size_t Size,
+                         T Copy) {
+  mach_vm_size_t Done = 0;
+  while (Done < Size) {
+    auto Page = FakePages.find((Address + Done) & ~(FAKE_PAGE_SIZE - 1ull));
+    if (Page == FakePages.end()) {
+      break;
+    }
+    auto Offset = (Address + Done) % FAKE_PAGE_SIZE;
+    auto Count =
+        std::min<mach_vm_size_t>(Size - Done, FAKE_PAGE_SIZE - Offset);
+    Copy(Page->second.data() + Offset, Done, Count);
+    Done += Count;
+  }
+  return Done;
+}
+} // namespace
+
+//-----------------------------------------------------------------------------
+// Setup
+//-----------------------------------------------------------------------------
+void fake::MapMemory(uint64_t Address, const void *Data, uint64_t Size) {
+  auto End = Address + Size;
+  for (auto Page = Address & ~(FAKE_PAGE_SIZE - 1ull); Page < End;
+       Page += FAKE_PAGE_SIZE) {
+    FakePages[Page].resize(FAKE_PAGE_SIZE);
+  }
+  CopyPages(Address, Size, [Data](char *Page, uint64_t Done, uint64_t Count) {
+    memcpy(Page, (const char *)Data + Done, Count);
+  });
+}
+
+void fake::UnmapMemory() { FakePages.clear(); }
+
+uint64_t fake::GetPC() { return FakeThreadState.__rip; }
+
+void fake::SetPC(uint64_t PC) { FakeThreadState.__rip = PC; }
+
+//-----------------------------------------------------------------------------
+// MachMemory
+//-----------------------------------------------------------------------------
+bool MachMemory::Init(mach_port_t TaskPort) {
+  Port = TaskPort;
+  PageSize = FAKE_PAGE_SIZE;
+  return true;
+}
+
+void MachMemory::Fini() {
+  Port = 0;
+  PageSize = 0;
+}
+
+mach_vm_size_t MachMemory::Read(mach_vm_address_t Address, mach_vm_size_t Size,
+                                void *Data) {
+  assert(Port);
+  auto Read = ReadAvailable(Address, Size, Data);
+  return Read == Size ? Read : 0;
+}
+
+mach_vm_size_t MachMemory::ReadAvailable(mach_vm_address_t Address,
+                                         mach_vm_size_t Size, void *Data) {
+  assert(Port);
+  return CopyPages(Address, Size,
+                   [Data](char *Page, uint64_t Done, uint64_t Count) {
+                     memcpy((char *)Data + Done, Page, Count);
+                   });
+}
+
+mach_vm_size_t MachMemory::Write(mach_vm_address_t Address, vm_offset_t Data,
+                                 mach_msg_type_number_t Size) {
+  assert(Port);
+  // Like the real one nothing is written unless all of it can be
+  if (CopyPages(Address, Size, [](char *, uint64_t, uint64_t) {}) != Size) {
+    return 0;
+  }
+  return CopyPages(Address, Size,
+                   [Data](char *Page, uint64_t Done, uint64_t Count) {
+                     memcpy(Page, (const char *)Data + Done, Count);
+                   });
+}
+
+//-----------------------------------------------------------------------------
+// MachTask and MachThread
+//-----------------------------------------------------------------------------
+bool MachTask::Attach(pid_t pid) {
+  assert(!Port);
+  PID = pid;
+  Port = 1;
+  return Memory.Init(Port);
+}
+
+bool MachTask::Detach() {
+  assert(Port);
+  PID = {};
+  Port = {};
+  Memory.Fini();
+  return true;
+}
+
+bool MachTask::Suspend() {
+  Suspended = true;
+  return true;
+}
+
+bool MachTask::Resume() {
+  Suspended = false;
+  return true;
+}
+
+std::vector<MachThread> MachTask::GetThreads(bool) {
+  assert(Port);
+  std::vector<MachThread> Threads;
+  Threads.emplace_back(1);
+  return Threads;
+}
+
+bool MachThread::GetThreadState() {
+  thread_state.uts.ts64 = FakeThreadState;
+  return true;
+}
+
+bool MachThread::SetThreadState() {
+  FakeThreadState = thread_state.uts.ts64;
+  return true;
+}
+
+bool MachThread::GetStates() { return GetThreadState(); }
+
+bool MachThread::SetStates() { return SetThreadState(); }
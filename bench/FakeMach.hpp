@@ -0,0 +1,35 @@
+#ifndef FAKEMACH_HPP_R6PX2MVC
+#define FAKEMACH_HPP_R6PX2MVC
+
+// Std
+#include <cstdint>
+#include <string>
+
+// A stand-in for the Mach side of a debugging session. FakeMach.cpp is linked
+// instead of MachMemory.cpp, MachTask.cpp and MachThread.cpp, and
+// FakeMachProcess.cpp instead of MachProcess.mm. The task's memory is a set of
+// pages in this process, its only thread does nothing but hold registers and
+// its images are whatever AddImage was given. Everything on top, e.g.
+// MachTaskMemoryStream, MachImage and BreakpointsControl, is the real thing,
+// so it can be measured without a live task.
+#define FAKE_PAGE_SIZE 0x1000u
+
+namespace mad {
+namespace fake {
+// Copies Data to Address, the pages it touches are mapped and zero filled
+void MapMemory(uint64_t Address, const void *Data, uint64_t Size);
+void UnmapMemory();
+
+// Images that MachProcess::Attach and UpdateImages find, in this order.
+// Their bytes must be mapped already. Only in FakeMachProcess.cpp.
+void AddImage(std::string Path, uint64_t Address);
+void RemoveImage(std::string Path);
+void RemoveImages();
+
+// Program counter of the only thread
+uint64_t GetPC();
+void SetPC(uint64_t PC);
+} // namespace fake
+} // namespace mad
+
+#endif /* end of include guard: FAKEMACH_HPP_R6PX2MVC */
@@ -0,0 +1,124 @@
+// System
+#include <signal.h>
+#include <unistd.h>
+
+// Std
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/Error.hpp"
+#include "MAD/MachImage.hpp"
+#include "MAD/MachProcess.hpp"
+
+#include "FakeMach.hpp"
+
+using namespace mad;
+
+namespace {
+std::vector<std::pair<std::string, uint64_t>> FakeImages;
+} // namespace
+
+void fake::AddImage(std::string Path, uint64_t Address) {
+  FakeImages.push_back({Path, Address});
+}
+
+void fake::RemoveImage(std::string Path) {
+  FakeImages.erase(std::remove_if(FakeImages.begin(), FakeImages.end(),
+                                  [&](auto &Entry) {
+                                    return Entry.first == Path;
+                                  }),
+                   FakeImages.end());
+}
+
+void fake::RemoveImages() { FakeImages.clear(); }
+
+//-----------------------------------------------------------------------------
+// MachProcess
+//-----------------------------------------------------------------------------
+MachProcess::MachProcess(std::string exec)
+    : Exec(exec), PID(0), Task(), Memory(Task.GetMemory()),
+      Imports(GlobalSymbols), dyld_process_info_create(nullptr),
+      dyld_process_info_for_each_image(nullptr),
+      dyld_process_info_release(nullptr),
+      dyld_process_info_get_cache(nullptr) {}
+
+void MachProcess::UpdateImages(
+    std::vector<std::shared_ptr<MachImage64>> &Added,
+    std::vector<std::shared_ptr<MachImage64>> &Removed) {
+  std::map<uint64_t, std::shared_ptr<MachImage64>> Known;
+  for (auto &Image : Images) {
+    Known.emplace(Image->GetAddress(), Image);
+  }
+
+  for (auto &Entry : FakeImages) {
+    if (Known.erase(Entry.second)) {
+      continue;
+    }
+    auto Image = std::make_shared<MachImage64>(Entry.first, Task, Entry.second,
+                                               nullptr, &SymbolIndex);
+    if (!Image->Scan()) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Could not scan fake image", Entry.first);
+      continue;
+    }
+    AddImage(Image);
+    Added.push_back(Image);
+  }
+
+  for (auto &Entry : Known) {
+    RemoveImage(Entry.second);
+    Removed.push_back(Entry.second);
+  }
+}
+
+vm_size_t MachProcess::ReadMemory(vm_address_t address, vm_size_t size,
+                                  void *data) {
+  return Memory.Read(address, size, data);
+}
+
+vm_size_t MachProcess::WriteMemory(vm_address_t address, vm_offset_t data,
+                                   mach_msg_type_number_t count) {
+  return Memory.Write(address, data, count);
+}
+
+int MachProcess::Execute() {
+  PID = getpid();
+  return 0;
+}
+
+bool MachProcess::Attach() {
+  assert(PID);
+  Task.Attach(PID);
+  std::vector<std::shared_ptr<MachImage64>> Added, Removed;
+  UpdateImages(Added, Removed);
+  return true;
+}
+
+void MachProcess::Detach() {
+  assert(PID);
+  ClearImages();
+  Task.Detach();
+}
+
+void MachProcess::Wait(MachProcessStatus &Status) {
+  Status.Type = MachProcessStatusType::STOPPED;
+  Status.StopSignal = SIGTRAP;
+}
+
+// The thread does not run, its program counter stays where it is
+MachProcessStatus MachProcess::Step() {
+  MachProcessStatus Status;
+  Wait(Status);
+  return Status;
+}
+
+MachProcessStatus MachProcess::Continue() {
+  MachProcessStatus Status;
+  Wait(Status);
+  return Status;
+}
@@ -0,0 +1,171 @@
+#ifndef IMAGE_HPP_W3KD8ZQA
+#define IMAGE_HPP_W3KD8ZQA
+
+// Std
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+// System
+#include <mach-o/loader.h>
+#include <mach-o/nlist.h>
+
+#define IMAGE_BASE 0x100000000ull
+#define IMAGE_TEXT_SIZE 0x100000ull
+
+// A dylib the way ld64 lays one out: __TEXT, __DATA and __LINKEDIT with the
+// symbol table and function starts in it, plus one LC_LOAD_DYLIB per
+// dependency. Real images have a few dozen of those, loaders of plugins many
+// more.
+//
+// The file is laid out the way it is loaded, so the same bytes put at an
+// address serve as the image in memory. Images of different Ids have
+// different symbol names.
+struct Image {
+  std::vector<char> Data;
+
+  static std::string GetSymbolName(uint32_t Id, uint32_t i) {
+    return "__ZN3mad" + (Id ? std::to_string(Id) + "Image" : std::string()) +
+           std::to_string(i % 97) + "Namespace" + std::string(i % 23, 'x') +
+           "E" + std::to_string(i);
+  }
+
+  // Functions are 0x20 bytes apart, the first one is right after the header
+  static uint64_t GetSymbolAddress(uint32_t i) {
+    return IMAGE_BASE + 1 + i * 0x20;
+  }
+
+  template <typename T> void Put(T Value) {
+    auto At = Data.size();
+    Data.resize(At + sizeof(T));
+    memcpy(&Data[At], &Value, sizeof(T));
+  }
+  template <typename T> void PutAt(size_t At, T Value) {
+    memcpy(&Data[At], &Value, sizeof(T));
+  }
+
+  void PutSegment(const char *Name, uint64_t Address, uint64_t Offset,
+                  uint64_t Size, uint32_t SectionCount, vm_prot_t Protection) {
+    segment_command_64 Segment = {};
+    Segment.cmd = LC_SEGMENT_64;
+    Segment.cmdsize = sizeof(Segment) + SectionCount * sizeof(section_64);
+    strncpy(Segment.segname, Name, sizeof(Segment.segname));
+    Segment.vmaddr = Address;
+    Segment.vmsize = Size;
+    Segment.fileoff = Offset;
+    Segment.filesize = Size;
+    Segment.maxprot = Protection;
+    Segment.initprot = Protection;
+    Segment.nsects = SectionCount;
+    Put(Segment);
+    for (uint32_t i = 0; i < SectionCount; ++i) {
+      section_64 Section = {};
+      snprintf(Section.sectname, sizeof(Section.sectname), "__s%u", i);
+      strncpy(Section.segname, Name, sizeof(Section.segname));
+      Section.addr = Address + i * 0x100;
+      Section.size = 0x100;
+      Section.offset = Offset + i * 0x100;
+      Put(Section);
+    }
+  }
+
+  Image(uint32_t SymbolCount, uint32_t LibraryCount, uint32_t Id = 0) {
+    Data.resize(sizeof(mach_header_64));
+    PutSegment("__TEXT", IMAGE_BASE, 0, IMAGE_TEXT_SIZE, 4,
+               VM_PROT_READ | VM_PROT_EXECUTE);
+    PutSegment("__DATA", IMAGE_BASE + IMAGE_TEXT_SIZE, IMAGE_TEXT_SIZE, 0x1000,
+               8, VM_PROT_READ | VM_PROT_WRITE);
+    size_t LinkEdit = Data.size();
+    PutSegment("__LINKEDIT", 0, 0, 0, 0, VM_PROT_READ);
+    size_t Symtab = Data.size();
+    Put(symtab_command{LC_SYMTAB, sizeof(symtab_command), 0, 0, 0, 0});
+    size_t Starts = Data.size();
+    Put(linkedit_data_command{LC_FUNCTION_STARTS,
+                              sizeof(linkedit_data_command), 0, 0});
+    for (uint32_t i = 0; i < LibraryCount; ++i) {
+      dylib_command Command = {};
+      Command.cmd = LC_LOAD_DYLIB;
+      Command.cmdsize = sizeof(Command) + 48;
+      Command.dylib.name.offset = sizeof(Command);
+      Put(Command);
+      char Name[48] = {};
+      snprintf(Name, sizeof(Name), "/usr/lib/libDependency%u.dylib", i);
+      for (auto Char : Name) {
+        Put(Char);
+      }
+    }
+
+    mach_header_64 Header = {};
+    Header.magic = MH_MAGIC_64;
+    Header.cputype = CPU_TYPE_X86_64;
+    Header.filetype = MH_DYLIB;
+    Header.flags = MH_TWOLEVEL;
+    Header.sizeofcmds = Data.size() - sizeof(mach_header_64);
+    Header.ncmds = 5 + LibraryCount;
+    memcpy(Data.data(), &Header, sizeof(Header));
+
+    // __LINKEDIT right after __TEXT and __DATA
+    uint64_t LinkEditOffset = IMAGE_TEXT_SIZE + 0x1000;
+    Data.resize(LinkEditOffset);
+
+    uint64_t StartsOffset = Data.size();
+    Data.push_back(1);
+    for (uint32_t i = 1; i < SymbolCount; ++i) {
+      Data.push_back(0x20);
+    }
+    Data.resize((Data.size() + 7) & ~7ull);
+
+    uint64_t SymbolsOffset = Data.size();
+    std::string Strings(" \0", 2);
+    std::vector<nlist_64> Symbols(SymbolCount);
+    for (uint32_t i = 0; i < SymbolCount; ++i) {
+      Symbols[i].n_un.n_strx = Strings.size();
+      Symbols[i].n_type = N_SECT | N_EXT;
+      Symbols[i].n_sect = 1;
+      Symbols[i].n_value = GetSymbolAddress(i);
+      Strings += GetSymbolName(Id, i);
+      Strings.push_back('\0');
+    }
+    Data.resize(SymbolsOffset + SymbolCount * sizeof(nlist_64));
+    memcpy(&Data[SymbolsOffset], Symbols.data(),
+           SymbolCount * sizeof(nlist_64));
+    uint64_t StringsOffset = Data.size();
+    Data.insert(Data.end(), Strings.begin(), Strings.end());
+    uint64_t LinkEditSize = Data.size() - LinkEditOffset;
+
+    strncpy(&Data[LinkEdit + offsetof(segment_command_64, segname)],
+            "__LINKEDIT", 16);
+    PutAt(LinkEdit + offsetof(segment_command_64, vmaddr),
+          IMAGE_BASE + LinkEditOffset);
+    PutAt(LinkEdit + offsetof(segment_command_64, vmsize), LinkEditSize);
+    PutAt(LinkEdit + offsetof(segment_command_64, fileoff), LinkEditOffset);
+    PutAt(LinkEdit + offsetof(segment_command_64, filesize), LinkEditSize);
+    PutAt<uint32_t>(Symtab + offsetof(symtab_command, symoff), SymbolsOffset);
+    PutAt<uint32_t>(Symtab + offsetof(symtab_command, nsyms), SymbolCount);
+    PutAt<uint32_t>(Symtab + offsetof(symtab_command, stroff), StringsOffset);
+    PutAt<uint32_t>(Symtab + offsetof(symtab_command, strsize),
+                    Strings.size());
+    PutAt<uint32_t>(Starts + offsetof(linkedit_data_command, dataoff),
+                    StartsOffset);
+    PutAt<uint32_t>(Starts + offsetof(linkedit_data_command, datasize),
+                    SymbolsOffset - StartsOffset);
+  }
+};
+
+// Millions of symbols take a while to lay out, each image is built once
+inline const Image &GetImage(uint32_t SymbolCount, uint32_t LibraryCount,
+                             uint32_t Id = 0) {
+  static std::map<std::tuple<uint32_t, uint32_t, uint32_t>, Image> Cache;
+  auto Key = std::make_tuple(SymbolCount, LibraryCount, Id);
+  auto It = Cache.find(Key);
+  if (It == Cache.end()) {
+    It = Cache.emplace(Key, Image(SymbolCount, LibraryCount, Id)).first;
+  }
+  return It->second;
+}
+
+#endif /* end of include guard: IMAGE_HPP_W3KD8ZQA */
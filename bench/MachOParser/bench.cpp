@@ -0,0 +1,66 @@
+// Std
+#include <sstream>
+#include <string>
+
+// Benchmark
+#include "benchmark/benchmark.h"
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/StreamInput.hpp"
+
+#include "Image.hpp"
+
+using namespace mad;
+
+//-----------------------------------------------------------------------------
+// Parse
+//-----------------------------------------------------------------------------
+
+// Load commands only, the symbols are left for later
+static void BM_ParseLoadCommands(benchmark::State &State) {
+  auto &I = GetImage(16, State.range(0));
+  ByteView View(I.Data.data(), I.Data.size());
+  for (auto _ : State) {
+    MachOFileParser64 Parser("bench", View,
+                             MO_PARSE_FILE | MO_PARSE_LAZY_SYMBOLS);
+    benchmark::DoNotOptimize(Parser.Parse());
+  }
+  State.SetItemsProcessed(State.iterations() * (State.range(0) + 5));
+}
+BENCHMARK(BM_ParseLoadCommands)->Range(8, 1 << 12);
+
+// Everything, the symbol store included, out of a mapped file. Items are
+// symbols.
+static void BM_ParseFile(benchmark::State &State) {
+  auto &I = GetImage(State.range(0), 32);
+  ByteView View(I.Data.data(), I.Data.size());
+  for (auto _ : State) {
+    MachOFileParser64 Parser("bench", View, MO_PARSE_FILE);
+    benchmark::DoNotOptimize(Parser.Parse());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_ParseFile)
+    ->RangeMultiplier(8)
+    ->Range(10000, 5000000)
+    ->Unit(benchmark::kMillisecond);
+
+// Same through a stream, which copies __LINKEDIT out piece by piece
+static void BM_ParseStream(benchmark::State &State) {
+  auto &I = GetImage(State.range(0), 32);
+  std::istringstream Stream(std::string(I.Data.data(), I.Data.size()));
+  for (auto _ : State) {
+    Stream.clear();
+    MachOParser64 Parser("bench", StreamInput(Stream), MO_PARSE_FILE);
+    benchmark::DoNotOptimize(Parser.Parse());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_ParseStream)
+    ->RangeMultiplier(8)
+    ->Range(10000, 5000000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
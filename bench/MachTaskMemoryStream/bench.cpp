@@ -0,0 +1,139 @@
+// System
+#include <unistd.h>
+
+// Std
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// Benchmark
+#include "benchmark/benchmark.h"
+
+// MAD
+#include "MAD/MachImageInput.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/MachTask.hpp"
+#include "MAD/MachTaskMemoryStream.hpp"
+#include "MAD/StreamInput.hpp"
+
+#include "FakeMach.hpp"
+#include "Image.hpp"
+
+using namespace mad;
+
+//-----------------------------------------------------------------------------
+// Fixture
+//-----------------------------------------------------------------------------
+
+// A task with one image loaded at its link address
+struct Task {
+  MachTask Mach;
+  const Image &Loaded;
+
+  explicit Task(uint32_t SymbolCount) : Loaded(GetImage(SymbolCount, 32)) {
+    fake::MapMemory(IMAGE_BASE, Loaded.Data.data(), Loaded.Data.size());
+    Mach.Attach(getpid());
+  }
+  ~Task() {
+    Mach.Detach();
+    fake::UnmapMemory();
+  }
+
+  uint64_t GetSize() const { return Loaded.Data.size(); }
+};
+
+//-----------------------------------------------------------------------------
+// Reads
+//-----------------------------------------------------------------------------
+
+// Front to back in reads of the given size. Items are bytes.
+static void BM_ReadSequential(benchmark::State &State) {
+  Task T(100000);
+  uint64_t ReadSize = State.range(0);
+  std::vector<char> Buffer(ReadSize);
+  for (auto _ : State) {
+    MachTaskMemoryStream Stream(T.Mach.GetMemory(), IMAGE_BASE);
+    for (uint64_t At = 0; At + ReadSize <= T.GetSize(); At += ReadSize) {
+      Stream.read(Buffer.data(), ReadSize);
+    }
+    benchmark::DoNotOptimize(Buffer.data());
+  }
+  State.SetBytesProcessed(State.iterations() * (T.GetSize() / ReadSize) *
+                          ReadSize);
+}
+BENCHMARK(BM_ReadSequential)->RangeMultiplier(8)->Range(8, 1 << 15);
+
+// Pointer-sized reads all over the image, e.g. chasing pointers
+static void BM_ReadRandom(benchmark::State &State) {
+  Task T(100000);
+  std::mt19937 Random(0);
+  std::uniform_int_distribution<uint64_t> Offset(0, T.GetSize() - 8);
+  std::vector<uint64_t> Offsets(4096);
+  for (auto &O : Offsets) {
+    O = Offset(Random);
+  }
+
+  MachTaskMemoryStream Stream(T.Mach.GetMemory(), IMAGE_BASE);
+  for (auto _ : State) {
+    for (auto O : Offsets) {
+      uint64_t Value;
+      Stream.seekg(O);
+      Stream.read((char *)&Value, sizeof(Value));
+      benchmark::DoNotOptimize(Value);
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Offsets.size());
+}
+BENCHMARK(BM_ReadRandom);
+
+// Every symbol name out of the string table, the way image mode parsers that
+// cannot slice their input read strings
+static void BM_ReadStrings(benchmark::State &State) {
+  Task T(State.range(0));
+  auto &Data = T.Loaded.Data;
+  auto Header = reinterpret_cast<const mach_header_64 *>(Data.data());
+  uint64_t At = sizeof(mach_header_64);
+  symtab_command Symtab = {};
+  for (uint32_t i = 0; i < Header->ncmds; ++i) {
+    auto Command = reinterpret_cast<const load_command *>(&Data[At]);
+    if (Command->cmd == LC_SYMTAB) {
+      memcpy(&Symtab, Command, sizeof(Symtab));
+    }
+    At += Command->cmdsize;
+  }
+
+  for (auto _ : State) {
+    MachTaskMemoryStream Stream(T.Mach.GetMemory(), IMAGE_BASE);
+    StreamInput Input(Stream);
+    Input.Seek(Symtab.stroff + 2);
+    for (uint32_t i = 0; i < Symtab.nsyms; ++i) {
+      benchmark::DoNotOptimize(Input.ReadNTString());
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_ReadStrings)->RangeMultiplier(8)->Range(10000, 1000000);
+
+//-----------------------------------------------------------------------------
+// Parse
+//-----------------------------------------------------------------------------
+
+// What MachImage does to every image in the target. Items are symbols.
+static void BM_ParseImage(benchmark::State &State) {
+  Task T(State.range(0));
+  for (auto _ : State) {
+    MachTaskMemoryStream Stream(T.Mach.GetMemory(), IMAGE_BASE);
+    MachOParser<MachSystem64_t, MachImageInput> Parser(
+        "bench", MachImageInput(Stream, IMAGE_BASE), MO_PARSE_IMAGE,
+        IMAGE_BASE);
+    benchmark::DoNotOptimize(Parser.Parse());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_ParseImage)
+    ->RangeMultiplier(8)
+    ->Range(10000, 5000000)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,143 @@
+// Std
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Benchmark
+#include "benchmark/benchmark.h"
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/StringTableIndex.hpp"
+
+using namespace mad;
+
+//-----------------------------------------------------------------------------
+// Fixture
+//-----------------------------------------------------------------------------
+
+// A string table that looks like the one ld64 emits: a leading " \0", mangled
+// names of varying length and every tenth symbol pointing into the middle of
+// another one because of tail merging.
+struct Strings {
+  std::string Data;
+  std::vector<uint32_t> Offsets;
+
+  explicit Strings(uint32_t Count) {
+    Data.append(" \0", 2);
+    for (uint32_t i = 0; i < Count; ++i) {
+      if (i % 10 == 9 && !Offsets.empty()) {
+        Offsets.push_back(Offsets.back() + 1);
+        continue;
+      }
+      Offsets.push_back(Data.size());
+      Data += "__ZN3mad" + std::to_string(i % 97) + "Namespace" +
+              std::string(i % 23, 'x') + "E" + std::to_string(i);
+      Data.push_back('\0');
+    }
+  }
+};
+
+static const Strings &GetStrings(uint32_t Count) {
+  static std::map<uint32_t, Strings> Cache;
+  auto It = Cache.find(Count);
+  if (It == Cache.end()) {
+    It = Cache.emplace(Count, Strings(Count)).first;
+  }
+  return It->second;
+}
+
+//-----------------------------------------------------------------------------
+// Baseline
+//-----------------------------------------------------------------------------
+
+// This is how MachOParser used to read symbol names, one byte at a time
+static std::string ReadNTStringFromInput(std::istream &I) {
+  std::string result;
+  while (I.good()) {
+    char ch;
+    I.read(&ch, 1);
+    if (!ch) {
+      return result;
+    }
+    result.push_back(ch);
+  }
+  return result;
+}
+
+static void BM_ReadNTStringFromInput(benchmark::State &State) {
+  auto &S = GetStrings(State.range(0));
+  std::istringstream Input(S.Data);
+  for (auto _ : State) {
+    for (auto Offset : S.Offsets) {
+      Input.seekg(Offset);
+      benchmark::DoNotOptimize(ReadNTStringFromInput(Input));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * S.Offsets.size());
+}
+BENCHMARK(BM_ReadNTStringFromInput)->Range(1 << 10, 1 << 20);
+
+static void BM_StringAt(benchmark::State &State) {
+  auto &S = GetStrings(State.range(0));
+  ByteView View(S.Data.data(), S.Data.size());
+  for (auto _ : State) {
+    for (auto Offset : S.Offsets) {
+      benchmark::DoNotOptimize(View.StringAt(Offset));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * S.Offsets.size());
+}
+BENCHMARK(BM_StringAt)->Range(1 << 10, 1 << 20);
+
+//-----------------------------------------------------------------------------
+// Index
+//-----------------------------------------------------------------------------
+
+static void BM_ScanTerminators(benchmark::State &State) {
+  auto &S = GetStrings(State.range(0));
+  auto Kernel = static_cast<StringScanKernel>(State.range(1));
+  std::vector<uint64_t> Bitmap((S.Data.size() + 63) / 64);
+  for (auto _ : State) {
+    std::fill(Bitmap.begin(), Bitmap.end(), 0);
+    StringTableIndex::ScanTerminators(S.Data.data(), S.Data.size(),
+                                      Bitmap.data(), Kernel);
+    benchmark::ClobberMemory();
+  }
+  State.SetBytesProcessed(State.iterations() * S.Data.size());
+}
+BENCHMARK(BM_ScanTerminators)
+    ->ArgsProduct({benchmark::CreateRange(1 << 10, 1 << 20, 32),
+                   {int(StringScanKernel::SCALAR), int(StringScanKernel::SSE2),
+                    int(StringScanKernel::AVX2)}});
+
+// Build plus one length lookup per symbol, i.e. what SymbolStore does
+static void BM_IndexLengths(benchmark::State &State) {
+  auto &S = GetStrings(State.range(0));
+  ByteView View(S.Data.data(), S.Data.size());
+  for (auto _ : State) {
+    StringTableIndex Index;
+    Index.Build(View);
+    for (auto Offset : S.Offsets) {
+      benchmark::DoNotOptimize(Index.GetLength(Offset));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * S.Offsets.size());
+}
+BENCHMARK(BM_IndexLengths)->Range(1 << 10, 1 << 20);
+
+static void BM_IndexHashes(benchmark::State &State) {
+  auto &S = GetStrings(State.range(0));
+  StringTableIndex Index;
+  Index.Build(ByteView(S.Data.data(), S.Data.size()));
+  for (auto _ : State) {
+    Index.BuildHashes();
+    benchmark::ClobberMemory();
+  }
+  State.SetItemsProcessed(State.iterations() * Index.GetStringCount());
+}
+BENCHMARK(BM_IndexHashes)->Range(1 << 10, 1 << 20);
+
+BENCHMARK_MAIN();
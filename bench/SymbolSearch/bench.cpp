@@ -0,0 +1,127 @@
+// Std
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+// Benchmark
+#include "benchmark/benchmark.h"
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/SymbolSearch.hpp"
+#include "MAD/SymbolTable.hpp"
+
+#include "Image.hpp"
+
+using namespace mad;
+
+using FileSymbolTable64 = SymbolTable<MachSystem64_t, ByteView>;
+
+//-----------------------------------------------------------------------------
+// Fixture
+//-----------------------------------------------------------------------------
+
+// Names look like __ZN3mad42NamespacexxxE1234, one in 97 symbols has any
+// given number before Namespace
+#define PREFIX_PATTERN "^__ZN3mad42Namespace.*"
+#define REGEX_PATTERN "^__ZN3mad42Namespacex*E\\d+7$"
+
+// Parsed once per benchmark, the symbol store is what is searched
+struct Parsed {
+  std::unique_ptr<MachOFileParser64> Parser;
+  std::unique_ptr<FileSymbolTable64> Table;
+
+  explicit Parsed(uint32_t SymbolCount) {
+    auto &I = GetImage(SymbolCount, 32);
+    Parser = std::make_unique<MachOFileParser64>(
+        "bench", ByteView(I.Data.data(), I.Data.size()), MO_PARSE_FILE);
+    Parser->Parse();
+    Table = std::make_unique<FileSymbolTable64>(*Parser);
+    Table->Init();
+  }
+
+  const SymbolStore &GetStore() { return Table->GetSymbols(); }
+};
+
+//-----------------------------------------------------------------------------
+// Baseline
+//-----------------------------------------------------------------------------
+
+// The regex engine on every name. Items are symbols.
+static void BM_SearchEveryName(benchmark::State &State) {
+  Parsed P(State.range(0));
+  auto &Store = P.GetStore();
+  std::regex Regex(PREFIX_PATTERN, std::regex::optimize);
+  for (auto _ : State) {
+    std::vector<uint32_t> Rows;
+    for (uint32_t Row = 0; Row < Store.GetSize(); ++Row) {
+      auto Name = Store.GetName(Row);
+      if (std::regex_search(Name.begin(), Name.end(), Regex)) {
+        Rows.push_back(Row);
+      }
+    }
+    benchmark::DoNotOptimize(Rows.data());
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_SearchEveryName)
+    ->RangeMultiplier(8)
+    ->Range(10000, 5000000)
+    ->Unit(benchmark::kMillisecond);
+
+//-----------------------------------------------------------------------------
+// Search
+//-----------------------------------------------------------------------------
+
+// Literals joined by .*, matched without the regex engine
+static void BM_SearchPrefix(benchmark::State &State) {
+  Parsed P(State.range(0));
+  SymbolPattern Pattern;
+  Pattern.Compile(PREFIX_PATTERN);
+  for (auto _ : State) {
+    benchmark::DoNotOptimize(SymbolSearch::Search(Pattern, {&P.GetStore()}));
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_SearchPrefix)
+    ->RangeMultiplier(8)
+    ->Range(10000, 5000000)
+    ->Unit(benchmark::kMillisecond);
+
+// The regex engine on the names that contain the literal only
+static void BM_SearchRegex(benchmark::State &State) {
+  Parsed P(State.range(0));
+  SymbolPattern Pattern;
+  Pattern.Compile(REGEX_PATTERN);
+  for (auto _ : State) {
+    benchmark::DoNotOptimize(SymbolSearch::Search(Pattern, {&P.GetStore()}));
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_SearchRegex)
+    ->RangeMultiplier(8)
+    ->Range(10000, 5000000)
+    ->Unit(benchmark::kMillisecond);
+
+// The literal prefilter alone, items are bytes of the string table
+static void BM_FindLiteral(benchmark::State &State) {
+  Parsed P(State.range(0));
+  auto Strings = P.GetStore().Strings;
+  std::vector<uint64_t> Hits((Strings.GetSize() + 63) / 64);
+  auto Kernel = static_cast<StringScanKernel>(State.range(1));
+  for (auto _ : State) {
+    SymbolSearch::FindLiteral(Strings.GetData(), Strings.GetSize(),
+                              "__ZN3mad42Namespace", Hits.data(), Kernel);
+    benchmark::DoNotOptimize(Hits.data());
+  }
+  State.SetBytesProcessed(State.iterations() * Strings.GetSize());
+}
+BENCHMARK(BM_FindLiteral)
+    ->ArgsProduct({{5000000},
+                   {int(StringScanKernel::SCALAR), int(StringScanKernel::SSE2),
+                    int(StringScanKernel::AVX2)}})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,167 @@
+// Std
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Benchmark
+#include "benchmark/benchmark.h"
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/SymbolTable.hpp"
+
+#include "Image.hpp"
+
+using namespace mad;
+
+using FileSymbolTable64 = SymbolTable<MachSystem64_t, ByteView>;
+
+//-----------------------------------------------------------------------------
+// Fixture
+//-----------------------------------------------------------------------------
+
+#define LOOKUP_COUNT 4096
+
+// Parsed once per benchmark, the symbol store is what is measured against
+struct Parsed {
+  std::unique_ptr<MachOFileParser64> Parser;
+
+  explicit Parsed(uint32_t SymbolCount) {
+    auto &I = GetImage(SymbolCount, 32);
+    Parser = std::make_unique<MachOFileParser64>(
+        "bench", ByteView(I.Data.data(), I.Data.size()), MO_PARSE_FILE);
+    Parser->Parse();
+  }
+};
+
+// Symbols are looked up in no particular order, the same ones in every run
+static std::vector<uint32_t> GetRandomSymbols(uint32_t SymbolCount) {
+  std::mt19937 Random(SymbolCount);
+  std::uniform_int_distribution<uint32_t> Symbol(0, SymbolCount - 1);
+  std::vector<uint32_t> Symbols(LOOKUP_COUNT);
+  for (auto &S : Symbols) {
+    S = Symbol(Random);
+  }
+  return Symbols;
+}
+
+//-----------------------------------------------------------------------------
+// By name
+//-----------------------------------------------------------------------------
+
+// The first lookup pays for the name index. Items are symbols.
+static void BM_BuildNameIndex(benchmark::State &State) {
+  Parsed P(State.range(0));
+  auto Name = Image::GetSymbolName(0, 0);
+  for (auto _ : State) {
+    FileSymbolTable64 Table(*P.Parser);
+    benchmark::DoNotOptimize(Table.GetSymbolByName(Name));
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_BuildNameIndex)
+    ->RangeMultiplier(8)
+    ->Range(10000, 5000000)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_GetSymbolByName(benchmark::State &State) {
+  Parsed P(State.range(0));
+  FileSymbolTable64 Table(*P.Parser);
+  Table.Init();
+
+  std::vector<std::string> Names;
+  for (auto i : GetRandomSymbols(State.range(0))) {
+    Names.push_back(Image::GetSymbolName(0, i));
+  }
+
+  for (auto _ : State) {
+    for (auto &Name : Names) {
+      benchmark::DoNotOptimize(Table.GetSymbolByName(Name));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_GetSymbolByName)->RangeMultiplier(8)->Range(10000, 5000000);
+
+// Most names a user types are in some other image
+static void BM_GetSymbolByNameMissing(benchmark::State &State) {
+  Parsed P(State.range(0));
+  FileSymbolTable64 Table(*P.Parser);
+  Table.Init();
+
+  std::vector<std::string> Names;
+  for (auto i : GetRandomSymbols(State.range(0))) {
+    Names.push_back(Image::GetSymbolName(1, i));
+  }
+
+  for (auto _ : State) {
+    for (auto &Name : Names) {
+      benchmark::DoNotOptimize(Table.GetSymbolByName(Name));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Names.size());
+}
+BENCHMARK(BM_GetSymbolByNameMissing)->RangeMultiplier(8)->Range(10000, 5000000);
+
+//-----------------------------------------------------------------------------
+// By address
+//-----------------------------------------------------------------------------
+
+// An address somewhere inside of every function
+static void BM_GetFunctionRange(benchmark::State &State) {
+  Parsed P(State.range(0));
+  FileSymbolTable64 Table(*P.Parser);
+  Table.Init();
+
+  std::vector<uint64_t> Addresses;
+  for (auto i : GetRandomSymbols(State.range(0))) {
+    Addresses.push_back(Image::GetSymbolAddress(i) + i % 0x20);
+  }
+
+  for (auto _ : State) {
+    for (auto Address : Addresses) {
+      uint64_t Start, End;
+      benchmark::DoNotOptimize(Table.GetFunctionRange(Address, Start, End));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Addresses.size());
+}
+BENCHMARK(BM_GetFunctionRange)->RangeMultiplier(8)->Range(10000, 5000000);
+
+// The first reverse lookup pays for the address index. Items are symbols.
+static void BM_BuildAddressIndex(benchmark::State &State) {
+  Parsed P(State.range(0));
+  for (auto _ : State) {
+    FileSymbolTable64 Table(*P.Parser);
+    benchmark::DoNotOptimize(Table.GetSymbolByAddress(IMAGE_BASE));
+  }
+  State.SetItemsProcessed(State.iterations() * State.range(0));
+}
+BENCHMARK(BM_BuildAddressIndex)
+    ->RangeMultiplier(8)
+    ->Range(10000, 5000000)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_GetSymbolByAddress(benchmark::State &State) {
+  Parsed P(State.range(0));
+  FileSymbolTable64 Table(*P.Parser);
+  Table.Init();
+  Table.GetAddressIndex();
+
+  std::vector<uint64_t> Addresses;
+  for (auto i : GetRandomSymbols(State.range(0))) {
+    Addresses.push_back(Image::GetSymbolAddress(i) + i % 0x20);
+  }
+
+  for (auto _ : State) {
+    for (auto Address : Addresses) {
+      benchmark::DoNotOptimize(Table.GetSymbolByAddress(Address));
+    }
+  }
+  State.SetItemsProcessed(State.iterations() * Addresses.size());
+}
+BENCHMARK(BM_GetSymbolByAddress)->RangeMultiplier(8)->Range(10000, 5000000);
+
+BENCHMARK_MAIN();
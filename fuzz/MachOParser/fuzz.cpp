@@ -0,0 +1,89 @@
+// Std
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/StreamInput.hpp"
+
+using namespace mad;
+
+// Built once per width, MAD_FUZZ_32 selects MachOParser32
+#ifdef MAD_FUZZ_32
+using System_t = MachSystem32_t;
+#else
+using System_t = MachSystem64_t;
+#endif
+
+// Everything the debugger asks of a parsed image, so the lazily read parts
+// are fuzzed along with the load commands
+template <typename P> static void Query(P &Parser) {
+  if (Parser.SymbolTable) {
+    auto &Store = Parser.SymbolTable->GetStore();
+    for (uint32_t i = 0; i < Store.GetSize() && i < 64; ++i) {
+      Store.GetName(i);
+    }
+  }
+  Parser.GetDebugMap();
+
+  uint64_t Address = 0;
+  Parser.GetExportAddress("_main", Address);
+
+  auto Text = Parser.GetSegmentByName(SEG_TEXT);
+  if (!Text) {
+    return;
+  }
+
+  uint64_t Start, End;
+  Parser.GetFunctionRange(Text->VirtualAddress, Start, End);
+
+  UnwindPlan Plan;
+  CompactUnwind::Entry E;
+  if (auto Unwind = Parser.GetCompactUnwind()) {
+    if (Unwind->Lookup(Text->VirtualAddress + 0x100, E)) {
+      CompactUnwind::GetPlan(E, Plan);
+    }
+  }
+  if (auto Frames = Parser.GetEhFrame()) {
+    Frames->GetPlan(Text->VirtualAddress + 0x100, Plan);
+  }
+
+  std::vector<DwarfFunction> Functions;
+  if (auto Index = Parser.GetDwarfIndex()) {
+    Index->FindMethods("main", Functions);
+    Index->FindClassMethods("Shape", Functions);
+  }
+
+  LineInfo Info;
+  std::vector<uint64_t> Addresses;
+  uint32_t Line;
+  if (auto Lines = Parser.GetLineTable()) {
+    Lines->LookupAddress(Text->VirtualAddress, Info);
+    Lines->LookupLine("main.c", 1, Addresses, Line);
+  }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
+  // Files are viewed in place, whatever the parser cannot slice is missing
+  MachOParser<System_t, ByteView> File("fuzz", ByteView(Data, Size),
+                                       MO_PARSE_FILE);
+  if (File.Parse()) {
+    Query(File);
+  }
+
+  // Images are read through a stream, offsets are relative to the header in
+  // memory and the slide is computed from __TEXT
+  std::istringstream Stream(
+      std::string(reinterpret_cast<const char *>(Data), Size));
+  MachOParser<System_t> Image("fuzz", StreamInput(Stream),
+                              MO_PARSE_IMAGE | MO_PARSE_LAZY_SYMBOLS,
+                              0x100000000);
+  if (Image.Parse()) {
+    Query(Image);
+  }
+
+  return 0;
+}
@@ -0,0 +1,23 @@
+// Std
+#include <cstdint>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/UniversalBinary.hpp"
+
+using namespace mad;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
+  UniversalBinary Binary("fuzz");
+  if (!Binary.Parse(ByteView(Data, Size))) {
+    return 0;
+  }
+
+  // Every slice is looked up the way the debugger does it, which parses it
+  for (auto &Slice : Binary.GetSlices()) {
+    Binary.GetObjectFile(Slice.CpuType, Slice.CpuSubType);
+  }
+  Binary.FindSlice(CPU_TYPE_X86_64, CPU_SUBTYPE_X86_64_H);
+
+  return 0;
+}
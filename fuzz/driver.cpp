@@ -0,0 +1,26 @@
+// Std
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// Stands in for a fuzzing engine: every argument is a file that is fed to the
+// target as is, e.g. a corpus entry or a crash to reproduce.
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size);
+
+int main(int argc, char *argv[]) {
+  for (int i = 1; i < argc; ++i) {
+    std::ifstream File(argv[i], std::ios::binary);
+    if (!File) {
+      fprintf(stderr, "Could not open %s\n", argv[i]);
+      return 1;
+    }
+    std::vector<uint8_t> Data((std::istreambuf_iterator<char>(File)),
+                              std::istreambuf_iterator<char>());
+    printf("Running %s (%zu bytes)\n", argv[i], Data.size());
+    LLVMFuzzerTestOneInput(Data.data(), Data.size());
+  }
+  return 0;
+}
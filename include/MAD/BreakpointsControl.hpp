@@ -14,6 +14,7 @@
 // MAD
 #include "MAD/MachMemory.hpp"
 #include "MAD/MachProcess.hpp"
+#include "MAD/SymbolSearch.hpp"
 #include "MAD/Utils.hpp"
 
 // This class-set describes breakpoints you can set during mad-debugging. There
@@ -68,6 +69,8 @@ using BreakpointByAddressCallback_t =
     std::function<BreakpointCallbackReturn(AddressType)>;
 using BreakpointBySymbolNameCallback_t =
     std::function<BreakpointCallbackReturn(std::string)>;
+using BreakpointByLineCallback_t =
+    std::function<BreakpointCallbackReturn(std::string, unsigned)>;
 
 // These are Seed types, and this is what user limited to. Every seed can be
 // placed even if the target does not yet exist. Every non-exact(e.g. regex)
@@ -89,6 +92,9 @@ enum class SeedType {
   // Breaks on all symbols that belong to a particular class
   CLASS,
 
+  // Breaks on methods of a particular name, of any class
+  METHOD,
+
   // Breaks on all symbols that belong to a particular file
   FILE,
 };
@@ -132,9 +138,78 @@ public:
   BreakpointCallbackReturn InvokeCallback() { return Callback(SymbolName); }
 };
 
+// Permanently pending, every time the seed is tried the images loaded since
+// the last time are searched
+class SeedRegex : public Seed {
+public:
+  // As given, a regular expression or a glob
+  std::string Pattern;
+  SymbolPattern Compiled;
+  // Images of the process searched so far
+  size_t SearchedImages;
+  BreakpointBySymbolNameCallback_t Callback;
+  SeedRegex(std::string Pattern, SymbolPattern Compiled,
+            BreakpointBySymbolNameCallback_t Callback)
+      : Seed(SeedType::REGEX, SeedPendingPolicy::KEEP), Pattern(Pattern),
+        Compiled(Compiled), SearchedImages(0), Callback(Callback) {}
+  BreakpointCallbackReturn InvokeCallback() { return Callback(Pattern); }
+};
+
+class SeedLine : public Seed {
+public:
+  // As given, matched against the trailing components of the paths in the
+  // line tables
+  std::string File;
+  unsigned Line;
+  BreakpointByLineCallback_t Callback;
+  SeedLine(std::string File, unsigned Line,
+           BreakpointByLineCallback_t Callback)
+      : Seed(SeedType::LINE, SeedPendingPolicy::REMOVE), File(File),
+        Line(Line), Callback(Callback) {}
+  BreakpointCallbackReturn InvokeCallback() { return Callback(File, Line); }
+};
+
+// Both resolve through the accelerator tables of images' dSYMs
+class SeedClass : public Seed {
+public:
+  // May be qualified, e.g. geo::Circle
+  std::string ClassName;
+  BreakpointBySymbolNameCallback_t Callback;
+  SeedClass(std::string ClassName, BreakpointBySymbolNameCallback_t Callback)
+      : Seed(SeedType::CLASS, SeedPendingPolicy::REMOVE), ClassName(ClassName),
+        Callback(Callback) {}
+  BreakpointCallbackReturn InvokeCallback() { return Callback(ClassName); }
+};
+class SeedMethod : public Seed {
+public:
+  std::string MethodName;
+  BreakpointBySymbolNameCallback_t Callback;
+  SeedMethod(std::string MethodName, BreakpointBySymbolNameCallback_t Callback)
+      : Seed(SeedType::METHOD, SeedPendingPolicy::REMOVE),
+        MethodName(MethodName), Callback(Callback) {}
+  BreakpointCallbackReturn InvokeCallback() { return Callback(MethodName); }
+};
+
+// Resolves through the debug maps of the images
+class SeedFile : public Seed {
+public:
+  // Matched like SeedLine's
+  std::string File;
+  BreakpointBySymbolNameCallback_t Callback;
+  SeedFile(std::string File, BreakpointBySymbolNameCallback_t Callback)
+      : Seed(SeedType::FILE, SeedPendingPolicy::REMOVE), File(File),
+        Callback(Callback) {}
+  BreakpointCallbackReturn InvokeCallback() { return Callback(File); }
+};
+
 using Seed_sp = std::shared_ptr<Seed>;
 using SeedAddress_sp = std::shared_ptr<SeedAddress>;
 using SeedSymbolName_sp = std::shared_ptr<SeedSymbolName>;
+using SeedRegex_sp = std::shared_ptr<SeedRegex>;
+using SeedLine_sp = std::shared_ptr<SeedLine>;
+using SeedClass_sp = std::shared_ptr<SeedClass>;
+using SeedMethod_sp = std::shared_ptr<SeedMethod>;
+using SeedFile_sp = std::shared_ptr<SeedFile>;
 
 //-----------------------------------------------------------------------------
 // Virtual breakpoints
@@ -147,14 +222,37 @@ public:
 };
 class VirtualPointSymbol : public VirtualPoint {
 public:
-  using SymbolType_sp = std::shared_ptr<MachOParser64::MachOSymbolTableEntry>;
-  SymbolType_sp Symbol;
-  VirtualPointSymbol(SymbolType_sp &Symbol) : Symbol(Symbol) {}
+  AddressType Address;
+  // A handle into the owning image's SymbolStore, empty if the symbol was
+  // found in the image's exports trie
+  SymbolRef Symbol;
+  VirtualPointSymbol(AddressType Address, SymbolRef Symbol = SymbolRef())
+      : Address(Address), Symbol(Symbol) {}
+};
+
+class VirtualPointLine : public VirtualPoint {
+public:
+  AddressType Address;
+  // The line that has code, it can be after the requested one
+  unsigned Line;
+  VirtualPointLine(AddressType Address, unsigned Line)
+      : Address(Address), Line(Line) {}
+};
+
+class VirtualPointFunction : public VirtualPoint {
+public:
+  AddressType Address;
+  // Linkage name from the debug info
+  std::string Name;
+  VirtualPointFunction(AddressType Address, std::string Name)
+      : Address(Address), Name(Name) {}
 };
 
 using VPoint_sp = std::shared_ptr<VirtualPoint>;
 using VPointAddress_sp = std::shared_ptr<VirtualPointAddress>;
 using VPointSymbol_sp = std::shared_ptr<VirtualPointSymbol>;
+using VPointLine_sp = std::shared_ptr<VirtualPointLine>;
+using VPointFunction_sp = std::shared_ptr<VirtualPointFunction>;
 
 //-----------------------------------------------------------------------------
 // Actual breakpoints
@@ -198,10 +296,18 @@ class BreakpointsControl {
   std::set<Seed_sp> PendingSeeds;
   std::map<AddressType, SeedAddress_sp> SeedsByAddress;
   std::map<std::string, SeedSymbolName_sp> SeedsBySymbolName;
+  std::map<std::string, SeedRegex_sp> SeedsByRegex;
+  std::map<std::pair<std::string, unsigned>, SeedLine_sp> SeedsByLine;
+  std::map<std::string, SeedClass_sp> SeedsByClass;
+  std::map<std::string, SeedMethod_sp> SeedsByMethod;
+  std::map<std::string, SeedFile_sp> SeedsByFile;
 
   std::set<VPoint_sp> AllVPoints;
   std::map<AddressType, VPointAddress_sp> VPointsByAddress;
-  std::map<VirtualPointSymbol::SymbolType_sp, VPointSymbol_sp> VPointsBySymbol;
+  // Keyed by the symbol's address
+  std::map<AddressType, VPointSymbol_sp> VPointsBySymbol;
+  std::map<AddressType, VPointLine_sp> VPointsByLine;
+  std::map<AddressType, VPointFunction_sp> VPointsByFunction;
 
   // These two MUST stay in sync
   std::map<Seed_sp, std::set<VPoint_sp>> SeedToVPoints;
@@ -217,6 +323,10 @@ class BreakpointsControl {
   std::shared_ptr<MachProcess> Process;
 
 private:
+  // Whether Address is in an executable segment of some image, a trap
+  // anywhere else corrupts whatever is there
+  bool IsCode(AddressType Address);
+
   APoint_sp GetOrCreateActualBreakpoint(AddressType Address);
   APoint_sp GetActualBreakpointAtAddress(AddressType Address);
   void TryDestroyActualBreakpoint(APoint_sp &);
@@ -227,14 +337,43 @@ private:
   bool TryInstantiateSeedSymbolName(const SeedSymbolName_sp &);
   void DestroySeedSymbolName(const SeedSymbolName_sp &);
 
+  bool TryInstantiateSeedRegex(const SeedRegex_sp &);
+  void DestroySeedRegex(const SeedRegex_sp &);
+
+  bool TryInstantiateSeedLine(const SeedLine_sp &);
+  void DestroySeedLine(const SeedLine_sp &);
+
+  bool TryInstantiateSeedClass(const SeedClass_sp &);
+  void DestroySeedClass(const SeedClass_sp &);
+
+  bool TryInstantiateSeedMethod(const SeedMethod_sp &);
+  void DestroySeedMethod(const SeedMethod_sp &);
+
+  bool TryInstantiateSeedFile(const SeedFile_sp &);
+  void DestroySeedFile(const SeedFile_sp &);
+
+  bool InstantiateFunctions(const Seed_sp &, uint64_t Slide,
+                            const std::vector<DwarfFunction> &Functions);
+  void DestroyFunctions(const Seed_sp &);
+
   bool TryToInstantiatePendingSeed(const Seed_sp &);
   void DestroySeed(const Seed_sp &);
 
   void TryToInstantiateAllPendingSeeds();
 
+  // Drops the a-points and v-points in the code of an unloaded image
+  void ForgetImage(const std::shared_ptr<MachImage64> &Image);
+
 public:
   void Attach(std::shared_ptr<MachProcess> Process);
 
+  // Catches up with the images dyld loaded and unloaded since the last call,
+  // which the breakpoint on its debugger notification does. Breakpoints of
+  // unloaded images are dropped and their seeds, unless other images keep
+  // them, pend again. Pending seeds, regex ones included, are then tried on
+  // what is loaded.
+  void UpdateImages();
+
   // IsProcessValid flag is used to force the controller to clean-up disable
   // breakpoints.  Normally when this method is called the process is dead and
   // there is no way to access its memory so we cannot remove breakpoints at
@@ -249,6 +388,27 @@ public:
                                  BreakpointBySymbolNameCallback_t);
   bool RemoveBreakpointBySymbolName(std::string SymbolName);
 
+  // Every defined function whose name matches the pattern, in the images
+  // loaded now and later on
+  bool AddBreakpointByRegex(std::string Pattern, bool IsGlob,
+                            BreakpointBySymbolNameCallback_t);
+  bool RemoveBreakpointByRegex(std::string Pattern);
+
+  bool AddBreakpointByLine(std::string File, unsigned Line,
+                           BreakpointByLineCallback_t);
+  bool RemoveBreakpointByLine(std::string File, unsigned Line);
+
+  bool AddBreakpointByClass(std::string ClassName,
+                            BreakpointBySymbolNameCallback_t);
+  bool RemoveBreakpointByClass(std::string ClassName);
+
+  bool AddBreakpointByMethod(std::string MethodName,
+                             BreakpointBySymbolNameCallback_t);
+  bool RemoveBreakpointByMethod(std::string MethodName);
+
+  bool AddBreakpointByFile(std::string File, BreakpointBySymbolNameCallback_t);
+  bool RemoveBreakpointByFile(std::string File);
+
   // These two methods must be called in sequance. CheckBreakpoints modifies
   // program counter so it points at he breakpoint that stopped program
   // execution. StepOverCurrentBreakpointIfAny steps over it without removing.
@@ -0,0 +1,162 @@
+#ifndef BYTEVIEW_HPP_QM4RZ7XN
+#define BYTEVIEW_HPP_QM4RZ7XN
+
+// Std
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace mad {
+
+// A read-only, bounds-checked window over a contiguous range of bytes, e.g. a
+// memory-mapped file. It never owns the bytes, so whoever provided the range
+// must keep it alive for as long as the view and every string_view it handed
+// out are in use.
+//
+// Besides random access it provides the same small positioning interface as
+// StreamInput, so MachOParser can be instantiated with either of them. Once an
+// out-of-bounds access happens the view is marked as failed, much like an
+// std::istream with its failbit set.
+class ByteView {
+  const char *Data;
+  uint64_t Size;
+  uint64_t Position;
+  bool Failed;
+
+public:
+  // Strings are returned in place, no copies are made
+  using String_t = std::string_view;
+
+public:
+  ByteView() : Data(nullptr), Size(0), Position(0), Failed(false) {}
+  ByteView(const void *Data, uint64_t Size)
+      : Data(static_cast<const char *>(Data)), Size(Size), Position(0),
+        Failed(false) {}
+
+  const char *GetData() const { return Data; }
+  uint64_t GetSize() const { return Size; }
+  bool IsEmpty() const { return Size == 0; }
+
+  // Overflow-safe check that [Offset, Offset + Length) is within the view
+  bool Contains(uint64_t Offset, uint64_t Length) const {
+    return Offset <= Size && Length <= Size - Offset;
+  }
+
+  // Returns an empty view if the requested range does not fit
+  ByteView Slice(uint64_t Offset, uint64_t Length) const {
+    if (!Contains(Offset, Length)) {
+      return ByteView();
+    }
+    return ByteView(Data + Offset, Length);
+  }
+
+  // Pointer to the Length bytes at Offset, or nullptr if they do not fit
+  const char *At(uint64_t Offset, uint64_t Length = 1) const {
+    return Contains(Offset, Length) ? Data + Offset : nullptr;
+  }
+
+  // Mach-O structures are not guaranteed to be naturally aligned within the
+  // file, so they are copied out instead of being dereferenced in place.
+  template <typename S> bool ReadAt(uint64_t Offset, S &Thing) const {
+    if (!Contains(Offset, sizeof(S))) {
+      return false;
+    }
+    memcpy(&Thing, Data + Offset, sizeof(S));
+    return true;
+  }
+
+  // Decodes an unsigned LEB128 number at Offset and moves Offset past it.
+  // Fails on truncated input and on numbers that do not fit 64 bits.
+  bool ReadULEB128At(uint64_t &Offset, uint64_t &Value) const {
+    uint64_t Result = 0;
+    unsigned Shift = 0;
+    for (uint64_t Cursor = Offset; Cursor < Size; ++Cursor) {
+      uint8_t Byte = Data[Cursor];
+      uint64_t Slice = Byte & 0x7f;
+      if (Shift >= 64 ? Slice != 0 : (Slice << Shift) >> Shift != Slice) {
+        return false;
+      }
+      if (Shift < 64) {
+        Result |= Slice << Shift;
+      }
+      Shift += 7;
+      if (!(Byte & 0x80)) {
+        Offset = Cursor + 1;
+        Value = Result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Signed counterpart of ReadULEB128At, the last byte's bit 6 is the sign
+  bool ReadSLEB128At(uint64_t &Offset, int64_t &Value) const {
+    uint64_t Result = 0;
+    unsigned Shift = 0;
+    for (uint64_t Cursor = Offset; Cursor < Size; ++Cursor) {
+      uint8_t Byte = Data[Cursor];
+      if (Shift < 64) {
+        Result |= uint64_t(Byte & 0x7f) << Shift;
+      }
+      Shift += 7;
+      if (!(Byte & 0x80)) {
+        if (Shift < 64 && (Byte & 0x40)) {
+          Result |= ~uint64_t(0) << Shift;
+        }
+        Offset = Cursor + 1;
+        Value = static_cast<int64_t>(Result);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // NUL terminated string at Offset. If there is no terminator within the view
+  // the string is cut at the view end.
+  std::string_view StringAt(uint64_t Offset) const {
+    if (Offset >= Size) {
+      return {};
+    }
+    auto Start = Data + Offset;
+    auto End = static_cast<const char *>(memchr(Start, 0, Size - Offset));
+    return std::string_view(Start, End ? End - Start : Size - Offset);
+  }
+
+  //----------------------------------------------------------------------------
+  // Stream-like interface
+  //----------------------------------------------------------------------------
+  bool Good() const { return !Failed; }
+  uint64_t Tell() const { return Position; }
+
+  bool Seek(uint64_t Offset) {
+    if (Offset > Size) {
+      Failed = true;
+    }
+    Position = Offset;
+    return Good();
+  }
+
+  bool Read(void *Out, uint64_t Length) {
+    if (Failed || !Contains(Position, Length)) {
+      Failed = true;
+      return false;
+    }
+    memcpy(Out, Data + Position, Length);
+    Position += Length;
+    return true;
+  }
+
+  std::string_view ReadNTString() {
+    if (Failed || Position >= Size) {
+      Failed = true;
+      return {};
+    }
+    auto Result = StringAt(Position);
+    Position += Result.size() + 1;
+    return Result;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: BYTEVIEW_HPP_QM4RZ7XN */
@@ -0,0 +1,95 @@
+#ifndef CHAINEDFIXUPS_HPP_V8QK3NJD
+#define CHAINEDFIXUPS_HPP_V8QK3NJD
+
+// System
+#include <mach-o/fixup-chains.h>
+
+// Std
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+
+namespace mad {
+
+// LC_DYLD_CHAINED_FIXUPS, the rebases and binds of images linked for macOS
+// 12 and later. Instead of opcodes in __LINKEDIT every pointer dyld has to
+// fix up holds, in the file, either its target or an import index along
+// with the distance to the next such pointer on the same page. The load
+// command's data only says where the first pointer of every page is, how the
+// pointers of a segment are encoded and what the imports are.
+//
+// Chains are walked once, over the image's file, and every fixup is kept by
+// its unslid address. The value dyld put at an address is then a local
+// computation: the target plus the slide for a rebase, the address of the
+// import plus the addend for a bind. Authenticated arm64e pointers are
+// computed without their signature, i.e. the way ptrauth_strip sees them.
+class ChainedFixups {
+public:
+  struct Import {
+    // One of BIND_SPECIAL_DYLIB_* or the index of the LC_LOAD_DYLIB, from 1
+    int32_t LibraryOrdinal;
+    bool IsWeak;
+    std::string_view Name;
+    int64_t Addend;
+  };
+
+  struct Fixup {
+    // Unslid address of the pointer
+    uint64_t Address;
+    // Unslid target of a rebase, index of the import of a bind
+    uint64_t Target;
+    // Added to the address of the import
+    int64_t Addend;
+    // Top byte of a rebased pointer, e.g. a tag
+    uint8_t High8;
+    bool IsBind;
+    bool IsAuth;
+
+    // What dyld writes for a rebase
+    uint64_t GetRebased(uint64_t Slide) const {
+      return (uint64_t(High8) << 56) | (Target + Slide);
+    }
+  };
+
+private:
+  std::vector<Import> Imports;
+  // Sorted by Address
+  std::vector<Fixup> Fixups;
+
+private:
+  bool ReadImports(ByteView Data, const dyld_chained_fixups_header &Header);
+  bool ReadSegment(ByteView Data, uint64_t Offset, uint64_t BaseAddress,
+                   ByteView Segment);
+  bool ReadChain(ByteView Segment, uint64_t Offset, uint64_t Address,
+                 uint16_t Format, uint64_t BaseAddress, uint64_t PageEnd,
+                 uint32_t MaxValidPointer);
+
+public:
+  ChainedFixups() {}
+
+  // Data is what the load command points to. BaseAddress is the unslid
+  // address of the mach header, Segments are the file contents of every
+  // segment in the order of their load commands.
+  ChainedFixups(ByteView Data, uint64_t BaseAddress,
+                const std::vector<ByteView> &Segments);
+
+  bool IsEmpty() const { return Fixups.empty() && Imports.empty(); }
+  size_t GetSize() const { return Fixups.size(); }
+  const std::vector<Fixup> &GetFixups() const { return Fixups; }
+  const std::vector<Import> &GetImports() const { return Imports; }
+
+  // Null if the index is not that of an import
+  const Import *GetImport(uint64_t Index) const {
+    return Index < Imports.size() ? &Imports[Index] : nullptr;
+  }
+
+  // The fixup of the pointer at the unslid Address
+  bool Lookup(uint64_t Address, Fixup &Found) const;
+};
+
+} // namespace mad
+
+#endif /* end of include guard: CHAINEDFIXUPS_HPP_V8QK3NJD */
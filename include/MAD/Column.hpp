@@ -0,0 +1,89 @@
+#ifndef COLUMN_HPP_W2LZ7RQA
+#define COLUMN_HPP_W2LZ7RQA
+
+// Std
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace mad {
+
+// A contiguous array of plain values that either owns them or views values
+// that live elsewhere, e.g. in a mapped index file. Only owned values may be
+// written to.
+template <typename T> class Column {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "Columns are written to and mapped from files as is");
+
+  std::vector<T> Own;
+  // Keeps viewed values alive, unless their storage outlives the column
+  std::shared_ptr<const void> Owner;
+  const T *Data;
+  size_t Size;
+
+public:
+  Column() : Data(nullptr), Size(0) {}
+
+  Column(const Column &Other)
+      : Own(Other.Own), Owner(Other.Owner),
+        Data(Other.IsView() ? Other.Data : Own.data()), Size(Other.Size) {}
+
+  // Moving a vector keeps its buffer, so Data stays valid either way
+  Column(Column &&Other)
+      : Own(std::move(Other.Own)), Owner(std::move(Other.Owner)),
+        Data(Other.Data), Size(Other.Size) {
+    Other.Data = nullptr;
+    Other.Size = 0;
+  }
+
+  Column &operator=(Column Other) {
+    std::swap(Own, Other.Own);
+    std::swap(Owner, Other.Owner);
+    std::swap(Data, Other.Data);
+    std::swap(Size, Other.Size);
+    return *this;
+  }
+
+  bool IsView() const { return Data && Data != Own.data(); }
+  bool IsEmpty() const { return !Size; }
+  size_t GetSize() const { return Size; }
+  const T *GetData() const { return Data; }
+
+  const T *begin() const { return Data; }
+  const T *end() const { return Data + Size; }
+
+  const T &operator[](size_t Index) const { return Data[Index]; }
+
+  T &operator[](size_t Index) {
+    assert(!IsView() && "Views are read-only");
+    return Own[Index];
+  }
+
+  void Assign(size_t Count, const T &Value) {
+    Own.assign(Count, Value);
+    Owner = nullptr;
+    Data = Own.data();
+    Size = Count;
+  }
+
+  void Adopt(std::vector<T> &&Values) {
+    Own = std::move(Values);
+    Owner = nullptr;
+    Data = Own.data();
+    Size = Own.size();
+  }
+
+  void View(const T *Values, size_t Count,
+            std::shared_ptr<const void> Storage = nullptr) {
+    Own = std::vector<T>();
+    Owner = std::move(Storage);
+    Data = Values;
+    Size = Count;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: COLUMN_HPP_W2LZ7RQA */
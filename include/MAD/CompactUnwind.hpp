@@ -0,0 +1,78 @@
+#ifndef COMPACTUNWIND_HPP_H2WD8RNE
+#define COMPACTUNWIND_HPP_H2WD8RNE
+
+// System
+#include <mach-o/compact_unwind_encoding.h>
+
+// Std
+#include <cstdint>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/UnwindPlan.hpp"
+
+namespace mad {
+
+// __TEXT,__unwind_info, what ld64 makes of the unwind info of every function
+// of an image. A first level index of function offsets points to pages of
+// second level entries, either regular, i.e. offset and encoding pairs, or
+// compressed, where an entry is a 24 bit offset from the page's first
+// function and an 8 bit index into the common or the page's own encodings.
+// A lookup is two binary searches.
+//
+// An encoding describes a whole function in 32 bits: a frame set up with
+// rbp, a frameless one of a known size, or a pointer to the FDE in
+// __eh_frame for anything that does not fit. Offsets are relative to the
+// mach header.
+class CompactUnwind {
+public:
+  struct Entry {
+    // Slid [Start, End) of the function
+    uint64_t Start;
+    uint64_t End;
+    compact_unwind_encoding_t Encoding;
+  };
+
+private:
+  ByteView Data;
+  // Slid address of the mach header
+  uint64_t Base;
+  unwind_info_section_header Header;
+
+private:
+  bool ReadEncoding(
+      uint64_t PageOffset,
+      const unwind_info_compressed_second_level_page_header &Page,
+      uint32_t Index, uint32_t &Encoding) const;
+
+public:
+  CompactUnwind() : Base(0), Header() {}
+  CompactUnwind(ByteView Data, uint64_t Base);
+
+  bool IsEmpty() const { return Data.IsEmpty(); }
+
+  // The function that contains Address, and how to unwind it. Functions the
+  // linker had nothing on have a zero encoding.
+  bool Lookup(uint64_t Address, Entry &Found) const;
+
+  static bool IsDwarf(uint32_t Encoding) {
+    return (Encoding & UNWIND_X86_64_MODE_MASK) == UNWIND_X86_64_MODE_DWARF;
+  }
+  // Offset of the FDE in __eh_frame
+  static uint32_t GetDwarfOffset(uint32_t Encoding) {
+    return Encoding & UNWIND_X86_64_DWARF_SECTION_OFFSET;
+  }
+
+  // Frameless functions with too big a stack keep its size in the immediate
+  // of the prologue's sub instruction, which is at this address
+  static bool IsIndirect(const Entry &E, uint64_t &SizeAddress);
+
+  // Rows of an rbp frame or a frameless function. IndirectSize is the
+  // immediate IsIndirect points to, if it does.
+  static bool GetPlan(const Entry &E, UnwindPlan &Plan,
+                      uint32_t IndirectSize = 0);
+};
+
+} // namespace mad
+
+#endif /* end of include guard: COMPACTUNWIND_HPP_H2WD8RNE */
@@ -2,7 +2,14 @@
 #define DEBUG_HPP_2BQNSAUZ
 
 #include <iostream>
+
+#ifdef __APPLE__
 #include <mach/kern_return.h>
+#else
+// File format readers do not depend on Mach and are built and tested on other
+// systems too
+typedef int kern_return_t;
+#endif
 
 class OutPrinter {
 public:
@@ -0,0 +1,84 @@
+#ifndef DEBUGMAP_HPP_R5KX9WQD
+#define DEBUGMAP_HPP_R5KX9WQD
+
+// Std
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/SymbolStore.hpp"
+
+namespace mad {
+
+// The debug map ld64 leaves in the symbol table of an image that was not
+// stripped. It is a run of STABS per object file the image was linked from:
+//
+//   N_SO     /work/src/        directory of the source file
+//   N_SO     lines.c           the source file, n_value is its first address
+//   N_OSO    /work/lines.o     the object, n_value is its modification time
+//   N_BNSYM                    for each function
+//   N_FUN    _main             n_value is the address
+//   N_FUN                      n_value is the size
+//   N_ENSYM
+//   N_SO                       end of the object file's run
+//
+// The index keeps a unit per run, with the functions of each unit together
+// and sorted, so all functions of a source file are a single range. The
+// object files still have the DWARF a dSYM would have had, units point to
+// them so that it can be loaded once needed.
+//
+// Addresses are unslid. Function names and object paths point into the
+// store's string table, the store must outlive the map.
+class DebugMap {
+public:
+  struct Function {
+    uint64_t Address;
+    uint64_t Size;
+    std::string_view Name;
+  };
+
+  struct Unit {
+    // Directory and file name of the N_SO pair joined
+    std::string Source;
+    std::string_view ObjectFile;
+    // The object is stale if its time differs
+    uint64_t ModificationTime = 0;
+    uint32_t FirstFunction = 0;
+    uint32_t FunctionCount = 0;
+  };
+
+private:
+  std::vector<Unit> Units;
+  std::vector<Function> Functions;
+  // Indexes into Functions sorted by address
+  std::vector<uint32_t> ByAddress;
+
+public:
+  DebugMap() {}
+
+  // One pass over the symbols, everything but STABS is skipped
+  void Build(const SymbolStore &Store);
+
+  bool IsEmpty() const { return Units.empty(); }
+  size_t GetUnitCount() const { return Units.size(); }
+  const std::vector<Unit> &GetUnits() const { return Units; }
+
+  // The first of the unit's FunctionCount functions
+  const Function *GetFunctions(const Unit &U) const {
+    return Functions.data() + U.FirstFunction;
+  }
+
+  // Units compiled from File, matched like the line table does it
+  bool FindSource(std::string_view File,
+                  std::vector<const Unit *> &Found) const;
+
+  // The function that contains Address and the unit it comes from
+  bool LookupAddress(uint64_t Address, const Unit *&U,
+                     const Function *&F) const;
+};
+
+} // namespace mad
+
+#endif /* end of include guard: DEBUGMAP_HPP_R5KX9WQD */
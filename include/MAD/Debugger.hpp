@@ -13,6 +13,7 @@
 #include "MAD/MachMemory.hpp"
 #include "MAD/MachProcess.hpp"
 #include "MAD/Prompt.hpp"
+#include "MAD/Unwinder.hpp"
 
 namespace mad {
 
@@ -22,6 +23,7 @@ private:
   std::string Exe;
   std::shared_ptr<MachProcess> Process;
   BreakpointsControl BreakpointsCtrl;
+  Unwinder Unwind;
 
 private:
   void HandleProcessContinue();
@@ -29,9 +31,14 @@ private:
   void HandleProcessStop();
 
   void HandleBreakpointSet(const std::shared_ptr<PromptCmdBreakpointSet> &BPS);
+  void
+  HandleThreadBacktrace(const std::shared_ptr<PromptCmdThreadBacktrace> &BT);
   BreakpointCallbackReturn HandleSymbolNameBreakpoint(std::string);
   BreakpointBySymbolNameCallback_t HandleSymbolNameBreakpoint_l =
       [this](const auto &a) { return HandleSymbolNameBreakpoint(a); };
+  BreakpointCallbackReturn HandleLineBreakpoint(std::string, unsigned);
+  BreakpointByLineCallback_t HandleLineBreakpoint_l =
+      [this](const auto &a, auto b) { return HandleLineBreakpoint(a, b); };
 
 public:
   Debugger() : Prompt("(mad) "), Process(nullptr) {}
@@ -0,0 +1,97 @@
+#ifndef DEMANGLEDNAMEINDEX_HPP_T4NW7XRC
+#define DEMANGLEDNAMEINDEX_HPP_T4NW7XRC
+
+// Std
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/SymbolStore.hpp"
+
+namespace mad {
+
+// Parts of a qualified C++ function name, e.g. of
+// geo::Circle::area(double) const. Scope holds namespaces and classes alike,
+// the mangling does not tell them apart either. Template arguments of the
+// function itself and its return type are in neither part.
+struct QualifiedName {
+  // geo::Circle
+  std::string_view Scope;
+  // area
+  std::string_view Basename;
+  // (double) const, empty if not given
+  std::string_view Parameters;
+
+  // Splits a demangled name, or what a user typed, e.g. Circle::area. False
+  // if there is no basename.
+  static bool Split(std::string_view Name, QualifiedName &Parts);
+
+  // Whether the function is the one Query, split the same way, names: the
+  // same basename, a scope that ends with the query's components and, if
+  // the query has them, the same parameters
+  bool Matches(const QualifiedName &Query) const;
+};
+
+// Demangled Itanium ABI function name of a symbol, split into its parts once
+class DemangledName {
+  std::string Full;
+  // Parts are kept as offsets into Full, so that moves do not break them
+  uint32_t ScopeBegin;
+  uint32_t ScopeSize;
+  uint32_t BasenameBegin;
+  uint32_t BasenameSize;
+  uint32_t ParametersBegin;
+
+public:
+  DemangledName()
+      : ScopeBegin(0), ScopeSize(0), BasenameBegin(0), BasenameSize(0),
+        ParametersBegin(0) {}
+
+  // Takes a name as the symbol table has it, i.e. with the extra leading
+  // underscore, e.g. __ZN3geo6Circle4areaEd. False for anything but a
+  // function, e.g. data, vtables, guard variables or C names.
+  bool Demangle(std::string_view Mangled);
+
+  const std::string &GetFull() const { return Full; }
+
+  QualifiedName GetParts() const {
+    std::string_view View = Full;
+    return {View.substr(ScopeBegin, ScopeSize),
+            View.substr(BasenameBegin, BasenameSize),
+            View.substr(ParametersBegin)};
+  }
+};
+
+// Demangled names of the C++ functions of a symbol store, by basename.
+//
+// Demangling is slow, a few microseconds per name, so a store is demangled
+// only when first asked, on the shared ThreadPool if it is big, and the parts
+// of every name are kept. After that finding every overload of Foo::bar, in
+// a method breakpoint, or naming a frame of a backtrace costs a search.
+class DemangledNameIndex {
+  // Rows of the store that are C++ functions, ascending, and their names
+  std::vector<uint32_t> Rows;
+  std::vector<DemangledName> Names;
+  // Upper half of the basename's hash << 32 | position in Names, sorted
+  std::vector<uint64_t> ByBasename;
+
+public:
+  // Demangles every defined function of the store
+  void Build(const SymbolStore &Store);
+
+  size_t GetSize() const { return Names.size(); }
+
+  // Appends the rows, ascending, of the functions Query names, e.g. bar for
+  // every overload of any bar, Foo::bar for those of classes or namespaces
+  // named Foo, or Foo::bar(int) for that one only
+  void Find(std::string_view Query, std::vector<uint32_t> &Result) const;
+
+  // Null if the symbol at Row is not a C++ function
+  const DemangledName *GetName(uint32_t Row) const;
+};
+
+} // namespace mad
+
+#endif /* end of include guard: DEMANGLEDNAMEINDEX_HPP_T4NW7XRC */
@@ -0,0 +1,255 @@
+#ifndef DWARF_HPP_J3XH8PQE
+#define DWARF_HPP_J3XH8PQE
+
+// Std
+#include <cstdint>
+#include <string_view>
+
+// MAD
+#include "MAD/ByteView.hpp"
+
+// Bits shared by the DWARF readers. Only the constants they use are here, the
+// names are the ones from the standard.
+namespace mad {
+
+// Tags
+enum : uint64_t {
+  DW_TAG_class_type = 0x02,
+  DW_TAG_formal_parameter = 0x05,
+  DW_TAG_compile_unit = 0x11,
+  DW_TAG_structure_type = 0x13,
+  DW_TAG_union_type = 0x17,
+  DW_TAG_subprogram = 0x2e,
+};
+
+// Attributes
+enum : uint64_t {
+  DW_AT_sibling = 0x01,
+  DW_AT_name = 0x03,
+  DW_AT_low_pc = 0x11,
+  DW_AT_abstract_origin = 0x31,
+  DW_AT_declaration = 0x3c,
+  DW_AT_specification = 0x47,
+  DW_AT_object_pointer = 0x64,
+  DW_AT_linkage_name = 0x6e,
+  DW_AT_str_offsets_base = 0x72,
+  DW_AT_addr_base = 0x73,
+  DW_AT_MIPS_linkage_name = 0x2007,
+};
+
+// Attribute forms
+enum : uint64_t {
+  DW_FORM_addr = 0x01,
+  DW_FORM_block2 = 0x03,
+  DW_FORM_block4 = 0x04,
+  DW_FORM_data2 = 0x05,
+  DW_FORM_data4 = 0x06,
+  DW_FORM_data8 = 0x07,
+  DW_FORM_string = 0x08,
+  DW_FORM_block = 0x09,
+  DW_FORM_block1 = 0x0a,
+  DW_FORM_data1 = 0x0b,
+  DW_FORM_flag = 0x0c,
+  DW_FORM_sdata = 0x0d,
+  DW_FORM_strp = 0x0e,
+  DW_FORM_udata = 0x0f,
+  DW_FORM_ref_addr = 0x10,
+  DW_FORM_ref1 = 0x11,
+  DW_FORM_ref2 = 0x12,
+  DW_FORM_ref4 = 0x13,
+  DW_FORM_ref8 = 0x14,
+  DW_FORM_ref_udata = 0x15,
+  DW_FORM_indirect = 0x16,
+  DW_FORM_sec_offset = 0x17,
+  DW_FORM_exprloc = 0x18,
+  DW_FORM_flag_present = 0x19,
+  DW_FORM_strx = 0x1a,
+  DW_FORM_addrx = 0x1b,
+  DW_FORM_ref_sup4 = 0x1c,
+  DW_FORM_strp_sup = 0x1d,
+  DW_FORM_data16 = 0x1e,
+  DW_FORM_line_strp = 0x1f,
+  DW_FORM_ref_sig8 = 0x20,
+  DW_FORM_implicit_const = 0x21,
+  DW_FORM_loclistx = 0x22,
+  DW_FORM_rnglistx = 0x23,
+  DW_FORM_ref_sup8 = 0x24,
+  DW_FORM_strx1 = 0x25,
+  DW_FORM_strx2 = 0x26,
+  DW_FORM_strx3 = 0x27,
+  DW_FORM_strx4 = 0x28,
+  DW_FORM_addrx1 = 0x29,
+  DW_FORM_addrx2 = 0x2a,
+  DW_FORM_addrx3 = 0x2b,
+  DW_FORM_addrx4 = 0x2c,
+  DW_FORM_GNU_addr_index = 0x1f01,
+  DW_FORM_GNU_str_index = 0x1f02,
+  DW_FORM_GNU_ref_alt = 0x1f20,
+  DW_FORM_GNU_strp_alt = 0x1f21,
+};
+
+// Unit types of version 5 unit headers
+enum : uint8_t {
+  DW_UT_compile = 0x01,
+  DW_UT_type = 0x02,
+  DW_UT_partial = 0x03,
+  DW_UT_skeleton = 0x04,
+  DW_UT_split_compile = 0x05,
+  DW_UT_split_type = 0x06,
+};
+
+// Values of __apple_* table entries
+enum : uint16_t {
+  DW_ATOM_die_offset = 0x01,
+  DW_ATOM_cu_offset = 0x02,
+  DW_ATOM_die_tag = 0x03,
+};
+
+// Values of .debug_names entries
+enum : uint64_t {
+  DW_IDX_compile_unit = 0x01,
+  DW_IDX_type_unit = 0x02,
+  DW_IDX_die_offset = 0x03,
+  DW_IDX_parent = 0x04,
+};
+
+// Call frame instructions, the first three keep their operand in the low six
+// bits of the opcode
+enum : uint8_t {
+  DW_CFA_advance_loc = 0x40,
+  DW_CFA_offset = 0x80,
+  DW_CFA_restore = 0xc0,
+  DW_CFA_nop = 0x00,
+  DW_CFA_set_loc = 0x01,
+  DW_CFA_advance_loc1 = 0x02,
+  DW_CFA_advance_loc2 = 0x03,
+  DW_CFA_advance_loc4 = 0x04,
+  DW_CFA_offset_extended = 0x05,
+  DW_CFA_restore_extended = 0x06,
+  DW_CFA_undefined = 0x07,
+  DW_CFA_same_value = 0x08,
+  DW_CFA_register = 0x09,
+  DW_CFA_remember_state = 0x0a,
+  DW_CFA_restore_state = 0x0b,
+  DW_CFA_def_cfa = 0x0c,
+  DW_CFA_def_cfa_register = 0x0d,
+  DW_CFA_def_cfa_offset = 0x0e,
+  DW_CFA_def_cfa_expression = 0x0f,
+  DW_CFA_expression = 0x10,
+  DW_CFA_offset_extended_sf = 0x11,
+  DW_CFA_def_cfa_sf = 0x12,
+  DW_CFA_def_cfa_offset_sf = 0x13,
+  DW_CFA_val_offset = 0x14,
+  DW_CFA_val_offset_sf = 0x15,
+  DW_CFA_val_expression = 0x16,
+  DW_CFA_GNU_args_size = 0x2e,
+  DW_CFA_GNU_negative_offset_extended = 0x2f,
+};
+
+// Pointer encodings of __eh_frame, the low nibble is the format and the high
+// one says what the value is relative to
+enum : uint8_t {
+  DW_EH_PE_absptr = 0x00,
+  DW_EH_PE_uleb128 = 0x01,
+  DW_EH_PE_udata2 = 0x02,
+  DW_EH_PE_udata4 = 0x03,
+  DW_EH_PE_udata8 = 0x04,
+  DW_EH_PE_sleb128 = 0x09,
+  DW_EH_PE_sdata2 = 0x0a,
+  DW_EH_PE_sdata4 = 0x0b,
+  DW_EH_PE_sdata8 = 0x0c,
+  DW_EH_PE_pcrel = 0x10,
+  DW_EH_PE_textrel = 0x20,
+  DW_EH_PE_datarel = 0x30,
+  DW_EH_PE_funcrel = 0x40,
+  DW_EH_PE_aligned = 0x50,
+  DW_EH_PE_indirect = 0x80,
+  DW_EH_PE_omit = 0xff,
+};
+
+// Reads forward through a section and, like ByteView's stream interface,
+// fails for good on the first out of bounds read. Bind it to a slice that
+// ends with the unit being read, so that a damaged unit cannot make it read
+// into the next one.
+class DwarfCursor {
+  ByteView Data;
+  uint64_t Offset;
+  bool Failed;
+
+public:
+  DwarfCursor(ByteView Data, uint64_t Offset)
+      : Data(Data), Offset(Offset), Failed(false) {}
+
+  bool Good() const { return !Failed; }
+  uint64_t Tell() const { return Offset; }
+  bool IsAtEnd() const { return Failed || Offset >= Data.GetSize(); }
+
+  void Seek(uint64_t Where) {
+    Failed |= Where > Data.GetSize();
+    Offset = Where;
+  }
+
+  void Skip(uint64_t Length) {
+    Failed |= !Data.Contains(Offset, Length);
+    Offset += Failed ? 0 : Length;
+  }
+
+  template <typename S> S Read() {
+    S Thing = 0;
+    if (!Failed && Data.ReadAt(Offset, Thing)) {
+      Offset += sizeof(S);
+    } else {
+      Failed = true;
+    }
+    return Thing;
+  }
+
+  // Little-endian unsigned number of Size bytes, e.g. 3 for DW_FORM_strx3
+  uint64_t ReadSized(unsigned Size) {
+    uint64_t Value = 0;
+    for (unsigned i = 0; i < Size; ++i) {
+      Value |= uint64_t(Read<uint8_t>()) << (8 * i);
+    }
+    return Value;
+  }
+
+  // 4 or 8 bytes depending on the unit's format
+  uint64_t ReadOffset(bool Is64) {
+    return Is64 ? Read<uint64_t>() : Read<uint32_t>();
+  }
+
+  uint64_t ReadULEB128() {
+    uint64_t Value = 0;
+    Failed = Failed || !Data.ReadULEB128At(Offset, Value);
+    return Value;
+  }
+
+  int64_t ReadSLEB128() {
+    int64_t Value = 0;
+    Failed = Failed || !Data.ReadSLEB128At(Offset, Value);
+    return Value;
+  }
+
+  // Must be terminated within the data
+  std::string_view ReadString() {
+    auto Result = Data.StringAt(Offset);
+    Failed = Failed || Offset + Result.size() >= Data.GetSize();
+    Offset += Failed ? 0 : Result.size() + 1;
+    return Result;
+  }
+};
+
+// Units start with a 4 byte length, or with 0xffffffff followed by an 8 byte
+// one in 64-bit DWARF. Leaves the cursor past the length.
+inline uint64_t ReadDwarfUnitLength(DwarfCursor &C, bool &Is64) {
+  uint64_t Length = C.Read<uint32_t>();
+  Is64 = Length == 0xffffffff;
+  if (Is64) {
+    Length = C.Read<uint64_t>();
+  }
+  return Length;
+}
+
+} // namespace mad
+
+#endif /* end of include guard: DWARF_HPP_J3XH8PQE */
@@ -0,0 +1,102 @@
+#ifndef DWARFACCELTABLE_HPP_Q8RZ2KNC
+#define DWARFACCELTABLE_HPP_Q8RZ2KNC
+
+// Std
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/Dwarf.hpp"
+
+// Hashed name indexes of DWARF. Both kinds map a name to the .debug_info
+// offsets of the DIEs that carry it, so a lookup costs a hash, a bucket and
+// a few string compares, and nothing of .debug_info is read. The tables are
+// not copied, whoever provided them must keep them alive.
+namespace mad {
+
+// One of the tables ld64 and dsymutil emit, __apple_names, __apple_types,
+// __apple_objc or __apple_namespac. The header is checked once, lookups read
+// straight from the section.
+class AppleAccelTable {
+  struct Atom {
+    uint16_t Type;
+    uint16_t Form;
+  };
+
+  ByteView Table;
+  ByteView Strings;
+
+  uint32_t BucketCount = 0;
+  uint32_t HashCount = 0;
+  uint64_t BucketsOffset = 0;
+  uint64_t HashesOffset = 0;
+  uint64_t OffsetsOffset = 0;
+  uint32_t DieOffsetBase = 0;
+  std::vector<Atom> Atoms;
+  bool IsValid = false;
+
+public:
+  AppleAccelTable() {}
+  AppleAccelTable(ByteView Table, ByteView Strings);
+
+  bool IsEmpty() const { return !IsValid; }
+
+  static uint32_t Hash(std::string_view Name);
+
+  // Appends the offsets of every DIE named Name, false if there are none
+  bool Lookup(std::string_view Name, std::vector<uint64_t> &Offsets) const;
+};
+
+// DWARF 5 .debug_names. A linked binary has one name index for all of its
+// units, an object file one per unit, all of them are probed. Entries of
+// type units are skipped, they are not in .debug_info.
+class DebugNamesTable {
+  struct Abbreviation {
+    uint64_t Tag;
+    // Index attribute and its form
+    std::vector<std::pair<uint64_t, uint64_t>> Attributes;
+  };
+
+  struct NameIndex {
+    bool Is64;
+    uint32_t CompUnitCount;
+    uint32_t BucketCount;
+    uint32_t NameCount;
+    uint64_t CompUnitsOffset;
+    uint64_t BucketsOffset;
+    uint64_t HashesOffset;
+    uint64_t StringOffsetsOffset;
+    uint64_t EntryOffsetsOffset;
+    uint64_t EntryPoolOffset;
+    uint64_t End;
+    std::unordered_map<uint64_t, Abbreviation> Abbreviations;
+  };
+
+  ByteView Table;
+  ByteView Strings;
+  std::vector<NameIndex> Indexes;
+
+private:
+  bool ReadIndex(DwarfCursor &C, NameIndex &Index);
+  std::string_view GetName(const NameIndex &Index, uint32_t Number) const;
+  void ReadEntries(const NameIndex &Index, uint32_t Number,
+                   std::vector<uint64_t> &Offsets) const;
+
+public:
+  DebugNamesTable() {}
+  DebugNamesTable(ByteView Table, ByteView Strings);
+
+  bool IsEmpty() const { return Indexes.empty(); }
+
+  static uint32_t Hash(std::string_view Name);
+
+  // Appends the offsets of every DIE named Name, false if there are none
+  bool Lookup(std::string_view Name, std::vector<uint64_t> &Offsets) const;
+};
+
+} // namespace mad
+
+#endif /* end of include guard: DWARFACCELTABLE_HPP_Q8RZ2KNC */
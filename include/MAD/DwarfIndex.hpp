@@ -0,0 +1,69 @@
+#ifndef DWARFINDEX_HPP_W4NC7ELB
+#define DWARFINDEX_HPP_W4NC7ELB
+
+// Std
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/DwarfAccelTable.hpp"
+#include "MAD/DwarfInfo.hpp"
+
+namespace mad {
+
+struct DwarfFunction {
+  // Unslid
+  uint64_t Address;
+  // Linkage name where there is one, e.g. _ZN3geo6Circle4areaEv, the plain
+  // one otherwise, e.g. -[Shape draw]
+  std::string_view Name;
+};
+
+// Finds functions by what they belong to, through the accelerator tables of
+// a dSYM or an object file. Every lookup is a hash probe and only the DIEs it
+// turns up are read, .debug_info is never walked as a whole. Without a table
+// there is nothing to probe and lookups fail.
+//
+// The Apple tables are used where both kinds are present. .debug_names has no
+// equivalent of __apple_objc, so Objective-C classes are only found through
+// the Apple ones.
+class DwarfIndex {
+  DwarfInfo Info;
+  AppleAccelTable AppleNames;
+  AppleAccelTable AppleTypes;
+  AppleAccelTable AppleObjC;
+  DebugNamesTable Names;
+
+private:
+  bool LookupNames(std::string_view Name, std::vector<uint64_t> &Offsets);
+  bool LookupTypes(std::string_view Name, std::vector<uint64_t> &Offsets);
+  bool ReadDeclaration(const DwarfDie &Die, DwarfDie &Declaration);
+  void AddFunction(const DwarfDie &Die, const DwarfDie &Declaration,
+                   std::vector<DwarfFunction> &Functions);
+  void FindDefinitions(const DwarfDie &Declaration,
+                       std::vector<DwarfFunction> &Functions);
+
+public:
+  DwarfIndex() {}
+  DwarfIndex(const DwarfSections &Sections);
+
+  bool IsEmpty() const {
+    return Info.IsEmpty() || (AppleNames.IsEmpty() && Names.IsEmpty());
+  }
+
+  // Definitions of methods named Name, of any class. Name is the plain name,
+  // e.g. area, or a whole Objective-C one, e.g. -[Shape draw].
+  bool FindMethods(std::string_view Name,
+                   std::vector<DwarfFunction> &Functions);
+
+  // Definitions of the methods of a class, or of a struct. Class may be
+  // qualified, e.g. geo::Circle.
+  bool FindClassMethods(std::string_view Class,
+                        std::vector<DwarfFunction> &Functions);
+};
+
+} // namespace mad
+
+#endif /* end of include guard: DWARFINDEX_HPP_W4NC7ELB */
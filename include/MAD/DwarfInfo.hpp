@@ -0,0 +1,123 @@
+#ifndef DWARFINFO_HPP_T6GM2VWA
+#define DWARFINFO_HPP_T6GM2VWA
+
+// Std
+#include <cstdint>
+#include <map>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/Dwarf.hpp"
+
+namespace mad {
+
+// Whatever of __DWARF a reader may need, missing sections are empty
+struct DwarfSections {
+  ByteView Info;
+  ByteView Abbrev;
+  ByteView Str;
+  ByteView StrOffsets;
+  ByteView Addr;
+  ByteView LineStr;
+  ByteView AppleNames;
+  ByteView AppleTypes;
+  ByteView AppleObjC;
+  ByteView Names;
+};
+
+// The attributes of a DIE the debugger has a use for. Offsets are from the
+// start of .debug_info, 0 where the attribute is missing.
+struct DwarfDie {
+  uint64_t Offset = 0;
+  uint64_t Tag = 0;
+  bool HasChildren = false;
+  // Past the attributes, i.e. the first child or the next sibling
+  uint64_t End = 0;
+  uint64_t Sibling = 0;
+
+  std::string_view Name;
+  std::string_view LinkageName;
+  uint64_t LowPC = 0;
+  bool HasLowPC = false;
+  bool IsDeclaration = false;
+  bool HasObjectPointer = false;
+  uint64_t Specification = 0;
+  uint64_t AbstractOrigin = 0;
+};
+
+// Random access to the DIEs of .debug_info, versions 2 to 5. Nothing is read
+// up front but unit lengths. A DIE is read by its offset, which is what
+// accelerator tables hand out, along with the header and the root DIE of its
+// unit and the unit's abbreviations, all of them once.
+//
+// The sections are not copied, whoever provided them must keep them alive.
+class DwarfInfo {
+  struct AttributeSpec {
+    uint64_t Attribute;
+    uint64_t Form;
+    int64_t ImplicitConst;
+  };
+
+  struct Abbreviation {
+    uint64_t Code;
+    uint64_t Tag;
+    bool HasChildren;
+    std::vector<AttributeSpec> Specs;
+  };
+
+  using AbbreviationTable = std::vector<Abbreviation>;
+
+  struct Unit {
+    uint64_t Offset;
+    uint64_t End;
+    uint16_t Version = 0;
+    bool Is64 = false;
+    uint8_t AddressSize = 0;
+    uint64_t AbbrevOffset = 0;
+    uint64_t FirstDie = 0;
+    // Where DW_FORM_strx and DW_FORM_addrx indexes start, from the root DIE
+    uint64_t StrOffsetsBase = 0;
+    uint64_t AddrBase = 0;
+
+    bool IsHeaderRead = false;
+    bool IsHeaderGood = false;
+    const AbbreviationTable *Abbreviations = nullptr;
+
+    Unit(uint64_t Offset, uint64_t End) : Offset(Offset), End(End) {}
+  };
+
+  DwarfSections Sections;
+  std::vector<Unit> Units;
+  // Units may share a table, they are keyed by their .debug_abbrev offset
+  std::map<uint64_t, AbbreviationTable> Abbreviations;
+
+private:
+  Unit *GetUnit(uint64_t Offset);
+  bool ReadHeader(Unit &U);
+  const AbbreviationTable *ReadAbbreviations(uint64_t Offset);
+  bool ReadDie(Unit &U, uint64_t Offset, DwarfDie &Die);
+  bool ReadAttribute(Unit &U, DwarfCursor &C, const AttributeSpec &Spec,
+                     DwarfDie &Die);
+  bool SkipSubtree(Unit &U, uint64_t Offset, uint64_t &End);
+
+  std::string_view GetIndexedString(const Unit &U, uint64_t Index) const;
+  uint64_t GetIndexedAddress(const Unit &U, uint64_t Index) const;
+
+public:
+  DwarfInfo() {}
+  DwarfInfo(const DwarfSections &Sections);
+
+  bool IsEmpty() const { return Units.empty(); }
+  size_t GetUnitCount() const { return Units.size(); }
+
+  bool ReadDie(uint64_t Offset, DwarfDie &Die);
+
+  // Direct children of a DIE read with ReadDie, their subtrees are skipped
+  bool ReadChildren(const DwarfDie &Parent, std::vector<DwarfDie> &Children);
+};
+
+} // namespace mad
+
+#endif /* end of include guard: DWARFINFO_HPP_T6GM2VWA */
@@ -0,0 +1,132 @@
+#ifndef DWARFLINETABLE_HPP_R5NW8KCE
+#define DWARFLINETABLE_HPP_R5NW8KCE
+
+// Std
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/Dwarf.hpp"
+
+namespace mad {
+
+// A row of the line number matrix as handed out by lookups
+struct LineInfo {
+  // Slid the same way the table was, i.e. not at all; callers add the slide
+  uint64_t Address;
+  // Lives as long as the table does
+  std::string_view File;
+  uint32_t Line;
+  bool IsStatement;
+};
+
+// Address to source line mapping read from __DWARF,__debug_line, versions 2
+// to 5.
+//
+// Construction only walks the unit lengths. A unit's header and file table
+// are read the first time a lookup needs them and its line program is run at
+// most once, into a compact sorted list of rows per sequence. Looking up a
+// line decodes only units whose file table names the file, looking up an
+// address decodes every unit on first use, there is no .debug_aranges to
+// narrow it down.
+//
+// The sections are not copied, whoever provided them must keep them alive.
+class DwarfLineTable {
+  // Row flags
+  enum : uint8_t {
+    LT_ROW_STATEMENT = 1u << 0,
+    LT_ROW_END_SEQUENCE = 1u << 1,
+  };
+
+  struct Row {
+    // From the start of the sequence
+    uint32_t Offset;
+    uint32_t Line;
+    uint16_t File;
+    uint8_t Flags;
+  };
+
+  // A run of rows with ascending addresses, ended by an end_sequence row
+  struct Sequence {
+    uint64_t Start;
+    uint64_t End;
+    uint32_t Unit;
+    uint32_t FirstRow;
+    uint32_t RowCount;
+  };
+
+  struct Unit {
+    uint64_t Offset;
+    uint64_t End;
+    uint16_t Version = 0;
+    bool Is64 = false;
+    uint8_t MinInstructionLength = 1;
+    bool DefaultIsStatement = true;
+    int8_t LineBase = 0;
+    uint8_t LineRange = 0;
+    uint8_t OpcodeBase = 0;
+    std::vector<uint8_t> StandardOpcodeLengths;
+    uint64_t ProgramOffset = 0;
+
+    // Index 0 is the compilation directory and the primary source file
+    // starting with version 5. Before that it is not in the table, a path in
+    // the compilation directory is kept relative.
+    std::vector<std::string> Directories;
+    // Joined with their directories
+    std::vector<std::string> Files;
+
+    bool IsHeaderRead = false;
+    bool IsHeaderGood = false;
+    bool IsDecoded = false;
+    std::vector<Row> Rows;
+    uint32_t FirstSequence = 0;
+    uint32_t SequenceCount = 0;
+
+    Unit(uint64_t Offset, uint64_t End) : Offset(Offset), End(End) {}
+  };
+
+  ByteView DebugLine;
+  // .debug_line_str and .debug_str, version 5 file tables refer to both
+  ByteView LineStrings;
+  ByteView Strings;
+
+  std::vector<Unit> Units;
+  // Every decoded unit's sequences, each unit's kept together
+  std::vector<Sequence> Sequences;
+  // Indexes into Sequences sorted by start, built on first address lookup
+  std::vector<uint32_t> ByAddress;
+  bool IsAddressIndexBuilt;
+
+private:
+  bool ReadHeader(Unit &U);
+  bool ReadFileTable(Unit &U, DwarfCursor &C);
+  bool ReadEntryTable(Unit &U, DwarfCursor &C,
+                      std::vector<std::string> &Paths);
+  bool Decode(uint32_t Index);
+  void BuildAddressIndex();
+
+public:
+  DwarfLineTable() : IsAddressIndexBuilt(false) {}
+  DwarfLineTable(ByteView DebugLine, ByteView LineStrings = ByteView(),
+                 ByteView Strings = ByteView());
+
+  bool IsEmpty() const { return Units.empty(); }
+  size_t GetUnitCount() const { return Units.size(); }
+
+  // The row that covers Address
+  bool LookupAddress(uint64_t Address, LineInfo &Info);
+
+  // Addresses where code for Line of File starts. File matches a unit's path
+  // as a whole or by its trailing path components, so "main.c" and
+  // "src/main.c" both find "/work/src/main.c". If Line has no code the next
+  // line that has some is used, it is returned in ResolvedLine.
+  bool LookupLine(std::string_view File, uint32_t Line,
+                  std::vector<uint64_t> &Addresses, uint32_t &ResolvedLine);
+};
+
+} // namespace mad
+
+#endif /* end of include guard: DWARFLINETABLE_HPP_R5NW8KCE */
@@ -0,0 +1,73 @@
+#ifndef EHFRAME_HPP_P3VJ6YKC
+#define EHFRAME_HPP_P3VJ6YKC
+
+// Std
+#include <cstdint>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/Dwarf.hpp"
+#include "MAD/UnwindPlan.hpp"
+
+namespace mad {
+
+// __TEXT,__eh_frame, the DWARF call frame information of the functions
+// compact unwind cannot describe. It is a list of CIEs, each with the
+// instructions common to its functions, and FDEs, one per function, with the
+// rest of them. The instructions of a function are run once into rows for
+// all of its instructions.
+//
+// Compact unwind entries point straight at their FDEs. For everything else
+// there is an index of all FDEs sorted by address, built on first search.
+class EhFrame {
+  struct Cie {
+    uint64_t CodeAlign = 1;
+    int64_t DataAlign = 1;
+    uint64_t ReturnRegister = REG_X86_64_RIP;
+    uint8_t PointerEncoding = DW_EH_PE_absptr;
+    bool HasAugmentationData = false;
+    // Initial instructions
+    uint64_t Instructions = 0;
+    uint64_t InstructionsEnd = 0;
+  };
+
+  struct Fde {
+    uint64_t Start;
+    uint64_t End;
+    uint64_t Offset;
+  };
+
+  ByteView Data;
+  // Slid address of the section, pc-relative pointers are relative to it
+  uint64_t SectionAddress;
+  std::vector<Fde> Index;
+  bool IsIndexBuilt;
+
+private:
+  bool ReadPointer(DwarfCursor &C, uint8_t Encoding, uint64_t &Value) const;
+  bool ReadCie(uint64_t Offset, Cie &C) const;
+  bool ReadFde(uint64_t Offset, Cie &C, Fde &F, uint64_t &Instructions,
+               uint64_t &InstructionsEnd) const;
+  bool Execute(const Cie &C, uint64_t Offset, uint64_t End,
+               const UnwindRow &Initial, UnwindRow &Row,
+               UnwindPlan *Plan) const;
+  void BuildIndex();
+
+public:
+  EhFrame() : SectionAddress(0), IsIndexBuilt(false) {}
+  EhFrame(ByteView Data, uint64_t SectionAddress)
+      : Data(Data), SectionAddress(SectionAddress), IsIndexBuilt(false) {}
+
+  bool IsEmpty() const { return Data.IsEmpty(); }
+
+  // Rows of the FDE at Offset, what DWARF mode compact encodings point to
+  bool GetPlanAt(uint64_t Offset, UnwindPlan &Plan) const;
+
+  // Rows of the function that contains Address
+  bool GetPlan(uint64_t Address, UnwindPlan &Plan);
+};
+
+} // namespace mad
+
+#endif /* end of include guard: EHFRAME_HPP_P3VJ6YKC */
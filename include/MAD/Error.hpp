@@ -2,11 +2,14 @@
 #define ERROR_HPP_FCRLWDDW
 
 // System
+#ifdef __APPLE__
 #include <mach/mach.h>
+#endif
 #include <unistd.h>
 
 // Std
 #include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <string>
 
@@ -74,7 +77,11 @@ private:
     case ErrorFlavour::MAD:
       return MadErrorToString(Val);
     case ErrorFlavour::Mach:
+#ifdef __APPLE__
       return mach_error_string(Val);
+#else
+      return "";
+#endif
     case ErrorFlavour::POSIX:
       return std::strerror(Val);
     }
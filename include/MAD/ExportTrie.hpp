@@ -0,0 +1,138 @@
+#ifndef EXPORTTRIE_HPP_P2WK7DZA
+#define EXPORTTRIE_HPP_P2WK7DZA
+
+// System
+#include <mach-o/loader.h>
+
+// Std
+#include <cstdint>
+#include <string_view>
+
+// MAD
+#include "MAD/ByteView.hpp"
+
+namespace mad {
+
+// Read-only view of the exports trie dyld uses to bind symbols, pointed to by
+// either LC_DYLD_INFO(_ONLY) or LC_DYLD_EXPORTS_TRIE. Lookups walk the encoded
+// bytes in place, so the cost depends only on the length of the name and not
+// on the number of symbols the image has.
+//
+// Every node is:
+//   uleb128 terminal size
+//   terminal info, if the size is not zero
+//   uint8   children count
+//   for every child: NUL terminated edge label, uleb128 child node offset
+class ExportTrie {
+  ByteView Trie;
+
+public:
+  struct Export {
+    uint64_t Flags;
+    // Offset from the image's mach header, unless the export is absolute or
+    // re-exported
+    uint64_t Address;
+    // Resolver offset for EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER, library
+    // ordinal for EXPORT_SYMBOL_FLAGS_REEXPORT
+    uint64_t Other;
+    // Name in the other library, empty if it is the same
+    std::string_view ImportName;
+
+    uint64_t GetKind() const { return Flags & EXPORT_SYMBOL_FLAGS_KIND_MASK; }
+    bool IsReExport() const { return Flags & EXPORT_SYMBOL_FLAGS_REEXPORT; }
+    bool IsWeakDefinition() const {
+      return Flags & EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION;
+    }
+    bool IsStubAndResolver() const {
+      return Flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER;
+    }
+  };
+
+private:
+  bool ReadExport(uint64_t Offset, Export &Result) const {
+    Result = Export();
+    if (!Trie.ReadULEB128At(Offset, Result.Flags)) {
+      return false;
+    }
+    if (Result.IsReExport()) {
+      if (!Trie.ReadULEB128At(Offset, Result.Other)) {
+        return false;
+      }
+      Result.ImportName = Trie.StringAt(Offset);
+      return true;
+    }
+    if (!Trie.ReadULEB128At(Offset, Result.Address)) {
+      return false;
+    }
+    if (Result.IsStubAndResolver()) {
+      return Trie.ReadULEB128At(Offset, Result.Other);
+    }
+    return true;
+  }
+
+public:
+  ExportTrie() {}
+  ExportTrie(ByteView Trie) : Trie(Trie) {}
+
+  bool IsEmpty() const { return Trie.IsEmpty(); }
+
+  bool Lookup(std::string_view Name, Export &Result) const {
+    if (Trie.IsEmpty()) {
+      return false;
+    }
+
+    uint64_t Node = 0;
+    // A malformed trie may loop, a well-formed one never visits more nodes
+    // than it has bytes
+    for (uint64_t Visited = 0; Visited < Trie.GetSize(); ++Visited) {
+      uint64_t Cursor = Node;
+      uint64_t TerminalSize;
+      if (!Trie.ReadULEB128At(Cursor, TerminalSize)) {
+        return false;
+      }
+
+      if (Name.empty()) {
+        return TerminalSize && Trie.Contains(Cursor, TerminalSize) &&
+               ReadExport(Cursor, Result);
+      }
+
+      if (!Trie.Contains(Cursor, TerminalSize)) {
+        return false;
+      }
+      Cursor += TerminalSize;
+
+      auto Count = Trie.At(Cursor);
+      if (!Count) {
+        return false;
+      }
+      ++Cursor;
+
+      bool Found = false;
+      for (uint8_t i = 0; i < uint8_t(*Count) && !Found; ++i) {
+        auto Edge = Trie.StringAt(Cursor);
+        Cursor += Edge.size() + 1;
+        uint64_t Child;
+        if (!Trie.ReadULEB128At(Cursor, Child)) {
+          return false;
+        }
+        // Edges of a node never share a first character, so the first one
+        // that is a prefix of the rest of the name is the only candidate
+        if (Name.substr(0, Edge.size()) == Edge && !Edge.empty()) {
+          Name.remove_prefix(Edge.size());
+          Node = Child;
+          Found = true;
+        }
+      }
+
+      if (!Found) {
+        return false;
+      }
+    }
+
+    return false;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: EXPORTTRIE_HPP_P2WK7DZA */
@@ -0,0 +1,123 @@
+#ifndef FUNCTIONSTARTS_HPP_K8RV2MTC
+#define FUNCTIONSTARTS_HPP_K8RV2MTC
+
+// Std
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/Column.hpp"
+
+namespace mad {
+
+// Function boundaries of a single image decoded from LC_FUNCTION_STARTS. The
+// linker emits them for every function, so they are there even if the image
+// is stripped of its nlist entries.
+//
+// The load command data is a zero terminated list of ULEB128 deltas, the
+// first one relative to the start of __TEXT, i.e. to the mach header. Deltas
+// are never negative, so decoding yields an already sorted list. Starts are
+// kept as 32-bit offsets from the slid __TEXT address.
+class FunctionStarts {
+  uint64_t Base;
+  // Where the last function ends, there is no next start to tell
+  uint64_t Limit;
+  Column<uint32_t> Offsets;
+
+public:
+  FunctionStarts() : Base(0), Limit(0) {}
+
+  bool IsEmpty() const { return Offsets.IsEmpty(); }
+  size_t GetSize() const { return Offsets.GetSize(); }
+  uint64_t GetBase() const { return Base; }
+  uint64_t GetLimit() const { return Limit; }
+  const Column<uint32_t> &GetOffsets() const { return Offsets; }
+  uint64_t GetStart(size_t Index) const { return Base + Offsets[Index]; }
+
+  // End of the function at Index, the next function's start
+  uint64_t GetEnd(size_t Index) const {
+    return Index + 1 < Offsets.GetSize() ? GetStart(Index + 1) : Limit;
+  }
+
+  // Takes already decoded starts, e.g. mapped from an index file
+  void Assign(uint64_t TextAddress, uint64_t End, Column<uint32_t> Starts) {
+    Base = TextAddress;
+    Limit = End;
+    Offsets = std::move(Starts);
+  }
+
+  // TextAddress is the slid address of __TEXT
+  bool Decode(ByteView Data, uint64_t TextAddress) {
+    Base = TextAddress;
+    Limit = TextAddress;
+    Offsets = Column<uint32_t>();
+
+    std::vector<uint32_t> Starts;
+    // Every start takes at least a byte
+    Starts.reserve(Data.GetSize());
+
+    auto Cursor = reinterpret_cast<const uint8_t *>(Data.GetData());
+    auto Last = Cursor + Data.GetSize();
+    uint64_t Offset = 0;
+
+    while (Cursor < Last) {
+      uint64_t Delta = *Cursor & 0x7f;
+      if (*Cursor++ & 0x80) {
+        unsigned Shift = 7;
+        uint8_t Byte;
+        do {
+          if (Cursor == Last || Shift > 63) {
+            return false;
+          }
+          Byte = *Cursor++;
+          Delta |= uint64_t(Byte & 0x7f) << Shift;
+          Shift += 7;
+        } while (Byte & 0x80);
+      }
+
+      // Zero delta terminates the list, the rest is padding
+      if (!Delta) {
+        break;
+      }
+
+      if (Delta > std::numeric_limits<uint32_t>::max() - Offset) {
+        return false;
+      }
+      Offset += Delta;
+      Starts.push_back(Offset);
+    }
+
+    Starts.shrink_to_fit();
+    Offsets.Adopt(std::move(Starts));
+    return true;
+  }
+
+  // The last function runs up to End, normally the end of its section
+  void SetLimit(uint64_t End) { Limit = End; }
+
+  // Finds the function that contains Address
+  bool Lookup(uint64_t Address, uint64_t &Start, uint64_t &End) const {
+    if (Offsets.IsEmpty() || Address < Base ||
+        Address - Base > std::numeric_limits<uint32_t>::max()) {
+      return false;
+    }
+
+    uint32_t Offset = Address - Base;
+    auto It = std::upper_bound(Offsets.begin(), Offsets.end(), Offset);
+    if (It == Offsets.begin()) {
+      return false;
+    }
+
+    size_t Index = It - Offsets.begin() - 1;
+    Start = GetStart(Index);
+    End = GetEnd(Index);
+    return Address < End;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: FUNCTIONSTARTS_HPP_K8RV2MTC */
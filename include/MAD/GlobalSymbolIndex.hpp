@@ -0,0 +1,299 @@
+#ifndef GLOBALSYMBOLINDEX_HPP_M2JX6TDW
+#define GLOBALSYMBOLINDEX_HPP_M2JX6TDW
+
+// Std
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/StringTableIndex.hpp"
+#include "MAD/SymbolStore.hpp"
+
+namespace mad {
+
+// Defined symbols of every image loaded in the target, by name. One lookup
+// finds a name in all of the images instead of one lookup per image.
+//
+// A flat open addressing table, probed linearly like SymbolNameIndex, with a
+// slot per definition: a part of the name's hash, the image and the row of
+// the image's symbol store. Names stay in the images' string tables. Every
+// definition of a name is kept; they come out in the order their images were
+// added, i.e. the order dyld loaded them in, and in nlist order within an
+// image.
+//
+// Images are indexed on the first lookup after they are added, so an image
+// nobody searches in costs nothing, and the ones loaded later on are added
+// to the table as it is. Removed images leave tombstones behind, once they
+// take a quarter of the used slots, or removed images half of the positions,
+// the table is rebuilt without them and the positions of removed images are
+// given to the ones after.
+//
+// It also keeps the loaded images by install name, which ImportResolver binds
+// imports through.
+//
+// Image_t is a MachImage, or anything else with the same GetSymbolTable() and
+// GetInstallName().
+template <typename Image_t> class GlobalSymbolIndex {
+public:
+  struct Definition {
+    std::shared_ptr<Image_t> Image;
+    SymbolRef Symbol;
+  };
+
+private:
+  struct Slot {
+    // Upper half of the name's hash
+    uint32_t Tag;
+    // Position in Images plus one, zero if the slot is empty
+    uint32_t Image;
+    uint32_t Row;
+  };
+
+  // A definition of a removed image
+  static constexpr uint32_t Tombstone = ~0u;
+
+  // Null once removed
+  std::vector<std::shared_ptr<Image_t>> Images;
+  // Images from this position on are not in the table yet
+  size_t Indexed;
+  std::map<std::string, uint32_t, std::less<>> ImagesByInstallName;
+
+  std::vector<Slot> Slots;
+  uint64_t Mask;
+  // Definitions and tombstones
+  size_t Used;
+  size_t Tombstones;
+  // Null entries of Images
+  size_t Removed;
+
+private:
+  static uint64_t Hash(std::string_view Name) {
+    return StringTableIndex::Hash(Name);
+  }
+
+  static bool IsDefinition(const SymbolStore &Store, uint32_t Row) {
+    return (Store.Flags[Row] & (MO_SYMBOL_STAB | MO_SYMBOL_DEFINED)) ==
+               MO_SYMBOL_DEFINED &&
+           Store.NameLengths[Row];
+  }
+
+  void Insert(uint64_t Hash, uint32_t Image, uint32_t Row) {
+    auto Position = Hash & Mask;
+    while (Slots[Position].Image) {
+      Position = (Position + 1) & Mask;
+    }
+    Slots[Position] = {uint32_t(Hash >> 32), Image, Row};
+    ++Used;
+  }
+
+  // Keeps the table at most half full, dropping the tombstones on the way
+  void Reserve(size_t Count) {
+    if (!Slots.empty() && 2 * (Used + Count) <= Slots.size()) {
+      return;
+    }
+    Rehash(Count);
+  }
+
+  // Rebuilds the table with room for Count more definitions
+  void Rehash(size_t Count) {
+    // Probe order, thus the order of definitions, survives since live slots
+    // are reinserted in the order they were added in
+    std::vector<Slot> Live;
+    for (auto &S : Slots) {
+      if (S.Image && S.Image != Tombstone) {
+        Live.push_back(S);
+      }
+    }
+
+    uint64_t Size = 16;
+    while (Size < 2 * (Live.size() + Count)) {
+      Size *= 2;
+    }
+    Slots.assign(Size, Slot{0, 0, 0});
+    Mask = Size - 1;
+    Used = 0;
+    Tombstones = 0;
+
+    std::sort(Live.begin(), Live.end(), [](const Slot &A, const Slot &B) {
+      return A.Image != B.Image ? A.Image < B.Image : A.Row < B.Row;
+    });
+    for (auto &S : Live) {
+      auto &Store = GetStore(S.Image);
+      Insert(Hash(Store.GetName(S.Row)), S.Image, S.Row);
+    }
+  }
+
+  // Moves the images left down over the removed ones, keeping their order,
+  // and drops the tombstones
+  void Compact() {
+    std::vector<uint32_t> Positions(Images.size() + 1, 0);
+    std::vector<std::shared_ptr<Image_t>> Left;
+    size_t LeftIndexed = 0;
+    for (size_t i = 0; i < Images.size(); ++i) {
+      if (Images[i]) {
+        Left.push_back(std::move(Images[i]));
+        Positions[i + 1] = Left.size();
+        LeftIndexed += i < Indexed;
+      }
+    }
+    Images = std::move(Left);
+    Indexed = LeftIndexed;
+    Removed = 0;
+
+    for (auto &Name : ImagesByInstallName) {
+      Name.second = Positions[Name.second];
+    }
+    for (auto &S : Slots) {
+      if (S.Image && S.Image != Tombstone) {
+        S.Image = Positions[S.Image];
+      }
+    }
+    if (!Slots.empty()) {
+      Rehash(0);
+    }
+  }
+
+  const SymbolStore &GetStore(uint32_t Image) {
+    return Images[Image - 1]->GetSymbolTable().GetSymbols();
+  }
+
+  void IndexPending() {
+    for (; Indexed < Images.size(); ++Indexed) {
+      if (!Images[Indexed]) {
+        continue;
+      }
+      auto &Store = GetStore(Indexed + 1);
+      Reserve(Store.GetSize());
+      for (uint32_t Row = 0; Row < Store.GetSize(); ++Row) {
+        if (IsDefinition(Store, Row)) {
+          Insert(Hash(Store.GetName(Row)), Indexed + 1, Row);
+        }
+      }
+    }
+  }
+
+  // Calls Fn(Image, Row) for every definition of the name until it returns
+  // false
+  template <typename F> void Probe(std::string_view Name, F &&Fn) {
+    IndexPending();
+    if (Slots.empty()) {
+      return;
+    }
+    uint64_t NameHash = Hash(Name);
+    for (auto Position = NameHash & Mask; Slots[Position].Image;
+         Position = (Position + 1) & Mask) {
+      auto &S = Slots[Position];
+      if (S.Image == Tombstone || S.Tag != uint32_t(NameHash >> 32) ||
+          GetStore(S.Image).GetName(S.Row) != Name) {
+        continue;
+      }
+      if (!Fn(S.Image, S.Row)) {
+        return;
+      }
+    }
+  }
+
+  Definition MakeDefinition(uint32_t Image, uint32_t Row) {
+    return {Images[Image - 1], SymbolRef(&GetStore(Image), Row)};
+  }
+
+public:
+  GlobalSymbolIndex()
+      : Indexed(0), Mask(0), Used(0), Tombstones(0), Removed(0) {}
+
+  bool IsEmpty() const { return Images.empty(); }
+
+  void AddImage(const std::shared_ptr<Image_t> &Image) {
+    Images.push_back(Image);
+    // The first image of an install name is the one dyld binds to
+    ImagesByInstallName.emplace(Image->GetInstallName(), Images.size());
+  }
+
+  void RemoveImage(const std::shared_ptr<Image_t> &Image) {
+    uint32_t Position = 0;
+    while (Position < Images.size() && Images[Position] != Image) {
+      ++Position;
+    }
+    if (Position == Images.size()) {
+      return;
+    }
+
+    auto InstallName = Image->GetInstallName();
+    auto Name = ImagesByInstallName.find(InstallName);
+    if (Name != ImagesByInstallName.end() && Name->second == Position + 1) {
+      ImagesByInstallName.erase(Name);
+      // The next one loaded under the same install name takes its place
+      for (uint32_t i = Position + 1; i < Images.size(); ++i) {
+        if (Images[i] && Images[i]->GetInstallName() == InstallName) {
+          ImagesByInstallName.emplace(InstallName, i + 1);
+          break;
+        }
+      }
+    }
+    // Slots cannot be emptied, probes for other names run through them
+    for (auto &S : Slots) {
+      if (S.Image == Position + 1) {
+        S.Image = Tombstone;
+        ++Tombstones;
+      }
+    }
+    Images[Position] = nullptr;
+    ++Removed;
+
+    if (4 * Tombstones > Used || 2 * Removed > Images.size()) {
+      Compact();
+    }
+  }
+
+  void Clear() {
+    Images.clear();
+    ImagesByInstallName.clear();
+    Slots.clear();
+    Indexed = 0;
+    Mask = 0;
+    Used = 0;
+    Tombstones = 0;
+    Removed = 0;
+  }
+
+  // Slots the table has, used or not
+  size_t GetCapacity() const { return Slots.size(); }
+  // Positions images take, removed ones too until they are reclaimed
+  size_t GetPositionCount() const { return Images.size(); }
+
+  // Every definition of the name in load order
+  std::vector<Definition> Lookup(std::string_view Name) {
+    std::vector<Definition> Result;
+    Probe(Name, [&](uint32_t Image, uint32_t Row) {
+      Result.push_back(MakeDefinition(Image, Row));
+      return true;
+    });
+    return Result;
+  }
+
+  // The image dyld binds the install name to, null if none is loaded
+  Image_t *FindImage(std::string_view InstallName) const {
+    auto It = ImagesByInstallName.find(InstallName);
+    return It == ImagesByInstallName.end() ? nullptr
+                                           : Images[It->second - 1].get();
+  }
+
+  // Calls Fn(Image) for every loaded image in load order until it returns
+  // false
+  template <typename F> void ForEachImage(F &&Fn) const {
+    for (auto &Image : Images) {
+      if (Image && !Fn(*Image)) {
+        return;
+      }
+    }
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: GLOBALSYMBOLINDEX_HPP_M2JX6TDW */
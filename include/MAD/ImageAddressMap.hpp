@@ -0,0 +1,182 @@
+#ifndef IMAGEADDRESSMAP_HPP_T5NW2HQD
+#define IMAGEADDRESSMAP_HPP_T5NW2HQD
+
+// Std
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <vector>
+
+// System
+#include <mach/mach.h>
+
+namespace mad {
+
+// Slid segments and sections of every image loaded in the target, by address.
+// Images are added and removed one at a time as they come and go, the rest of
+// the map is left as it is. Any address maps to its image, segment and section
+// in O(log n) of the segments and sections of all the images.
+//
+// Ranges are half-open and do not overlap, with one exception: every image of
+// the shared cache claims the cache's __LINKEDIT as its own. A range claimed
+// by more than one image is kept once, it belongs to the image added first
+// until that one is removed. A range that only partially overlaps another one
+// is left out, so are ranges that merely reserve address space, e.g.
+// __PAGEZERO.
+//
+// Image_t is a MachImage, or anything else with the same GetSegments().
+template <typename Image_t> class ImageAddressMap {
+public:
+  using Segment_t = typename Image_t::Segment_t;
+  using Section_t = typename Image_t::Section_t;
+
+  struct Location {
+    std::shared_ptr<Image_t> Image;
+    std::shared_ptr<Segment_t> Segment;
+    // Null in between sections, e.g. in __LINKEDIT
+    std::shared_ptr<Section_t> Section;
+  };
+
+private:
+  template <typename Thing_t> struct Range {
+    uint64_t End;
+    // Whoever claims the range, the one added first goes first
+    std::vector<std::pair<std::shared_ptr<Image_t>, std::shared_ptr<Thing_t>>>
+        Owners;
+  };
+
+  template <typename Thing_t>
+  using RangeMap_t = std::map<uint64_t, Range<Thing_t>>;
+
+  RangeMap_t<Segment_t> Segments;
+  RangeMap_t<Section_t> Sections;
+  size_t ImageCount;
+
+private:
+  template <typename Thing_t>
+  static bool Insert(RangeMap_t<Thing_t> &Map,
+                     const std::shared_ptr<Image_t> &Image,
+                     const std::shared_ptr<Thing_t> &Thing) {
+    uint64_t Start = Thing->VirtualAddress;
+    uint64_t End = Start + Thing->VirtualSize;
+    // Empty or wrapping around
+    if (End <= Start) {
+      return false;
+    }
+
+    auto Next = Map.lower_bound(Start);
+    if (Next != Map.end() && Next->first == Start && Next->second.End == End) {
+      Next->second.Owners.emplace_back(Image, Thing);
+      return true;
+    }
+    if ((Next != Map.end() && Next->first < End) ||
+        (Next != Map.begin() && std::prev(Next)->second.End > Start)) {
+      return false;
+    }
+
+    Map.emplace_hint(Next, Start, Range<Thing_t>{End, {{Image, Thing}}});
+    return true;
+  }
+
+  template <typename Thing_t>
+  static void Erase(RangeMap_t<Thing_t> &Map, const Image_t &Image,
+                    const Thing_t &Thing) {
+    auto It = Map.find(Thing.VirtualAddress);
+    if (It == Map.end()) {
+      return;
+    }
+
+    auto &Owners = It->second.Owners;
+    for (auto Owner = Owners.begin(); Owner != Owners.end(); ++Owner) {
+      if (Owner->first.get() == &Image && Owner->second.get() == &Thing) {
+        Owners.erase(Owner);
+        break;
+      }
+    }
+    if (Owners.empty()) {
+      Map.erase(It);
+    }
+  }
+
+  template <typename Thing_t>
+  static const Range<Thing_t> *Find(const RangeMap_t<Thing_t> &Map,
+                                    uint64_t Address) {
+    auto It = Map.upper_bound(Address);
+    if (It == Map.begin() || Address >= std::prev(It)->second.End) {
+      return nullptr;
+    }
+    return &std::prev(It)->second;
+  }
+
+  static bool IsReserveOnly(const Segment_t &Segment) {
+    return Segment.Raw.maxprot == VM_PROT_NONE && !Segment.FileSize;
+  }
+
+public:
+  ImageAddressMap() : ImageCount(0) {}
+
+  bool IsEmpty() const { return Segments.empty(); }
+  size_t GetImageCount() const { return ImageCount; }
+
+  // The image must have been scanned, its segments are slid by then
+  void AddImage(const std::shared_ptr<Image_t> &Image) {
+    for (auto &Segment : Image->GetSegments()) {
+      if (IsReserveOnly(*Segment) || !Insert(Segments, Image, Segment)) {
+        continue;
+      }
+      for (auto &Section : Segment->Sections) {
+        Insert(Sections, Image, Section);
+      }
+    }
+    ++ImageCount;
+  }
+
+  void RemoveImage(const std::shared_ptr<Image_t> &Image) {
+    for (auto &Segment : Image->GetSegments()) {
+      for (auto &Section : Segment->Sections) {
+        Erase(Sections, *Image, *Section);
+      }
+      Erase(Segments, *Image, *Segment);
+    }
+    --ImageCount;
+  }
+
+  void Clear() {
+    Segments.clear();
+    Sections.clear();
+    ImageCount = 0;
+  }
+
+  bool Lookup(uint64_t Address, Location &Result) const {
+    auto Segment = Find(Segments, Address);
+    if (!Segment) {
+      return false;
+    }
+
+    auto &Owner = Segment->Owners.front();
+    Result.Image = Owner.first;
+    Result.Segment = Owner.second;
+    Result.Section = nullptr;
+
+    // Sections of a shared range are those of the image it belongs to
+    if (auto Section = Find(Sections, Address)) {
+      for (auto &Claim : Section->Owners) {
+        if (Claim.first == Result.Image) {
+          Result.Section = Claim.second;
+          break;
+        }
+      }
+    }
+    return true;
+  }
+
+  std::shared_ptr<Image_t> FindImage(uint64_t Address) const {
+    auto Segment = Find(Segments, Address);
+    return Segment ? Segment->Owners.front().first : nullptr;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: IMAGEADDRESSMAP_HPP_T5NW2HQD */
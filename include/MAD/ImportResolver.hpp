@@ -0,0 +1,119 @@
+#ifndef IMPORTRESOLVER_HPP_K8RV3NQE
+#define IMPORTRESOLVER_HPP_K8RV3NQE
+
+// System
+#include <mach-o/loader.h>
+
+// Std
+#include <cstdint>
+#include <string_view>
+
+// MAD
+#include "MAD/ExportTrie.hpp"
+#include "MAD/GlobalSymbolIndex.hpp"
+
+namespace mad {
+
+// Binds imports to the exports of the images loaded in the target the way
+// dyld does, without reading the pointers it wrote.
+//
+// An import is looked up in the library its ordinal names, the image itself
+// or the main executable. A library that re-exports the name, on its own or
+// with the whole library that defines it, e.g. libSystem.B.dylib does with
+// most of libc, is followed to the definition. Flat and weak lookups, and
+// libraries that are not loaded under the install name they were linked
+// against, take the first image, in load order, that exports the name.
+//
+// The loaded images and their install names are those of a GlobalSymbolIndex,
+// which must outlive the resolver.
+//
+// Image_t is a MachImage, or anything else with the same GetSymbolTable(),
+// whose GetExports() and GetExportAddress(Export, Address) are used,
+// GetInstallName(), GetDyLibraries() and GetType().
+template <typename Image_t> class ImportResolver {
+  // Re-exports followed in a row at most, a malformed chain may loop
+  static constexpr unsigned MaxReExportDepth = 16;
+
+  const GlobalSymbolIndex<Image_t> &Index;
+
+private:
+  // Library with the ordinal in From's LC_LOAD_DYLIB and alike, from 1
+  Image_t *FindLibrary(Image_t &From, uint64_t Ordinal) const {
+    auto &Libraries = From.GetDyLibraries();
+    if (!Ordinal || Ordinal > Libraries.size()) {
+      return nullptr;
+    }
+    return Index.FindImage(Libraries[Ordinal - 1]->Name);
+  }
+
+  // Address of the name exported by Library, or by the one it re-exports the
+  // name from
+  bool FindExport(Image_t &Library, std::string_view Name, uint64_t &Address,
+                  unsigned Depth) const {
+    if (Depth > MaxReExportDepth) {
+      return false;
+    }
+
+    auto &Table = Library.GetSymbolTable();
+    ExportTrie::Export Export;
+    if (Table.GetExports().Lookup(Name, Export)) {
+      if (!Export.IsReExport()) {
+        return Table.GetExportAddress(Export, Address);
+      }
+      // Possibly under another name, e.g. _bzero as ___bzero
+      auto Other = FindLibrary(Library, Export.Other);
+      auto OtherName = Export.ImportName.empty() ? Name : Export.ImportName;
+      return Other && FindExport(*Other, OtherName, Address, Depth + 1);
+    }
+
+    // Exports of libraries re-exported as a whole are not in the trie
+    for (auto &Dependency : Library.GetDyLibraries()) {
+      if (Dependency->Raw.cmd != LC_REEXPORT_DYLIB) {
+        continue;
+      }
+      auto Other = Index.FindImage(Dependency->Name);
+      if (Other && FindExport(*Other, Name, Address, Depth + 1)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+public:
+  ImportResolver(const GlobalSymbolIndex<Image_t> &Index) : Index(Index) {}
+
+  // Address an import of From binds to. Ordinal is one of
+  // BIND_SPECIAL_DYLIB_* or that of a library of From. False if no image
+  // exports the name, which is where dyld binds weak imports to zero.
+  bool Resolve(Image_t &From, int64_t Ordinal, std::string_view Name,
+               uint64_t &Address) const {
+    Image_t *Library = nullptr;
+    if (Ordinal == BIND_SPECIAL_DYLIB_SELF) {
+      Library = &From;
+    } else if (Ordinal == BIND_SPECIAL_DYLIB_MAIN_EXECUTABLE) {
+      Index.ForEachImage([&](Image_t &Image) {
+        if (Image.GetType() == MH_EXECUTE) {
+          Library = &Image;
+        }
+        return !Library;
+      });
+    } else if (Ordinal > 0) {
+      Library = FindLibrary(From, Ordinal);
+    }
+
+    if (Library && FindExport(*Library, Name, Address, 0)) {
+      return true;
+    }
+
+    bool Found = false;
+    Index.ForEachImage([&](Image_t &Image) {
+      Found = &Image != Library && FindExport(Image, Name, Address, 0);
+      return !Found;
+    });
+    return Found;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: IMPORTRESOLVER_HPP_K8RV3NQE */
@@ -1,28 +1,176 @@
 #ifndef MACHIMAGE_HPP_12TQWXQI
 #define MACHIMAGE_HPP_12TQWXQI
 
+#include <mach-o/fat.h>
 #include <mach/mach.h>
+#include <unistd.h>
 
 #include <MAD/Debug.hpp>
+#include <MAD/DwarfIndex.hpp>
+#include <MAD/DwarfLineTable.hpp>
 #include <MAD/Mach.hpp>
+#include <MAD/MachImageInput.hpp>
 #include <MAD/MachOParser.hpp>
 #include <MAD/MachTask.hpp>
 #include <MAD/MachTaskMemoryStream.hpp>
+#include <MAD/SharedCache.hpp>
+#include <MAD/SymbolIndexCache.hpp>
+#include <MAD/SymbolStore.hpp>
 #include <MAD/SymbolTable.hpp>
+#include <MAD/UniversalBinary.hpp>
 
 namespace mad {
 template <typename T, typename = IsMachSystem_t<T>> class MachImage {
+  using NList_t = std::conditional_t<std::is_same_v<T, MachSystem32_t>,
+                                     struct nlist, struct nlist_64>;
+
+public:
+  using Segment_t = typename MachOParser<T, MachImageInput>::MachOSegment;
+  using Section_t = typename MachOParser<T, MachImageInput>::MachOSection;
+
+private:
+
+  std::string Path;
   MachTask &Task;
   vm_address_t Address;
+  // Set if the image comes from the dyld shared cache
+  const SharedCache *Cache;
   MachTaskMemoryStream MemoryStream;
-  MachOParser<T> Parser;
-  SymbolTable<T> SymbolTable;
+  MachOParser<T, MachImageInput> Parser;
+  SymbolTable<T, MachImageInput> SymbolTable;
+
+  // Local symbols dyld stripped from a shared cache image
+  SymbolStore LocalSymbols;
+  bool IsLocalSymbolsBuilt;
+
+  // The image's dSYM, if it has one, and whatever maps it
+  std::shared_ptr<void> DebugStorage;
+  std::shared_ptr<MachOParser<T, ByteView>> DebugParser;
+  bool IsDebugInfoLoaded;
+
+  // The image's own file, for what only the file has
+  std::shared_ptr<void> FileStorage;
+  std::shared_ptr<MachOParser<T, ByteView>> FileParser;
+  bool IsFileLoaded;
 
 private:
+  // Maps a Mach-O file, or the slice of a universal one, that belongs to this
+  // very build of the image
+  std::shared_ptr<MachOParser<T, ByteView>>
+  OpenFile(const std::string &FilePath, std::shared_ptr<void> &Storage) {
+    auto File = std::make_shared<MappedFile>();
+    if (!File->Open(FilePath)) {
+      return nullptr;
+    }
+    Storage = File;
+    auto View = File->GetView();
+
+    // Slices of universal binaries, dSYMs of them are universal as well
+    uint32_t Magic = 0;
+    View.ReadAt(0, Magic);
+    if (Magic == FAT_MAGIC || Magic == FAT_CIGAM || Magic == FAT_MAGIC_64 ||
+        Magic == FAT_CIGAM_64) {
+      auto Binary = std::make_shared<UniversalBinary>(FilePath);
+      auto &Raw = Parser.Header->Raw;
+      auto Slice = Binary->Parse()
+                       ? Binary->FindSlice(Raw.cputype, Raw.cpusubtype)
+                       : nullptr;
+      if (!Slice) {
+        PRINT_DEBUG("No matching slice in", FilePath);
+        return nullptr;
+      }
+      View = Binary->GetSliceView(*Slice);
+      Storage = Binary;
+      View.ReadAt(0, Magic);
+    }
+
+    if (Magic != (std::is_same_v<T, MachSystem32_t> ? MH_MAGIC : MH_MAGIC_64)) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Not a Mach-O file", FilePath);
+      return nullptr;
+    }
+
+    auto Result = std::make_shared<MachOParser<T, ByteView>>(
+        FilePath, View, MO_PARSE_FILE | MO_PARSE_LAZY_SYMBOLS);
+    if (!Result->Parse()) {
+      return nullptr;
+    }
+
+    // A file of another build would put breakpoints anywhere
+    if (!Parser.UUID || !Result->UUID ||
+        memcmp(Parser.UUID->Raw.uuid, Result->UUID->Raw.uuid,
+               sizeof(uuid_t))) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Ignoring", FilePath, "of another build");
+      return nullptr;
+    }
+    return Result;
+  }
+
+  void LoadDebugInfo() {
+    IsDebugInfoLoaded = true;
+
+    auto Slash = Path.rfind('/');
+    auto DSYM = Path + ".dSYM/Contents/Resources/DWARF/" +
+                Path.substr(Slash == std::string::npos ? 0 : Slash + 1);
+    // Most images have none
+    if (access(DSYM.c_str(), R_OK)) {
+      return;
+    }
+
+    std::shared_ptr<void> Storage;
+    if (auto Debug = OpenFile(DSYM, Storage)) {
+      DebugStorage = std::move(Storage);
+      DebugParser = std::move(Debug);
+    }
+  }
+
+  void LoadFile() {
+    IsFileLoaded = true;
+
+    // Images of the shared cache are not on disk, nor have they fixups left
+    if (Cache || access(Path.c_str(), R_OK)) {
+      return;
+    }
+
+    std::shared_ptr<void> Storage;
+    if (auto File = OpenFile(Path, Storage)) {
+      FileStorage = std::move(Storage);
+      FileParser = std::move(File);
+    }
+  }
+
+  void BuildLocalSymbols() {
+    IsLocalSymbolsBuilt = true;
+
+    SharedCache::LocalSymbols Local;
+    if (!Cache || Cache->GetNListSize() != sizeof(NList_t) ||
+        !Cache->GetLocalSymbols(Address, Local)) {
+      return;
+    }
+
+    uint32_t Count = Local.NList.GetSize() / sizeof(NList_t);
+    LocalSymbols.Reset(Local.Strings, Count, Cache->GetSlide(),
+                       Cache->GetStringTableIndex(Local.Strings));
+    for (uint32_t i = 0; i < Count; ++i) {
+      NList_t Entry;
+      Local.NList.ReadAt(i * sizeof(NList_t), Entry);
+      LocalSymbols.Set(i, Entry, false, true);
+    }
+  }
+
 public:
-  MachImage(std::string Name, MachTask &Task, vm_address_t Address)
-      : Task(Task), Address(Address), MemoryStream(Task.GetMemory(), Address),
-        Parser(Name, MemoryStream, MO_PARSE_IMAGE, Address), SymbolTable(Parser) {}
+  MachImage(std::string Name, MachTask &Task, vm_address_t Address,
+            const SharedCache *Cache = nullptr,
+            const SymbolIndexCache *Index = nullptr)
+      : Path(Name), Task(Task), Address(Address), Cache(Cache),
+        MemoryStream(Task.GetMemory(), Address),
+        Parser(Name, MachImageInput(MemoryStream, Address, Cache),
+               MO_PARSE_IMAGE | MO_PARSE_LAZY_SYMBOLS, Address),
+        SymbolTable(Parser), IsLocalSymbolsBuilt(false),
+        IsDebugInfoLoaded(false), IsFileLoaded(false) {
+    Parser.SetSymbolIndexCache(Index);
+  }
 
   MachImage(const MachImage &Other) = delete;
   MachImage &operator=(const MachImage &Other) = delete;
@@ -34,15 +182,92 @@ public:
     if (!Parser.Parse()) {
       return false;
     }
+    // Every image in the cache shares the same string pool. Images loaded
+    // from a symbol index have not read it at all.
+    if (Cache && Parser.SymbolTable &&
+        !Parser.SymbolTable->StringData.IsEmpty()) {
+      Parser.SymbolTable->SetStringTableIndex(
+          Cache->GetStringTableIndex(Parser.SymbolTable->StringData));
+    }
     SymbolTable.Init();
+    // Lookups go on to the locals the cache keeps apart, decoded only once a
+    // name is not found elsewhere or an address is symbolicated
+    if (Cache) {
+      SymbolTable.SetLocalSymbols(
+          [this]() -> const SymbolStore & { return GetLocalSymbols(); });
+    }
 
     return true;
   }
 
-  auto GetType() { return Parser.Header->Filetype; }
+  // Zero if the image failed to parse
+  uint32_t GetType() { return Parser.Header ? Parser.Header->Filetype : 0; }
+  auto &GetPath() { return Path; }
+  // What other images name this one by in their LC_LOAD_DYLIB, the path for
+  // executables and bundles
+  std::string GetInstallName() {
+    return Parser.DyLibraryId ? std::string(Parser.DyLibraryId->Name) : Path;
+  }
   auto GetAddress() { return Address; }
+  auto GetSlide() { return Parser.GetImageSlide(); }
   auto &GetSymbolTable() { return SymbolTable; }
+  bool IsInSharedCache() { return Cache != nullptr; }
+
+  // Empty unless the image comes from the shared cache
+  const SymbolStore &GetLocalSymbols() {
+    if (!IsLocalSymbolsBuilt) {
+      BuildLocalSymbols();
+    }
+    return LocalSymbols;
+  }
+
+  // Line table of the image's dSYM, read on first call. Null if there is no
+  // dSYM next to the image. Its addresses are unslid, add GetSlide().
+  DwarfLineTable *GetLineTable() {
+    if (!IsDebugInfoLoaded) {
+      LoadDebugInfo();
+    }
+    return DebugParser ? DebugParser->GetLineTable() : nullptr;
+  }
+
+  // Debug map of an image linked from object files with debug info and not
+  // stripped since
+  const DebugMap *GetDebugMap() { return Parser.GetDebugMap(); }
+
+  // Accelerator tables and DIEs of the image's dSYM, same as the line table
+  DwarfIndex *GetDwarfIndex() {
+    if (!IsDebugInfoLoaded) {
+      LoadDebugInfo();
+    }
+    return DebugParser ? DebugParser->GetDwarfIndex() : nullptr;
+  }
+
+  // Chained fixup of the pointer at the slid Address, decoded from the
+  // image's file on first call. False for images of the shared cache, images
+  // with rebase and bind opcodes and addresses dyld fixes up nothing at.
+  bool GetFixup(uint64_t Address, ChainedFixups::Fixup &Fixup) {
+    if (!IsFileLoaded) {
+      LoadFile();
+    }
+    auto Fixups = FileParser ? FileParser->GetChainedFixups() : nullptr;
+    return Fixups && Fixups->Lookup(Address - GetSlide(), Fixup);
+  }
+
+  // Import a bind fixup's Target is the index of
+  const ChainedFixups::Import *GetImport(uint64_t Index) {
+    auto Fixups = FileParser ? FileParser->GetChainedFixups() : nullptr;
+    return Fixups ? Fixups->GetImport(Index) : nullptr;
+  }
+
+  // LC_LOAD_DYLIB and the like, ordinals of imports count from 1
+  auto &GetDyLibraries() { return Parser.DyLibraries; }
+
+  // Unwind info of the image itself, addresses are slid
+  const CompactUnwind *GetCompactUnwind() { return Parser.GetCompactUnwind(); }
+  EhFrame *GetEhFrame() { return Parser.GetEhFrame(); }
 
+  // Slid, in the order of their load commands
+  auto &GetSegments() { return Parser.Segments; }
   auto GetSegmentByName(std::string Name) {
     return Parser.GetSegmentByName(Name);
   }
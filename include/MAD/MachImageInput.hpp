@@ -0,0 +1,97 @@
+#ifndef MACHIMAGEINPUT_HPP_J5NQ8WSD
+#define MACHIMAGEINPUT_HPP_J5NQ8WSD
+
+// Std
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <string>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/SharedCache.hpp"
+#include "MAD/StreamInput.hpp"
+
+namespace mad {
+
+// Input for an image loaded into a task. Offsets are relative to the image's
+// mach header. Bytes of images that come from the dyld shared cache are served
+// from its mapping, which saves a round trip to the target per page;
+// everything else is read out of the task through the stream.
+//
+// Only the read-only parts of the cache, i.e. load commands, __TEXT and
+// __LINKEDIT, are guaranteed to match the target's memory, which is all
+// MachOParser reads.
+class MachImageInput {
+  StreamInput Stream;
+  const SharedCache *Cache;
+  // In-memory address of the mach header
+  uint64_t Address;
+  uint64_t Position;
+  bool Failed;
+
+public:
+  // Strings read from the task are copies
+  using String_t = std::string;
+
+public:
+  MachImageInput(std::istream &Stream, uint64_t Address,
+                 const SharedCache *Cache = nullptr)
+      : Stream(Stream), Cache(Cache), Address(Address), Position(0),
+        Failed(false) {}
+
+  bool Good() const { return !Failed; }
+  uint64_t Tell() const { return Position; }
+
+  bool Seek(uint64_t Offset) {
+    Position = Offset;
+    return Good();
+  }
+
+  // Empty unless the whole range is in the shared cache
+  ByteView Slice(uint64_t Offset, uint64_t Length) const {
+    return Cache ? Cache->GetView(Address + Offset, Length) : ByteView();
+  }
+
+  bool Read(void *Out, uint64_t Length) {
+    if (Failed) {
+      return false;
+    }
+
+    auto View = Slice(Position, Length);
+    if (View.GetSize() == Length) {
+      memcpy(Out, View.GetData(), Length);
+    } else if (!Stream.Seek(Position) || !Stream.Read(Out, Length)) {
+      Failed = true;
+      return false;
+    }
+
+    Position += Length;
+    return true;
+  }
+
+  std::string ReadNTString() {
+    if (Failed) {
+      return {};
+    }
+
+    std::string Result;
+    auto Tail = Cache ? Cache->GetViewToEnd(Address + Position) : ByteView();
+    if (!Tail.IsEmpty()) {
+      Result = Tail.StringAt(0);
+    } else {
+      Stream.Seek(Position);
+      Result = Stream.ReadNTString();
+      if (!Stream.Good()) {
+        Failed = true;
+      }
+    }
+
+    Position += Result.size() + 1;
+    return Result;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: MACHIMAGEINPUT_HPP_J5NQ8WSD */
@@ -52,6 +52,10 @@ public:
 
   mach_vm_size_t Read(mach_vm_address_t address, mach_vm_size_t size,
                       void *data);
+  // Reads the range up to its first gap, if any, instead of failing on it.
+  // Meant for reading ahead, e.g. of a stack whose end is not known.
+  mach_vm_size_t ReadAvailable(mach_vm_address_t Address, mach_vm_size_t Size,
+                               void *Data);
   mach_vm_size_t Write(mach_vm_address_t address, vm_offset_t data,
                        mach_msg_type_number_t count);
 };
@@ -1,8 +1,10 @@
 #ifndef MACHOPARSER_HPP_L6XJ5WJN
 #define MACHOPARSER_HPP_L6XJ5WJN
 
+#include <algorithm>
+#include <array>
 #include <cassert>
-#include <istream>
+#include <cstring>
 #include <map>
 #include <memory>
 #include <string>
@@ -16,16 +18,65 @@
 #include <mach-o/stab.h>
 #include <uuid/uuid.h>
 
+#include "MAD/ByteView.hpp"
+#include "MAD/ChainedFixups.hpp"
+#include "MAD/CompactUnwind.hpp"
+#include "MAD/DebugMap.hpp"
+#include "MAD/DwarfIndex.hpp"
+#include "MAD/DwarfLineTable.hpp"
+#include "MAD/EhFrame.hpp"
+#include "MAD/ExportTrie.hpp"
+#include "MAD/FunctionStarts.hpp"
 #include "MAD/Error.hpp"
 #include "MAD/Mach.hpp"
+#include "MAD/StreamInput.hpp"
+#include "MAD/SymbolIndexCache.hpp"
+#include "MAD/SymbolStore.hpp"
+#include "MAD/ThreadPool.hpp"
 #include "MAD/Utils.hpp"
 
 namespace mad {
 
+// Parse modes
 #define MO_PARSE_IMAGE 0
 #define MO_PARSE_FILE 1
+#define MO_PARSE_MODE_MASK 0xFu
+
+// Parse options, these are OR-ed with the mode
+//
+// Keep the symbol table raw and build the SymbolStore only when a symbol is
+// first queried
+#define MO_PARSE_LAZY_SYMBOLS 0x10u
+
+// Symbol tables at least this big are decoded on the shared ThreadPool in
+// chunks of MO_PARALLEL_SYMBOLS_CHUNK symbols
+#define MO_PARALLEL_SYMBOLS_THRESHOLD 65536u
+#define MO_PARALLEL_SYMBOLS_CHUNK 16384u
+
+// Inputs that cannot be viewed in place are read at most this much at once,
+// more only once they have proven to have that much. A bogus size in a load
+// command cannot make the parser allocate much more than the input has.
+#define MO_READ_CHUNK 0x1000000u
+
+// Load commands are below this once LC_REQ_DYLD is taken off
+#define MO_LOAD_COMMAND_LIMIT 0x40u
+
+// The parser reads its input through I, which is a StreamInput, e.g. over
+// MachTaskMemoryStream, a MachImageInput for in-memory images or a ByteView
+// over a mapped file. With a ByteView every string the parser hands out points
+// straight into the mapping, so the mapping must outlive the parser. Inputs
+// that can hand out views of their bytes with Slice are never copied from.
+//
+// Whatever is loaded in the target is parsed, corrupted or hostile images
+// included, so nothing read from the input is trusted: every load command has
+// to fit in sizeofcmds and every table in its segment, otherwise Parse fails.
+template <typename T, typename I = StreamInput,
+          typename = IsMachSystem_t<T>>
+class MachOParser {
+public:
+  using Input_t = I;
+  using String_t = typename I::String_t;
 
-template <typename T, typename = IsMachSystem_t<T>> class MachOParser {
 private:
   using HeaderCmd_t = std::conditional_t<std::is_same_v<T, MachSystem32_t>,
                                          mach_header, mach_header_64>;
@@ -35,53 +86,50 @@ private:
                                           section, section_64>;
   using NList_t = std::conditional_t<std::is_same_v<T, MachSystem32_t>,
                                      struct nlist, struct nlist_64>;
+  using EncryptionCmd_t =
+      std::conditional_t<std::is_same_v<T, MachSystem32_t>,
+                         encryption_info_command, encryption_info_command_64>;
 
   static const bool Is32 = std::is_same_v<T, MachSystem32_t>;
   static const bool Is64 = std::is_same_v<T, MachSystem64_t>;
   static const uint32_t lc_segment = Is32 ? LC_SEGMENT : LC_SEGMENT_64;
+  static const uint32_t lc_encryption_info =
+      Is32 ? LC_ENCRYPTION_INFO : LC_ENCRYPTION_INFO_64;
 
 private:
+  // Things are read out of a view of the load commands, Input is the command
+  // itself. Size is what the input says the thing takes, e.g. its cmdsize.
+  // Things that do not fit in it are not read at all.
   template <typename S>
-  static bool ReadAThingFromInput(std::istream &I, std::shared_ptr<S> &Thing) {
-    Thing = std::make_shared<S>();
-    if (I.read((char *)&Thing->Raw, sizeof(Thing->Raw))) {
-      Thing->Parse(I);
-      return true;
+  static bool ReadAThingFromInput(ByteView &Input, std::shared_ptr<S> &Thing,
+                                  uint64_t Size) {
+    auto New = std::make_shared<S>();
+    if (sizeof(New->Raw) > Size || !Input.Read(&New->Raw, sizeof(New->Raw)) ||
+        !New->Parse(Input)) {
+      return false;
     }
-    return false;
+    Thing = std::move(New);
+    return true;
   }
 
   template <typename S>
   static bool
-  ReadAThingFromInputAndPush(std::istream &I,
-                             std::vector<std::shared_ptr<S>> &Container) {
-    std::shared_ptr<S> Thing = std::make_shared<S>();
-    if (I.read((char *)&Thing->Raw, sizeof(Thing->Raw))) {
-      Thing->Parse(I);
-      Container.push_back(std::move(Thing));
-      return true;
-    }
-    return false;
-  }
-
-  static std::string ReadNTStringFromInput(std::istream &I) {
-    std::string result;
-    while (I.good()) {
-      char ch;
-      I.read(&ch, 1);
-      if (!ch) {
-        return result;
-      }
-      result.push_back(ch);
+  ReadAThingFromInputAndPush(ByteView &Input,
+                             std::vector<std::shared_ptr<S>> &Container,
+                             uint64_t Size) {
+    Container.emplace_back();
+    if (!ReadAThingFromInput(Input, Container.back(), Size)) {
+      Container.pop_back();
+      return false;
     }
-    return result;
+    return true;
   }
 
 public:
   template <typename R> class MachOThing {
   public:
     R Raw;
-    bool Parse(std::istream &) { return true; }
+    bool Parse(ByteView &) { return true; }
     bool PostParse(MachOParser &) { return true; }
   };
 
@@ -131,7 +179,7 @@ public:
     BoundFlagAnd<MH_APP_EXTENSION_SAFE> IsAppExtensionSafe{Raw.flags};
 
   public:
-    bool Parse(std::istream &) {
+    bool Parse(ByteView &) {
       Filetype = Raw.filetype;
       return true;
     }
@@ -149,9 +197,13 @@ public:
 
   public:
     void ApplyVirtualMemorySlide(uint64_t Value) { VirtualAddress += Value; }
-    bool Parse(std::istream &) {
-      Name = std::string(Raw.sectname);
-      SegmentName = std::string(Raw.segname);
+    bool Parse(ByteView &) {
+      // Names take all 16 bytes without a terminator, e.g. __debug_line_str
+      Name = std::string(Raw.sectname, strnlen(Raw.sectname, 16));
+      SegmentName = std::string(Raw.segname, strnlen(Raw.segname, 16));
+      VirtualAddress = Raw.addr;
+      VirtualSize = Raw.size;
+      FileOffset = Raw.offset;
       return true;
     }
   };
@@ -174,15 +226,24 @@ public:
         Section->ApplyVirtualMemorySlide(Value);
       }
     }
-    bool Parse(std::istream &I) {
-      Name = std::string(Raw.segname);
+    bool Parse(ByteView &Input) {
+      Name = std::string(Raw.segname, strnlen(Raw.segname, 16));
       VirtualAddress = Raw.vmaddr;
       VirtualSize = Raw.vmsize;
       FileOffset = Raw.fileoff;
       FileSize = Raw.filesize;
 
+      // Sections follow the command and are part of it
+      if (Raw.nsects > (Raw.cmdsize - sizeof(Raw)) / sizeof(SectionCmd_t)) {
+        return false;
+      }
+
+      Sections.reserve(Raw.nsects);
       for (uint32_t s = 0; s < Raw.nsects; ++s) {
-        ReadAThingFromInputAndPush(I, Sections);
+        if (!ReadAThingFromInputAndPush(Input, Sections,
+                                        sizeof(SectionCmd_t))) {
+          return false;
+        }
       }
 
       return true;
@@ -190,7 +251,7 @@ public:
 
     std::shared_ptr<MachOSection> GetSectionByName(std::string SectionName) {
       for (auto &Section : Sections) {
-        if (Section.Name == SectionName) {
+        if (Section->Name == SectionName) {
           return Section;
         }
       }
@@ -198,258 +259,266 @@ public:
     }
   };
 
-  class MachOSymbolTableEntry : public MachOThing<NList_t> {
+  class MachOSymbolTable : public MachOThing<symtab_command> {
+    MachOParser *Parser = nullptr;
 
-  public:
-    using MachOThing<NList_t>::Raw;
-    std::string Name;
+    // Backs NListData and StringData if the input cannot be viewed in place
+    std::vector<char> Buffer;
 
-    // n_type::N_STAB
-    uint8_t StubType;
-    bool IsStub;
-
-    // n_type::N_PEXT
-    bool IsPrivateExternal;
-
-    // n_type::N_TYPE
-    bool IsUndefined;
-    bool IsAbsolute;
-    bool IsDefined;
-    bool IsPrebound;
-    bool IsIndirect;
-
-    // n_type::N_EXT
-    bool IsExtenal;
-
-    // n_sect
-    uint8_t SectionNumber;
-
-    // n_desc
-    uint32_t LineNumber;
-    uint32_t NestingLevel;
-    uint32_t Alignment;
-    // REFERENCE_FLAG_* flags
-    bool IsReferenceUndefinedNonLazy;
-    bool IsReferenceUndefinedLazy;
-    bool IsReferenceDefined;
-    bool IsReferencePrivateDefined;
-    bool IsReferencePrivateUndefinedNonLazy;
-    bool IsReferencePrivateUndefinedLazy;
-    // Additional flags
-    bool IsReferenceDynamically;
-    bool IsNoDeadStrip;
-    bool IsDescDiscarded;
-    bool IsWeakReference;
-    bool IsWeakDefinition;
-    bool IsReferenceToWeak;
-    bool IsArmThumbDefinition;
-    bool IsSymbolResolver;
-    bool IsAltEntry;
-    //
-    uint32_t LibraryOrdinal;
+    // In lazy mode the store is built on first use
+    SymbolStore Store;
+    bool IsStoreBuilt = false;
 
-    // n_value
-    uint64_t Value;
+    // Index of StringData shared with other images, if any
+    std::shared_ptr<const StringTableIndex> StringIndex;
 
   private:
-    void ParseDesc(MachOParser &Parser) {
-      // Common symbols have N_TYPE = U_UNDF | U_EXT
-      if (IsUndefined && IsExtenal) {
-        Alignment = GET_COMM_ALIGN(Raw.n_desc);
-      }
+    void BuildStore() {
+      auto Count = GetSymbolCount();
+      auto Slide = Parser->ImageSlide;
+      bool IsObject = bool(Parser->Header->IsTypeObject);
+      bool IsImage = bool(Parser->IsImage);
+
+      Store.Reset(StringData, Count, Slide, StringIndex);
+      Store.IsTwoLevel = bool(Parser->Header->IsTwoLevel);
+
+      // Both the nlist array and the string table are immutable by now and
+      // every row is written by exactly one chunk, so the result does not
+      // depend on how chunks are scheduled.
+      auto Decode = [&](uint64_t Begin, uint64_t End) {
+        for (auto i = Begin; i < End; ++i) {
+          Store.Set(i, GetRawSymbol(i), IsObject, IsImage);
+        }
+      };
 
-      auto ReferenceType = Raw.n_desc & REFERENCE_TYPE;
-      IsReferenceUndefinedNonLazy =
-          ReferenceType == REFERENCE_FLAG_UNDEFINED_NON_LAZY;
-      IsReferenceUndefinedLazy = ReferenceType == REFERENCE_FLAG_UNDEFINED_LAZY;
-      IsReferenceDefined = ReferenceType == REFERENCE_FLAG_DEFINED;
-      IsReferencePrivateDefined =
-          ReferenceType == REFERENCE_FLAG_PRIVATE_DEFINED;
-      IsReferencePrivateUndefinedNonLazy =
-          ReferenceType == REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY;
-      IsReferencePrivateUndefinedLazy =
-          ReferenceType == REFERENCE_FLAG_PRIVATE_UNDEFINED_LAZY;
-
-      IsReferenceDynamically = Raw.n_desc & REFERENCED_DYNAMICALLY;
-
-      if (Parser.Header->IsTypeObject) {
-        IsNoDeadStrip = Raw.n_desc & N_NO_DEAD_STRIP;
-        IsSymbolResolver = Raw.n_desc & N_SYMBOL_RESOLVER;
+      if (Count >= MO_PARALLEL_SYMBOLS_THRESHOLD) {
+        ThreadPool::GetShared().ParallelFor(Count, MO_PARALLEL_SYMBOLS_CHUNK,
+                                            Decode);
+      } else {
+        Decode(0, Count);
       }
 
-      if (Parser.IsImage) {
-        IsDescDiscarded = Raw.n_desc & N_DESC_DISCARDED;
-      }
+      IsStoreBuilt = true;
+      Parser->SaveSymbolIndex(Store);
+    }
 
-      IsWeakReference = Raw.n_desc & N_WEAK_REF;
-      IsWeakDefinition = Raw.n_desc & N_WEAK_DEF;
-      IsReferenceToWeak = Raw.n_desc & N_REF_TO_WEAK;
-      IsArmThumbDefinition = Raw.n_desc & N_ARM_THUMB_DEF;
-      IsAltEntry = Raw.n_desc & N_ALT_ENTRY;
+  public:
+    using MachOThing<symtab_command>::Raw;
 
-      if (Parser.Header->IsTwoLevel) {
-        LibraryOrdinal = GET_LIBRARY_ORDINAL(Raw.n_desc);
-      }
+    // Raw nlist array and string table
+    ByteView NListData;
+    ByteView StringData;
+
+    // Offset in the input, which is not the file for images
+    uint64_t StringTableOffset;
+    decltype(Raw.strsize) StringTableSize;
+
+  public:
+    uint32_t GetSymbolCount() const {
+      return NListData.GetSize() / sizeof(NList_t);
     }
 
-    void ParseStub(MachOParser &Parser) {
-      StubType = Raw.n_type;
+    NList_t GetRawSymbol(uint32_t Index) const {
+      NList_t Entry = {};
+      NListData.ReadAt(Index * sizeof(NList_t), Entry);
+      return Entry;
+    }
 
-      switch (StubType) {
-      case N_FUN:
-      case N_SLINE:
-      case N_ENTRY:
-        LineNumber = Raw.n_desc;
-        break;
-      case N_LBRAC:
-      case N_RBRAC:
-        NestingLevel = Raw.n_desc;
-        break;
-      case N_GSYM:
-      case N_STSYM:
-      case N_LCSYM:
-      case N_RSYM:
-      case N_SSYM:
-      case N_LSYM:
-      case N_PSYM:
-        ParseDesc(Parser);
-        break;
+    SymbolStore &GetStore() {
+      if (!IsStoreBuilt) {
+        BuildStore();
       }
+      return Store;
     }
 
-  public:
-    // TODO init all the fields
-    MachOSymbolTableEntry()
-        : StubType(0), SectionNumber(0), LineNumber(0), NestingLevel(0),
-          Value(0) {}
+    SymbolRef GetSymbol(uint32_t Index) {
+      return SymbolRef(&GetStore(), Index);
+    }
 
-    // Do processing and specifically string retrieval in post-parse call so we
-    // would not jump memory between symbols and strings often
-    bool PostParse(MachOParser &Parser) {
-      auto &I = Parser.Input;
-      auto StringTableOffset = Parser.SymbolTable->StringTableOffset;
-      auto StringTableSize = Parser.SymbolTable->StringTableSize;
-
-      SectionNumber = Raw.n_sect;
-      Value = Raw.n_value + Parser.ImageSlide;
-
-      IsStub = Raw.n_type & N_STAB;
-      IsPrivateExternal = Raw.n_type & N_PEXT;
-      IsExtenal = Raw.n_type & N_EXT;
-
-      auto NType = Raw.n_type & N_TYPE;
-      IsUndefined = NType == N_UNDF;
-      IsAbsolute = NType == N_ABS;
-      IsDefined = NType == N_SECT;
-      IsPrebound = NType == N_PBUD;
-      IsIndirect = NType == N_INDR;
-
-      if (IsStub) {
-        ParseStub(Parser);
-      } else {
-        ParseDesc(Parser);
-      }
+    // False with lazy symbols until the store is first asked for
+    bool HasStore() const { return IsStoreBuilt; }
 
-      // For whatever reason symbol table may contain invalid records with
-      // n_strx pointing way beyond its string table limits. Dynamic Loader
-      // just skips those, so does this parser.
-      auto Index = Raw.n_un.n_strx;
-      if (Index > StringTableSize) {
-        return true;
+    // Must be set before the store is built to have any effect
+    void SetStringTableIndex(std::shared_ptr<const StringTableIndex> Index) {
+      StringIndex = std::move(Index);
+    }
+
+    // Takes a store loaded from a symbol index instead of reading the nlist
+    // array and the string table
+    void AdoptStore(MachOParser &Parser, SymbolStore &&Loaded) {
+      this->Parser = &Parser;
+      Store = std::move(Loaded);
+      IsStoreBuilt = true;
+    }
+
+    bool PostParse(MachOParser &Parser) {
+      // Even a table that fails to parse builds an empty store
+      this->Parser = &Parser;
+
+      uint64_t SymbolsOffset;
+      uint64_t SymbolsSize = uint64_t(Raw.nsyms) * sizeof(NList_t);
+      StringTableSize = Raw.strsize;
+      if (!Parser.GetLinkEditOffset(Raw.symoff, SymbolsSize, SymbolsOffset) ||
+          !Parser.GetLinkEditOffset(Raw.stroff, StringTableSize,
+                                    StringTableOffset)) {
+        return false;
       }
 
-      // Zero string table offsets means there is no name for the thing
-      if (Index) {
-        I.seekg(StringTableOffset + Index);
-        Name = ReadNTStringFromInput(I);
+      // Both live in __LINKEDIT next to each other, normally with only the
+      // indirect symbol table in between, so a single read brings them in.
+      // Inputs that can, e.g. mapped files and the shared cache, hand out a
+      // view and nothing is copied.
+      auto Start = std::min<uint64_t>(SymbolsOffset, StringTableOffset);
+      auto End = std::max<uint64_t>(SymbolsOffset + SymbolsSize,
+                                    StringTableOffset + StringTableSize);
+      auto Whole = Parser.ReadRange(Start, End - Start, Buffer);
+      NListData = Whole.Slice(SymbolsOffset - Start, SymbolsSize);
+      StringData = Whole.Slice(StringTableOffset - Start, StringTableSize);
+
+      if (NListData.GetSize() != SymbolsSize ||
+          StringData.GetSize() != StringTableSize) {
+        return false;
       }
 
       return true;
     }
   };
 
-  class MachOSymbolTable : public MachOThing<symtab_command> {
-  public:
-    using MachOThing<symtab_command>::Raw;
-    std::vector<std::shared_ptr<MachOSymbolTableEntry>> Symbols;
+  class MachODySymbolTable : public MachOThing<dysymtab_command> {};
 
-    decltype(Raw.stroff) StringTableOffset;
-    decltype(Raw.strsize) StringTableSize;
+  // Strings of a load command start at Offset from the command and are cut at
+  // its end, the terminator is just padding
+  template <typename C>
+  static bool ReadCommandString(ByteView &Input, const C &Raw,
+                                uint32_t Offset, String_t &String) {
+    if (Offset < sizeof(Raw) || Offset >= Input.GetSize()) {
+      return false;
+    }
+    String = String_t(Input.StringAt(Offset));
+    return true;
+  }
 
+  class MachODyLibrary : public MachOThing<dylib_command> {
   public:
-    bool PostParse(MachOParser &Parser) {
-      // We know that symbol table records reside in __LINKEDIT segment, but
-      // the symoff is given relative to the object file and not segment
-      // itself. We have to subtract segment fileoff from this value to get
-      // segment relative offset.
-      if (auto LinkEdit = Parser.GetSegmentByName(SEG_LINKEDIT)) {
-        auto &I = Parser.Input;
-
-        uint64_t LinkEditOffset =
-            Parser.IsImage ? LinkEdit->VirtualAddress - Parser.ImageAddress
-                           : LinkEdit->FileOffset;
-
-        StringTableOffset = LinkEditOffset + Raw.stroff - LinkEdit->FileOffset;
-        StringTableSize = Raw.strsize;
-
-        I.seekg(LinkEditOffset + Raw.symoff - LinkEdit->FileOffset);
-        for (uint32_t i = 0; i < Raw.nsyms && I.good(); ++i) {
-          ReadAThingFromInputAndPush(I, Symbols);
-        }
+    String_t Name;
 
-        for (auto symbol : Symbols) {
-          symbol->PostParse(Parser);
-          if (!I.good()) {
-            return false;
-          }
-        }
+  public:
+    using MachOThing<dylib_command>::Raw;
+    bool Parse(ByteView &Input) {
+      return ReadCommandString(Input, Raw, Raw.dylib.name.offset, Name);
+    }
+  };
 
-        return true;
-      }
-      return false;
+  class MachODyLinker : public MachOThing<dylinker_command> {
+  public:
+    String_t Name;
+
+  public:
+    using MachOThing<dylinker_command>::Raw;
+    bool Parse(ByteView &Input) {
+      return ReadCommandString(Input, Raw, Raw.name.offset, Name);
     }
   };
 
-  class MachODySymbolTable : public MachOThing<dysymtab_command> {};
+  // Both only locate their data in __LINKEDIT
+  class MachODyldInfo : public MachOThing<dyld_info_command> {};
+  class MachOLinkEditData : public MachOThing<linkedit_data_command> {};
 
-  class MachODyLibrary : public MachOThing<dylib_command> {
+  class MachOUUID : public MachOThing<uuid_command> {};
+
+  class MachORPath : public MachOThing<rpath_command> {
   public:
-    std::string Name;
+    String_t Path;
 
   public:
-    using MachOThing<dylib_command>::Raw;
-    bool Parse(std::istream &I) {
-      I.seekg((size_t)I.tellg() + Raw.dylib.name.offset - sizeof(Raw));
-      Name = ReadNTStringFromInput(I);
-      return true;
+    using MachOThing<rpath_command>::Raw;
+    bool Parse(ByteView &Input) {
+      return ReadCommandString(Input, Raw, Raw.path.offset, Path);
     }
   };
 
-  class MachODyLinker : public MachOThing<dylinker_command> {
+  // Platform, minimum OS and SDK the image was built for, followed by the
+  // tools that built it
+  class MachOBuildVersion : public MachOThing<build_version_command> {
   public:
-    std::string Name;
+    std::vector<build_tool_version> Tools;
 
   public:
-    using MachOThing<dylinker_command>::Raw;
-    bool Parse(std::istream &I) {
-      I.seekg((size_t)I.tellg() + Raw.name.offset - sizeof(Raw));
-      Name = ReadNTStringFromInput(I);
+    using MachOThing<build_version_command>::Raw;
+    bool Parse(ByteView &Input) {
+      if (Raw.ntools >
+          (Input.GetSize() - sizeof(Raw)) / sizeof(build_tool_version)) {
+        return false;
+      }
+      Tools.resize(Raw.ntools);
+      for (auto &Tool : Tools) {
+        if (!Input.Read(&Tool, sizeof(Tool))) {
+          return false;
+        }
+      }
       return true;
     }
   };
 
+  // LC_VERSION_MIN_* of images older than LC_BUILD_VERSION
+  class MachOVersionMin : public MachOThing<version_min_command> {};
+  class MachOSourceVersion : public MachOThing<source_version_command> {};
+
+  // LC_MAIN, entryoff is relative to the mach header
+  class MachOEntryPoint : public MachOThing<entry_point_command> {};
+
+  // A non-zero cryptid means the range is encrypted in the file
+  class MachOEncryptionInfo : public MachOThing<EncryptionCmd_t> {};
+
 private:
   std::string Label;
-  std::istream &Input;
+  I Input;
 
   uint32_t Flags;
-  BoundFlagEq<MO_PARSE_IMAGE> IsImage{Flags};
-  BoundFlagEq<MO_PARSE_FILE> IsFile{Flags};
+  uint32_t Mode;
+  BoundFlagEq<MO_PARSE_IMAGE> IsImage{Mode};
+  BoundFlagEq<MO_PARSE_FILE> IsFile{Mode};
+  BoundFlagAnd<MO_PARSE_LAZY_SYMBOLS> IsLazySymbols{Flags};
 
   // VirtualAddress of the image we parse
   uint64_t ImageAddress;
   uint64_t ImageSlide;
 
+  // Backs Exports if the input cannot hand out views
+  std::vector<char> ExportsBuffer;
+  ExportTrie Exports;
+  FunctionStarts Functions;
+
+  // Back the __DWARF sections if the input cannot hand out views
+  std::vector<std::vector<char>> DwarfBuffers;
+  std::shared_ptr<DwarfLineTable> LineTable;
+  std::shared_ptr<DwarfIndex> DebugIndex;
+
+  // Built from the symbols on first use
+  DebugMap Map;
+  bool IsDebugMapBuilt;
+
+  // Back the unwind sections if the input cannot hand out views
+  std::vector<char> UnwindBuffer;
+  std::vector<char> EhFrameBuffer;
+  CompactUnwind Unwind;
+  EhFrame Frames;
+  bool IsUnwindInfoRead;
+
+  // Back the fixups blob and the segments if the input cannot hand out views
+  std::vector<std::vector<char>> FixupsBuffers;
+  ChainedFixups Fixups;
+  bool IsFixupsRead;
+
+  // Where parsed symbols of images with LC_UUID are saved and looked up
+  const SymbolIndexCache *IndexCache;
+
+  // Backs the header and the load commands if the input cannot hand out views
+  std::vector<char> CommandsBuffer;
+
+  // Load commands nothing in the parser knows of
+  uint32_t UnknownCommandCount;
+
 public:
   std::shared_ptr<MachOHeader> Header;
   std::vector<std::shared_ptr<MachOSegment>> Segments;
@@ -460,12 +529,156 @@ public:
   std::shared_ptr<MachODyLibrary> DyLibraryId;
   std::shared_ptr<MachODyLinker> DyLinker;
   std::shared_ptr<MachODyLinker> DyLinkerId;
+  std::shared_ptr<MachODyldInfo> DyldInfo;
+  std::shared_ptr<MachOLinkEditData> DyldExportsTrie;
+  std::shared_ptr<MachOLinkEditData> FunctionStartsData;
+  std::shared_ptr<MachOLinkEditData> DyldChainedFixups;
+  std::shared_ptr<MachOLinkEditData> CodeSignature;
+  std::shared_ptr<MachOLinkEditData> SegmentSplitInfo;
+  std::shared_ptr<MachOLinkEditData> DataInCode;
+  std::shared_ptr<MachOUUID> UUID;
+  std::vector<std::shared_ptr<MachORPath>> RPaths;
+  std::shared_ptr<MachOBuildVersion> BuildVersion;
+  std::shared_ptr<MachOVersionMin> VersionMin;
+  std::shared_ptr<MachOSourceVersion> SourceVersion;
+  std::shared_ptr<MachOEntryPoint> EntryPoint;
+  std::shared_ptr<MachOEncryptionInfo> EncryptionInfo;
 
 public:
-  MachOParser(std::string Label, std::istream &Input, uint32_t Flags,
+  MachOParser(std::string Label, I Input, uint32_t Flags,
               uint64_t ImageAddress = 0)
-      : Label(Label), Input(Input), Flags(Flags), ImageAddress(ImageAddress),
-        ImageSlide(0) {}
+      : Label(Label), Input(Input), Flags(Flags),
+        Mode(Flags & MO_PARSE_MODE_MASK), ImageAddress(ImageAddress),
+        ImageSlide(0), IsDebugMapBuilt(false), IsUnwindInfoRead(false),
+        IsFixupsRead(false), IndexCache(nullptr), UnknownCommandCount(0) {}
+
+  bool HasLazySymbols() const { return bool(IsLazySymbols); }
+
+  // E.g. commands newer than the parser, they are skipped
+  uint32_t GetUnknownCommandCount() const { return UnknownCommandCount; }
+
+  // Must be set before parsing to have any effect
+  void SetSymbolIndexCache(const SymbolIndexCache *Cache) {
+    IndexCache = Cache;
+  }
+
+  const ExportTrie &GetExports() const { return Exports; }
+  const FunctionStarts &GetFunctionStarts() const { return Functions; }
+
+  // Slid [Start, End) of the function that contains Address
+  bool GetFunctionRange(uint64_t Address, uint64_t &Start, uint64_t &End) {
+    return Functions.Lookup(Address, Start, End);
+  }
+
+  uint64_t GetImageSlide() const { return ImageSlide; }
+
+  // __DWARF,__debug_line, read on first call. Linked images leave their
+  // debug info to dSYMs and object files, so only files have one. Addresses
+  // are the unslid ones.
+  DwarfLineTable *GetLineTable() {
+    if (!LineTable) {
+      LineTable = std::make_shared<DwarfLineTable>();
+      auto DWARF = GetSegmentByName("__DWARF");
+      if (IsFile && DWARF) {
+        auto Lines = ReadDwarfSection(*DWARF, "__debug_line");
+        auto LineStrings = ReadDwarfSection(*DWARF, "__debug_line_str");
+        auto Strings = ReadDwarfSection(*DWARF, "__debug_str");
+        *LineTable = DwarfLineTable(Lines, LineStrings, Strings);
+      }
+    }
+    return LineTable->IsEmpty() ? nullptr : LineTable.get();
+  }
+
+  // STABS debug map of the symbol table. Builds the symbol store of a lazy
+  // parser. Addresses are the unslid ones.
+  const DebugMap *GetDebugMap() {
+    if (!IsDebugMapBuilt && SymbolTable) {
+      Map.Build(SymbolTable->GetStore());
+      IsDebugMapBuilt = true;
+    }
+    return Map.IsEmpty() ? nullptr : &Map;
+  }
+
+  // DIEs of __DWARF and the accelerator tables to find them with, read on
+  // first call. Files only, like the line table.
+  DwarfIndex *GetDwarfIndex() {
+    if (!DebugIndex) {
+      DebugIndex = std::make_shared<DwarfIndex>();
+      auto DWARF = GetSegmentByName("__DWARF");
+      if (IsFile && DWARF) {
+        DwarfSections Sections;
+        // Section names are cut at 16 characters
+        Sections.Info = ReadDwarfSection(*DWARF, "__debug_info");
+        Sections.Abbrev = ReadDwarfSection(*DWARF, "__debug_abbrev");
+        Sections.Str = ReadDwarfSection(*DWARF, "__debug_str");
+        Sections.StrOffsets = ReadDwarfSection(*DWARF, "__debug_str_offs");
+        Sections.Addr = ReadDwarfSection(*DWARF, "__debug_addr");
+        Sections.LineStr = ReadDwarfSection(*DWARF, "__debug_line_str");
+        Sections.AppleNames = ReadDwarfSection(*DWARF, "__apple_names");
+        Sections.AppleTypes = ReadDwarfSection(*DWARF, "__apple_types");
+        Sections.AppleObjC = ReadDwarfSection(*DWARF, "__apple_objc");
+        Sections.Names = ReadDwarfSection(*DWARF, "__debug_names");
+        *DebugIndex = DwarfIndex(Sections);
+      }
+    }
+    return DebugIndex->IsEmpty() ? nullptr : DebugIndex.get();
+  }
+
+  // __TEXT,__unwind_info, read on first call like __eh_frame. Both are there
+  // for images and files alike and their addresses are slid.
+  const CompactUnwind *GetCompactUnwind() {
+    ReadUnwindInfo();
+    return Unwind.IsEmpty() ? nullptr : &Unwind;
+  }
+
+  EhFrame *GetEhFrame() {
+    ReadUnwindInfo();
+    return Frames.IsEmpty() ? nullptr : &Frames;
+  }
+
+  // LC_DYLD_CHAINED_FIXUPS, decoded on first call. The chains are only there
+  // in the file, dyld overwrites them in memory, so images have none.
+  // Addresses are the unslid ones.
+  const ChainedFixups *GetChainedFixups() {
+    if (!IsFixupsRead) {
+      IsFixupsRead = true;
+      ReadChainedFixups();
+    }
+    return Fixups.IsEmpty() ? nullptr : &Fixups;
+  }
+
+  // Address of an export defined by this very image. Re-exports and
+  // thread-local variables have none.
+  bool GetExportAddress(std::string_view Name, uint64_t &Address) {
+    ExportTrie::Export Export;
+    return Exports.Lookup(Name, Export) && GetExportAddress(Export, Address);
+  }
+
+  // Same for an export already looked up in GetExports()
+  bool GetExportAddress(const ExportTrie::Export &Export, uint64_t &Address) {
+    if (Export.IsReExport()) {
+      return false;
+    }
+
+    switch (Export.GetKind()) {
+    case EXPORT_SYMBOL_FLAGS_KIND_REGULAR: {
+      // Offsets are relative to the mach header, i.e. to the start of the
+      // already slid __TEXT
+      auto Text = GetSegmentByName(SEG_TEXT);
+      if (!Text) {
+        return false;
+      }
+      Address = Text->VirtualAddress + Export.Address;
+      return true;
+    }
+    case EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE: {
+      Address = Export.Address;
+      return true;
+    }
+    }
+
+    return false;
+  }
 
   std::shared_ptr<MachOSegment> GetSegmentByName(std::string Name) {
     for (auto &Segment : Segments) {
@@ -476,102 +689,197 @@ public:
     return nullptr;
   }
 
+  // Indexes come from the input, zero is NO_SECT
   std::shared_ptr<MachOSegment> GetSegmentByIndex(unsigned Index) {
-    assert(Index && "Index must not be zero");
-    if (Segments.size() >= Index) {
+    if (Index && Segments.size() >= Index) {
       return Segments.at(Index - 1);
     }
     return nullptr;
   }
 
   std::shared_ptr<MachOSection> GetSectionByIndex(unsigned Index) {
-    assert(Index && "Index must not be zero");
-    if (Sections.size() >= Index) {
+    if (Index && Sections.size() >= Index) {
       return Sections.at(Index - 1);
     }
     return nullptr;
   }
 
   bool Parse() {
-    uint64_t mainptr = 0;
-    Input.seekg(mainptr);
-    ReadAThingFromInput(Input, Header);
-    mainptr += sizeof(mach_header_64);
+    // The header and then all of the load commands are read in one go, every
+    // command is a slice of them
+    auto HeaderData = ReadRange(0, sizeof(HeaderCmd_t), CommandsBuffer);
+    if (!ReadAThingFromInput(HeaderData, Header, HeaderData.GetSize()) ||
+        Header->Raw.magic != (Is32 ? MH_MAGIC : MH_MAGIC_64)) {
+      Header = nullptr;
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("No MachO header in", Label);
+      return false;
+    }
     PRINT_DEBUG("HEADER magic: ", HEX(Header->Raw.magic),
                 ", ncmds: ", Header->Raw.ncmds);
 
-    for (uint32_t i = 0; i < Header->Raw.ncmds; ++i) {
-      load_command loadcmd;
-      Input.seekg(mainptr);
-      Input.read((char *)&loadcmd, sizeof(load_command));
-      Input.seekg(mainptr);
-
-      switch (loadcmd.cmd) {
-
-      case lc_segment: {
-        ReadAThingFromInputAndPush(Input, Segments);
-        auto Segment = Segments.back();
-        break;
-      }
-
-      case LC_SYMTAB: {
-        ReadAThingFromInput(Input, SymbolTable);
-        assert(SymbolTable);
-        break;
-      }
-
-      case LC_DYSYMTAB: {
-        ReadAThingFromInput(Input, DySymbolTable);
-        break;
-      }
-
-      case LC_ID_DYLIB: {
-        ReadAThingFromInput(Input, DyLibraryId);
-        break;
-      }
-
-      case LC_LOAD_DYLIB:
-      case LC_LOAD_WEAK_DYLIB:
-      case LC_REEXPORT_DYLIB: {
-        ReadAThingFromInputAndPush(Input, DyLibraries);
-        break;
-      }
+    // However many commands ncmds claims, they all fit in sizeofcmds
+    auto Commands = ReadRange(sizeof(HeaderCmd_t), Header->Raw.sizeofcmds,
+                              CommandsBuffer);
+    if (Commands.GetSize() != Header->Raw.sizeofcmds) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Truncated load commands in", Label);
+      return false;
+    }
 
-      case LC_ID_DYLINKER: {
-        ReadAThingFromInput(Input, DyLinkerId);
-        break;
-      }
+    static constexpr LoadCommandTable_t LoadCommands = MakeLoadCommandTable();
 
-      case LC_LOAD_DYLINKER: {
-        ReadAThingFromInput(Input, DyLinker);
-        break;
-      }
-      default: {
-        PRINT_DEBUG("UNKNOWN LOAD COMMAND ", loadcmd.cmd);
-        break;
-      }
+    UnknownCommandCount = 0;
+    uint64_t Offset = 0;
+    for (uint32_t i = 0; i < Header->Raw.ncmds; ++i) {
+      load_command loadcmd;
+      if (!Commands.ReadAt(Offset, loadcmd) ||
+          loadcmd.cmdsize < sizeof(load_command) ||
+          !Commands.Contains(Offset, loadcmd.cmdsize)) {
+        Error Err(MAD_ERROR_PARSER);
+        Err.Log("Malformed load command", i, "in", Label, "at",
+                sizeof(HeaderCmd_t) + Offset);
+        return false;
       }
 
-      if (!Input.good()) {
+      auto Command = Commands.Slice(Offset, loadcmd.cmdsize);
+      auto Handler = LoadCommands[GetLoadCommandSlot(loadcmd.cmd)];
+      if (!Handler) {
+        ++UnknownCommandCount;
+      } else if (!(this->*Handler)(Command)) {
         Error Err(MAD_ERROR_PARSER);
-        Err.Log("Faild to parse", Label, "at", mainptr);
+        Err.Log("Faild to parse", Label, "at", sizeof(HeaderCmd_t) + Offset);
         return false;
       }
 
-      mainptr += loadcmd.cmdsize;
+      Offset += loadcmd.cmdsize;
     }
 
     return PostParse();
   }
 
 private:
+  // Load commands are dispatched through a table built at compile time and
+  // indexed by the command, the ones with LC_REQ_DYLD in the upper half.
+  // Commands the parser has no use for are skipped, empty slots are unknown.
+  using LoadCommandHandler_t = bool (MachOParser::*)(ByteView &);
+  using LoadCommandTable_t =
+      std::array<LoadCommandHandler_t, 2 * MO_LOAD_COMMAND_LIMIT>;
+
+  static constexpr uint32_t GetLoadCommandSlot(uint32_t Cmd) {
+    uint32_t Slot = Cmd & ~LC_REQ_DYLD;
+    if (Slot >= MO_LOAD_COMMAND_LIMIT) {
+      return 0;
+    }
+    return Cmd & LC_REQ_DYLD ? Slot + MO_LOAD_COMMAND_LIMIT : Slot;
+  }
+
+  template <auto Member> bool ReadCommand(ByteView &Command) {
+    return ReadAThingFromInput(Command, this->*Member, Command.GetSize());
+  }
+
+  template <auto Member> bool PushCommand(ByteView &Command) {
+    return ReadAThingFromInputAndPush(Command, this->*Member,
+                                      Command.GetSize());
+  }
+
+  bool SkipCommand(ByteView &) { return true; }
+
+  static constexpr LoadCommandTable_t MakeLoadCommandTable() {
+    LoadCommandTable_t Table = {};
+    // Slot 0 is no command and stays empty for the ones out of range
+    auto Add = [&Table](uint32_t Cmd, LoadCommandHandler_t Handler) {
+      Table[GetLoadCommandSlot(Cmd)] = Handler;
+    };
+    using P = MachOParser;
+
+    Add(lc_segment, &P::PushCommand<&P::Segments>);
+    Add(LC_SYMTAB, &P::ReadCommand<&P::SymbolTable>);
+    Add(LC_DYSYMTAB, &P::ReadCommand<&P::DySymbolTable>);
+    Add(LC_UUID, &P::ReadCommand<&P::UUID>);
+
+    // Libraries and the dynamic linker
+    Add(LC_ID_DYLIB, &P::ReadCommand<&P::DyLibraryId>);
+    Add(LC_LOAD_DYLIB, &P::PushCommand<&P::DyLibraries>);
+    Add(LC_LOAD_WEAK_DYLIB, &P::PushCommand<&P::DyLibraries>);
+    Add(LC_REEXPORT_DYLIB, &P::PushCommand<&P::DyLibraries>);
+    Add(LC_LAZY_LOAD_DYLIB, &P::PushCommand<&P::DyLibraries>);
+    Add(LC_LOAD_UPWARD_DYLIB, &P::PushCommand<&P::DyLibraries>);
+    Add(LC_ID_DYLINKER, &P::ReadCommand<&P::DyLinkerId>);
+    Add(LC_LOAD_DYLINKER, &P::ReadCommand<&P::DyLinker>);
+    Add(LC_RPATH, &P::PushCommand<&P::RPaths>);
+    Add(LC_MAIN, &P::ReadCommand<&P::EntryPoint>);
+
+    // Data in __LINKEDIT
+    Add(LC_DYLD_INFO, &P::ReadCommand<&P::DyldInfo>);
+    Add(LC_DYLD_INFO_ONLY, &P::ReadCommand<&P::DyldInfo>);
+    Add(LC_DYLD_EXPORTS_TRIE, &P::ReadCommand<&P::DyldExportsTrie>);
+    Add(LC_DYLD_CHAINED_FIXUPS, &P::ReadCommand<&P::DyldChainedFixups>);
+    Add(LC_FUNCTION_STARTS, &P::ReadCommand<&P::FunctionStartsData>);
+    Add(LC_CODE_SIGNATURE, &P::ReadCommand<&P::CodeSignature>);
+    Add(LC_SEGMENT_SPLIT_INFO, &P::ReadCommand<&P::SegmentSplitInfo>);
+    Add(LC_DATA_IN_CODE, &P::ReadCommand<&P::DataInCode>);
+    Add(lc_encryption_info, &P::ReadCommand<&P::EncryptionInfo>);
+
+    // Versions
+    Add(LC_BUILD_VERSION, &P::ReadCommand<&P::BuildVersion>);
+    Add(LC_VERSION_MIN_MACOSX, &P::ReadCommand<&P::VersionMin>);
+    Add(LC_VERSION_MIN_IPHONEOS, &P::ReadCommand<&P::VersionMin>);
+    Add(LC_VERSION_MIN_TVOS, &P::ReadCommand<&P::VersionMin>);
+    Add(LC_VERSION_MIN_WATCHOS, &P::ReadCommand<&P::VersionMin>);
+    Add(LC_SOURCE_VERSION, &P::ReadCommand<&P::SourceVersion>);
+
+    // Known, but of no use to a debugger
+    Add(Is32 ? LC_SEGMENT_64 : LC_SEGMENT, &P::SkipCommand);
+    Add(Is32 ? LC_ENCRYPTION_INFO_64 : LC_ENCRYPTION_INFO, &P::SkipCommand);
+    Add(LC_ROUTINES, &P::SkipCommand);
+    Add(LC_ROUTINES_64, &P::SkipCommand);
+    Add(LC_THREAD, &P::SkipCommand);
+    Add(LC_UNIXTHREAD, &P::SkipCommand);
+    Add(LC_SYMSEG, &P::SkipCommand);
+    Add(LC_LOADFVMLIB, &P::SkipCommand);
+    Add(LC_IDFVMLIB, &P::SkipCommand);
+    Add(LC_IDENT, &P::SkipCommand);
+    Add(LC_FVMFILE, &P::SkipCommand);
+    Add(LC_PREPAGE, &P::SkipCommand);
+    Add(LC_PREBOUND_DYLIB, &P::SkipCommand);
+    Add(LC_PREBIND_CKSUM, &P::SkipCommand);
+    Add(LC_TWOLEVEL_HINTS, &P::SkipCommand);
+    Add(LC_SUB_FRAMEWORK, &P::SkipCommand);
+    Add(LC_SUB_UMBRELLA, &P::SkipCommand);
+    Add(LC_SUB_CLIENT, &P::SkipCommand);
+    Add(LC_SUB_LIBRARY, &P::SkipCommand);
+    Add(LC_DYLD_ENVIRONMENT, &P::SkipCommand);
+    Add(LC_DYLIB_CODE_SIGN_DRS, &P::SkipCommand);
+    Add(LC_LINKER_OPTION, &P::SkipCommand);
+    Add(LC_LINKER_OPTIMIZATION_HINT, &P::SkipCommand);
+    Add(LC_NOTE, &P::SkipCommand);
+    Add(LC_FILESET_ENTRY, &P::SkipCommand);
+    return Table;
+  }
+
   bool PostParse() {
-    HandleASLR();
+    if (!HandleASLR()) {
+      return false;
+    }
 
-    if (SymbolTable) {
-      SymbolTable->PostParse(*this);
+    // A saved index replaces both the symbol table and the function starts,
+    // neither has to be read then
+    if (!LoadSymbolIndex()) {
+      bool HasSymbols = SymbolTable && SymbolTable->PostParse(*this);
+      if (SymbolTable && !HasSymbols) {
+        Error Err(MAD_ERROR_PARSER);
+        Err.Log("Malformed symbol table in", Label);
+      }
+      ParseFunctionStarts();
+      // The index is saved along with the store, so function starts go first
+      if (HasSymbols && !IsLazySymbols) {
+        SymbolTable->GetStore();
+      }
     }
 
+    ParseExports();
+
     // Push every segment's sections into Sections vector so they could be
     // retrieved via appearance index
     for (auto &Segment : Segments) {
@@ -582,16 +890,255 @@ private:
     return true;
   }
 
+  // Images without LC_UUID cannot be told apart and are never indexed
+  bool GetSymbolIndexKey(SymbolIndexKey &Key) {
+    auto Text = GetSegmentByName(SEG_TEXT);
+    if (!IndexCache || !IndexCache->IsEnabled() || !UUID || !SymbolTable ||
+        !Text) {
+      return false;
+    }
+
+    memset(&Key, 0, sizeof(Key));
+    memcpy(Key.UUID, UUID->Raw.uuid, sizeof(Key.UUID));
+    Key.Kind = (Is64 ? MO_SYMBOL_INDEX_64 : 0) |
+               (Header->IsTypeObject ? MO_SYMBOL_INDEX_OBJECT : 0) |
+               (IsImage ? MO_SYMBOL_INDEX_IMAGE : 0) |
+               (Header->IsTwoLevel ? MO_SYMBOL_INDEX_TWO_LEVEL : 0);
+    Key.SymbolCount = SymbolTable->Raw.nsyms;
+    Key.StringTableSize = SymbolTable->Raw.strsize;
+    Key.FunctionStartsSize =
+        FunctionStartsData ? FunctionStartsData->Raw.datasize : 0;
+    Key.TextAddress = Text->VirtualAddress - ImageSlide;
+    return true;
+  }
+
+  bool LoadSymbolIndex() {
+    SymbolIndexKey Key;
+    SymbolStore Store;
+    FunctionStarts Starts;
+    if (!GetSymbolIndexKey(Key) ||
+        !IndexCache->Load(Key, ImageSlide, Store, Starts)) {
+      return false;
+    }
+
+    PRINT_DEBUG("Loaded symbol index of", Label);
+    SymbolTable->AdoptStore(*this, std::move(Store));
+    Functions = std::move(Starts);
+    return true;
+  }
+
+  // Called once the store is built, function starts are decoded by then
+  void SaveSymbolIndex(const SymbolStore &Store) {
+    SymbolIndexKey Key;
+    // A malformed symbol table leaves the store short of nsyms rows
+    if (GetSymbolIndexKey(Key) && Store.GetSize() == Key.SymbolCount) {
+      IndexCache->Save(Key, Store, Functions);
+    }
+  }
+
+  // Points into the input if it can be sliced, otherwise the range is read
+  // into Buffer. Returns an empty view on failure.
+  ByteView ReadRange(uint64_t Offset, uint64_t Size,
+                     std::vector<char> &Buffer) {
+    auto View = Input.Slice(Offset, Size);
+    if (View.GetSize() == Size) {
+      return View;
+    }
+    // What a mapped file cannot slice is not there
+    if constexpr (std::is_same_v<I, ByteView>) {
+      return ByteView();
+    }
+
+    Buffer.clear();
+    Input.Seek(Offset);
+    while (Buffer.size() < Size) {
+      // Doubling keeps the copies of a huge range amortized
+      uint64_t Chunk =
+          std::min<uint64_t>(Size - Buffer.size(),
+                             std::max<uint64_t>(Buffer.size(), MO_READ_CHUNK));
+      Buffer.resize(Buffer.size() + Chunk);
+      if (!Input.Read(Buffer.data() + Buffer.size() - Chunk, Chunk)) {
+        return ByteView();
+      }
+    }
+    return ByteView(Buffer.data(), Buffer.size());
+  }
+
+  // Input offset of a file range that must lie within __LINKEDIT.
+  //
+  // We know that e.g. symbol table records reside in __LINKEDIT segment, but
+  // the symoff is given relative to the object file and not segment itself.
+  // We have to subtract segment fileoff from this value to get segment
+  // relative offset.
+  bool GetLinkEditOffset(uint64_t FileOffset, uint64_t Size,
+                         uint64_t &Offset) {
+    auto LinkEdit = GetSegmentByName(SEG_LINKEDIT);
+    if (!LinkEdit || FileOffset < LinkEdit->FileOffset ||
+        FileOffset - LinkEdit->FileOffset > LinkEdit->FileSize ||
+        Size > LinkEdit->FileSize - (FileOffset - LinkEdit->FileOffset)) {
+      return false;
+    }
+
+    uint64_t LinkEditOffset = IsImage
+                                  ? LinkEdit->VirtualAddress - ImageAddress
+                                  : LinkEdit->FileOffset;
+    Offset = LinkEditOffset + FileOffset - LinkEdit->FileOffset;
+    // Offset + Size is computed by every caller
+    return Offset + Size >= Offset;
+  }
+
+  // Maps a file range that lives in __LINKEDIT onto the input
+  ByteView ReadLinkEdit(uint64_t FileOffset, uint64_t Size,
+                        std::vector<char> &Buffer) {
+    uint64_t Offset;
+    if (!GetLinkEditOffset(FileOffset, Size, Offset)) {
+      return ByteView();
+    }
+    return ReadRange(Offset, Size, Buffer);
+  }
+
+  // Same as ReadLinkEdit for a section of any segment
+  ByteView ReadSection(const MachOSection &Section, std::vector<char> &Buffer) {
+    uint64_t Offset = IsImage ? Section.VirtualAddress - ImageAddress
+                              : Section.FileOffset;
+    return ReadRange(Offset, Section.VirtualSize, Buffer);
+  }
+
+  void ReadUnwindInfo() {
+    if (IsUnwindInfoRead) {
+      return;
+    }
+    IsUnwindInfoRead = true;
+
+    auto Text = GetSegmentByName(SEG_TEXT);
+    if (!Text) {
+      return;
+    }
+
+    // Function offsets are relative to the mach header
+    if (auto Section = Text->GetSectionByName("__unwind_info")) {
+      Unwind = CompactUnwind(ReadSection(*Section, UnwindBuffer),
+                             Text->VirtualAddress);
+      if (Unwind.IsEmpty()) {
+        Error Err(MAD_ERROR_PARSER);
+        Err.Log("Malformed unwind info in", Label);
+      }
+    }
+    if (auto Section = Text->GetSectionByName("__eh_frame")) {
+      Frames = EhFrame(ReadSection(*Section, EhFrameBuffer),
+                       Section->VirtualAddress);
+    }
+  }
+
+  void ReadChainedFixups() {
+    auto Text = GetSegmentByName(SEG_TEXT);
+    if (!IsFile || !DyldChainedFixups || !Text) {
+      return;
+    }
+
+    auto Data = ReadLinkEdit(DyldChainedFixups->Raw.dataoff,
+                             DyldChainedFixups->Raw.datasize,
+                             FixupsBuffers.emplace_back());
+    // Starts are per segment in the order of the commands
+    std::vector<ByteView> Contents;
+    for (auto &Segment : Segments) {
+      Contents.push_back(ReadRange(Segment->FileOffset, Segment->FileSize,
+                                   FixupsBuffers.emplace_back()));
+    }
+
+    Fixups = ChainedFixups(Data, Text->Raw.vmaddr, Contents);
+    if (Fixups.IsEmpty()) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed chained fixups in", Label);
+    }
+  }
+
+  ByteView ReadDwarfSection(MachOSegment &DWARF, std::string Name) {
+    auto Section = DWARF.GetSectionByName(Name);
+    if (!Section) {
+      return ByteView();
+    }
+
+    auto View = ReadRange(Section->FileOffset, Section->VirtualSize,
+                          DwarfBuffers.emplace_back());
+    if (View.GetSize() != Section->VirtualSize) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Could not read", Name, "of", Label);
+      return ByteView();
+    }
+    return View;
+  }
+
+  void ParseExports() {
+    uint64_t Offset = 0;
+    uint64_t Size = 0;
+
+    // LC_DYLD_EXPORTS_TRIE replaces LC_DYLD_INFO on chained fixups images
+    if (DyldExportsTrie) {
+      Offset = DyldExportsTrie->Raw.dataoff;
+      Size = DyldExportsTrie->Raw.datasize;
+    } else if (DyldInfo) {
+      Offset = DyldInfo->Raw.export_off;
+      Size = DyldInfo->Raw.export_size;
+    }
+
+    if (!Size) {
+      return;
+    }
+
+    Exports = ExportTrie(ReadLinkEdit(Offset, Size, ExportsBuffer));
+    if (Exports.IsEmpty()) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Could not read exports trie of", Label);
+    }
+  }
+
+  void ParseFunctionStarts() {
+    auto Text = GetSegmentByName(SEG_TEXT);
+    if (!FunctionStartsData || !Text) {
+      return;
+    }
+
+    // The data is only needed while decoding
+    std::vector<char> Buffer;
+    auto Data = ReadLinkEdit(FunctionStartsData->Raw.dataoff,
+                             FunctionStartsData->Raw.datasize, Buffer);
+    if (!Functions.Decode(Data, Text->VirtualAddress)) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed function starts in", Label);
+      Functions = FunctionStarts();
+      return;
+    }
+
+    if (Functions.IsEmpty()) {
+      return;
+    }
+
+    // The last function ends with its section, normally __text
+    auto Last = Functions.GetStart(Functions.GetSize() - 1);
+    Functions.SetLimit(Text->VirtualAddress + Text->VirtualSize);
+    for (auto &Section : Text->Sections) {
+      if (Last >= Section->VirtualAddress &&
+          Last - Section->VirtualAddress < Section->VirtualSize) {
+        Functions.SetLimit(Section->VirtualAddress + Section->VirtualSize);
+        break;
+      }
+    }
+  }
+
   // FIXME: Design Issue:
   // This seems like a bad choice to handle ASLR in parser, but without knowing
   // the slide it is not possible(in general case) to parse symbol table in
   // memory.
-  void HandleASLR() {
+  bool HandleASLR() {
     // DyLD is a subject to ASLR(though it is a non-pie binary), and this works
     // because MacOS's x86-64 only user-space code model is very similar to
     // AMD64 Small PIE. In this case we have to adjust provided value to
     // pinpoint the symbol we are looking for.
-    if (IsImage && (Header->IsPIE || Header->IsTypeDynamicLinker)) {
+    //
+    // Dylibs and bundles are slid without MH_PIE, and an image that is not
+    // slid simply has none, so every image gets its slide.
+    if (IsImage) {
 
       // Slide is the distance between requested virtual address and assigned
       // after ASLR. It is calculated by subtracting vmaddr of the __TEXT
@@ -602,18 +1149,29 @@ private:
       // DyLD, though, does not use __TEXT segment directly but rather
       // selects a segment that has no file offset (fileoff == 0) and has
       // non-zero size (filesize != 0) which selects __TEXT.
-      ImageSlide = ImageAddress - GetSegmentByName(SEG_TEXT)->VirtualAddress;
+      auto Text = GetSegmentByName(SEG_TEXT);
+      if (!Text) {
+        Error Err(MAD_ERROR_PARSER);
+        Err.Log("No __TEXT segment in", Label);
+        return false;
+      }
+      ImageSlide = ImageAddress - Text->VirtualAddress;
 
       for (auto &Segment : Segments) {
         Segment->ApplyVirtualMemorySlide(ImageSlide);
       }
     }
+    return true;
   }
 };
 
 using MachOParser32 = MachOParser<MachSystem32_t>;
 using MachOParser64 = MachOParser<MachSystem64_t>;
 
+// File-mode parsers reading straight out of a mapped file
+using MachOFileParser32 = MachOParser<MachSystem32_t, ByteView>;
+using MachOFileParser64 = MachOParser<MachSystem64_t, ByteView>;
+
 } // namespace mad
 
 #endif /* end of include guard: MACHOPARSER_HPP_L6XJ5WJN */
@@ -3,6 +3,7 @@
 
 // #include <CoreFoundation/CoreFoundation.h>
 
+#include <algorithm>
 #include <map>
 #include <string>
 #include <unistd.h>
@@ -13,7 +14,13 @@
 
 #include "MAD/MachTask.hpp"
 #include <MAD/Error.hpp>
+#include <MAD/GlobalSymbolIndex.hpp>
+#include <MAD/ImageAddressMap.hpp>
+#include <MAD/ImportResolver.hpp>
 #include <MAD/MachImage.hpp>
+#include <MAD/SharedCache.hpp>
+#include <MAD/SymbolIndexCache.hpp>
+#include <MAD/Symbolicator.hpp>
 
 namespace mad {
 
@@ -42,13 +49,49 @@ private:
   pid_t PID;
   MachTask Task;
   MachMemory &Memory;
+  // Must outlive the images that read from it
+  SharedCache Cache;
+  SymbolIndexCache SymbolIndex;
   std::vector<std::shared_ptr<MachImage64>> Images;
   std::map<std::string, std::shared_ptr<MachImage64>> ImagesByName;
   std::map<unsigned, std::vector<std::shared_ptr<MachImage64>>> ImagesByType;
+  ImageAddressMap<MachImage64> ImagesByAddress;
+  GlobalSymbolIndex<MachImage64> GlobalSymbols;
+  // Binds through the images of GlobalSymbols
+  ImportResolver<MachImage64> Imports;
 
 private:
   int RunTarget();
-  void FindAllImages();
+  void OpenSharedCache(void *Info);
+
+  // Every map of the images is kept in sync through these
+  void AddImage(const std::shared_ptr<MachImage64> &Image) {
+    ImagesByName.insert({Image->GetPath(), Image});
+    ImagesByType[Image->GetType()].push_back(Image);
+    ImagesByAddress.AddImage(Image);
+    GlobalSymbols.AddImage(Image);
+    Images.push_back(Image);
+  }
+  void RemoveImage(const std::shared_ptr<MachImage64> &Image) {
+    auto ByName = ImagesByName.find(Image->GetPath());
+    if (ByName != ImagesByName.end() && ByName->second == Image) {
+      ImagesByName.erase(ByName);
+    }
+    auto &SameType = ImagesByType[Image->GetType()];
+    SameType.erase(std::remove(SameType.begin(), SameType.end(), Image),
+                   SameType.end());
+    ImagesByAddress.RemoveImage(Image);
+    GlobalSymbols.RemoveImage(Image);
+    Images.erase(std::remove(Images.begin(), Images.end(), Image),
+                 Images.end());
+  }
+  void ClearImages() {
+    Images.clear();
+    ImagesByName.clear();
+    ImagesByType.clear();
+    ImagesByAddress.Clear();
+    GlobalSymbols.Clear();
+  }
 
 public:
   MachProcess(std::string exec);
@@ -62,14 +105,39 @@ public:
   vm_size_t WriteMemory(vm_address_t address, vm_offset_t data,
                         mach_msg_type_number_t count);
 
+  // Brings the images up to date with the ones dyld has loaded, e.g. on its
+  // debugger notification. Images loaded since the last call are added to
+  // every map and the unloaded ones removed, both in the order dyld lists
+  // them. Images that stay are left as they are.
+  void UpdateImages(std::vector<std::shared_ptr<MachImage64>> &Added,
+                    std::vector<std::shared_ptr<MachImage64>> &Removed);
+
+  // Value of the pointer at Address. Pointers dyld fixed up through chained
+  // fixups are computed from the image's file and the slide, the rest are
+  // read from the target. For clients reading GOT entries, vtables or class
+  // lists, MAD itself reads no fixed up pointers.
+  bool ReadPointer(uint64_t Address, uint64_t &Value);
+
   pid_t GetPID() { return PID; }
   bool IsParent() { return PID > 0; }
 
   auto &GetTask() { return Task; };
+  auto &GetSharedCache() { return Cache; }
+  auto &GetSymbolIndex() { return SymbolIndex; }
 
   auto &GetImagess() { return Images; }
   auto GetImagesByName(std::string Name) { return ImagesByName[Name]; }
   auto GetImagesByType(unsigned Type) { return ImagesByType[Type]; }
+  auto &GetImagesByAddress() { return ImagesByAddress; }
+  // Definitions of a name in every image, see GlobalSymbolIndex
+  auto &GetGlobalSymbols() { return GlobalSymbols; }
+
+  // Symbol, offset and line of every address, in the order given. Meant for
+  // batches, e.g. samples or the frames of every thread.
+  auto Symbolicate(const uint64_t *Addresses, size_t Count) {
+    return Symbolicator<MachImage64>(ImagesByAddress)
+        .Symbolicate(Addresses, Count);
+  }
 
   auto GetDynamicLinkerImage() {
     auto &List = ImagesByType[MH_DYLINKER];
@@ -110,45 +110,36 @@ public:
   }
 
   std::streamsize xsgetn(char_type *Out, std::streamsize Count) {
+    // Bulk reads, e.g. a whole symbol table, go to the task memory directly
+    // instead of being chopped into pages
+    if (Count > (std::streamsize)PageSize) {
+      auto Read = Memory.Read(Address, Count, Out);
+      AdvancePosition(Read);
+      return Read;
+    }
+
     if (!UpdateBufferIfNeeded()) {
       return 0;
     }
 
     auto Written = 0;
 
-    // If the requested data sits on 2+ pages we handle this explicitly
+    // If the requested data sits on two pages we handle this explicitly
     auto LastBytePageStart = (Address + Count - 1) & PageMask;
     if (LastBytePageStart != PageStart) {
-      // Write what'Out left on the current page
+      // Write what's left on the current page
       auto LeftHere = PageSize - (Address % PageSize);
       memcpy(Out, PageBuffer.data() + (Address % PageSize), LeftHere);
       AdvancePosition(LeftHere);
+      Out += LeftHere;
       Written += LeftHere;
       Count -= LeftHere;
 
-      // If the read range occupies more than two pages we just read middle
-      // pages sequentially.
-      auto MorePages = (LastBytePageStart - PageStart) / PageSize;
-      while (MorePages != 1) {
-        if (!UpdateBufferIfNeeded()) {
-          return Written;
-        }
-        memcpy(Out, PageBuffer.data(), PageSize);
-        AdvancePosition(PageSize);
-        Written += PageSize;
-        Count -= PageSize;
-        MorePages--;
-      }
-
-      if (!Count) {
+      if (!UpdateBufferIfNeeded()) {
         return Written;
       }
     }
 
-    if (!UpdateBufferIfNeeded()) {
-      return Written;
-    }
-
     memcpy(Out, PageBuffer.data() + (Address % PageSize), Count);
     AdvancePosition(Count);
     Written += Count;
@@ -0,0 +1,42 @@
+#ifndef MAPPEDFILE_HPP_5HTV0YQB
+#define MAPPEDFILE_HPP_5HTV0YQB
+
+// Std
+#include <cstdint>
+#include <string>
+
+// MAD
+#include "MAD/ByteView.hpp"
+
+namespace mad {
+
+// Read-only memory mapping of a whole file. Every ByteView obtained from it is
+// valid until the mapping is closed or destroyed.
+class MappedFile {
+  std::string Path;
+  int FD;
+  void *Data;
+  uint64_t Size;
+
+public:
+  MappedFile() : FD(-1), Data(nullptr), Size(0) {}
+  ~MappedFile() { Close(); }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&Other);
+  MappedFile &operator=(MappedFile &&Other);
+
+  bool Open(std::string Path);
+  void Close();
+
+  bool IsOpen() const { return FD >= 0; }
+  auto &GetPath() const { return Path; }
+  auto GetSize() const { return Size; }
+  ByteView GetView() const { return ByteView(Data, Size); }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: MAPPEDFILE_HPP_5HTV0YQB */
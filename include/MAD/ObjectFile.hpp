@@ -5,14 +5,16 @@
 #include <mach/mach.h>
 #include <uuid/uuid.h>
 
-#include <fstream>
 #include <string>
 #include <vector>
 
+#include "MAD/ByteView.hpp"
+
 namespace mad {
 class ObjectFile {
   std::string Path;
-  std::ifstream &Input;
+  // The object's bytes, e.g. a single slice of a mapped universal binary
+  ByteView Input;
 
 private:
   struct Segment {
@@ -35,9 +37,13 @@ private:
   std::vector<Segment> Segments;
 
 public:
-  ObjectFile(std::string path, std::ifstream &input)
-      : Path(path), Input(input) {}
+  ObjectFile(std::string path, ByteView input) : Path(path), Input(input) {}
   bool Parse();
+
+  auto &GetPath() const { return Path; }
+  ByteView GetInput() const { return Input; }
+  auto &GetHeader() const { return Header; }
+  const uint8_t *GetUUID() const { return UUID; }
 };
 } // namespace mad
 
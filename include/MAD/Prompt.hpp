@@ -20,7 +20,7 @@ namespace mad {
 //------------------------------------------------------------------------------
 // Commands
 //------------------------------------------------------------------------------
-enum class PromptCmdGroup { MAD, PROCESS, BREAKPOINT };
+enum class PromptCmdGroup { MAD, PROCESS, BREAKPOINT, THREAD };
 static inline std::string PromptCmdGroupToString(PromptCmdGroup Group) {
   switch (Group) {
   case PromptCmdGroup::MAD:
@@ -29,6 +29,8 @@ static inline std::string PromptCmdGroupToString(PromptCmdGroup Group) {
     return "process";
   case PromptCmdGroup::BREAKPOINT:
     return "breakpoint";
+  case PromptCmdGroup::THREAD:
+    return "thread";
   }
 }
 
@@ -37,7 +39,8 @@ enum class PromptCmdType {
   MAD_HELP,
   BREAKPOINT_SET,
   PROCESS_RUN,
-  PROCESS_CONTINUE
+  PROCESS_CONTINUE,
+  THREAD_BACKTRACE
 };
 static inline std::string PromptCmdTypeToString(PromptCmdType Type) {
   switch (Type) {
@@ -51,6 +54,8 @@ static inline std::string PromptCmdTypeToString(PromptCmdType Type) {
     return "continue";
   case PromptCmdType::BREAKPOINT_SET:
     return "set";
+  case PromptCmdType::THREAD_BACKTRACE:
+    return "backtrace";
   }
 }
 
@@ -106,8 +111,23 @@ public:
                           args::Group::Validators::Xor};
   args::ValueFlag<std::string> SymbolName{
       TargetGroup, "SYMBOL", "Name of a symbol", {'n', "name"}};
+  args::ValueFlag<std::string> Regex{TargetGroup,
+                                     "REGEX",
+                                     "Every function whose name matches",
+                                     {'r', "regex"}};
+  args::ValueFlag<std::string> Glob{
+      TargetGroup, "GLOB", "Same, but a shell glob", {'g', "glob"}};
   args::ValueFlag<std::string> MethodName{
-      TargetGroup, "METHOD", "Name of a method", {'m', "method"}};
+      TargetGroup,
+      "METHOD",
+      "Every overload of a method, e.g. Foo::bar or Foo::bar(int)",
+      {'m', "method"}};
+  args::ValueFlag<std::string> ClassName{
+      TargetGroup, "CLASS", "Every method of a class", {'c', "class"}};
+  args::ValueFlag<std::string> File{
+      TargetGroup, "FILE", "Every function of a source file", {'f', "file"}};
+  args::ValueFlag<std::string> Line{
+      TargetGroup, "FILE:LINE", "A line in a source file", {'l', "line"}};
 
 public:
   PromptCmdBreakpointSet()
@@ -132,6 +152,19 @@ public:
                   "continue", "c") {}
 };
 
+//-----------------------------------------------------------------------------
+// Thread
+//-----------------------------------------------------------------------------
+class PromptCmdThreadBacktrace : public PromptCmd {
+public:
+  args::Flag All{Parser, "ALL", "Every thread of the process", {'a', "all"}};
+
+public:
+  PromptCmdThreadBacktrace()
+      : PromptCmd(PromptCmdGroup::THREAD, PromptCmdType::THREAD_BACKTRACE,
+                  "backtrace", "bt") {}
+};
+
 //------------------------------------------------------------------------------
 // Prompt
 //------------------------------------------------------------------------------
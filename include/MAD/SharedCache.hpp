@@ -0,0 +1,260 @@
+#ifndef SHAREDCACHE_HPP_R7CX4LWE
+#define SHAREDCACHE_HPP_R7CX4LWE
+
+// Std
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/MappedFile.hpp"
+#include "MAD/StringTableIndex.hpp"
+
+namespace mad {
+
+//-----------------------------------------------------------------------------
+// Cache format
+//
+// dyld_cache_format.h is not part of the SDK, so the structures we read are
+// mirrored here. The header only ever grows; its actual size is given by
+// MappingOffset, fields past it are absent and read as zero.
+//-----------------------------------------------------------------------------
+struct SharedCacheHeader {
+  char Magic[16];
+  uint32_t MappingOffset;
+  uint32_t MappingCount;
+  uint32_t ImagesOffsetOld;
+  uint32_t ImagesCountOld;
+  uint64_t DyldBaseAddress;
+  uint64_t CodeSignatureOffset;
+  uint64_t CodeSignatureSize;
+  uint64_t SlideInfoOffsetUnused;
+  uint64_t SlideInfoSizeUnused;
+  uint64_t LocalSymbolsOffset;
+  uint64_t LocalSymbolsSize;
+  uint8_t UUID[16];
+  uint64_t CacheType;
+  uint32_t BranchPoolsOffset;
+  uint32_t BranchPoolsCount;
+  uint64_t DyldInCacheMH;
+  uint64_t DyldInCacheEntry;
+  uint64_t ImagesTextOffset;
+  uint64_t ImagesTextCount;
+  uint64_t PatchInfoAddr;
+  uint64_t PatchInfoSize;
+  uint64_t OtherImageGroupAddrUnused;
+  uint64_t OtherImageGroupSizeUnused;
+  uint64_t ProgClosuresAddr;
+  uint64_t ProgClosuresSize;
+  uint64_t ProgClosuresTrieAddr;
+  uint64_t ProgClosuresTrieSize;
+  uint32_t Platform;
+  uint32_t FormatFlags;
+  uint64_t SharedRegionStart;
+  uint64_t SharedRegionSize;
+  uint64_t MaxSlide;
+  uint64_t DylibsImageArrayAddr;
+  uint64_t DylibsImageArraySize;
+  uint64_t DylibsTrieAddr;
+  uint64_t DylibsTrieSize;
+  uint64_t OtherImageArrayAddr;
+  uint64_t OtherImageArraySize;
+  uint64_t OtherTrieAddr;
+  uint64_t OtherTrieSize;
+  uint32_t MappingWithSlideOffset;
+  uint32_t MappingWithSlideCount;
+  uint64_t DylibsPBLStateArrayAddrUnused;
+  uint64_t DylibsPBLSetAddr;
+  uint64_t ProgramsPBLSetPoolAddr;
+  uint64_t ProgramsPBLSetPoolSize;
+  uint64_t ProgramTrieAddr;
+  uint32_t ProgramTrieSize;
+  uint32_t OSVersion;
+  uint32_t AltPlatform;
+  uint32_t AltOSVersion;
+  uint64_t SwiftOptsOffset;
+  uint64_t SwiftOptsSize;
+  uint32_t SubCacheArrayOffset;
+  uint32_t SubCacheArrayCount;
+  uint8_t SymbolFileUUID[16];
+  uint64_t RosettaReadOnlyAddr;
+  uint64_t RosettaReadOnlySize;
+  uint64_t RosettaReadWriteAddr;
+  uint64_t RosettaReadWriteSize;
+  uint32_t ImagesOffset;
+  uint32_t ImagesCount;
+  uint32_t CacheSubType;
+};
+
+struct SharedCacheMappingInfo {
+  uint64_t Address;
+  uint64_t Size;
+  uint64_t FileOffset;
+  uint32_t MaxProt;
+  uint32_t InitProt;
+};
+
+struct SharedCacheImageInfo {
+  uint64_t Address;
+  uint64_t ModTime;
+  uint64_t Inode;
+  uint32_t PathFileOffset;
+  uint32_t Pad;
+};
+
+struct SharedCacheLocalSymbolsInfo {
+  uint32_t NListOffset;
+  uint32_t NListCount;
+  uint32_t StringsOffset;
+  uint32_t StringsSize;
+  uint32_t EntriesOffset;
+  uint32_t EntriesCount;
+};
+
+struct SharedCacheLocalSymbolsEntry32 {
+  uint32_t DylibOffset;
+  uint32_t NListStartIndex;
+  uint32_t NListCount;
+};
+
+struct SharedCacheLocalSymbolsEntry64 {
+  uint64_t DylibOffset;
+  uint32_t NListStartIndex;
+  uint32_t NListCount;
+};
+
+struct SharedCacheSubCacheEntryV1 {
+  uint8_t UUID[16];
+  uint64_t CacheVMOffset;
+};
+
+struct SharedCacheSubCacheEntry {
+  uint8_t UUID[16];
+  uint64_t CacheVMOffset;
+  char FileSuffix[32];
+};
+
+//-----------------------------------------------------------------------------
+// Reader
+//-----------------------------------------------------------------------------
+
+// Read-only view of a dyld shared cache on disk. The cache, every sub-cache
+// it refers to and the separate .symbols file, if there is one, are mapped
+// once. Afterwards image headers, __LINKEDIT and the local symbols dyld
+// stripped from the cached dylibs are served straight from the mappings
+// instead of being read out of the target task.
+//
+// Addresses taken by the lookups are the target's, i.e. they include the
+// slide set with SetSlide.
+class SharedCache {
+public:
+  struct Image {
+    // Unslid, as recorded in the cache
+    uint64_t Address;
+    std::string_view Path;
+  };
+
+  // A slice of the local nlist array that belongs to a single image and the
+  // string pool all of them share
+  struct LocalSymbols {
+    ByteView NList;
+    ByteView Strings;
+  };
+
+private:
+  struct File {
+    MappedFile Mapping;
+    std::vector<SharedCacheMappingInfo> Mappings;
+  };
+
+  struct LocalEntry {
+    uint64_t DylibOffset;
+    uint32_t NListStartIndex;
+    uint32_t NListCount;
+
+    bool operator<(const LocalEntry &Other) const {
+      return DylibOffset < Other.DylibOffset;
+    }
+  };
+
+  std::string Path;
+  SharedCacheHeader Header;
+  // The main cache file first, then sub-caches and the symbols file
+  std::vector<File> Files;
+  std::vector<Image> Images;
+  uint64_t BaseAddress;
+  uint64_t Slide;
+  uint32_t NListSize;
+
+  ByteView LocalNList;
+  ByteView LocalStrings;
+  std::vector<LocalEntry> LocalEntries;
+
+  // Keyed by the table's bytes
+  mutable std::mutex IndexesMutex;
+  mutable std::map<std::pair<const char *, uint64_t>,
+                   std::shared_ptr<const StringTableIndex>>
+      Indexes;
+
+private:
+  static bool ReadHeader(ByteView View, SharedCacheHeader &Result);
+
+  bool OpenFile(std::string FilePath, SharedCacheHeader &FileHeader);
+  bool OpenSubCaches();
+  bool ReadImages();
+  bool ReadLocalSymbols(const File &Source, const SharedCacheHeader &Owner);
+
+  // Mapping and file that contain the unslid Address, if any
+  const File *FindFile(uint64_t Address,
+                       const SharedCacheMappingInfo *&Mapping) const;
+
+public:
+  SharedCache();
+
+  SharedCache(const SharedCache &) = delete;
+  SharedCache &operator=(const SharedCache &) = delete;
+
+  bool Open(std::string CachePath);
+  void Close();
+
+  bool IsOpen() const { return !Files.empty(); }
+  auto &GetPath() const { return Path; }
+  const uint8_t *GetUUID() const { return Header.UUID; }
+  bool HasUUID(const uint8_t *UUID) const;
+
+  // Unslid address of the first mapping
+  uint64_t GetBaseAddress() const { return BaseAddress; }
+  uint64_t GetSlide() const { return Slide; }
+  void SetSlide(uint64_t Value) { Slide = Value; }
+
+  const std::vector<Image> &GetImages() const { return Images; }
+  const Image *GetImageByAddress(uint64_t Address) const;
+  const Image *GetImageByPath(std::string_view ImagePath) const;
+
+  bool Contains(uint64_t Address) const;
+
+  // Size bytes at Address, empty if they are not mapped or span mappings
+  ByteView GetView(uint64_t Address, uint64_t Size) const;
+  // Everything from Address to the end of the mapping that contains it
+  ByteView GetViewToEnd(uint64_t Address) const;
+
+  // Local symbols of the image whose mach header is at Address
+  bool GetLocalSymbols(uint64_t Address, LocalSymbols &Result) const;
+  uint32_t GetNListSize() const { return NListSize; }
+
+  // String tables in the cache are shared by many images, every cached
+  // dylib's LC_SYMTAB points to the same pool, so each is indexed only once
+  std::shared_ptr<const StringTableIndex>
+  GetStringTableIndex(ByteView Strings) const;
+};
+
+} // namespace mad
+
+#endif /* end of include guard: SHAREDCACHE_HPP_R7CX4LWE */
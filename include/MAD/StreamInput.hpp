@@ -0,0 +1,51 @@
+#ifndef STREAMINPUT_HPP_W2C8KDPE
+#define STREAMINPUT_HPP_W2C8KDPE
+
+// Std
+#include <cstdint>
+#include <istream>
+#include <string>
+
+// MAD
+#include "MAD/ByteView.hpp"
+
+namespace mad {
+
+// Adapts an std::istream to the positioning interface of ByteView, so
+// MachOParser can keep reading through MachTaskMemoryStream when there is no
+// way to map the bytes we parse.
+class StreamInput {
+  std::istream *Stream;
+
+public:
+  // Bytes are copied out of the stream, so are the strings
+  using String_t = std::string;
+
+public:
+  StreamInput(std::istream &Stream) : Stream(&Stream) {}
+
+  bool Good() const { return Stream->good(); }
+  uint64_t Tell() const { return Stream->tellg(); }
+
+  bool Seek(uint64_t Offset) {
+    Stream->seekg(Offset);
+    return Good();
+  }
+
+  bool Read(void *Out, uint64_t Length) {
+    return static_cast<bool>(Stream->read(static_cast<char *>(Out), Length));
+  }
+
+  // Streams cannot hand out views, callers fall back to Read
+  ByteView Slice(uint64_t, uint64_t) const { return ByteView(); }
+
+  std::string ReadNTString() {
+    std::string Result;
+    std::getline(*Stream, Result, '\0');
+    return Result;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: STREAMINPUT_HPP_W2C8KDPE */
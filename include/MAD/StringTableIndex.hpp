@@ -0,0 +1,149 @@
+#ifndef STRINGTABLEINDEX_HPP_H3UQ9CFM
+#define STRINGTABLEINDEX_HPP_H3UQ9CFM
+
+// Std
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+
+namespace mad {
+
+// Which implementation scans the string table for terminators. BEST picks the
+// widest one the CPU supports at runtime.
+enum class StringScanKernel { BEST, SCALAR, SSE2, AVX2 };
+
+// Index over a string table, i.e. a blob of NUL terminated strings such as the
+// one LC_SYMTAB points to. The table is scanned once, with SIMD if possible,
+// into a bitmap of terminator positions. After that the length of the string
+// at any offset, including offsets into the middle of a string that the
+// linker's tail merging produces, is a couple of word operations away.
+//
+// Optionally every whole string can be hashed in bulk; hashes are then
+// addressed by the string's ordinal number, which the per-word rank table
+// gives in constant time.
+class StringTableIndex {
+  ByteView Strings;
+  // Bit i is set if Strings[i] is NUL
+  std::vector<uint64_t> Terminators;
+  // Number of terminators before each bitmap word
+  std::vector<uint32_t> Ranks;
+  // Hash of the n-th whole string, i.e. of the bytes between terminators n-1
+  // and n
+  std::vector<uint64_t> Hashes;
+
+private:
+  bool IsTerminator(uint64_t Offset) const {
+    return Terminators[Offset / 64] & (1ull << (Offset % 64));
+  }
+
+  // Ordinal of the first terminator at or after Offset
+  uint32_t GetRank(uint64_t Offset) const {
+    auto Word = Offset / 64;
+    auto Below = Terminators[Word] & ((1ull << (Offset % 64)) - 1);
+    return Ranks[Word] + __builtin_popcountll(Below);
+  }
+
+public:
+  // Fills Bitmap, which must hold at least (Size + 63) / 64 zeroed words
+  static void ScanTerminators(const char *Data, uint64_t Size,
+                              uint64_t *Bitmap,
+                              StringScanKernel Kernel = StringScanKernel::BEST);
+
+  // Hash used for symbol names everywhere in MAD
+  static uint64_t Hash(std::string_view String) {
+    const uint64_t Multiplier = 0x9E3779B97F4A7C15ull;
+    uint64_t Result = String.size() * Multiplier;
+    size_t i = 0;
+    for (; i + 8 <= String.size(); i += 8) {
+      uint64_t Word;
+      memcpy(&Word, String.data() + i, 8);
+      Result = (Result ^ Word) * Multiplier;
+      Result ^= Result >> 29;
+    }
+    uint64_t Tail = 0;
+    memcpy(&Tail, String.data() + i, String.size() - i);
+    Result = (Result ^ Tail) * Multiplier;
+    return Result ^ (Result >> 32);
+  }
+
+public:
+  void Build(ByteView StringTable,
+             StringScanKernel Kernel = StringScanKernel::BEST);
+
+  // Hashes every whole string, large tables are hashed on the shared
+  // ThreadPool
+  void BuildHashes();
+
+  bool IsBuilt() const { return !Terminators.empty() || Strings.IsEmpty(); }
+  bool HasHashes() const { return !Hashes.empty(); }
+  auto GetStrings() const { return Strings; }
+
+  // Number of terminated strings in the table
+  uint32_t GetStringCount() const {
+    return Ranks.empty() ? 0 : GetRank(Strings.GetSize() - 1) +
+                                   IsTerminator(Strings.GetSize() - 1);
+  }
+
+  // Length of the string at Offset. An unterminated tail runs up to the end
+  // of the table.
+  uint32_t GetLength(uint64_t Offset) const {
+    if (Offset >= Strings.GetSize()) {
+      return 0;
+    }
+    auto Word = Offset / 64;
+    auto Bits = Terminators[Word] & (~0ull << (Offset % 64));
+    while (!Bits) {
+      if (++Word == Terminators.size()) {
+        return Strings.GetSize() - Offset;
+      }
+      Bits = Terminators[Word];
+    }
+    return Word * 64 + __builtin_ctzll(Bits) - Offset;
+  }
+
+  std::string_view GetString(uint64_t Offset) const {
+    return std::string_view(Strings.GetData() + Offset, GetLength(Offset));
+  }
+
+  // A string start is an offset right after a terminator, or zero
+  bool IsStringStart(uint64_t Offset) const {
+    return Offset < Strings.GetSize() &&
+           (Offset == 0 || IsTerminator(Offset - 1));
+  }
+
+  // Whole strings come straight from the bulk hashes, tail-merged suffixes
+  // are hashed on the spot
+  uint64_t GetHash(uint64_t Offset) const {
+    if (HasHashes() && IsStringStart(Offset)) {
+      auto Rank = GetRank(Offset);
+      if (Rank < Hashes.size()) {
+        return Hashes[Rank];
+      }
+    }
+    return Hash(GetString(Offset));
+  }
+
+  // Calls Fn(Offset, String) for every non-empty whole string in table order
+  template <typename F> void ForEachString(F &&Fn) const {
+    uint64_t Start = 0;
+    for (uint64_t Word = 0; Word < Terminators.size(); ++Word) {
+      auto Bits = Terminators[Word];
+      while (Bits) {
+        uint64_t End = Word * 64 + __builtin_ctzll(Bits);
+        if (End > Start) {
+          Fn(Start, std::string_view(Strings.GetData() + Start, End - Start));
+        }
+        Start = End + 1;
+        Bits &= Bits - 1;
+      }
+    }
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: STRINGTABLEINDEX_HPP_H3UQ9CFM */
@@ -0,0 +1,76 @@
+#ifndef SYMBOLINDEXCACHE_HPP_Q4HM9ZTE
+#define SYMBOLINDEXCACHE_HPP_Q4HM9ZTE
+
+// Std
+#include <cstdint>
+#include <string>
+
+// MAD
+#include "MAD/FunctionStarts.hpp"
+#include "MAD/SymbolStore.hpp"
+
+namespace mad {
+
+// Bump whenever the file layout or the meaning of anything stored changes,
+// e.g. the MO_SYMBOL_* flags. Files of any other version are ignored and
+// overwritten by the next save.
+#define MO_SYMBOL_INDEX_VERSION 1u
+
+// SymbolIndexKey kinds, decoding of symbol flags depends on all of these
+#define MO_SYMBOL_INDEX_64 (1u << 0)
+#define MO_SYMBOL_INDEX_OBJECT (1u << 1)
+#define MO_SYMBOL_INDEX_IMAGE (1u << 2)
+#define MO_SYMBOL_INDEX_TWO_LEVEL (1u << 3)
+
+// Describes what an index was built from. A saved index is used only if its
+// key matches byte for byte: strip(1) for one keeps the image's UUID, but not
+// its symbol table.
+struct SymbolIndexKey {
+  uint8_t UUID[16];
+  uint32_t Kind;
+  uint32_t SymbolCount;
+  uint32_t StringTableSize;
+  uint32_t FunctionStartsSize;
+  // Unslid, function starts are relative to it
+  uint64_t TextAddress;
+};
+
+// A directory of parsed symbol stores and function starts, one file per image
+// UUID. Every column is saved exactly as it is kept in memory, together with
+// a copy of the string table, so loading an index is a single mmap and the
+// store and function starts then view the mapping. Neither the nlist array
+// nor the string table has to be read from the target or decoded again.
+//
+// Files are native endian and are replaced atomically, so any number of
+// sessions may share a directory.
+class SymbolIndexCache {
+  std::string Directory;
+
+private:
+  std::string GetPath(const SymbolIndexKey &Key) const;
+
+public:
+  // Without a directory the cache is disabled
+  SymbolIndexCache() {}
+  explicit SymbolIndexCache(std::string Directory)
+      : Directory(std::move(Directory)) {}
+
+  // MAD_SYMBOL_INDEX_DIR if set, an empty value disables the cache,
+  // otherwise a directory in the user's caches
+  static std::string GetDefaultDirectory();
+
+  bool IsEnabled() const { return !Directory.empty(); }
+  auto &GetDirectory() const { return Directory; }
+
+  // Maps the index saved under Key. Values and function starts are slid by
+  // Slide. Store and Functions are left untouched on a miss.
+  bool Load(const SymbolIndexKey &Key, uint64_t Slide, SymbolStore &Store,
+            FunctionStarts &Functions) const;
+
+  bool Save(const SymbolIndexKey &Key, const SymbolStore &Store,
+            const FunctionStarts &Functions) const;
+};
+
+} // namespace mad
+
+#endif /* end of include guard: SYMBOLINDEXCACHE_HPP_Q4HM9ZTE */
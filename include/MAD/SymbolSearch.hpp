@@ -0,0 +1,121 @@
+#ifndef SYMBOLSEARCH_HPP_K5VQ8NBE
+#define SYMBOLSEARCH_HPP_K5VQ8NBE
+
+// Std
+#include <cstdint>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/StringTableIndex.hpp"
+#include "MAD/SymbolStore.hpp"
+
+namespace mad {
+
+// A pattern symbol names are matched against, either an ECMAScript regular
+// expression, searched for anywhere in the name unless anchored, or a shell
+// glob, which must match the whole name.
+//
+// Compiling works out a literal every matching name contains, e.g. _ZN5myapp
+// of ^_ZN5myapp.*, which SymbolSearch looks for first. Patterns that are
+// nothing but literals joined by .* and anchors are then matched without the
+// regex engine at all.
+class SymbolPattern {
+  std::string Source;
+  // Every matching name contains it, empty if there is no such literal
+  std::string Literal;
+
+  // Literal pieces joined by .*, set only if the pattern is of that form
+  bool IsSimple;
+  bool IsAnchoredBegin;
+  bool IsAnchoredEnd;
+  std::vector<std::string> Pieces;
+
+  std::regex Regex;
+
+private:
+  void Analyze(const std::string &Expression);
+  bool MatchSimple(std::string_view Name) const;
+
+public:
+  SymbolPattern()
+      : IsSimple(false), IsAnchoredBegin(false), IsAnchoredEnd(false) {}
+
+  // Turns a glob into the regular expression that matches the same names
+  static std::string GlobToRegex(std::string_view Glob);
+
+  bool Compile(std::string Pattern, bool IsGlob = false);
+
+  const std::string &GetSource() const { return Source; }
+  const std::string &GetLiteral() const { return Literal; }
+
+  // True if finding the literal in a name already means it matches
+  bool IsLiteral() const {
+    return IsSimple && !IsAnchoredBegin && !IsAnchoredEnd &&
+           Pieces.size() == 1;
+  }
+
+  bool Match(std::string_view Name) const;
+};
+
+// Finds the defined symbols of many symbol stores whose names match a
+// pattern.
+//
+// Instead of running the matcher on every name, the string tables are
+// searched for the pattern's literal first, 16 or 32 bytes at a time with
+// SIMD, which leaves a bitmap of the positions it occurs at. A symbol is
+// matched only if its name covers one of them. Every table is searched once
+// however many stores share it, e.g. all the images of the shared cache.
+//
+// Tables are split among the shared ThreadPool, and so are the symbols of the
+// stores, big stores in several pieces.
+class SymbolSearch {
+public:
+  template <typename Image_t> struct Match {
+    std::shared_ptr<Image_t> Image;
+    SymbolRef Symbol;
+  };
+
+public:
+  // Sets bit i of Hits, which must hold at least (Size + 63) / 64 zeroed
+  // words, for every occurrence of Literal at Data + i
+  static void FindLiteral(const char *Data, uint64_t Size,
+                          std::string_view Literal, uint64_t *Hits,
+                          StringScanKernel Kernel = StringScanKernel::BEST);
+
+  // Rows of every store whose names match, in row order; Result[i] is that
+  // of Stores[i]
+  static std::vector<std::vector<uint32_t>>
+  Search(const SymbolPattern &Pattern,
+         const std::vector<const SymbolStore *> &Stores);
+
+  // Symbols of the images from First on whose names match, in the order of
+  // the images. Searching new images only is a matter of remembering how
+  // many were there the last time.
+  template <typename Image_t>
+  static std::vector<Match<Image_t>>
+  Search(const SymbolPattern &Pattern,
+         const std::vector<std::shared_ptr<Image_t>> &Images,
+         size_t First = 0) {
+    std::vector<const SymbolStore *> Stores;
+    for (size_t i = First; i < Images.size(); ++i) {
+      Stores.push_back(&Images[i]->GetSymbolTable().GetSymbols());
+    }
+
+    std::vector<Match<Image_t>> Result;
+    auto Rows = Search(Pattern, Stores);
+    for (size_t i = 0; i < Rows.size(); ++i) {
+      for (auto Row : Rows[i]) {
+        Result.push_back({Images[First + i], SymbolRef(Stores[i], Row)});
+      }
+    }
+    return Result;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: SYMBOLSEARCH_HPP_K5VQ8NBE */
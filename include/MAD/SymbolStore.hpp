@@ -0,0 +1,544 @@
+#ifndef SYMBOLSTORE_HPP_T6NB3KQE
+#define SYMBOLSTORE_HPP_T6NB3KQE
+
+// System
+#include <mach-o/nlist.h>
+#include <mach-o/stab.h>
+
+// Std
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/Column.hpp"
+#include "MAD/MappedFile.hpp"
+#include "MAD/StringTableIndex.hpp"
+#include "MAD/ThreadPool.hpp"
+
+// Names of stores at least this big are hashed on the shared ThreadPool, in
+// chunks of MO_PARALLEL_NAMES_CHUNK symbols
+#define MO_PARALLEL_NAMES_THRESHOLD 65536u
+#define MO_PARALLEL_NAMES_CHUNK 16384u
+
+namespace mad {
+
+//-----------------------------------------------------------------------------
+// Symbol flags
+//
+// Everything MachOParser used to unpack into separate bools is packed into a
+// single word per symbol.
+//-----------------------------------------------------------------------------
+// n_type
+#define MO_SYMBOL_STAB (1u << 0)
+#define MO_SYMBOL_PRIVATE_EXTERNAL (1u << 1)
+#define MO_SYMBOL_EXTERNAL (1u << 2)
+#define MO_SYMBOL_UNDEFINED (1u << 3)
+#define MO_SYMBOL_ABSOLUTE (1u << 4)
+#define MO_SYMBOL_DEFINED (1u << 5)
+#define MO_SYMBOL_PREBOUND (1u << 6)
+#define MO_SYMBOL_INDIRECT (1u << 7)
+// n_desc REFERENCE_FLAG_*
+#define MO_SYMBOL_REF_UNDEFINED_NON_LAZY (1u << 8)
+#define MO_SYMBOL_REF_UNDEFINED_LAZY (1u << 9)
+#define MO_SYMBOL_REF_DEFINED (1u << 10)
+#define MO_SYMBOL_REF_PRIVATE_DEFINED (1u << 11)
+#define MO_SYMBOL_REF_PRIVATE_UNDEFINED_NON_LAZY (1u << 12)
+#define MO_SYMBOL_REF_PRIVATE_UNDEFINED_LAZY (1u << 13)
+// n_desc additional flags
+#define MO_SYMBOL_REF_DYNAMICALLY (1u << 14)
+#define MO_SYMBOL_NO_DEAD_STRIP (1u << 15)
+#define MO_SYMBOL_DESC_DISCARDED (1u << 16)
+#define MO_SYMBOL_WEAK_REFERENCE (1u << 17)
+#define MO_SYMBOL_WEAK_DEFINITION (1u << 18)
+#define MO_SYMBOL_REF_TO_WEAK (1u << 19)
+#define MO_SYMBOL_ARM_THUMB_DEFINITION (1u << 20)
+#define MO_SYMBOL_RESOLVER (1u << 21)
+#define MO_SYMBOL_ALT_ENTRY (1u << 22)
+
+//-----------------------------------------------------------------------------
+// Store
+//-----------------------------------------------------------------------------
+
+// Columnar storage of a single image's symbols. Every column is indexed by the
+// symbol's position in the nlist array. Names are not copied, NameOffsets and
+// NameLengths point into the image's string table, which must outlive the
+// store. Lengths come from a StringTableIndex built once per table.
+//
+// Rows are independent of each other, so once the store is reset to the final
+// size any number of threads may fill disjoint ranges of it with Set.
+//
+// Values are kept as the image states them and the slide is added when read,
+// so nothing in the columns depends on where the image was loaded. That lets
+// SymbolIndexCache map a store saved by an earlier session as is.
+//
+// STABS-only values, e.g. line numbers and nesting levels, as well as the
+// library ordinal and common alignment are not stored, they are cut out of
+// the raw n_desc when asked for.
+class SymbolStore {
+public:
+  Column<uint64_t> Values;
+  Column<uint32_t> NameOffsets;
+  Column<uint32_t> NameLengths;
+  Column<uint32_t> Flags;
+  Column<uint16_t> Descs;
+  Column<uint8_t> Types;
+  Column<uint8_t> Sections;
+
+  ByteView Strings;
+  std::shared_ptr<const StringTableIndex> StringIndex;
+  // Backs Strings of a store loaded from an index file
+  std::shared_ptr<const MappedFile> Mapping;
+  uint64_t Slide;
+  bool IsTwoLevel;
+
+private:
+  static uint32_t DecodeDesc(uint16_t Desc, uint32_t Result, bool IsObject,
+                             bool IsImage) {
+    switch (Desc & REFERENCE_TYPE) {
+    case REFERENCE_FLAG_UNDEFINED_NON_LAZY:
+      Result |= MO_SYMBOL_REF_UNDEFINED_NON_LAZY;
+      break;
+    case REFERENCE_FLAG_UNDEFINED_LAZY:
+      Result |= MO_SYMBOL_REF_UNDEFINED_LAZY;
+      break;
+    case REFERENCE_FLAG_DEFINED:
+      Result |= MO_SYMBOL_REF_DEFINED;
+      break;
+    case REFERENCE_FLAG_PRIVATE_DEFINED:
+      Result |= MO_SYMBOL_REF_PRIVATE_DEFINED;
+      break;
+    case REFERENCE_FLAG_PRIVATE_UNDEFINED_NON_LAZY:
+      Result |= MO_SYMBOL_REF_PRIVATE_UNDEFINED_NON_LAZY;
+      break;
+    case REFERENCE_FLAG_PRIVATE_UNDEFINED_LAZY:
+      Result |= MO_SYMBOL_REF_PRIVATE_UNDEFINED_LAZY;
+      break;
+    }
+
+    if (Desc & REFERENCED_DYNAMICALLY) {
+      Result |= MO_SYMBOL_REF_DYNAMICALLY;
+    }
+
+    if (IsObject) {
+      if (Desc & N_NO_DEAD_STRIP) {
+        Result |= MO_SYMBOL_NO_DEAD_STRIP;
+      }
+      if (Desc & N_SYMBOL_RESOLVER) {
+        Result |= MO_SYMBOL_RESOLVER;
+      }
+    }
+
+    if (IsImage && (Desc & N_DESC_DISCARDED)) {
+      Result |= MO_SYMBOL_DESC_DISCARDED;
+    }
+
+    if (Desc & N_WEAK_REF) {
+      Result |= MO_SYMBOL_WEAK_REFERENCE;
+    }
+    if (Desc & N_WEAK_DEF) {
+      Result |= MO_SYMBOL_WEAK_DEFINITION;
+    }
+    if (Desc & N_REF_TO_WEAK) {
+      Result |= MO_SYMBOL_REF_TO_WEAK;
+    }
+    if (Desc & N_ARM_THUMB_DEF) {
+      Result |= MO_SYMBOL_ARM_THUMB_DEFINITION;
+    }
+    if (Desc & N_ALT_ENTRY) {
+      Result |= MO_SYMBOL_ALT_ENTRY;
+    }
+
+    return Result;
+  }
+
+public:
+  SymbolStore() : Slide(0), IsTwoLevel(false) {}
+
+  // Packs everything n_type and n_desc tell about a symbol. Some n_desc bits
+  // mean different things in object files and in loaded images.
+  static uint32_t DecodeFlags(uint8_t Type, uint16_t Desc, bool IsObject,
+                              bool IsImage) {
+    uint32_t Result = 0;
+
+    if (Type & N_STAB) {
+      // Only symbol-like STABS carry regular n_desc
+      switch (Type) {
+      case N_GSYM:
+      case N_STSYM:
+      case N_LCSYM:
+      case N_RSYM:
+      case N_SSYM:
+      case N_LSYM:
+      case N_PSYM:
+        Result = DecodeDesc(Desc, Result, IsObject, IsImage);
+        break;
+      }
+      return Result | MO_SYMBOL_STAB;
+    }
+
+    if (Type & N_PEXT) {
+      Result |= MO_SYMBOL_PRIVATE_EXTERNAL;
+    }
+    if (Type & N_EXT) {
+      Result |= MO_SYMBOL_EXTERNAL;
+    }
+
+    switch (Type & N_TYPE) {
+    case N_UNDF:
+      Result |= MO_SYMBOL_UNDEFINED;
+      break;
+    case N_ABS:
+      Result |= MO_SYMBOL_ABSOLUTE;
+      break;
+    case N_SECT:
+      Result |= MO_SYMBOL_DEFINED;
+      break;
+    case N_PBUD:
+      Result |= MO_SYMBOL_PREBOUND;
+      break;
+    case N_INDR:
+      Result |= MO_SYMBOL_INDIRECT;
+      break;
+    }
+
+    return DecodeDesc(Desc, Result, IsObject, IsImage);
+  }
+
+  uint32_t GetSize() const { return Values.GetSize(); }
+
+  // Stores over the same string table, e.g. the one the shared cache's local
+  // symbols use, may share its index instead of scanning it again
+  void Reset(ByteView StringTable, uint32_t Count, uint64_t ImageSlide,
+             std::shared_ptr<const StringTableIndex> Index = nullptr) {
+    if (!Index) {
+      auto Own = std::make_shared<StringTableIndex>();
+      Own->Build(StringTable);
+      Index = std::move(Own);
+    }
+    Strings = StringTable;
+    StringIndex = std::move(Index);
+    Mapping = nullptr;
+    Slide = ImageSlide;
+    Values.Assign(Count, 0);
+    NameOffsets.Assign(Count, 0);
+    NameLengths.Assign(Count, 0);
+    Flags.Assign(Count, 0);
+    Descs.Assign(Count, 0);
+    Types.Assign(Count, 0);
+    Sections.Assign(Count, 0);
+  }
+
+  // Fills a row from a raw nlist or nlist_64
+  template <typename N>
+  void Set(uint32_t Index, const N &Entry, bool IsObject, bool IsImage) {
+    // For whatever reason symbol table may contain invalid records with
+    // n_strx pointing way beyond its string table limits. Dynamic Loader
+    // just skips those, so does this store by giving them no name.
+    uint32_t Strx = Entry.n_un.n_strx;
+    if (Strx >= Strings.GetSize()) {
+      Strx = 0;
+    }
+
+    uint16_t Desc = Entry.n_desc;
+
+    Values[Index] = Entry.n_value;
+    NameOffsets[Index] = Strx;
+    NameLengths[Index] = Strx ? StringIndex->GetLength(Strx) : 0;
+    Flags[Index] = DecodeFlags(Entry.n_type, Desc, IsObject, IsImage);
+    Descs[Index] = Desc;
+    Types[Index] = Entry.n_type;
+    Sections[Index] = Entry.n_sect;
+  }
+
+  uint64_t GetValue(uint32_t Index) const { return Values[Index] + Slide; }
+
+  // Zero string table offsets means there is no name for the thing
+  std::string_view GetName(uint32_t Index) const {
+    return std::string_view(Strings.GetData() + NameOffsets[Index],
+                            NameLengths[Index]);
+  }
+};
+
+//-----------------------------------------------------------------------------
+// Handle
+//-----------------------------------------------------------------------------
+
+// A cheap, copyable reference to a single symbol of a SymbolStore. A default
+// constructed handle refers to nothing and converts to false.
+class SymbolRef {
+  const SymbolStore *Store;
+  uint32_t Index;
+
+public:
+  SymbolRef() : Store(nullptr), Index(0) {}
+  SymbolRef(const SymbolStore *Store, uint32_t Index)
+      : Store(Store), Index(Index) {
+    assert(Store && Index < Store->GetSize());
+  }
+
+  explicit operator bool() const { return Store != nullptr; }
+
+  bool operator==(const SymbolRef &Other) const {
+    return Store == Other.Store && Index == Other.Index;
+  }
+  bool operator!=(const SymbolRef &Other) const { return !(*this == Other); }
+  bool operator<(const SymbolRef &Other) const {
+    return Store != Other.Store ? Store < Other.Store : Index < Other.Index;
+  }
+
+  auto GetStore() const { return Store; }
+  auto GetIndex() const { return Index; }
+
+  std::string_view GetName() const { return Store->GetName(Index); }
+  uint64_t GetValue() const { return Store->GetValue(Index); }
+  uint32_t GetFlags() const { return Store->Flags[Index]; }
+  uint16_t GetDesc() const { return Store->Descs[Index]; }
+  uint8_t GetType() const { return Store->Types[Index]; }
+  uint8_t GetSectionNumber() const { return Store->Sections[Index]; }
+
+  bool Is(uint32_t Flag) const { return (GetFlags() & Flag) == Flag; }
+  bool IsStab() const { return Is(MO_SYMBOL_STAB); }
+  bool IsExternal() const { return Is(MO_SYMBOL_EXTERNAL); }
+  bool IsPrivateExternal() const { return Is(MO_SYMBOL_PRIVATE_EXTERNAL); }
+  bool IsUndefined() const { return Is(MO_SYMBOL_UNDEFINED); }
+  bool IsDefined() const { return Is(MO_SYMBOL_DEFINED); }
+  bool IsAbsolute() const { return Is(MO_SYMBOL_ABSOLUTE); }
+  bool IsIndirect() const { return Is(MO_SYMBOL_INDIRECT); }
+
+  uint8_t GetStabType() const { return IsStab() ? GetType() : 0; }
+
+  uint32_t GetLineNumber() const {
+    switch (GetStabType()) {
+    case N_FUN:
+    case N_SLINE:
+    case N_ENTRY:
+      return GetDesc();
+    }
+    return 0;
+  }
+
+  uint32_t GetNestingLevel() const {
+    switch (GetStabType()) {
+    case N_LBRAC:
+    case N_RBRAC:
+      return GetDesc();
+    }
+    return 0;
+  }
+
+  // Common symbols have N_TYPE = U_UNDF | U_EXT
+  uint32_t GetAlignment() const {
+    return IsUndefined() && IsExternal() ? GET_COMM_ALIGN(GetDesc()) : 0;
+  }
+
+  uint32_t GetLibraryOrdinal() const {
+    return Store->IsTwoLevel && !IsStab() ? GET_LIBRARY_ORDINAL(GetDesc()) : 0;
+  }
+};
+
+//-----------------------------------------------------------------------------
+// Address index
+//-----------------------------------------------------------------------------
+
+// Named symbols of a section in address order, for mapping addresses back to
+// symbols. Of the symbols at the same address, e.g. aliases, only the first
+// one in the nlist array is kept.
+//
+// Besides the sorted list the addresses are kept in Eytzinger order, i.e. as
+// an implicit binary search tree laid out breadth first, the children of node
+// k at 2k and 2k + 1. The top levels every search goes through share a few
+// cache lines, and the nodes of the levels further down can be prefetched
+// ahead of time, since they are next to each other too. The search does not
+// branch on the comparison, so it costs a handful of nanoseconds even for
+// millions of symbols.
+class SymbolAddressIndex {
+  // Store rows in address order
+  std::vector<uint32_t> Indexes;
+  // Unslid addresses in Eytzinger order from 1, and their positions in
+  // Indexes
+  std::vector<uint64_t> Keys;
+  std::vector<uint32_t> Ranks;
+  uint64_t Slide;
+
+private:
+  // In-order walk of the tree is the sorted order
+  uint32_t Fill(const SymbolStore &Store, uint32_t Rank, size_t Node) {
+    if (Node < Keys.size()) {
+      Rank = Fill(Store, Rank, 2 * Node);
+      Keys[Node] = Store.Values[Indexes[Rank]];
+      Ranks[Node] = Rank++;
+      Rank = Fill(Store, Rank, 2 * Node + 1);
+    }
+    return Rank;
+  }
+
+public:
+  SymbolAddressIndex() : Slide(0) {}
+
+  bool IsEmpty() const { return Indexes.empty(); }
+  size_t GetSize() const { return Indexes.size(); }
+  uint32_t operator[](size_t Position) const { return Indexes[Position]; }
+
+  void Build(const SymbolStore &Store) {
+    Indexes.clear();
+    for (uint32_t i = 0; i < Store.GetSize(); ++i) {
+      if ((Store.Flags[i] & (MO_SYMBOL_STAB | MO_SYMBOL_DEFINED)) ==
+              MO_SYMBOL_DEFINED &&
+          Store.NameLengths[i]) {
+        Indexes.push_back(i);
+      }
+    }
+
+    auto &Values = Store.Values;
+    std::stable_sort(Indexes.begin(), Indexes.end(),
+                     [&](uint32_t A, uint32_t B) {
+                       return Values[A] < Values[B];
+                     });
+    Indexes.erase(std::unique(Indexes.begin(), Indexes.end(),
+                              [&](uint32_t A, uint32_t B) {
+                                return Values[A] == Values[B];
+                              }),
+                  Indexes.end());
+
+    Keys.assign(Indexes.size() + 1, 0);
+    Ranks.assign(Indexes.size() + 1, 0);
+    Fill(Store, 0, 1);
+    Slide = Store.Slide;
+  }
+
+  // Position of the first symbol above the slid Address, GetSize() if there
+  // is none
+  size_t UpperBound(uint64_t Address) const {
+    if (Address < Slide) {
+      return 0;
+    }
+    uint64_t Value = Address - Slide;
+    size_t Node = 1;
+    while (Node < Keys.size()) {
+      // The 16 descendants four levels down share two cache lines
+      __builtin_prefetch(
+          reinterpret_cast<const void *>(uintptr_t(Keys.data()) +
+                                         Node * 16 * sizeof(uint64_t)));
+      Node = 2 * Node + (Keys[Node] <= Value);
+    }
+    // Every right turn after the last left one went past the answer
+    Node >>= __builtin_ffsll(~Node);
+    return Node ? Ranks[Node] : Indexes.size();
+  }
+
+  // Store row of the closest symbol at or below the slid Address
+  bool Lookup(uint64_t Address, uint32_t &Index) const {
+    auto Position = UpperBound(Address);
+    if (!Position) {
+      return false;
+    }
+    Index = Indexes[Position - 1];
+    return true;
+  }
+};
+
+//-----------------------------------------------------------------------------
+// Name index
+//-----------------------------------------------------------------------------
+
+// Symbol names to store rows, a flat open addressing hash table with linear
+// probing. Names are not copied, they are interned in the string table the
+// store already points into. A slot is one word: the upper half of the
+// name's hash and the row, so probing rejects almost every other name
+// without touching the strings.
+//
+// Symbols of the same name, e.g. local ones of different object files, all
+// have their own slots. Rows are inserted in nlist order and probing runs
+// in slot order, so a name's symbols come out in nlist order too.
+class SymbolNameIndex {
+  // Hash << 32 | (Row + 1), zero if empty
+  std::vector<uint64_t> Slots;
+  uint64_t Mask;
+
+private:
+  template <typename F>
+  void Probe(const SymbolStore &Store, std::string_view Name, F &&Fn) const {
+    if (Slots.empty()) {
+      return;
+    }
+    uint64_t Hash = StringTableIndex::Hash(Name);
+    for (uint64_t Slot = Hash & Mask; Slots[Slot]; Slot = (Slot + 1) & Mask) {
+      uint32_t Row = uint32_t(Slots[Slot]) - 1;
+      if (Slots[Slot] >> 32 == Hash >> 32 && Store.GetName(Row) == Name &&
+          !Fn(Row)) {
+        return;
+      }
+    }
+  }
+
+public:
+  SymbolNameIndex() : Mask(0) {}
+
+  bool IsEmpty() const { return Slots.empty(); }
+
+  // Nameless symbols are left out
+  void Build(const SymbolStore &Store) {
+    auto Count = Store.GetSize();
+    std::vector<uint64_t> Hashes(Count);
+    auto HashNames = [&](uint64_t Begin, uint64_t End) {
+      for (auto i = Begin; i < End; ++i) {
+        Hashes[i] = StringTableIndex::Hash(Store.GetName(i));
+      }
+    };
+    if (Count >= MO_PARALLEL_NAMES_THRESHOLD) {
+      ThreadPool::GetShared().ParallelFor(Count, MO_PARALLEL_NAMES_CHUNK,
+                                          HashNames);
+    } else {
+      HashNames(0, Count);
+    }
+
+    // At most half full keeps the probes short
+    uint64_t Size = 16;
+    while (Size < 2 * uint64_t(Count)) {
+      Size *= 2;
+    }
+    Slots.assign(Size, 0);
+    Mask = Size - 1;
+
+    for (uint32_t i = 0; i < Count; ++i) {
+      if (!Store.NameLengths[i]) {
+        continue;
+      }
+      auto Slot = Hashes[i] & Mask;
+      while (Slots[Slot]) {
+        Slot = (Slot + 1) & Mask;
+      }
+      Slots[Slot] = (Hashes[i] & ~0xFFFFFFFFull) | (uint64_t(i) + 1);
+    }
+  }
+
+  // Row of the first symbol named Name
+  bool Lookup(const SymbolStore &Store, std::string_view Name,
+              uint32_t &Row) const {
+    bool Found = false;
+    Probe(Store, Name, [&](uint32_t Match) {
+      Row = Match;
+      Found = true;
+      return false;
+    });
+    return Found;
+  }
+
+  // Calls Fn(Row) for every symbol named Name
+  template <typename F>
+  void ForEach(const SymbolStore &Store, std::string_view Name, F &&Fn) const {
+    Probe(Store, Name, [&](uint32_t Row) {
+      Fn(Row);
+      return true;
+    });
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: SYMBOLSTORE_HPP_T6NB3KQE */
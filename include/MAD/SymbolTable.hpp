@@ -2,45 +2,192 @@
 #define SYMBOLTABLE_HPP_D8BWWYFY
 
 #include <cassert>
-#include <map>
+#include <functional>
 #include <memory>
+#include <string_view>
+#include <vector>
 
 #include <MAD/Debug.hpp>
+#include <MAD/DemangledNameIndex.hpp>
 #include <MAD/Mach.hpp>
 #include <MAD/MachOParser.hpp>
 
 namespace mad {
-template <typename T, typename = IsMachSystem_t<T>> class SymbolTable {
-  using SymbolEntry_t = typename MachOParser<T>::MachOSymbolTableEntry;
+template <typename T, typename I = StreamInput,
+          typename = IsMachSystem_t<T>>
+class SymbolTable {
+private:
+  MachOParser<T, I> &Parser;
+  // Names stay in the parser's string table, values are nlist indexes
+  SymbolNameIndex SymbolsByName;
+  bool IsIndexed;
+  // Built on first use as well, only symbolication needs it
+  SymbolAddressIndex SymbolsByAddress;
+  bool IsAddressIndexed;
+  // Demangling takes the longest, it waits for a C++ name to be asked for
+  DemangledNameIndex DemangledNames;
+  bool IsDemangled;
+  // What images without a symbol table, or that failed to parse, have
+  SymbolStore NoSymbols;
+  // Symbols kept apart from the symbol table, i.e. the locals the shared
+  // cache strips from its images, and their indexes, all built on first use
+  std::function<const SymbolStore &()> LocalsSource;
+  SymbolNameIndex LocalsByName;
+  bool IsLocalsIndexed;
+  SymbolAddressIndex LocalsByAddress;
+  bool IsLocalsAddressIndexed;
 
 private:
-  MachOParser<T> &Parser;
-  std::map<std::string, std::shared_ptr<SymbolEntry_t>> SymbolsByName;
+  void BuildNameIndex() {
+    SymbolsByName.Build(GetSymbols());
+    IsIndexed = true;
+  }
+
+  const SymbolNameIndex &GetLocalNameIndex() {
+    if (!IsLocalsIndexed) {
+      LocalsByName.Build(GetLocalSymbols());
+      IsLocalsIndexed = true;
+    }
+    return LocalsByName;
+  }
 
 public:
-  SymbolTable(MachOParser<T> &Parser) : Parser(Parser) {}
+  SymbolTable(MachOParser<T, I> &Parser)
+      : Parser(Parser), IsIndexed(false), IsAddressIndexed(false),
+        IsDemangled(false), IsLocalsIndexed(false),
+        IsLocalsAddressIndexed(false) {}
 
   void Init() {
-    assert(Parser.SymbolTable);
-    for (auto Entry : Parser.SymbolTable->Symbols) {
-      SymbolsByName.insert({Entry->Name, Entry});
+    // With lazy symbols even the name index waits for the first query
+    if (!Parser.HasLazySymbols()) {
+      BuildNameIndex();
     }
   }
 
-  auto GetSymbols() {
-    assert(Parser.Header);
-    return Parser.SymbolTable->Symbols;
+  const SymbolStore &GetSymbols() {
+    return Parser.SymbolTable ? Parser.SymbolTable->GetStore() : NoSymbols;
+  }
+
+  // Source of the symbols the image's own table leaves out, which is only
+  // called once they are first needed
+  void SetLocalSymbols(std::function<const SymbolStore &()> Source) {
+    LocalsSource = std::move(Source);
+  }
+
+  // Empty unless the image has a source of local symbols
+  const SymbolStore &GetLocalSymbols() {
+    return LocalsSource ? LocalsSource() : NoSymbols;
+  }
+
+  // Defined local symbols in address order, indexes into GetLocalSymbols()
+  const SymbolAddressIndex &GetLocalAddressIndex() {
+    if (!IsLocalsAddressIndexed) {
+      LocalsByAddress.Build(GetLocalSymbols());
+      IsLocalsAddressIndexed = true;
+    }
+    return LocalsByAddress;
+  }
+
+  bool HasSymbol(std::string_view Name) {
+    return bool(GetSymbolByName(Name));
+  }
+
+  // Looks the name up in the image's exports trie, which is much cheaper than
+  // building the name index. Only exports defined by the image itself have
+  // an address.
+  bool GetExportAddress(std::string_view Name, uint64_t &Address) {
+    return Parser.GetExportAddress(Name, Address);
+  }
+
+  // The trie itself, e.g. to follow re-exports into other images
+  const ExportTrie &GetExports() { return Parser.GetExports(); }
+
+  bool GetExportAddress(const ExportTrie::Export &Export, uint64_t &Address) {
+    return Parser.GetExportAddress(Export, Address);
   }
 
-  bool HasSymbol(std::string Name) {
-    return GetSymbolByName(Name) != nullptr;
+  // Function boundaries come from LC_FUNCTION_STARTS and are known even for
+  // stripped images
+  bool GetFunctionRange(uint64_t Address, uint64_t &Start, uint64_t &End) {
+    return Parser.GetFunctionRange(Address, Start, End);
   }
 
-  std::shared_ptr<SymbolEntry_t> GetSymbolByName(std::string Name) {
-    if (SymbolsByName.count(Name)) {
-      return SymbolsByName.at(Name);
+  const FunctionStarts &GetFunctionStarts() {
+    return Parser.GetFunctionStarts();
+  }
+
+  // Closest defined symbol at or below the slid Address, e.g. the function a
+  // return address is in, local ones included. Null if there is none.
+  SymbolRef GetSymbolByAddress(uint64_t Address) {
+    SymbolRef Result;
+    uint32_t Index;
+    if (GetAddressIndex().Lookup(Address, Index)) {
+      Result = SymbolRef(&GetSymbols(), Index);
+    }
+    if (LocalsSource && GetLocalAddressIndex().Lookup(Address, Index)) {
+      SymbolRef Local(&GetLocalSymbols(), Index);
+      if (!Result || Local.GetValue() > Result.GetValue()) {
+        Result = Local;
+      }
+    }
+    return Result;
+  }
+
+  // Defined symbols in address order, indexes into GetSymbols()
+  const SymbolAddressIndex &GetAddressIndex() {
+    if (!IsAddressIndexed) {
+      SymbolsByAddress.Build(GetSymbols());
+      IsAddressIndexed = true;
+    }
+    return SymbolsByAddress;
+  }
+
+  // C++ functions by the parts of their demangled names, indexes into
+  // GetSymbols()
+  const DemangledNameIndex &GetDemangledNames() {
+    if (!IsDemangled) {
+      DemangledNames.Build(GetSymbols());
+      IsDemangled = true;
+    }
+    return DemangledNames;
+  }
+
+  // The first symbol of the name in nlist order, local ones after the rest
+  SymbolRef GetSymbolByName(std::string_view Name) {
+    if (!IsIndexed) {
+      BuildNameIndex();
+    }
+    auto &Store = GetSymbols();
+    uint32_t Index;
+    if (SymbolsByName.Lookup(Store, Name, Index)) {
+      return SymbolRef(&Store, Index);
+    }
+    if (LocalsSource) {
+      auto &Locals = GetLocalSymbols();
+      if (GetLocalNameIndex().Lookup(Locals, Name, Index)) {
+        return SymbolRef(&Locals, Index);
+      }
+    }
+    return SymbolRef();
+  }
+
+  // Every symbol of the name, e.g. static functions of different files
+  std::vector<SymbolRef> GetSymbolsByName(std::string_view Name) {
+    if (!IsIndexed) {
+      BuildNameIndex();
+    }
+    auto &Store = GetSymbols();
+    std::vector<SymbolRef> Result;
+    SymbolsByName.ForEach(Store, Name, [&](uint32_t Index) {
+      Result.emplace_back(&Store, Index);
+    });
+    if (LocalsSource) {
+      auto &Locals = GetLocalSymbols();
+      GetLocalNameIndex().ForEach(Locals, Name, [&](uint32_t Index) {
+        Result.emplace_back(&Locals, Index);
+      });
     }
-    return nullptr;
+    return Result;
   }
 };
 } // namespace mad
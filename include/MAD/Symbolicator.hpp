@@ -0,0 +1,176 @@
+#ifndef SYMBOLICATOR_HPP_R7LC4XPE
+#define SYMBOLICATOR_HPP_R7LC4XPE
+
+// Std
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+// MAD
+#include "MAD/DwarfLineTable.hpp"
+#include "MAD/FunctionStarts.hpp"
+#include "MAD/ImageAddressMap.hpp"
+#include "MAD/SymbolStore.hpp"
+
+namespace mad {
+
+// Resolves a batch of addresses, e.g. the samples of a profile or every frame
+// of a crashed process, to symbols and lines in one go.
+//
+// Addresses are sorted first. A run of them within one segment takes a single
+// lookup in the image map, then walks the image's symbols and function starts
+// alongside, both of which are in address order too. Only the first address
+// of a run is searched for, so a batch costs a sort plus a lookup per run
+// instead of a few searches per address.
+//
+// The symbol of an address is the closest one at or below it, unless a
+// function the symbol table does not name is closer, e.g. in a stripped
+// image. Local symbols the shared cache keeps apart from its images count as
+// well. Lines come from the image's dSYM, if it has one.
+//
+// Image_t is a MachImage, or anything else with the same GetSymbolTable(),
+// GetSlide() and GetLineTable().
+template <typename Image_t> class Symbolicator {
+public:
+  struct SymbolicatedAddress {
+    uint64_t Address;
+    // Null if the address is in no image
+    std::shared_ptr<Image_t> Image;
+    // Null for functions only LC_FUNCTION_STARTS knows of
+    SymbolRef Symbol;
+    // Slid start of the symbol, or of the function; Address is that plus
+    // Offset. Zero if neither is known.
+    uint64_t Start;
+    uint64_t Offset;
+    bool HasLine;
+    LineInfo Line;
+  };
+
+private:
+  const ImageAddressMap<Image_t> &Images;
+
+private:
+  // Position past the last function that starts at or below Address
+  static size_t UpperBound(const FunctionStarts &Functions, uint64_t Address) {
+    size_t Position = 0;
+    for (size_t Count = Functions.GetSize(); Count;) {
+      size_t Half = Count / 2;
+      if (Functions.GetStart(Position + Half) <= Address) {
+        Position += Half + 1;
+        Count -= Half + 1;
+      } else {
+        Count = Half;
+      }
+    }
+    return Position;
+  }
+
+  // Resolves the addresses at [Begin, End) of the order, all of them in the
+  // segment of Image that starts at Floor and in ascending order
+  static void Resolve(const std::shared_ptr<Image_t> &Image, uint64_t Floor,
+                      const uint64_t *Addresses, const uint32_t *Begin,
+                      const uint32_t *End, SymbolicatedAddress *Results) {
+    auto &Table = Image->GetSymbolTable();
+    auto &Store = Table.GetSymbols();
+    auto &Index = Table.GetAddressIndex();
+    auto &Locals = Table.GetLocalSymbols();
+    auto &LocalIndex = Table.GetLocalAddressIndex();
+    auto &Functions = Table.GetFunctionStarts();
+    auto Lines = Image->GetLineTable();
+    uint64_t Slide = Image->GetSlide();
+
+    // Every cursor points past the last entry at or below the address
+    auto SymbolValue = [&](size_t i) { return Store.GetValue(Index[i]); };
+    auto LocalValue = [&](size_t i) { return Locals.GetValue(LocalIndex[i]); };
+    auto FunctionStart = [&](size_t i) { return Functions.GetStart(i); };
+    size_t Symbol = Index.UpperBound(Addresses[*Begin]);
+    size_t Local = LocalIndex.UpperBound(Addresses[*Begin]);
+    size_t Function = UpperBound(Functions, Addresses[*Begin]);
+
+    for (auto It = Begin; It != End; ++It) {
+      uint64_t Address = Addresses[*It];
+      while (Symbol < Index.GetSize() && SymbolValue(Symbol) <= Address) {
+        ++Symbol;
+      }
+      while (Local < LocalIndex.GetSize() && LocalValue(Local) <= Address) {
+        ++Local;
+      }
+      while (Function < Functions.GetSize() &&
+             FunctionStart(Function) <= Address) {
+        ++Function;
+      }
+
+      auto &Result = Results[*It];
+      Result.Image = Image;
+
+      // Neither a symbol nor a function of another segment says anything
+      // about the address
+      bool InFunction = Function && FunctionStart(Function - 1) >= Floor &&
+                        Address < Functions.GetEnd(Function - 1);
+      uint64_t Start = InFunction ? FunctionStart(Function - 1) : Floor;
+      // The table's own symbol wins over a local at the same address
+      if (Local && LocalValue(Local - 1) >= Start &&
+          (!Symbol || LocalValue(Local - 1) > SymbolValue(Symbol - 1))) {
+        Result.Symbol = SymbolRef(&Locals, LocalIndex[Local - 1]);
+        Result.Start = Result.Symbol.GetValue();
+      } else if (Symbol && SymbolValue(Symbol - 1) >= Start) {
+        Result.Symbol = SymbolRef(&Store, Index[Symbol - 1]);
+        Result.Start = Result.Symbol.GetValue();
+      } else if (InFunction) {
+        Result.Start = Start;
+      }
+      Result.Offset = Result.Start ? Address - Result.Start : 0;
+
+      // Line tables of dSYMs are not slid
+      Result.HasLine = Lines && Lines->LookupAddress(Address - Slide,
+                                                     Result.Line);
+    }
+  }
+
+public:
+  explicit Symbolicator(const ImageAddressMap<Image_t> &Images)
+      : Images(Images) {}
+
+  // One result per address, in the order given
+  std::vector<SymbolicatedAddress> Symbolicate(const uint64_t *Addresses,
+                                               size_t Count) const {
+    std::vector<SymbolicatedAddress> Results(Count);
+    std::vector<uint32_t> Order(Count);
+    std::iota(Order.begin(), Order.end(), 0);
+    std::sort(Order.begin(), Order.end(), [&](uint32_t A, uint32_t B) {
+      return Addresses[A] < Addresses[B];
+    });
+
+    for (size_t i = 0; i < Count; ++i) {
+      Results[i].Address = Addresses[i];
+    }
+
+    for (size_t Begin = 0; Begin < Count;) {
+      typename ImageAddressMap<Image_t>::Location Location;
+      if (!Images.Lookup(Addresses[Order[Begin]], Location)) {
+        ++Begin;
+        continue;
+      }
+
+      // The rest of the run is in the same segment
+      auto &Segment = *Location.Segment;
+      uint64_t End = Segment.VirtualAddress + Segment.VirtualSize;
+      size_t Last = Begin + 1;
+      while (Last < Count && Addresses[Order[Last]] < End) {
+        ++Last;
+      }
+
+      Resolve(Location.Image, Segment.VirtualAddress, Addresses,
+              Order.data() + Begin, Order.data() + Last, Results.data());
+      Begin = Last;
+    }
+
+    return Results;
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: SYMBOLICATOR_HPP_R7LC4XPE */
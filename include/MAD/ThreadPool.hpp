@@ -0,0 +1,50 @@
+#ifndef THREADPOOL_HPP_R8KXW3ZD
+#define THREADPOOL_HPP_R8KXW3ZD
+
+// Std
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mad {
+
+// A fixed set of worker threads pulling tasks from a FIFO queue.
+class ThreadPool {
+  std::vector<std::thread> Workers;
+  std::deque<std::function<void()>> Tasks;
+  std::mutex Mutex;
+  std::condition_variable Condition;
+  bool Stopping;
+
+private:
+  void Work();
+
+public:
+  ThreadPool(unsigned Count = std::thread::hardware_concurrency());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // The pool every parser and index shares
+  static ThreadPool &GetShared();
+
+  unsigned GetSize() const { return Workers.size(); }
+
+  void Enqueue(std::function<void()> Task);
+
+  // Calls Body(Begin, End) for every ChunkSize-long piece of [0, Count) and
+  // returns once all of them are done. The calling thread processes chunks
+  // too and only waits for chunks other workers have already started, so it
+  // is safe to call this from within a pool task.
+  void ParallelFor(uint64_t Count, uint64_t ChunkSize,
+                   std::function<void(uint64_t, uint64_t)> Body);
+};
+
+} // namespace mad
+
+#endif /* end of include guard: THREADPOOL_HPP_R8KXW3ZD */
@@ -1,23 +1,70 @@
 #ifndef UNIVERSALBINARY_HPP_PMFJI0Q2
 #define UNIVERSALBINARY_HPP_PMFJI0Q2
 
-#include <fstream>
-#include <map>
+#include <mach/machine.h>
+
+#include <memory>
 #include <string>
+#include <vector>
 
+#include "MAD/ByteView.hpp"
+#include "MAD/MappedFile.hpp"
 #include "MAD/ObjectFile.hpp"
 
 namespace mad {
+
+// A fat binary mapped as a whole. Parse reads only the fat table, slices are
+// parsed on first request straight out of the mapping, so however many
+// architectures the binary has only the one in use is ever parsed.
 class UniversalBinary {
+public:
+  // A fat_arch or fat_arch_64 in host byte order
+  struct Slice {
+    cpu_type_t CpuType;
+    // Without capability bits
+    cpu_subtype_t CpuSubType;
+    uint64_t Offset;
+    uint64_t Size;
+    uint32_t Align;
+  };
+
+private:
   std::string Path;
-  std::ifstream &Input;
-  std::map<uint32_t, ObjectFile> ObjectFiles;
+  // Every ObjectFile views its slice straight out of this mapping
+  MappedFile File;
+  // All of the binary, File's mapping unless the bytes were given to Parse
+  ByteView View;
+  std::vector<Slice> Slices;
+  // Parallel to Slices, null until the slice is asked for
+  std::vector<std::unique_ptr<ObjectFile>> ObjectFiles;
+  std::vector<bool> IsParsed;
+
+private:
+  bool ReadSlices(ByteView Input);
 
 public:
-  UniversalBinary(std::string path, std::ifstream &input)
-      : Path(path), Input(input) {}
+  UniversalBinary(std::string path) : Path(path) {}
 
   bool Parse();
+  // Same for a binary that is already in memory, the bytes must outlive this
+  bool Parse(ByteView Input);
+
+  auto &GetPath() const { return Path; }
+  auto &GetSlices() const { return Slices; }
+
+  // Exact subtype first, then the CPU type's _ALL subtype, the way the kernel
+  // picks a slice to run. CPU_SUBTYPE_MULTIPLE takes any slice of the type.
+  const Slice *FindSlice(cpu_type_t CpuType,
+                         cpu_subtype_t CpuSubType = CPU_SUBTYPE_MULTIPLE) const;
+
+  ByteView GetSliceView(const Slice &Which) const {
+    return View.Slice(Which.Offset, Which.Size);
+  }
+
+  // Parses the matching slice on first call. Null if there is none or it
+  // fails to parse.
+  ObjectFile *GetObjectFile(cpu_type_t CpuType,
+                            cpu_subtype_t CpuSubType = CPU_SUBTYPE_MULTIPLE);
 };
 } // namespace mad
 
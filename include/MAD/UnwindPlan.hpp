@@ -0,0 +1,165 @@
+#ifndef UNWINDPLAN_HPP_T6QZ2MVA
+#define UNWINDPLAN_HPP_T6QZ2MVA
+
+// Std
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace mad {
+
+// x86_64 registers by their DWARF numbers, the CFI uses them as is
+enum : uint8_t {
+  REG_X86_64_RAX = 0,
+  REG_X86_64_RDX = 1,
+  REG_X86_64_RCX = 2,
+  REG_X86_64_RBX = 3,
+  REG_X86_64_RSI = 4,
+  REG_X86_64_RDI = 5,
+  REG_X86_64_RBP = 6,
+  REG_X86_64_RSP = 7,
+  REG_X86_64_R8 = 8,
+  REG_X86_64_R9 = 9,
+  REG_X86_64_R10 = 10,
+  REG_X86_64_R11 = 11,
+  REG_X86_64_R12 = 12,
+  REG_X86_64_R13 = 13,
+  REG_X86_64_R14 = 14,
+  REG_X86_64_R15 = 15,
+  // The return address column
+  REG_X86_64_RIP = 16,
+  REG_X86_64_COUNT = 17,
+};
+
+// Registers of a frame. Only the ones a callee has to preserve are known
+// past the innermost frame.
+struct UnwindRegisters {
+  uint64_t Values[REG_X86_64_COUNT] = {};
+  uint32_t ValidMask = 0;
+
+  bool Has(unsigned Register) const { return ValidMask & (1u << Register); }
+  uint64_t Get(unsigned Register) const { return Values[Register]; }
+  void Set(unsigned Register, uint64_t Value) {
+    Values[Register] = Value;
+    ValidMask |= 1u << Register;
+  }
+};
+
+enum class UnwindRuleType : uint8_t {
+  // The callee did not touch it
+  SAME,
+  // Lost, e.g. a scratch register
+  UNDEFINED,
+  // Saved at CFA + Value
+  AT_CFA,
+  // Is CFA + Value itself
+  IS_CFA,
+  // Copied to register Value
+  IN_REGISTER
+};
+
+// Where to find the caller's value of a register
+struct UnwindRule {
+  UnwindRuleType Type;
+  int64_t Value;
+};
+
+// How to get from a frame to its caller's from some instruction of a function
+// on. The CFA is the caller's stack pointer before the call, i.e. the address
+// right above the return address.
+struct UnwindRow {
+  // From the start of the function
+  uint64_t Offset;
+  uint8_t CFARegister;
+  int64_t CFAOffset;
+  UnwindRule Rules[REG_X86_64_COUNT];
+
+  // What every function looks like on entry, before its first instruction
+  UnwindRow() : Offset(0), CFARegister(REG_X86_64_RSP), CFAOffset(8) {
+    for (auto &Rule : Rules) {
+      Rule = {UnwindRuleType::UNDEFINED, 0};
+    }
+    for (auto Register : {REG_X86_64_RBX, REG_X86_64_RBP, REG_X86_64_R12,
+                          REG_X86_64_R13, REG_X86_64_R14, REG_X86_64_R15}) {
+      Rules[Register] = {UnwindRuleType::SAME, 0};
+    }
+    Rules[REG_X86_64_RIP] = {UnwindRuleType::AT_CFA, -8};
+  }
+
+  void SetSavedAt(unsigned Register, int64_t Offset) {
+    Rules[Register] = {UnwindRuleType::AT_CFA, Offset};
+  }
+
+  // Fills Caller from Callee, reading saved registers with ReadWord, e.g.
+  // bool(uint64_t Address, uint64_t &Value). Fails if the CFA or a saved
+  // register cannot be had.
+  template <typename R>
+  bool Step(const UnwindRegisters &Callee, UnwindRegisters &Caller,
+            R &&ReadWord) const {
+    if (!Callee.Has(CFARegister)) {
+      return false;
+    }
+    uint64_t CFA = Callee.Get(CFARegister) + CFAOffset;
+
+    Caller = UnwindRegisters();
+    for (unsigned i = 0; i < REG_X86_64_COUNT; ++i) {
+      auto &Rule = Rules[i];
+      switch (Rule.Type) {
+      case UnwindRuleType::SAME:
+        if (Callee.Has(i)) {
+          Caller.Set(i, Callee.Get(i));
+        }
+        break;
+      case UnwindRuleType::UNDEFINED:
+        break;
+      case UnwindRuleType::AT_CFA: {
+        uint64_t Value;
+        if (!ReadWord(CFA + Rule.Value, Value)) {
+          return false;
+        }
+        Caller.Set(i, Value);
+        break;
+      }
+      case UnwindRuleType::IS_CFA:
+        Caller.Set(i, CFA + Rule.Value);
+        break;
+      case UnwindRuleType::IN_REGISTER:
+        if (Rule.Value < REG_X86_64_COUNT && Callee.Has(Rule.Value)) {
+          Caller.Set(i, Callee.Get(Rule.Value));
+        }
+        break;
+      }
+    }
+
+    // The return pops the return address and nothing else
+    Caller.Set(REG_X86_64_RSP, CFA);
+    return true;
+  }
+};
+
+// Rows of a single function, [Start, End) are slid addresses
+struct UnwindPlan {
+  uint64_t Start = 0;
+  uint64_t End = 0;
+  // Sorted by offset, the first one is at 0
+  std::vector<UnwindRow> Rows;
+
+  bool IsEmpty() const { return Rows.empty(); }
+  bool Contains(uint64_t Address) const {
+    return Address >= Start && Address < End;
+  }
+
+  // The row in effect at Address, which must be within the function
+  const UnwindRow &GetRow(uint64_t Address) const {
+    auto It = std::upper_bound(
+        Rows.begin(), Rows.end(), Address - Start,
+        [](uint64_t Offset, const UnwindRow &Row) {
+          return Offset < Row.Offset;
+        });
+    return It == Rows.begin() ? Rows.front() : *(It - 1);
+  }
+};
+
+} // namespace mad
+
+#endif /* end of include guard: UNWINDPLAN_HPP_T6QZ2MVA */
@@ -0,0 +1,70 @@
+#ifndef UNWINDER_HPP_F7LC3XZB
+#define UNWINDER_HPP_F7LC3XZB
+
+// Std
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+// MAD
+#include "MAD/MachProcess.hpp"
+#include "MAD/MachThread.hpp"
+#include "MAD/UnwindPlan.hpp"
+
+namespace mad {
+
+// Runaway recursion aside, nothing is this deep
+#define UNWIND_MAX_FRAMES 1024u
+// Stacks are read this much at a time
+#define UNWIND_STACK_WINDOW 0x4000u
+
+struct StackFrame {
+  // Return addresses past the innermost frame
+  uint64_t PC;
+  // Zero if the frame could not be unwound
+  uint64_t CFA;
+};
+
+// Walks the stacks of a stopped process with the unwind info of its images.
+// The plan of a function is decoded once, from its compact unwind encoding
+// or from its FDE if the encoding points to one or there is none, and kept
+// for every later backtrace. Frames of code without any unwind info are
+// assumed to be standard rbp frames.
+//
+// The stack is read in windows of UNWIND_STACK_WINDOW bytes from the frame
+// being unwound up, which covers the next few callers' frames as well.
+// Windows do not outlive a backtrace, the stack changes in between.
+class Unwinder {
+  std::shared_ptr<MachProcess> Process;
+  // Plans by the slid start of their functions
+  std::map<uint64_t, UnwindPlan> Plans;
+  std::vector<char> Window;
+  uint64_t WindowAddress;
+
+private:
+  bool ReadPlan(MachImage64 &Image, uint64_t Address, UnwindPlan &Plan);
+  const UnwindPlan *FindPlan(uint64_t Address);
+  bool ReadStack(uint64_t Address, uint64_t &Value);
+
+public:
+  Unwinder() : WindowAddress(0) {}
+
+  void Attach(std::shared_ptr<MachProcess> Process);
+  void Detach();
+
+  // The image whose __TEXT contains Address
+  MachImage64 *FindImage(uint64_t Address);
+
+  // Frames of a stopped thread, the innermost first
+  bool Backtrace(MachThread &Thread, std::vector<StackFrame> &Frames,
+                 size_t MaxFrames = UNWIND_MAX_FRAMES);
+
+  // Every thread of the stopped process, in the order the task lists them
+  bool BacktraceAll(std::vector<std::vector<StackFrame>> &Traces,
+                    size_t MaxFrames = UNWIND_MAX_FRAMES);
+};
+
+} // namespace mad
+
+#endif /* end of include guard: UNWINDER_HPP_F7LC3XZB */
@@ -2,6 +2,7 @@
 #define UTILS_HPP_J9PMINOK
 
 #include <ostream>
+#include <string_view>
 
 namespace mad {
 
@@ -73,6 +74,21 @@ using BoundFlagEq = BoundFlag<unsigned, FlagPolicyEq, Value>;
 template <unsigned Value>
 using BoundFlagAnd = BoundFlag<unsigned, FlagPolicyAnd, Value>;
 
+//-----------------------------------------------------------------------------
+// Paths
+//-----------------------------------------------------------------------------
+
+// The whole path, or its trailing components unless the query is absolute,
+// i.e. lines.c and src/lines.c both match /work/src/lines.c
+inline bool IsPathMatching(std::string_view Path, std::string_view Query) {
+  if (Query.empty() || Path.size() < Query.size() ||
+      Path.compare(Path.size() - Query.size(), Query.size(), Query)) {
+    return false;
+  }
+  return Path.size() == Query.size() ||
+         (Query.front() != '/' && Path[Path.size() - Query.size() - 1] == '/');
+}
+
 } // namespace mad
 
 //-----------------------------------------------------------------------------
@@ -70,15 +70,94 @@ void BreakpointsControl::Attach(std::shared_ptr<MachProcess> Proc) {
   // to the process it will stop at _start symbol of the Dynamic Linker, in
   // order to skip the DyLD code we need to setup a breakpoint at this
   // function. This stub function is run just before executing any user code
-  // including shared library's init code and C++ static constructors.
+  // including shared library's init code and C++ static constructors. DyLD
+  // runs it again whenever it loads or unloads images, e.g. on dlopen(), so
+  // the breakpoint stays and keeps the images and breakpoints up to date.
   AddBreakpointBySymbolName(
       "__dyld_debugger_notification", [this](std::string) {
-        TryToInstantiateAllPendingSeeds();
-        RemoveBreakpointBySymbolName("__dyld_debugger_notification");
+        UpdateImages();
         return BreakpointCallbackReturn::CONTINUE;
       });
 }
 
+void BreakpointsControl::UpdateImages() {
+  if (!Process) {
+    return;
+  }
+
+  // Regex seeds count the images they searched, the ones after an unloaded
+  // image move down a position
+  auto Before = Process->GetImagess();
+  std::vector<std::shared_ptr<MachImage64>> Added, Removed;
+  Process->UpdateImages(Added, Removed);
+  if (!Removed.empty()) {
+    std::set<std::shared_ptr<MachImage64>> Gone(Removed.begin(),
+                                                Removed.end());
+    for (auto &Entry : SeedsByRegex) {
+      auto &Searched = Entry.second->SearchedImages;
+      Searched -= std::count_if(Before.begin(), Before.begin() + Searched,
+                                [&](auto &Image) { return Gone.count(Image); });
+    }
+    for (auto &Image : Removed) {
+      ForgetImage(Image);
+    }
+  }
+
+  TryToInstantiateAllPendingSeeds();
+}
+
+void BreakpointsControl::ForgetImage(
+    const std::shared_ptr<MachImage64> &Image) {
+  // The code is unmapped along with the traps in it, nothing to restore
+  std::vector<std::pair<AddressType, APoint_sp>> Gone;
+  for (auto &Segment : Image->GetSegments()) {
+    if (!(Segment->Raw.initprot & VM_PROT_EXECUTE)) {
+      continue;
+    }
+    auto Begin = APointsByAddress.lower_bound(Segment->VirtualAddress);
+    auto End = APointsByAddress.lower_bound(Segment->VirtualAddress +
+                                            Segment->VirtualSize);
+    Gone.insert(Gone.end(), Begin, End);
+  }
+
+  for (auto &Entry : Gone) {
+    auto Address = Entry.first;
+    auto &A = Entry.second;
+    for (auto &V : APointToVPoints[A]) {
+      // A seed left without v-points waits for the image to come back
+      for (auto &S : VPointToSeeds[V]) {
+        auto &VPoints = SeedToVPoints[S];
+        VPoints.erase(V);
+        if (VPoints.empty()) {
+          SeedToVPoints.erase(S);
+          if (S->PendingPolicy == SeedPendingPolicy::REMOVE) {
+            PendingSeeds.insert(S);
+          }
+        }
+      }
+      VPointToSeeds.erase(V);
+      VPointToAPoint.erase(V);
+
+      // The v-point owns at most one entry of the address
+      auto Erase = [&](auto &Map) {
+        auto It = Map.find(Address);
+        if (It != Map.end() && It->second == V) {
+          Map.erase(It);
+        }
+      };
+      Erase(VPointsByAddress);
+      Erase(VPointsBySymbol);
+      Erase(VPointsByLine);
+      Erase(VPointsByFunction);
+      AllVPoints.erase(V);
+    }
+
+    APointToVPoints.erase(A);
+    APointsByAddress.erase(Address);
+    AllAPoints.erase(A);
+  }
+}
+
 void BreakpointsControl::Detach(bool IsProcessValid) {
   // 1. Disable all active breakpoints
   if (IsProcessValid) {
@@ -100,15 +179,26 @@ void BreakpointsControl::Detach(bool IsProcessValid) {
   SeedToVPoints.clear();
   VPointsBySymbol.clear();
   VPointsByAddress.clear();
+  VPointsByLine.clear();
+  VPointsByFunction.clear();
   AllVPoints.clear();
 
   // 4. Make all available seeds pending, so that next run of a program can use
   // them
   PendingSeeds = AllSeeds;
+  for (auto &Entry : SeedsByRegex) {
+    Entry.second->SearchedImages = 0;
+  }
 
   Process = nullptr;
 }
 
+bool BreakpointsControl::IsCode(AddressType Address) {
+  ImageAddressMap<MachImage64>::Location Location;
+  return Process->GetImagesByAddress().Lookup(Address, Location) &&
+         (Location.Segment->Raw.initprot & VM_PROT_EXECUTE);
+}
+
 APoint_sp BreakpointsControl::GetOrCreateActualBreakpoint(AddressType Address) {
   if (APointsByAddress.count(Address)) {
     return APointsByAddress[Address];
@@ -153,29 +243,56 @@ bool BreakpointsControl::TryInstantiateSeedSymbolName(
     return false;
   }
 
-  VirtualPointSymbol::SymbolType_sp Symbol;
+  // Exported symbols are found by walking the images' exports tries, which
+  // does not need the nlist tables at all. Only if none of the images
+  // exports the name we fall back to the full symbol tables.
+  bool Found = false;
+  AddressType Address = 0;
+  SymbolRef Symbol;
   for (auto &Image : Process->GetImagess()) {
-    auto &SymbolTable = Image->GetSymbolTable();
-    // TODO There are no HW breakpoints now, so filter out non-code
-    // symbols somehow
-    if (SymbolTable.HasSymbol(S->SymbolName)) {
-      Symbol = SymbolTable.GetSymbolByName(S->SymbolName);
+    uint64_t Exported;
+    if (Image->GetSymbolTable().GetExportAddress(S->SymbolName, Exported) &&
+        IsCode(Exported)) {
+      Address = Exported;
+      Found = true;
       break;
     }
   }
 
-  if (!Symbol) {
+  // One lookup in the process wide index finds every definition at once. An
+  // external one wins over the locals of the same name, e.g. statics, and
+  // since there are no HW breakpoints data symbols are skipped.
+  if (!Found) {
+    for (auto &Definition :
+         Process->GetGlobalSymbols().Lookup(S->SymbolName)) {
+      auto Candidate = Definition.Symbol;
+      if (!IsCode(Candidate.GetValue())) {
+        continue;
+      }
+      if (!Found || Candidate.IsExternal()) {
+        Symbol = Candidate;
+        Address = Candidate.GetValue();
+        Found = true;
+      }
+      if (Candidate.IsExternal()) {
+        break;
+      }
+    }
+  }
+
+  if (!Found) {
     return false;
   }
 
-  auto A = GetOrCreateActualBreakpoint(Symbol->Value);
+  auto A = GetOrCreateActualBreakpoint(Address);
   // If we fail at this moment we do not create any v/a points
   if (!A->Up()) {
+    TryDestroyActualBreakpoint(A);
     return false;
   }
 
-  auto V = std::make_shared<VirtualPointSymbol>(Symbol);
-  VPointsBySymbol.emplace(Symbol, V);
+  auto V = std::make_shared<VirtualPointSymbol>(Address, Symbol);
+  VPointsBySymbol.emplace(Address, V);
   AllVPoints.insert(V);
 
   // Keep in sync
@@ -191,8 +308,9 @@ bool BreakpointsControl::TryInstantiateSeedSymbolName(
 void BreakpointsControl::DestroySeedSymbolName(const SeedSymbolName_sp &S) {
   for (auto &VPoint : SeedToVPoints[S]) {
     auto V = std::static_pointer_cast<VirtualPointSymbol>(VPoint);
-    VPointToSeeds[V].erase(S);
-    auto &A = VPointToAPoint[V];
+    VPointToSeeds.erase(V);
+    // A copy, the entry is gone right below
+    auto A = VPointToAPoint[V];
 
     VPointToAPoint.erase(V);
     APointToVPoints[A].erase(V);
@@ -200,7 +318,11 @@ void BreakpointsControl::DestroySeedSymbolName(const SeedSymbolName_sp &S) {
     A->Down();
     TryDestroyActualBreakpoint(A);
 
-    VPointsBySymbol.erase(V->Symbol);
+    // Another seed may own the entry of the address
+    auto It = VPointsBySymbol.find(V->Address);
+    if (It != VPointsBySymbol.end() && It->second == V) {
+      VPointsBySymbol.erase(It);
+    }
     AllVPoints.erase(V);
   }
   SeedToVPoints.erase(S);
@@ -208,6 +330,289 @@ void BreakpointsControl::DestroySeedSymbolName(const SeedSymbolName_sp &S) {
   SeedsBySymbolName.erase(S->SymbolName);
 }
 
+bool BreakpointsControl::TryInstantiateSeedRegex(const SeedRegex_sp &S) {
+  if (!Process) {
+    return false;
+  }
+
+  // Images searched the last time have nothing new to offer
+  auto &Images = Process->GetImagess();
+  auto Matches = SymbolSearch::Search(S->Compiled, Images, S->SearchedImages);
+  S->SearchedImages = Images.size();
+
+  // Aliases share an address, one v-point covers all of them
+  bool Found = false;
+  std::set<AddressType> Seen;
+  for (auto &Match : Matches) {
+    AddressType Address = Match.Symbol.GetValue();
+    if (!IsCode(Address) || !Seen.insert(Address).second) {
+      continue;
+    }
+
+    auto A = GetOrCreateActualBreakpoint(Address);
+    if (!A->Up()) {
+      TryDestroyActualBreakpoint(A);
+      continue;
+    }
+
+    auto V = std::make_shared<VirtualPointSymbol>(Address, Match.Symbol);
+    VPointsBySymbol.emplace(Address, V);
+    AllVPoints.insert(V);
+
+    // Keep in sync
+    SeedToVPoints[S].insert(V);
+    VPointToSeeds[V].insert(S);
+
+    // Keep in sync
+    VPointToAPoint.emplace(V, A);
+    APointToVPoints[A].insert(V);
+
+    Found = true;
+  }
+
+  return Found;
+}
+void BreakpointsControl::DestroySeedRegex(const SeedRegex_sp &S) {
+  for (auto &VPoint : SeedToVPoints[S]) {
+    auto V = std::static_pointer_cast<VirtualPointSymbol>(VPoint);
+    VPointToSeeds.erase(V);
+    // A copy, the entry is gone right below
+    auto A = VPointToAPoint[V];
+
+    VPointToAPoint.erase(V);
+    APointToVPoints[A].erase(V);
+
+    A->Down();
+    TryDestroyActualBreakpoint(A);
+
+    // A symbol seed may own the entry of the address
+    auto It = VPointsBySymbol.find(V->Address);
+    if (It != VPointsBySymbol.end() && It->second == V) {
+      VPointsBySymbol.erase(It);
+    }
+    AllVPoints.erase(V);
+  }
+  SeedToVPoints.erase(S);
+
+  SeedsByRegex.erase(S->Pattern);
+}
+
+bool BreakpointsControl::TryInstantiateSeedLine(const SeedLine_sp &S) {
+  if (!Process) {
+    return false;
+  }
+
+  // A file can be compiled into several images, e.g. a header with inline
+  // functions, every one of them gets its breakpoints
+  bool Found = false;
+  for (auto &Image : Process->GetImagess()) {
+    auto Table = Image->GetLineTable();
+    std::vector<uint64_t> Addresses;
+    uint32_t Line;
+    if (!Table || !Table->LookupLine(S->File, S->Line, Addresses, Line)) {
+      continue;
+    }
+
+    if (Line != S->Line) {
+      PRINT_DEBUG("No code at", S->File, S->Line, "moved to line", Line);
+    }
+
+    for (auto Unslid : Addresses) {
+      AddressType Address = Unslid + Image->GetSlide();
+      auto A = GetOrCreateActualBreakpoint(Address);
+      if (!A->Up()) {
+        TryDestroyActualBreakpoint(A);
+        continue;
+      }
+
+      auto V = std::make_shared<VirtualPointLine>(Address, Line);
+      VPointsByLine.emplace(Address, V);
+      AllVPoints.insert(V);
+
+      // Keep in sync
+      SeedToVPoints[S].insert(V);
+      VPointToSeeds[V].insert(S);
+
+      // Keep in sync
+      VPointToAPoint.emplace(V, A);
+      APointToVPoints[A].insert(V);
+
+      Found = true;
+    }
+  }
+
+  return Found;
+}
+void BreakpointsControl::DestroySeedLine(const SeedLine_sp &S) {
+  for (auto &VPoint : SeedToVPoints[S]) {
+    auto V = std::static_pointer_cast<VirtualPointLine>(VPoint);
+    VPointToSeeds.erase(V);
+    // A copy, the entry is gone right below
+    auto A = VPointToAPoint[V];
+
+    VPointToAPoint.erase(V);
+    APointToVPoints[A].erase(V);
+
+    A->Down();
+    TryDestroyActualBreakpoint(A);
+
+    // Another line seed may own the entry of the address
+    auto It = VPointsByLine.find(V->Address);
+    if (It != VPointsByLine.end() && It->second == V) {
+      VPointsByLine.erase(It);
+    }
+    AllVPoints.erase(V);
+  }
+  SeedToVPoints.erase(S);
+
+  SeedsByLine.erase({S->File, S->Line});
+}
+
+bool BreakpointsControl::InstantiateFunctions(
+    const Seed_sp &S, uint64_t Slide,
+    const std::vector<DwarfFunction> &Functions) {
+  bool Found = false;
+  for (auto &Function : Functions) {
+    AddressType Address = Function.Address + Slide;
+    auto A = GetOrCreateActualBreakpoint(Address);
+    if (!A->Up()) {
+      TryDestroyActualBreakpoint(A);
+      continue;
+    }
+
+    auto V = std::make_shared<VirtualPointFunction>(
+        Address, std::string(Function.Name));
+    VPointsByFunction.emplace(Address, V);
+    AllVPoints.insert(V);
+
+    // Keep in sync
+    SeedToVPoints[S].insert(V);
+    VPointToSeeds[V].insert(S);
+
+    // Keep in sync
+    VPointToAPoint.emplace(V, A);
+    APointToVPoints[A].insert(V);
+
+    Found = true;
+  }
+  return Found;
+}
+void BreakpointsControl::DestroyFunctions(const Seed_sp &S) {
+  for (auto &VPoint : SeedToVPoints[S]) {
+    auto V = std::static_pointer_cast<VirtualPointFunction>(VPoint);
+    VPointToSeeds.erase(V);
+    // A copy, the entry is gone right below
+    auto A = VPointToAPoint[V];
+
+    VPointToAPoint.erase(V);
+    APointToVPoints[A].erase(V);
+
+    A->Down();
+    TryDestroyActualBreakpoint(A);
+
+    // Another class, method or file seed may own the entry of the address
+    auto It = VPointsByFunction.find(V->Address);
+    if (It != VPointsByFunction.end() && It->second == V) {
+      VPointsByFunction.erase(It);
+    }
+    AllVPoints.erase(V);
+  }
+  SeedToVPoints.erase(S);
+}
+
+bool BreakpointsControl::TryInstantiateSeedClass(const SeedClass_sp &S) {
+  if (!Process) {
+    return false;
+  }
+
+  // Each image knows only the classes it defines methods of, a class may
+  // have them in several, e.g. through categories
+  bool Found = false;
+  for (auto &Image : Process->GetImagess()) {
+    auto Index = Image->GetDwarfIndex();
+    std::vector<DwarfFunction> Functions;
+    if (Index && Index->FindClassMethods(S->ClassName, Functions)) {
+      Found |= InstantiateFunctions(S, Image->GetSlide(), Functions);
+    }
+  }
+
+  return Found;
+}
+void BreakpointsControl::DestroySeedClass(const SeedClass_sp &S) {
+  DestroyFunctions(S);
+  SeedsByClass.erase(S->ClassName);
+}
+
+bool BreakpointsControl::TryInstantiateSeedMethod(const SeedMethod_sp &S) {
+  if (!Process) {
+    return false;
+  }
+
+  bool Found = false;
+  for (auto &Image : Process->GetImagess()) {
+    auto Index = Image->GetDwarfIndex();
+    std::vector<DwarfFunction> Functions;
+    if (Index && Index->FindMethods(S->MethodName, Functions)) {
+      Found |= InstantiateFunctions(S, Image->GetSlide(), Functions);
+      continue;
+    }
+
+    // Without debug info the demangled symbol names tell, which also take
+    // qualified names, e.g. Foo::bar for every overload of it. Symbol
+    // values are slid already.
+    auto &Table = Image->GetSymbolTable();
+    std::vector<uint32_t> Rows;
+    Table.GetDemangledNames().Find(S->MethodName, Rows);
+    auto &Store = Table.GetSymbols();
+    // Aliases share an address, e.g. the complete and base constructors
+    std::set<AddressType> Seen;
+    for (auto Row : Rows) {
+      AddressType Address = Store.GetValue(Row);
+      if (IsCode(Address) && Seen.insert(Address).second) {
+        Functions.push_back({Address, Store.GetName(Row)});
+      }
+    }
+    Found |= InstantiateFunctions(S, 0, Functions);
+  }
+
+  return Found;
+}
+void BreakpointsControl::DestroySeedMethod(const SeedMethod_sp &S) {
+  DestroyFunctions(S);
+  SeedsByMethod.erase(S->MethodName);
+}
+
+bool BreakpointsControl::TryInstantiateSeedFile(const SeedFile_sp &S) {
+  if (!Process) {
+    return false;
+  }
+
+  // Every function of the file is a single range of the debug map
+  bool Found = false;
+  for (auto &Image : Process->GetImagess()) {
+    auto Map = Image->GetDebugMap();
+    std::vector<const DebugMap::Unit *> Units;
+    if (!Map || !Map->FindSource(S->File, Units)) {
+      continue;
+    }
+
+    std::vector<DwarfFunction> Functions;
+    for (auto U : Units) {
+      auto First = Map->GetFunctions(*U);
+      for (uint32_t i = 0; i < U->FunctionCount; ++i) {
+        Functions.push_back({First[i].Address, First[i].Name});
+      }
+    }
+    Found |= InstantiateFunctions(S, Image->GetSlide(), Functions);
+  }
+
+  return Found;
+}
+void BreakpointsControl::DestroySeedFile(const SeedFile_sp &S) {
+  DestroyFunctions(S);
+  SeedsByFile.erase(S->File);
+}
+
 bool BreakpointsControl::TryToInstantiatePendingSeed(const Seed_sp &S) {
   assert(PendingSeeds.count(S));
 
@@ -230,19 +635,38 @@ bool BreakpointsControl::TryToInstantiatePendingSeed(const Seed_sp &S) {
     break;
   }
   case SeedType::LINE: {
-    mad_not_implemented();
+    if (!TryInstantiateSeedLine(std::static_pointer_cast<SeedLine>(S))) {
+      return false;
+    }
+    Instantiated = true;
     break;
   }
   case SeedType::REGEX: {
-    mad_not_implemented();
+    if (!TryInstantiateSeedRegex(std::static_pointer_cast<SeedRegex>(S))) {
+      return false;
+    }
+    Instantiated = true;
     break;
   }
   case SeedType::CLASS: {
-    mad_not_implemented();
+    if (!TryInstantiateSeedClass(std::static_pointer_cast<SeedClass>(S))) {
+      return false;
+    }
+    Instantiated = true;
+    break;
+  }
+  case SeedType::METHOD: {
+    if (!TryInstantiateSeedMethod(std::static_pointer_cast<SeedMethod>(S))) {
+      return false;
+    }
+    Instantiated = true;
     break;
   }
   case SeedType::FILE: {
-    mad_not_implemented();
+    if (!TryInstantiateSeedFile(std::static_pointer_cast<SeedFile>(S))) {
+      return false;
+    }
+    Instantiated = true;
     break;
   }
   }
@@ -257,25 +681,30 @@ void BreakpointsControl::DestroySeed(const Seed_sp &S) {
   switch (S->Type) {
   case SeedType::ADDRESS: {
     DestroySeedAddress(std::static_pointer_cast<SeedAddress>(S));
+    break;
   }
   case SeedType::SYMBOL: {
     DestroySeedSymbolName(std::static_pointer_cast<SeedSymbolName>(S));
     break;
   }
   case SeedType::LINE: {
-    mad_not_implemented();
+    DestroySeedLine(std::static_pointer_cast<SeedLine>(S));
     break;
   }
   case SeedType::REGEX: {
-    mad_not_implemented();
+    DestroySeedRegex(std::static_pointer_cast<SeedRegex>(S));
     break;
   }
   case SeedType::CLASS: {
-    mad_not_implemented();
+    DestroySeedClass(std::static_pointer_cast<SeedClass>(S));
+    break;
+  }
+  case SeedType::METHOD: {
+    DestroySeedMethod(std::static_pointer_cast<SeedMethod>(S));
     break;
   }
   case SeedType::FILE: {
-    mad_not_implemented();
+    DestroySeedFile(std::static_pointer_cast<SeedFile>(S));
     break;
   }
   }
@@ -330,8 +759,161 @@ bool BreakpointsControl::RemoveBreakpointBySymbolName(std::string SymbolName) {
 
   return true;
 }
+
+bool BreakpointsControl::AddBreakpointByRegex(
+    std::string Pattern, bool IsGlob,
+    BreakpointBySymbolNameCallback_t Callback) {
+  if (SeedsByRegex.count(Pattern)) {
+    PRINT_DEBUG("Breakpoint on pattern", Pattern, "already exists");
+    return false;
+  }
+
+  SymbolPattern Compiled;
+  if (!Compiled.Compile(Pattern, IsGlob)) {
+    return false;
+  }
+
+  auto S = std::make_shared<SeedRegex>(Pattern, Compiled, Callback);
+  SeedsByRegex.emplace(Pattern, S);
+  AllSeeds.insert(S);
+
+  PendingSeeds.insert(S);
+  TryToInstantiatePendingSeed(S);
+
+  return true;
+}
+bool BreakpointsControl::RemoveBreakpointByRegex(std::string Pattern) {
+  if (!SeedsByRegex.count(Pattern)) {
+    PRINT_DEBUG("Breakpoint on pattern", Pattern, "does not exist");
+    return false;
+  }
+
+  auto S = SeedsByRegex.at(Pattern);
+  DestroySeed(S);
+
+  return true;
+}
+
+bool BreakpointsControl::AddBreakpointByLine(
+    std::string File, unsigned Line, BreakpointByLineCallback_t Callback) {
+  if (SeedsByLine.count({File, Line})) {
+    PRINT_DEBUG("Breakpoint on", File, Line, "already exists");
+    return false;
+  }
+
+  auto S = std::make_shared<SeedLine>(File, Line, Callback);
+  SeedsByLine.emplace(std::make_pair(File, Line), S);
+  AllSeeds.insert(S);
+
+  PendingSeeds.insert(S);
+  TryToInstantiatePendingSeed(S);
+
+  return true;
+}
+bool BreakpointsControl::RemoveBreakpointByLine(std::string File,
+                                                unsigned Line) {
+  if (!SeedsByLine.count({File, Line})) {
+    PRINT_DEBUG("Breakpoint on", File, Line, "does not exist");
+    return false;
+  }
+
+  auto S = SeedsByLine.at({File, Line});
+  DestroySeed(S);
+
+  return true;
+}
+
+bool BreakpointsControl::AddBreakpointByClass(
+    std::string ClassName, BreakpointBySymbolNameCallback_t Callback) {
+  if (SeedsByClass.count(ClassName)) {
+    PRINT_DEBUG("Breakpoint on class", ClassName, "already exists");
+    return false;
+  }
+
+  auto S = std::make_shared<SeedClass>(ClassName, Callback);
+  SeedsByClass.emplace(ClassName, S);
+  AllSeeds.insert(S);
+
+  PendingSeeds.insert(S);
+  TryToInstantiatePendingSeed(S);
+
+  return true;
+}
+bool BreakpointsControl::RemoveBreakpointByClass(std::string ClassName) {
+  if (!SeedsByClass.count(ClassName)) {
+    PRINT_DEBUG("Breakpoint on class", ClassName, "does not exist");
+    return false;
+  }
+
+  auto S = SeedsByClass.at(ClassName);
+  DestroySeed(S);
+
+  return true;
+}
+
+bool BreakpointsControl::AddBreakpointByMethod(
+    std::string MethodName, BreakpointBySymbolNameCallback_t Callback) {
+  if (SeedsByMethod.count(MethodName)) {
+    PRINT_DEBUG("Breakpoint on method", MethodName, "already exists");
+    return false;
+  }
+
+  auto S = std::make_shared<SeedMethod>(MethodName, Callback);
+  SeedsByMethod.emplace(MethodName, S);
+  AllSeeds.insert(S);
+
+  PendingSeeds.insert(S);
+  TryToInstantiatePendingSeed(S);
+
+  return true;
+}
+bool BreakpointsControl::RemoveBreakpointByMethod(std::string MethodName) {
+  if (!SeedsByMethod.count(MethodName)) {
+    PRINT_DEBUG("Breakpoint on method", MethodName, "does not exist");
+    return false;
+  }
+
+  auto S = SeedsByMethod.at(MethodName);
+  DestroySeed(S);
+
+  return true;
+}
+
+bool BreakpointsControl::AddBreakpointByFile(
+    std::string File, BreakpointBySymbolNameCallback_t Callback) {
+  if (SeedsByFile.count(File)) {
+    PRINT_DEBUG("Breakpoint on file", File, "already exists");
+    return false;
+  }
+
+  auto S = std::make_shared<SeedFile>(File, Callback);
+  SeedsByFile.emplace(File, S);
+  AllSeeds.insert(S);
+
+  PendingSeeds.insert(S);
+  TryToInstantiatePendingSeed(S);
+
+  return true;
+}
+bool BreakpointsControl::RemoveBreakpointByFile(std::string File) {
+  if (!SeedsByFile.count(File)) {
+    PRINT_DEBUG("Breakpoint on file", File, "does not exist");
+    return false;
+  }
+
+  auto S = SeedsByFile.at(File);
+  DestroySeed(S);
+
+  return true;
+}
+
 bool BreakpointsControl::CheckBreakpoints() {
-  auto &Thread = Process->GetTask().GetThreads().front();
+  // The vector is a temporary, the thread must not outlive it
+  auto Threads = Process->GetTask().GetThreads();
+  if (Threads.empty()) {
+    return false;
+  }
+  auto &Thread = Threads.front();
   Thread.GetStates();
   auto Address = Thread.ThreadState64()->__rip - BREAKPOINT_SIZE;
   auto A = GetActualBreakpointAtAddress(Address);
@@ -363,7 +945,11 @@ bool BreakpointsControl::CheckBreakpoints() {
   return Continue;
 }
 bool BreakpointsControl::StepOverCurrentBreakpointIfAny() {
-  auto &Thread = Process->GetTask().GetThreads().front();
+  auto Threads = Process->GetTask().GetThreads();
+  if (Threads.empty()) {
+    return false;
+  }
+  auto &Thread = Threads.front();
   Thread.GetStates();
   auto Address = Thread.ThreadState64()->__rip;
   auto A = GetActualBreakpointAtAddress(Address);
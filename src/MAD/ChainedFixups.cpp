@@ -0,0 +1,308 @@
+// Std
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// MAD
+#include "MAD/ChainedFixups.hpp"
+
+using namespace mad;
+
+namespace {
+
+// Pointers of these formats are 8 bytes apart at least, the rest 4
+bool IsArm64e(uint16_t Format) {
+  return Format == DYLD_CHAINED_PTR_ARM64E ||
+         Format == DYLD_CHAINED_PTR_ARM64E_USERLAND ||
+         Format == DYLD_CHAINED_PTR_ARM64E_USERLAND24;
+}
+
+bool IsSupported(uint16_t Format) {
+  return IsArm64e(Format) || Format == DYLD_CHAINED_PTR_64 ||
+         Format == DYLD_CHAINED_PTR_64_OFFSET || Format == DYLD_CHAINED_PTR_32;
+}
+
+template <typename T> T Cast(uint64_t Raw) {
+  T Result;
+  memcpy(&Result, &Raw, sizeof(Result));
+  return Result;
+}
+
+int64_t SignExtend(uint64_t Value, unsigned Bits) {
+  return int64_t(Value << (64 - Bits)) >> (64 - Bits);
+}
+
+// Ordinals are 8 or 16 bits wide, the special ones are negative
+int32_t GetOrdinal(uint64_t Value, unsigned Bits) {
+  return Value > (1ull << Bits) - 16 ? int32_t(SignExtend(Value, Bits))
+                                     : int32_t(Value);
+}
+
+} // namespace
+
+ChainedFixups::ChainedFixups(ByteView Data, uint64_t BaseAddress,
+                             const std::vector<ByteView> &Segments) {
+  dyld_chained_fixups_header Header;
+  uint32_t SegmentCount;
+  // There is only version 0, and ld64 never compresses the names
+  bool Good = Data.ReadAt(0, Header) && Header.fixups_version == 0 &&
+              Header.symbols_format == 0 &&
+              Data.ReadAt(Header.starts_offset, SegmentCount) &&
+              ReadImports(Data, Header);
+
+  for (uint32_t i = 0; Good && i < SegmentCount; ++i) {
+    uint32_t Offset;
+    Good = Data.ReadAt(Header.starts_offset + sizeof(SegmentCount) +
+                           uint64_t(i) * sizeof(Offset),
+                       Offset);
+    // Segments without fixups have no starts
+    if (Good && Offset) {
+      Good = i < Segments.size() &&
+             ReadSegment(Data, uint64_t(Header.starts_offset) + Offset,
+                         BaseAddress, Segments[i]);
+    }
+  }
+
+  if (!Good) {
+    Imports.clear();
+    Fixups.clear();
+    return;
+  }
+
+  // Segments are normally in address order already
+  std::sort(Fixups.begin(), Fixups.end(), [](const Fixup &A, const Fixup &B) {
+    return A.Address < B.Address;
+  });
+}
+
+bool ChainedFixups::ReadImports(ByteView Data,
+                                const dyld_chained_fixups_header &Header) {
+  uint64_t Size;
+  switch (Header.imports_format) {
+  case DYLD_CHAINED_IMPORT:
+    Size = sizeof(dyld_chained_import);
+    break;
+  case DYLD_CHAINED_IMPORT_ADDEND:
+    Size = sizeof(dyld_chained_import_addend);
+    break;
+  case DYLD_CHAINED_IMPORT_ADDEND64:
+    Size = sizeof(dyld_chained_import_addend64);
+    break;
+  default:
+    return false;
+  }
+  if (!Data.Contains(Header.imports_offset, Header.imports_count * Size)) {
+    return false;
+  }
+
+  Imports.resize(Header.imports_count);
+  for (uint32_t i = 0; i < Header.imports_count; ++i) {
+    auto &I = Imports[i];
+    uint64_t At = Header.imports_offset + i * Size;
+    uint64_t NameOffset;
+    if (Header.imports_format == DYLD_CHAINED_IMPORT_ADDEND64) {
+      dyld_chained_import_addend64 Raw;
+      Data.ReadAt(At, Raw);
+      I.LibraryOrdinal = GetOrdinal(Raw.lib_ordinal, 16);
+      I.IsWeak = Raw.weak_import;
+      I.Addend = int64_t(Raw.addend);
+      NameOffset = Raw.name_offset;
+    } else {
+      // The plain import is a prefix of the one with an addend
+      dyld_chained_import Raw;
+      Data.ReadAt(At, Raw);
+      I.LibraryOrdinal = GetOrdinal(Raw.lib_ordinal, 8);
+      I.IsWeak = Raw.weak_import;
+      I.Addend = 0;
+      NameOffset = Raw.name_offset;
+      if (Header.imports_format == DYLD_CHAINED_IMPORT_ADDEND) {
+        dyld_chained_import_addend WithAddend;
+        Data.ReadAt(At, WithAddend);
+        I.Addend = WithAddend.addend;
+      }
+    }
+
+    // Names must end within the data
+    NameOffset += Header.symbols_offset;
+    I.Name = Data.StringAt(NameOffset);
+    if (NameOffset + I.Name.size() >= Data.GetSize()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ChainedFixups::ReadSegment(ByteView Data, uint64_t Offset,
+                                uint64_t BaseAddress, ByteView Segment) {
+  // page_start is as long as page_count says
+  const uint64_t StartsOffset = offsetof(dyld_chained_starts_in_segment,
+                                         page_start);
+  dyld_chained_starts_in_segment Starts;
+  auto Raw = Data.At(Offset, StartsOffset);
+  if (!Raw) {
+    return false;
+  }
+  memcpy(&Starts, Raw, StartsOffset);
+  if (!Starts.page_size || Starts.size < StartsOffset ||
+      !Data.Contains(Offset, Starts.size) ||
+      Starts.page_count > (Starts.size - StartsOffset) / sizeof(uint16_t)) {
+    return false;
+  }
+
+  // Kernel collections and firmware, nothing a debugger attaches to
+  if (!IsSupported(Starts.pointer_format)) {
+    return true;
+  }
+
+  auto Page = [&](uint32_t Index) {
+    uint16_t Start = DYLD_CHAINED_PTR_START_NONE;
+    Data.ReadAt(Offset + StartsOffset + Index * sizeof(Start), Start);
+    return Start;
+  };
+
+  uint64_t SegmentAddress = BaseAddress + Starts.segment_offset;
+  uint32_t Overflow = (Starts.size - StartsOffset) / sizeof(uint16_t);
+  for (uint32_t i = 0; i < Starts.page_count; ++i) {
+    auto Start = Page(i);
+    if (Start == DYLD_CHAINED_PTR_START_NONE) {
+      continue;
+    }
+
+    uint64_t PageOffset = uint64_t(i) * Starts.page_size;
+    uint64_t PageEnd = PageOffset + Starts.page_size;
+    // Only 32-bit pages have more than one chain, their starts follow the
+    // ones of the pages and the last one is marked
+    if (!(Start & DYLD_CHAINED_PTR_START_MULTI)) {
+      if (!ReadChain(Segment, PageOffset + Start, SegmentAddress,
+                     Starts.pointer_format, BaseAddress, PageEnd,
+                     Starts.max_valid_pointer)) {
+        return false;
+      }
+      continue;
+    }
+
+    for (uint32_t j = Start & ~DYLD_CHAINED_PTR_START_MULTI;; ++j) {
+      if (j >= Overflow) {
+        return false;
+      }
+      auto Chain = Page(j);
+      if (!ReadChain(Segment,
+                     PageOffset + (Chain & ~DYLD_CHAINED_PTR_START_LAST),
+                     SegmentAddress, Starts.pointer_format, BaseAddress,
+                     PageEnd, Starts.max_valid_pointer)) {
+        return false;
+      }
+      if (Chain & DYLD_CHAINED_PTR_START_LAST) {
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+bool ChainedFixups::ReadChain(ByteView Segment, uint64_t Offset,
+                              uint64_t Address, uint16_t Format,
+                              uint64_t BaseAddress, uint64_t PageEnd,
+                              uint32_t MaxValidPointer) {
+  uint64_t Stride = IsArm64e(Format) ? 8 : 4;
+  while (true) {
+    Fixup F = {};
+    F.Address = Address + Offset;
+    bool IsPointer = true;
+    uint64_t Next;
+
+    if (Format == DYLD_CHAINED_PTR_32) {
+      uint32_t Raw;
+      if (!Segment.ReadAt(Offset, Raw)) {
+        return false;
+      }
+      auto Rebase = Cast<dyld_chained_ptr_32_rebase>(Raw);
+      Next = Rebase.next;
+      if (Rebase.bind) {
+        auto Bind = Cast<dyld_chained_ptr_32_bind>(Raw);
+        F.IsBind = true;
+        F.Target = Bind.ordinal;
+        F.Addend = Bind.addend;
+      } else if (Rebase.target > MaxValidPointer) {
+        // A value that merely sits in the chain, it is not slid and the
+        // target has it as it is
+        IsPointer = false;
+      } else {
+        F.Target = Rebase.target;
+      }
+    } else {
+      uint64_t Raw;
+      if (!Segment.ReadAt(Offset, Raw)) {
+        return false;
+      }
+
+      if (IsArm64e(Format)) {
+        auto Rebase = Cast<dyld_chained_ptr_arm64e_rebase>(Raw);
+        bool Is24 = Format == DYLD_CHAINED_PTR_ARM64E_USERLAND24;
+        Next = Rebase.next;
+        F.IsBind = Rebase.bind;
+        F.IsAuth = Rebase.auth;
+        if (F.IsBind) {
+          // Authenticated binds have the ordinal in the same bits, and the
+          // diversity where the addend would be
+          auto Bind = Cast<dyld_chained_ptr_arm64e_bind>(Raw);
+          F.Target = Is24 ? Cast<dyld_chained_ptr_arm64e_bind24>(Raw).ordinal
+                          : Bind.ordinal;
+          F.Addend = F.IsAuth ? 0 : SignExtend(Bind.addend, 19);
+        } else if (F.IsAuth) {
+          F.Target = BaseAddress +
+                     Cast<dyld_chained_ptr_arm64e_auth_rebase>(Raw).target;
+        } else {
+          // Only the original arm64e format has addresses, the rest offsets
+          F.Target = Rebase.target;
+          F.High8 = Rebase.high8;
+          if (Format != DYLD_CHAINED_PTR_ARM64E) {
+            F.Target += BaseAddress;
+          }
+        }
+      } else {
+        auto Rebase = Cast<dyld_chained_ptr_64_rebase>(Raw);
+        Next = Rebase.next;
+        if (Rebase.bind) {
+          auto Bind = Cast<dyld_chained_ptr_64_bind>(Raw);
+          F.IsBind = true;
+          F.Target = Bind.ordinal;
+          F.Addend = Bind.addend;
+        } else {
+          F.Target = Rebase.target;
+          F.High8 = Rebase.high8;
+          if (Format == DYLD_CHAINED_PTR_64_OFFSET) {
+            F.Target += BaseAddress;
+          }
+        }
+      }
+    }
+
+    if (F.IsBind && F.Target >= Imports.size()) {
+      return false;
+    }
+    if (IsPointer) {
+      Fixups.push_back(F);
+    }
+
+    if (!Next) {
+      return true;
+    }
+    // Chains never leave their page
+    Offset += Next * Stride;
+    if (Offset >= PageEnd) {
+      return false;
+    }
+  }
+}
+
+bool ChainedFixups::Lookup(uint64_t Address, Fixup &Found) const {
+  auto It = std::lower_bound(
+      Fixups.begin(), Fixups.end(), Address,
+      [](const Fixup &F, uint64_t A) { return F.Address < A; });
+  if (It == Fixups.end() || It->Address != Address) {
+    return false;
+  }
+  Found = *It;
+  return true;
+}
@@ -0,0 +1,325 @@
+// Std
+#include <limits>
+
+// MAD
+#include "MAD/CompactUnwind.hpp"
+
+using namespace mad;
+
+namespace {
+
+// Index of the last of Count ascending keys that is not above Key. ReadKey
+// reads the key at an index and may fail.
+template <typename F>
+bool FindLast(uint32_t Count, uint32_t Key, F &&ReadKey, uint32_t &Found) {
+  uint32_t First;
+  if (!Count || !ReadKey(0, First) || First > Key) {
+    return false;
+  }
+
+  uint32_t Low = 0;
+  uint32_t High = Count;
+  while (High - Low > 1) {
+    uint32_t Middle = Low + (High - Low) / 2;
+    uint32_t Other;
+    if (!ReadKey(Middle, Other)) {
+      return false;
+    }
+    if (Other <= Key) {
+      Low = Middle;
+    } else {
+      High = Middle;
+    }
+  }
+
+  Found = Low;
+  return true;
+}
+
+// Compact register numbers to DWARF ones
+bool GetRegister(uint32_t Compact, unsigned &Register) {
+  switch (Compact) {
+  case UNWIND_X86_64_REG_RBX:
+    Register = REG_X86_64_RBX;
+    return true;
+  case UNWIND_X86_64_REG_R12:
+    Register = REG_X86_64_R12;
+    return true;
+  case UNWIND_X86_64_REG_R13:
+    Register = REG_X86_64_R13;
+    return true;
+  case UNWIND_X86_64_REG_R14:
+    Register = REG_X86_64_R14;
+    return true;
+  case UNWIND_X86_64_REG_R15:
+    Register = REG_X86_64_R15;
+    return true;
+  case UNWIND_X86_64_REG_RBP:
+    Register = REG_X86_64_RBP;
+    return true;
+  }
+  return false;
+}
+
+// Frameless functions list up to 6 saved registers in the order they were
+// pushed as a permutation of the 6 possible ones, numbered lexicographically
+bool DecodePermutation(uint32_t Count, uint32_t Permutation,
+                       unsigned Registers[6]) {
+  static const uint32_t Factors[7][6] = {
+      {},
+      {1},
+      {5, 1},
+      {20, 4, 1},
+      {60, 12, 3, 1},
+      {120, 24, 6, 2, 1},
+      {120, 24, 6, 2, 1, 1},
+  };
+
+  bool IsUsed[7] = {};
+  for (uint32_t i = 0; i < Count; ++i) {
+    uint32_t Rank = Permutation / Factors[Count][i];
+    Permutation -= Rank * Factors[Count][i];
+
+    // The Rank-th of the registers that are still unused
+    uint32_t Compact = 1;
+    for (; Compact < 7; ++Compact) {
+      if (IsUsed[Compact]) {
+        continue;
+      }
+      if (!Rank--) {
+        break;
+      }
+    }
+    if (Compact == 7 || !GetRegister(Compact, Registers[i])) {
+      return false;
+    }
+    IsUsed[Compact] = true;
+  }
+  return true;
+}
+
+} // namespace
+
+CompactUnwind::CompactUnwind(ByteView Data, uint64_t Base)
+    : Data(Data), Base(Base), Header() {
+  // There is always the sentinel entry that ends the last function
+  if (!Data.ReadAt(0, Header) || Header.version != UNWIND_SECTION_VERSION ||
+      !Header.indexCount ||
+      !Data.Contains(Header.indexSectionOffset,
+                     uint64_t(Header.indexCount) *
+                         sizeof(unwind_info_section_header_index_entry))) {
+    this->Data = ByteView();
+  }
+}
+
+bool CompactUnwind::ReadEncoding(
+    uint64_t PageOffset,
+    const unwind_info_compressed_second_level_page_header &Page,
+    uint32_t Index, uint32_t &Encoding) const {
+  if (Index < Header.commonEncodingsArrayCount) {
+    return Data.ReadAt(Header.commonEncodingsArraySectionOffset +
+                           uint64_t(Index) * sizeof(uint32_t),
+                       Encoding);
+  }
+  Index -= Header.commonEncodingsArrayCount;
+  return Index < Page.encodingsCount &&
+         Data.ReadAt(PageOffset + Page.encodingsPageOffset +
+                         uint64_t(Index) * sizeof(uint32_t),
+                     Encoding);
+}
+
+bool CompactUnwind::Lookup(uint64_t Address, Entry &Found) const {
+  if (IsEmpty() || Address < Base ||
+      Address - Base > std::numeric_limits<uint32_t>::max()) {
+    return false;
+  }
+  uint32_t Offset = Address - Base;
+
+  auto ReadIndex = [&](uint32_t i, unwind_info_section_header_index_entry &E) {
+    return Data.ReadAt(Header.indexSectionOffset + uint64_t(i) * sizeof(E),
+                       E);
+  };
+
+  // The sentinel is not a page of its own
+  uint32_t Index;
+  unwind_info_section_header_index_entry First, Next;
+  if (!FindLast(Header.indexCount - 1, Offset,
+                [&](uint32_t i, uint32_t &Key) {
+                  bool Read = ReadIndex(i, First);
+                  Key = First.functionOffset;
+                  return Read;
+                },
+                Index) ||
+      !ReadIndex(Index, First) || !ReadIndex(Index + 1, Next) ||
+      Offset >= Next.functionOffset) {
+    return false;
+  }
+
+  uint64_t PageOffset = First.secondLevelPagesSectionOffset;
+  uint32_t Kind;
+  if (!Data.ReadAt(PageOffset, Kind)) {
+    return false;
+  }
+
+  if (Kind == UNWIND_SECOND_LEVEL_REGULAR) {
+    unwind_info_regular_second_level_page_header Page;
+    if (!Data.ReadAt(PageOffset, Page)) {
+      return false;
+    }
+    uint64_t Entries = PageOffset + Page.entryPageOffset;
+    using RegularEntry = unwind_info_regular_second_level_entry;
+    RegularEntry E;
+    auto ReadEntry = [&](uint32_t i, RegularEntry &R) {
+      return Data.ReadAt(Entries + uint64_t(i) * sizeof(R), R);
+    };
+
+    uint32_t Position;
+    if (!FindLast(Page.entryCount, Offset,
+                  [&](uint32_t i, uint32_t &Key) {
+                    bool Read = ReadEntry(i, E);
+                    Key = E.functionOffset;
+                    return Read;
+                  },
+                  Position) ||
+        !ReadEntry(Position, E)) {
+      return false;
+    }
+
+    Found.Start = Base + E.functionOffset;
+    Found.End = Base + Next.functionOffset;
+    Found.Encoding = E.encoding;
+    if (Position + 1 < Page.entryCount && ReadEntry(Position + 1, E)) {
+      Found.End = Base + E.functionOffset;
+    }
+    return true;
+  }
+
+  if (Kind == UNWIND_SECOND_LEVEL_COMPRESSED) {
+    unwind_info_compressed_second_level_page_header Page;
+    if (!Data.ReadAt(PageOffset, Page)) {
+      return false;
+    }
+    uint64_t Entries = PageOffset + Page.entryPageOffset;
+    auto ReadEntry = [&](uint32_t i, uint32_t &R) {
+      return Data.ReadAt(Entries + uint64_t(i) * sizeof(R), R);
+    };
+
+    // Entries are relative to the first function of the page
+    uint32_t Position, E;
+    if (!FindLast(Page.entryCount, Offset - First.functionOffset,
+                  [&](uint32_t i, uint32_t &Key) {
+                    bool Read = ReadEntry(i, E);
+                    Key = UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(E);
+                    return Read;
+                  },
+                  Position) ||
+        !ReadEntry(Position, E) ||
+        !ReadEncoding(PageOffset, Page,
+                      UNWIND_INFO_COMPRESSED_ENTRY_ENCODING_INDEX(E),
+                      Found.Encoding)) {
+      return false;
+    }
+
+    Found.Start = Base + First.functionOffset +
+                  UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(E);
+    Found.End = Base + Next.functionOffset;
+    if (Position + 1 < Page.entryCount && ReadEntry(Position + 1, E)) {
+      Found.End = Base + First.functionOffset +
+                  UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(E);
+    }
+    return true;
+  }
+
+  return false;
+}
+
+bool CompactUnwind::IsIndirect(const Entry &E, uint64_t &SizeAddress) {
+  if ((E.Encoding & UNWIND_X86_64_MODE_MASK) != UNWIND_X86_64_MODE_STACK_IND) {
+    return false;
+  }
+  SizeAddress =
+      E.Start + ((E.Encoding & UNWIND_X86_64_FRAMELESS_STACK_SIZE) >> 16);
+  return true;
+}
+
+bool CompactUnwind::GetPlan(const Entry &E, UnwindPlan &Plan,
+                            uint32_t IndirectSize) {
+  Plan.Start = E.Start;
+  Plan.End = E.End;
+  Plan.Rows.clear();
+
+  // The encoding holds past the prologue only. Breakpoints on functions sit
+  // on their first instruction, so that one gets a row of its own.
+  UnwindRow Entry;
+
+  switch (E.Encoding & UNWIND_X86_64_MODE_MASK) {
+  case UNWIND_X86_64_MODE_RBP_FRAME: {
+    // ld64 gives this encoding to the standard prologue only, i.e. to
+    // push %rbp, one byte, followed by mov %rsp, %rbp, three more
+    UnwindRow Pushed = Entry;
+    Pushed.Offset = 1;
+    Pushed.CFAOffset = 16;
+    Pushed.SetSavedAt(REG_X86_64_RBP, -16);
+
+    UnwindRow Framed = Pushed;
+    Framed.Offset = 4;
+    Framed.CFARegister = REG_X86_64_RBP;
+
+    // Up to five registers saved right below where rbp points to, minus the
+    // offset
+    int64_t Saved = -16 - 8 * int64_t((E.Encoding &
+                                       UNWIND_X86_64_RBP_FRAME_OFFSET) >>
+                                      16);
+    uint32_t Locations = E.Encoding & UNWIND_X86_64_RBP_FRAME_REGISTERS;
+    for (unsigned i = 0; i < 5; ++i, Saved += 8, Locations >>= 3) {
+      unsigned Register;
+      if (!(Locations & 0x7)) {
+        continue;
+      }
+      if (!GetRegister(Locations & 0x7, Register)) {
+        return false;
+      }
+      Framed.SetSavedAt(Register, Saved);
+    }
+
+    Plan.Rows = {Entry, Pushed, Framed};
+    return true;
+  }
+  case UNWIND_X86_64_MODE_STACK_IMMD:
+  case UNWIND_X86_64_MODE_STACK_IND: {
+    // The size includes the return address
+    uint64_t Size = (E.Encoding & UNWIND_X86_64_FRAMELESS_STACK_SIZE) >> 16;
+    uint64_t Adjust = (E.Encoding & UNWIND_X86_64_FRAMELESS_STACK_ADJUST) >> 13;
+    uint32_t Count = (E.Encoding & UNWIND_X86_64_FRAMELESS_STACK_REG_COUNT) >>
+                     10;
+    uint32_t Permutation =
+        E.Encoding & UNWIND_X86_64_FRAMELESS_STACK_REG_PERMUTATION;
+    bool IsSizeIndirect = (E.Encoding & UNWIND_X86_64_MODE_MASK) ==
+                          UNWIND_X86_64_MODE_STACK_IND;
+    Size = IsSizeIndirect ? IndirectSize + 8 * Adjust : 8 * Size;
+
+    unsigned Registers[6];
+    if (Count > 6 || Size < 8 * (Count + 1) ||
+        !DecodePermutation(Count, Permutation, Registers)) {
+      return false;
+    }
+
+    Plan.Rows = {Entry};
+    if (Size == 8) {
+      return true;
+    }
+
+    // Right below the return address, the last one pushed lowest
+    UnwindRow Body = Entry;
+    Body.Offset = 1;
+    Body.CFAOffset = Size;
+    for (uint32_t i = 0; i < Count; ++i) {
+      Body.SetSavedAt(Registers[i], -8 - 8 * int64_t(Count - i));
+    }
+    Plan.Rows.push_back(Body);
+    return true;
+  }
+  }
+
+  return false;
+}
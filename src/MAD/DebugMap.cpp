@@ -0,0 +1,125 @@
+// Std
+#include <algorithm>
+#include <numeric>
+
+// MAD
+#include "MAD/DebugMap.hpp"
+#include "MAD/Utils.hpp"
+
+using namespace mad;
+
+void DebugMap::Build(const SymbolStore &Store) {
+  Units.clear();
+  Functions.clear();
+  ByAddress.clear();
+
+  std::string_view Directory;
+  bool IsInUnit = false;
+  // A named N_FUN was seen and the one with its size was not yet
+  bool IsInFunction = false;
+
+  auto CloseUnit = [&]() {
+    if (!IsInUnit) {
+      return;
+    }
+    auto &U = Units.back();
+    U.FunctionCount = Functions.size() - U.FirstFunction;
+    std::sort(Functions.begin() + U.FirstFunction, Functions.end(),
+              [](const Function &A, const Function &B) {
+                return A.Address < B.Address;
+              });
+    IsInUnit = false;
+  };
+
+  for (uint32_t i = 0; i < Store.GetSize(); ++i) {
+    if (!(Store.Flags[i] & MO_SYMBOL_STAB)) {
+      continue;
+    }
+
+    auto Name = Store.GetName(i);
+    uint64_t Value = Store.Values[i];
+
+    switch (Store.Types[i]) {
+    case N_SO: {
+      CloseUnit();
+      IsInFunction = false;
+      // An empty one ends the unit, a directory comes before the file
+      if (Name.empty() || Name.back() == '/') {
+        Directory = Name;
+        break;
+      }
+      Unit U;
+      if (Name.front() != '/') {
+        U.Source = Directory;
+      }
+      U.Source += Name;
+      U.FirstFunction = Functions.size();
+      Units.push_back(std::move(U));
+      IsInUnit = true;
+      break;
+    }
+    case N_OSO:
+      if (IsInUnit) {
+        Units.back().ObjectFile = Name;
+        Units.back().ModificationTime = Value;
+      }
+      break;
+    case N_FUN:
+      if (!IsInUnit) {
+        break;
+      }
+      if (!Name.empty()) {
+        Functions.push_back({Value, 0, Name});
+        IsInFunction = true;
+      } else if (IsInFunction) {
+        Functions.back().Size = Value;
+        IsInFunction = false;
+      }
+      break;
+    }
+  }
+  CloseUnit();
+
+  ByAddress.resize(Functions.size());
+  std::iota(ByAddress.begin(), ByAddress.end(), 0);
+  std::sort(ByAddress.begin(), ByAddress.end(), [&](uint32_t A, uint32_t B) {
+    return Functions[A].Address < Functions[B].Address;
+  });
+}
+
+bool DebugMap::FindSource(std::string_view File,
+                          std::vector<const Unit *> &Found) const {
+  Found.clear();
+  for (auto &U : Units) {
+    if (IsPathMatching(U.Source, File)) {
+      Found.push_back(&U);
+    }
+  }
+  return !Found.empty();
+}
+
+bool DebugMap::LookupAddress(uint64_t Address, const Unit *&U,
+                             const Function *&F) const {
+  auto It = std::upper_bound(ByAddress.begin(), ByAddress.end(), Address,
+                             [&](uint64_t A, uint32_t Index) {
+                               return A < Functions[Index].Address;
+                             });
+  if (It == ByAddress.begin()) {
+    return false;
+  }
+
+  uint32_t Index = *(It - 1);
+  auto &Candidate = Functions[Index];
+  if (Address - Candidate.Address >= std::max<uint64_t>(Candidate.Size, 1)) {
+    return false;
+  }
+
+  // Units own consecutive runs of functions, empty ones come first
+  auto Owner = std::upper_bound(Units.begin(), Units.end(), Index,
+                                [](uint32_t I, const Unit &Other) {
+                                  return I < Other.FirstFunction;
+                                });
+  U = &*(Owner - 1);
+  F = &Candidate;
+  return true;
+}
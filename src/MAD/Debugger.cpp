@@ -7,6 +7,7 @@
 #include <sys/ptrace.h>
 
 // Std
+#include <cstdlib>
 #include <iostream>
 
 // MAD
@@ -110,12 +111,14 @@ void Debugger::HandleProcessRun() {
   PRINT_DEBUG("Done");
 
   BreakpointsCtrl.Attach(Process);
+  Unwind.Attach(Process);
 
   HandleProcessContinue();
 }
 
 void Debugger::HandleProcessStop() {
   BreakpointsCtrl.Detach();
+  Unwind.Detach();
   Process->Detach();
   Process = nullptr;
 }
@@ -127,8 +130,96 @@ void Debugger::HandleBreakpointSet(
     BreakpointsCtrl.AddBreakpointBySymbolName(BPS->SymbolName.Get(),
                                               HandleSymbolNameBreakpoint_l);
   }
+  if (BPS->Regex || BPS->Glob) {
+    auto &Pattern = BPS->Regex ? BPS->Regex.Get() : BPS->Glob.Get();
+    PRINT_DEBUG("SET TO", Pattern);
+    BreakpointsCtrl.AddBreakpointByRegex(Pattern, bool(BPS->Glob),
+                                         HandleSymbolNameBreakpoint_l);
+  }
   if (BPS->MethodName) {
     PRINT_DEBUG("SET TO", BPS->MethodName.Get());
+    BreakpointsCtrl.AddBreakpointByMethod(BPS->MethodName.Get(),
+                                          HandleSymbolNameBreakpoint_l);
+  }
+  if (BPS->ClassName) {
+    PRINT_DEBUG("SET TO", BPS->ClassName.Get());
+    BreakpointsCtrl.AddBreakpointByClass(BPS->ClassName.Get(),
+                                         HandleSymbolNameBreakpoint_l);
+  }
+  if (BPS->File) {
+    PRINT_DEBUG("SET TO", BPS->File.Get());
+    BreakpointsCtrl.AddBreakpointByFile(BPS->File.Get(),
+                                        HandleSymbolNameBreakpoint_l);
+  }
+  if (BPS->Line) {
+    auto &Value = BPS->Line.Get();
+    auto Colon = Value.rfind(':');
+    char *End = nullptr;
+    unsigned long Line =
+        Colon == std::string::npos ? 0 : strtoul(&Value[Colon + 1], &End, 10);
+    if (!Line || *End || Colon == 0) {
+      Error Err(MAD_ERROR_ARGUMENTS);
+      Err.Log("Expected FILE:LINE, got", Value);
+      return;
+    }
+    PRINT_DEBUG("SET TO", Value);
+    BreakpointsCtrl.AddBreakpointByLine(Value.substr(0, Colon), Line,
+                                        HandleLineBreakpoint_l);
+  }
+}
+
+void Debugger::HandleThreadBacktrace(
+    const std::shared_ptr<PromptCmdThreadBacktrace> &BT) {
+  if (!Process) {
+    Prompt.Say("You must run the program first");
+    return;
+  }
+
+  std::vector<std::vector<StackFrame>> Traces(1);
+  if (BT->All) {
+    Unwind.BacktraceAll(Traces);
+  } else {
+    auto Threads = Process->GetTask().GetThreads();
+    if (Threads.empty() || !Unwind.Backtrace(Threads.front(), Traces[0])) {
+      Error Err(MAD_ERROR_PROCESS);
+      Err.Log("Could not unwind the stack of", Process->GetPID());
+      return;
+    }
+  }
+
+  // Frames of every thread are symbolicated together
+  std::vector<uint64_t> PCs;
+  for (auto &Trace : Traces) {
+    for (auto &Frame : Trace) {
+      PCs.push_back(Frame.PC);
+    }
+  }
+  auto Frames = Process->Symbolicate(PCs.data(), PCs.size());
+
+  size_t Next = 0;
+  for (size_t i = 0; i < Traces.size(); ++i) {
+    Prompt.Say("thread", "#" + std::to_string(i));
+    for (size_t j = 0; j < Traces[i].size(); ++j) {
+      auto &Frame = Frames[Next++];
+      auto Number = "#" + std::to_string(j);
+      if (!Frame.Image) {
+        Prompt.Say("  frame", Number, HEX(Frame.Address));
+      } else if (!Frame.Symbol) {
+        Prompt.Say("  frame", Number, HEX(Frame.Address),
+                   Frame.Image->GetPath());
+      } else {
+        // C++ names read better demangled, the index is shared with method
+        // breakpoints
+        auto Demangled =
+            Frame.Image->GetSymbolTable().GetDemangledNames().GetName(
+                Frame.Symbol.GetIndex());
+        auto Name = Demangled ? Demangled->GetFull()
+                              : std::string(Frame.Symbol.GetName());
+        Prompt.Say("  frame", Number, HEX(Frame.Address),
+                   Name + " + " + std::to_string(Frame.Offset),
+                   Frame.Image->GetPath());
+      }
+    }
   }
 }
 
@@ -138,6 +229,12 @@ Debugger::HandleSymbolNameBreakpoint(std::string SymbolName) {
   return BreakpointCallbackReturn::BREAK;
 }
 
+BreakpointCallbackReturn Debugger::HandleLineBreakpoint(std::string File,
+                                                        unsigned Line) {
+  PRINT_DEBUG("BREAK ON", File, Line);
+  return BreakpointCallbackReturn::BREAK;
+}
+
 int Debugger::Start(int argc, char *argv[]) {
   if (argc < 2) {
     Error Err(MAD_ERROR_ARGUMENTS);
@@ -179,6 +276,11 @@ int Debugger::Start(int argc, char *argv[]) {
       HandleBreakpointSet(
           std::static_pointer_cast<PromptCmdBreakpointSet>(Cmd));
       break;
+
+    case PromptCmdType::THREAD_BACKTRACE:
+      HandleThreadBacktrace(
+          std::static_pointer_cast<PromptCmdThreadBacktrace>(Cmd));
+      break;
     }
   }
 
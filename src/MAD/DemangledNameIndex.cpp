@@ -0,0 +1,347 @@
+// Std
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <utility>
+
+// System
+#include <cxxabi.h>
+
+// MAD
+#include "MAD/DemangledNameIndex.hpp"
+#include "MAD/StringTableIndex.hpp"
+#include "MAD/ThreadPool.hpp"
+
+using namespace mad;
+
+// Stores with at least this many symbols are demangled on the shared
+// ThreadPool, in chunks of this many symbols. Demangling costs far more per
+// symbol than hashing a name, so both are lower than for the name index.
+#define DNI_PARALLEL_THRESHOLD 4096u
+#define DNI_PARALLEL_CHUNK 1024u
+
+//-----------------------------------------------------------------------------
+// Qualified name
+//-----------------------------------------------------------------------------
+static bool IsIdentifier(char C) {
+  return std::isalnum(static_cast<unsigned char>(C)) || C == '_' || C == '$';
+}
+
+static std::string_view Trim(std::string_view Value) {
+  while (!Value.empty() && Value.front() == ' ') {
+    Value.remove_prefix(1);
+  }
+  while (!Value.empty() && Value.back() == ' ') {
+    Value.remove_suffix(1);
+  }
+  return Value;
+}
+
+// Position past the operator that follows the operator keyword at Begin,
+// e.g. past () of operator()(int) or past int of operator int()
+static size_t SkipOperator(std::string_view Name, size_t Begin) {
+  if (Begin < Name.size() && Name[Begin] == ' ') {
+    // Conversions, new and delete, up to the parameters
+    size_t Depth = 0;
+    for (; Begin < Name.size(); ++Begin) {
+      char C = Name[Begin];
+      if (C == '(' && !Depth) {
+        break;
+      }
+      Depth += C == '<';
+      Depth -= C == '>' && Depth;
+    }
+    return Begin;
+  }
+  if (!Name.compare(Begin, 2, "()") || !Name.compare(Begin, 2, "[]")) {
+    return Begin + 2;
+  }
+  while (Begin < Name.size() &&
+         std::string_view("+-*/%^&|~!=<>,").find(Name[Begin]) !=
+             std::string_view::npos) {
+    ++Begin;
+  }
+  return Begin;
+}
+
+// Position of the ) that closes the ( at Begin, npos if there is none
+static size_t FindClose(std::string_view Name, size_t Begin) {
+  size_t Depth = 0;
+  for (size_t i = Begin; i < Name.size(); ++i) {
+    if (Name[i] == '(') {
+      ++Depth;
+    } else if (Name[i] == ')' && !--Depth) {
+      return i;
+    }
+  }
+  return std::string_view::npos;
+}
+
+static bool IsOperator(std::string_view Name, size_t Begin) {
+  return !Name.compare(Begin, 8, "operator") &&
+         (Begin + 8 == Name.size() || !IsIdentifier(Name[Begin + 8]));
+}
+
+// Removes the last :: separated component of Scope and returns it
+static std::string_view PopComponent(std::string_view &Scope) {
+  size_t Depth = 0;
+  for (size_t i = Scope.size(); i > 1; --i) {
+    char C = Scope[i - 1];
+    if (C == '>' || C == ')') {
+      ++Depth;
+    } else if ((C == '<' || C == '(') && Depth) {
+      --Depth;
+    } else if (C == ':' && Scope[i - 2] == ':' && !Depth) {
+      auto Component = Scope.substr(i);
+      Scope = Scope.substr(0, i - 2);
+      return Component;
+    }
+  }
+  auto Component = Scope;
+  Scope = {};
+  return Component;
+}
+
+// Spaces only matter between two identifiers, e.g. unsigned int
+static std::string Normalize(std::string_view Value) {
+  std::string Result;
+  for (size_t i = 0; i < Value.size(); ++i) {
+    if (Value[i] != ' ') {
+      Result += Value[i];
+    } else if (!Result.empty() && IsIdentifier(Result.back()) &&
+               i + 1 < Value.size() && IsIdentifier(Value[i + 1])) {
+      Result += ' ';
+    }
+  }
+  return Result;
+}
+
+bool QualifiedName::Split(std::string_view Name, QualifiedName &Parts) {
+  Name = Trim(Name);
+
+  // Where the scope begins, past any return type, the last top level ::
+  // and where the component after it begins
+  size_t Begin = 0;
+  size_t Separator = std::string_view::npos;
+  size_t Component = 0;
+  size_t Parameters = Name.size();
+  // Past the operator if the component is one
+  size_t Operator = std::string_view::npos;
+  size_t Depth = 0;
+
+  for (size_t i = 0; i < Name.size();) {
+    char C = Name[i];
+    if (!Depth) {
+      if (i == Component && IsOperator(Name, i)) {
+        i = Operator = SkipOperator(Name, i + 8);
+        continue;
+      }
+      if (C == ':' && i + 1 < Name.size() && Name[i + 1] == ':') {
+        Separator = i;
+        Component = i += 2;
+        Operator = std::string_view::npos;
+        continue;
+      }
+      if (C == ' ') {
+        // Whatever came before is the return type
+        Begin = Component = ++i;
+        Separator = Operator = std::string_view::npos;
+        continue;
+      }
+      // A component can be in parentheses, e.g. (anonymous namespace)
+      if (C == '(' && i != Component) {
+        auto Close = FindClose(Name, i);
+        if (Close == std::string_view::npos) {
+          return false;
+        }
+        // Parameters of a function that has local entities, e.g. lambdas
+        if (!Name.compare(Close + 1, 2, "::")) {
+          Separator = Close + 1;
+          Component = i = Close + 3;
+          Operator = std::string_view::npos;
+          continue;
+        }
+        Parameters = i;
+        break;
+      }
+    }
+    if (C == '<' || C == '(' || C == '[' || C == '{') {
+      ++Depth;
+    } else if ((C == '>' || C == ')' || C == ']' || C == '}') && Depth) {
+      --Depth;
+    }
+    ++i;
+  }
+
+  auto Basename = Name.substr(Component, Parameters - Component);
+  // Template arguments of the function itself
+  auto Arguments = Operator == std::string_view::npos
+                       ? Basename.find('<')
+                       : Basename.find('<', Operator - Component);
+  if (Arguments != std::string_view::npos &&
+      (Operator == std::string_view::npos ||
+       Arguments == Operator - Component)) {
+    Basename = Basename.substr(0, Arguments);
+  }
+  Parts.Basename = Trim(Basename);
+  if (Parts.Basename.empty()) {
+    return false;
+  }
+  Parts.Scope = Separator == std::string_view::npos
+                    ? std::string_view()
+                    : Name.substr(Begin, Separator - Begin);
+  Parts.Parameters = Name.substr(Parameters);
+  return true;
+}
+
+bool QualifiedName::Matches(const QualifiedName &Query) const {
+  if (Basename != Query.Basename) {
+    return false;
+  }
+
+  // Component by component from the innermost, a component without
+  // template arguments stands for every specialization
+  auto Own = Scope;
+  auto Wanted = Query.Scope;
+  while (!Wanted.empty()) {
+    if (Own.empty()) {
+      return false;
+    }
+    auto Component = PopComponent(Own);
+    auto WantedComponent = PopComponent(Wanted);
+    if (WantedComponent.find('<') == std::string_view::npos) {
+      Component = Component.substr(0, Component.find('<'));
+    }
+    if (Component != WantedComponent) {
+      return false;
+    }
+  }
+
+  if (Query.Parameters.empty()) {
+    return true;
+  }
+  // Parameters alone match any qualifiers, e.g. (int) that of (int) const
+  auto OwnParameters = Normalize(Parameters);
+  auto WantedParameters = Normalize(Query.Parameters);
+  return OwnParameters == WantedParameters ||
+         (WantedParameters.back() == ')' &&
+          !OwnParameters.compare(0, WantedParameters.size(), WantedParameters));
+}
+
+//-----------------------------------------------------------------------------
+// Demangled name
+//-----------------------------------------------------------------------------
+bool DemangledName::Demangle(std::string_view Mangled) {
+  // Special names, e.g. vtables, typeinfo, thunks and guard variables, are
+  // not functions one can break on
+  if (Mangled.substr(0, 3) != "__Z" || Mangled.substr(0, 4) == "__ZT" ||
+      Mangled.substr(0, 4) == "__ZG") {
+    return false;
+  }
+
+  std::string Source(Mangled.substr(1));
+  int Status;
+  auto Result = abi::__cxa_demangle(Source.c_str(), nullptr, nullptr, &Status);
+  if (Status) {
+    return false;
+  }
+  Full = Result;
+  std::free(Result);
+
+  // Data has no parameters
+  QualifiedName Parts;
+  if (!QualifiedName::Split(Full, Parts) || Parts.Parameters.empty()) {
+    return false;
+  }
+  ScopeBegin = Parts.Scope.data() - Full.data();
+  ScopeSize = Parts.Scope.size();
+  BasenameBegin = Parts.Basename.data() - Full.data();
+  BasenameSize = Parts.Basename.size();
+  ParametersBegin = Parts.Parameters.data() - Full.data();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Index
+//-----------------------------------------------------------------------------
+void DemangledNameIndex::Build(const SymbolStore &Store) {
+  Rows.clear();
+  Names.clear();
+  ByBasename.clear();
+
+  // Every chunk demangles into one list of its own, joined in row order
+  // after
+  uint32_t Count = Store.GetSize();
+  std::vector<std::vector<std::pair<uint32_t, DemangledName>>> Chunks(
+      (Count + DNI_PARALLEL_CHUNK - 1) / DNI_PARALLEL_CHUNK);
+  auto DemangleRows = [&](uint64_t Begin, uint64_t End) {
+    auto &Chunk = Chunks[Begin / DNI_PARALLEL_CHUNK];
+    for (auto i = Begin; i < End; ++i) {
+      SymbolRef Symbol(&Store, i);
+      if (!Symbol.IsDefined() || Symbol.IsStab()) {
+        continue;
+      }
+      DemangledName Name;
+      if (Name.Demangle(Symbol.GetName())) {
+        Chunk.emplace_back(i, std::move(Name));
+      }
+    }
+  };
+  if (Count >= DNI_PARALLEL_THRESHOLD) {
+    ThreadPool::GetShared().ParallelFor(Count, DNI_PARALLEL_CHUNK,
+                                        DemangleRows);
+  } else {
+    for (uint32_t Begin = 0; Begin < Count; Begin += DNI_PARALLEL_CHUNK) {
+      DemangleRows(Begin, std::min(Count, Begin + DNI_PARALLEL_CHUNK));
+    }
+  }
+
+  size_t Total = 0;
+  for (auto &Chunk : Chunks) {
+    Total += Chunk.size();
+  }
+  Rows.reserve(Total);
+  Names.reserve(Total);
+  for (auto &Chunk : Chunks) {
+    for (auto &Entry : Chunk) {
+      Rows.push_back(Entry.first);
+      Names.push_back(std::move(Entry.second));
+    }
+  }
+
+  // Sorting plain words groups the overloads without touching the names
+  ByBasename.resize(Names.size());
+  for (uint32_t i = 0; i < Names.size(); ++i) {
+    ByBasename[i] = (StringTableIndex::Hash(Names[i].GetParts().Basename) &
+                     ~0xFFFFFFFFull) |
+                    i;
+  }
+  std::sort(ByBasename.begin(), ByBasename.end());
+}
+
+void DemangledNameIndex::Find(std::string_view Query,
+                              std::vector<uint32_t> &Result) const {
+  QualifiedName Wanted;
+  if (!QualifiedName::Split(Query, Wanted)) {
+    return;
+  }
+
+  // Names whose basenames share the upper half of the hash, which
+  // Matches() tells apart. Positions, and so rows, ascend within them.
+  auto Key = StringTableIndex::Hash(Wanted.Basename) & ~0xFFFFFFFFull;
+  auto It = std::lower_bound(ByBasename.begin(), ByBasename.end(), Key);
+  for (; It != ByBasename.end() && (*It & ~0xFFFFFFFFull) == Key; ++It) {
+    auto Position = uint32_t(*It);
+    if (Names[Position].GetParts().Matches(Wanted)) {
+      Result.push_back(Rows[Position]);
+    }
+  }
+}
+
+const DemangledName *DemangledNameIndex::GetName(uint32_t Row) const {
+  auto It = std::lower_bound(Rows.begin(), Rows.end(), Row);
+  if (It == Rows.end() || *It != Row) {
+    return nullptr;
+  }
+  return &Names[It - Rows.begin()];
+}
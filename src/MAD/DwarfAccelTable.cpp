@@ -0,0 +1,347 @@
+// Std
+#include <cctype>
+
+// MAD
+#include "MAD/Debug.hpp"
+#include "MAD/DwarfAccelTable.hpp"
+#include "MAD/Error.hpp"
+
+using namespace mad;
+
+namespace {
+
+const uint32_t APPLE_HASH_MAGIC = 0x48415348; // 'HASH'
+const uint16_t APPLE_HASH_VERSION = 1;
+const uint16_t APPLE_HASH_DJB = 0;
+const uint32_t APPLE_HASH_EMPTY = 0xffffffff;
+
+// Values of both tables use a handful of fixed and variable size forms
+bool ReadValue(DwarfCursor &C, uint64_t Form, bool Is64, uint64_t &Value) {
+  switch (Form) {
+  case DW_FORM_data1:
+  case DW_FORM_ref1:
+  case DW_FORM_flag:
+    Value = C.ReadSized(1);
+    break;
+  case DW_FORM_data2:
+  case DW_FORM_ref2:
+    Value = C.ReadSized(2);
+    break;
+  case DW_FORM_data4:
+  case DW_FORM_ref4:
+    Value = C.ReadSized(4);
+    break;
+  case DW_FORM_data8:
+  case DW_FORM_ref8:
+  case DW_FORM_ref_sig8:
+    Value = C.ReadSized(8);
+    break;
+  case DW_FORM_udata:
+  case DW_FORM_ref_udata:
+    Value = C.ReadULEB128();
+    break;
+  case DW_FORM_sdata:
+    Value = C.ReadSLEB128();
+    break;
+  case DW_FORM_ref_addr:
+  case DW_FORM_sec_offset:
+    Value = C.ReadOffset(Is64);
+    break;
+  case DW_FORM_flag_present:
+    Value = 1;
+    break;
+  default:
+    return false;
+  }
+  return C.Good();
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+// AppleAccelTable
+//-----------------------------------------------------------------------------
+
+AppleAccelTable::AppleAccelTable(ByteView Table, ByteView Strings)
+    : Table(Table), Strings(Strings) {
+  if (Table.IsEmpty()) {
+    return;
+  }
+
+  DwarfCursor C(Table, 0);
+  auto Magic = C.Read<uint32_t>();
+  auto Version = C.Read<uint16_t>();
+  auto HashFunction = C.Read<uint16_t>();
+  BucketCount = C.Read<uint32_t>();
+  HashCount = C.Read<uint32_t>();
+  auto HeaderDataLength = C.Read<uint32_t>();
+  auto HeaderDataStart = C.Tell();
+  DieOffsetBase = C.Read<uint32_t>();
+  auto AtomCount = C.Read<uint32_t>();
+  for (uint32_t i = 0; C.Good() && i < AtomCount; ++i) {
+    Atom A;
+    A.Type = C.Read<uint16_t>();
+    A.Form = C.Read<uint16_t>();
+    Atoms.push_back(A);
+  }
+
+  BucketsOffset = HeaderDataStart + HeaderDataLength;
+  HashesOffset = BucketsOffset + uint64_t(BucketCount) * 4;
+  OffsetsOffset = HashesOffset + uint64_t(HashCount) * 4;
+
+  if (!C.Good() || Magic != APPLE_HASH_MAGIC ||
+      Version != APPLE_HASH_VERSION || HashFunction != APPLE_HASH_DJB ||
+      !BucketCount || !Table.Contains(OffsetsOffset, uint64_t(HashCount) * 4)) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Malformed accelerator table");
+    return;
+  }
+
+  IsValid = true;
+}
+
+uint32_t AppleAccelTable::Hash(std::string_view Name) {
+  uint32_t Result = 5381;
+  for (unsigned char C : Name) {
+    Result = Result * 33 + C;
+  }
+  return Result;
+}
+
+bool AppleAccelTable::Lookup(std::string_view Name,
+                             std::vector<uint64_t> &Offsets) const {
+  if (!IsValid) {
+    return false;
+  }
+
+  auto Before = Offsets.size();
+  auto Hash = AppleAccelTable::Hash(Name);
+  uint32_t Bucket = Hash % BucketCount;
+
+  uint32_t First = APPLE_HASH_EMPTY;
+  Table.ReadAt(BucketsOffset + uint64_t(Bucket) * 4, First);
+
+  // Hashes of a bucket are stored together, the bucket points to the first
+  for (uint64_t i = First; i < HashCount; ++i) {
+    uint32_t Other = 0;
+    Table.ReadAt(HashesOffset + i * 4, Other);
+    if (Other % BucketCount != Bucket) {
+      break;
+    }
+    if (Other != Hash) {
+      continue;
+    }
+
+    uint32_t DataOffset = 0;
+    Table.ReadAt(OffsetsOffset + i * 4, DataOffset);
+
+    // Names sharing the hash follow each other, each with its entries
+    DwarfCursor C(Table, DataOffset);
+    for (uint32_t String = C.Read<uint32_t>(); C.Good() && String;
+         String = C.Read<uint32_t>()) {
+      auto Count = C.Read<uint32_t>();
+      bool IsMatch = Strings.StringAt(String) == Name;
+      for (uint32_t j = 0; C.Good() && j < Count; ++j) {
+        for (auto &A : Atoms) {
+          uint64_t Value = 0;
+          if (!ReadValue(C, A.Form, false, Value)) {
+            PRINT_DEBUG("Unsupported accelerator table form", A.Form);
+            return Offsets.size() != Before;
+          }
+          if (IsMatch && A.Type == DW_ATOM_die_offset) {
+            Offsets.push_back(DieOffsetBase + Value);
+          }
+        }
+      }
+    }
+  }
+
+  return Offsets.size() != Before;
+}
+
+//-----------------------------------------------------------------------------
+// DebugNamesTable
+//-----------------------------------------------------------------------------
+
+DebugNamesTable::DebugNamesTable(ByteView Table, ByteView Strings)
+    : Table(Table), Strings(Strings) {
+  DwarfCursor C(Table, 0);
+  while (!C.IsAtEnd()) {
+    auto Start = C.Tell();
+    NameIndex Index;
+    if (!ReadIndex(C, Index)) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed name index at", Start);
+      break;
+    }
+    Indexes.push_back(std::move(Index));
+  }
+}
+
+bool DebugNamesTable::ReadIndex(DwarfCursor &C, NameIndex &Index) {
+  uint64_t Length = ReadDwarfUnitLength(C, Index.Is64);
+  Index.End = C.Tell() + Length;
+  if (!C.Good() || !Table.Contains(C.Tell(), Length)) {
+    return false;
+  }
+  // Whatever happens the next index starts past this one
+  DwarfCursor Next(Table, Index.End);
+
+  auto Version = C.Read<uint16_t>();
+  C.Skip(2);
+  Index.CompUnitCount = C.Read<uint32_t>();
+  auto LocalTypeUnitCount = C.Read<uint32_t>();
+  auto ForeignTypeUnitCount = C.Read<uint32_t>();
+  Index.BucketCount = C.Read<uint32_t>();
+  Index.NameCount = C.Read<uint32_t>();
+  auto AbbrevTableSize = C.Read<uint32_t>();
+  auto AugmentationSize = C.Read<uint32_t>();
+  C.Skip((AugmentationSize + 3) & ~3u);
+  if (!C.Good() || Version != 5) {
+    return false;
+  }
+
+  uint64_t OffsetSize = Index.Is64 ? 8 : 4;
+  Index.CompUnitsOffset = C.Tell();
+  Index.BucketsOffset =
+      Index.CompUnitsOffset +
+      (uint64_t(Index.CompUnitCount) + LocalTypeUnitCount) * OffsetSize +
+      uint64_t(ForeignTypeUnitCount) * 8;
+  Index.HashesOffset = Index.BucketsOffset + uint64_t(Index.BucketCount) * 4;
+  Index.StringOffsetsOffset =
+      Index.HashesOffset + (Index.BucketCount ? Index.NameCount * 4ull : 0);
+  Index.EntryOffsetsOffset =
+      Index.StringOffsetsOffset + Index.NameCount * OffsetSize;
+  uint64_t AbbrevsOffset =
+      Index.EntryOffsetsOffset + Index.NameCount * OffsetSize;
+  Index.EntryPoolOffset = AbbrevsOffset + AbbrevTableSize;
+  if (Index.EntryPoolOffset > Index.End) {
+    return false;
+  }
+
+  DwarfCursor A(Table.Slice(0, Index.EntryPoolOffset), AbbrevsOffset);
+  for (uint64_t Code = A.ReadULEB128(); A.Good() && Code;
+       Code = A.ReadULEB128()) {
+    auto &Abbrev = Index.Abbreviations[Code];
+    Abbrev.Tag = A.ReadULEB128();
+    while (A.Good()) {
+      uint64_t Attribute = A.ReadULEB128();
+      uint64_t Form = A.ReadULEB128();
+      if (!Attribute && !Form) {
+        break;
+      }
+      Abbrev.Attributes.emplace_back(Attribute, Form);
+    }
+  }
+
+  C = Next;
+  return A.Good();
+}
+
+uint32_t DebugNamesTable::Hash(std::string_view Name) {
+  // Case folded DJB, only ASCII is folded here
+  uint32_t Result = 5381;
+  for (unsigned char C : Name) {
+    Result = Result * 33 + std::tolower(C);
+  }
+  return Result;
+}
+
+std::string_view DebugNamesTable::GetName(const NameIndex &Index,
+                                          uint32_t Number) const {
+  uint64_t OffsetSize = Index.Is64 ? 8 : 4;
+  DwarfCursor C(Table, Index.StringOffsetsOffset + Number * OffsetSize);
+  uint64_t Offset = C.ReadOffset(Index.Is64);
+  return C.Good() ? Strings.StringAt(Offset) : std::string_view();
+}
+
+void DebugNamesTable::ReadEntries(const NameIndex &Index, uint32_t Number,
+                                  std::vector<uint64_t> &Offsets) const {
+  uint64_t OffsetSize = Index.Is64 ? 8 : 4;
+  DwarfCursor E(Table, Index.EntryOffsetsOffset + Number * OffsetSize);
+  uint64_t EntryOffset = E.ReadOffset(Index.Is64);
+  if (!E.Good()) {
+    return;
+  }
+
+  DwarfCursor C(Table.Slice(0, Index.End), Index.EntryPoolOffset + EntryOffset);
+  for (uint64_t Code = C.ReadULEB128(); C.Good() && Code;
+       Code = C.ReadULEB128()) {
+    auto It = Index.Abbreviations.find(Code);
+    if (It == Index.Abbreviations.end()) {
+      PRINT_DEBUG("Unknown name index abbreviation", Code);
+      return;
+    }
+
+    // A single unit needs no unit attribute
+    uint64_t Unit = 0;
+    uint64_t DieOffset = 0;
+    bool HasDieOffset = false;
+    bool IsTypeUnit = false;
+    for (auto &Attribute : It->second.Attributes) {
+      uint64_t Value = 0;
+      if (!ReadValue(C, Attribute.second, Index.Is64, Value)) {
+        PRINT_DEBUG("Unsupported name index form", Attribute.second);
+        return;
+      }
+      switch (Attribute.first) {
+      case DW_IDX_compile_unit:
+        Unit = Value;
+        break;
+      case DW_IDX_type_unit:
+        IsTypeUnit = true;
+        break;
+      case DW_IDX_die_offset:
+        DieOffset = Value;
+        HasDieOffset = true;
+        break;
+      }
+    }
+
+    if (IsTypeUnit || !HasDieOffset || Unit >= Index.CompUnitCount) {
+      continue;
+    }
+
+    // DIE offsets are relative to their unit
+    DwarfCursor U(Table, Index.CompUnitsOffset + Unit * OffsetSize);
+    uint64_t UnitOffset = U.ReadOffset(Index.Is64);
+    if (U.Good()) {
+      Offsets.push_back(UnitOffset + DieOffset);
+    }
+  }
+}
+
+bool DebugNamesTable::Lookup(std::string_view Name,
+                             std::vector<uint64_t> &Offsets) const {
+  auto Before = Offsets.size();
+  auto Hash = DebugNamesTable::Hash(Name);
+
+  for (auto &Index : Indexes) {
+    // Without buckets the names can only be compared one by one
+    if (!Index.BucketCount) {
+      for (uint32_t i = 0; i < Index.NameCount; ++i) {
+        if (GetName(Index, i) == Name) {
+          ReadEntries(Index, i, Offsets);
+        }
+      }
+      continue;
+    }
+
+    uint32_t Bucket = Hash % Index.BucketCount;
+    uint32_t First = 0;
+    Table.ReadAt(Index.BucketsOffset + uint64_t(Bucket) * 4, First);
+    // Names are numbered from 1, 0 is an empty bucket
+    for (uint32_t i = First; i && i <= Index.NameCount; ++i) {
+      uint32_t Other = 0;
+      if (!Table.ReadAt(Index.HashesOffset + uint64_t(i - 1) * 4, Other) ||
+          Other % Index.BucketCount != Bucket) {
+        break;
+      }
+      if (Other == Hash && GetName(Index, i - 1) == Name) {
+        ReadEntries(Index, i - 1, Offsets);
+      }
+    }
+  }
+
+  return Offsets.size() != Before;
+}
@@ -0,0 +1,213 @@
+// Std
+#include <algorithm>
+#include <string>
+
+// MAD
+#include "MAD/DwarfIndex.hpp"
+
+using namespace mad;
+
+namespace {
+
+bool IsObjCMethodName(std::string_view Name) {
+  return Name.size() > 2 && (Name[0] == '-' || Name[0] == '+') &&
+         Name[1] == '[';
+}
+
+bool IsTypeWithMethods(const DwarfDie &Die) {
+  return Die.Tag == DW_TAG_class_type || Die.Tag == DW_TAG_structure_type ||
+         Die.Tag == DW_TAG_union_type;
+}
+
+// Itanium mangling of the scopes of a qualified name, i.e. what the nested
+// names of its methods start with: geo::Circle is 3geo6Circle
+std::string GetMangledScope(std::string_view Name) {
+  std::string Result;
+  size_t Start = 0;
+  while (true) {
+    auto End = Name.find("::", Start);
+    auto Part = Name.substr(Start, End - Start);
+    Result += std::to_string(Part.size());
+    Result += Part;
+    if (End == std::string_view::npos) {
+      return Result;
+    }
+    Start = End + 2;
+  }
+}
+
+// Whether a linkage name is that of a member of the mangled scope. CV and
+// ref qualifiers of the method come between _ZN and the scope, e.g.
+// _ZNK3geo6Circle8diameterEv.
+bool IsInMangledScope(std::string_view LinkageName, std::string_view Scope) {
+  if (LinkageName.substr(0, 3) != "_ZN") {
+    return false;
+  }
+  auto Nested = LinkageName.substr(3);
+  while (!Nested.empty() &&
+         std::string_view("rVKRO").find(Nested.front()) !=
+             std::string_view::npos) {
+    Nested.remove_prefix(1);
+  }
+  return Nested.substr(0, Scope.size()) == Scope;
+}
+
+} // namespace
+
+DwarfIndex::DwarfIndex(const DwarfSections &Sections)
+    : Info(Sections), AppleNames(Sections.AppleNames, Sections.Str),
+      AppleTypes(Sections.AppleTypes, Sections.Str),
+      AppleObjC(Sections.AppleObjC, Sections.Str),
+      Names(Sections.Names, Sections.Str) {}
+
+bool DwarfIndex::LookupNames(std::string_view Name,
+                             std::vector<uint64_t> &Offsets) {
+  if (!AppleNames.IsEmpty()) {
+    return AppleNames.Lookup(Name, Offsets);
+  }
+  return Names.Lookup(Name, Offsets);
+}
+
+bool DwarfIndex::LookupTypes(std::string_view Name,
+                             std::vector<uint64_t> &Offsets) {
+  if (!AppleTypes.IsEmpty()) {
+    return AppleTypes.Lookup(Name, Offsets);
+  }
+  return Names.Lookup(Name, Offsets);
+}
+
+bool DwarfIndex::ReadDeclaration(const DwarfDie &Die, DwarfDie &Declaration) {
+  Declaration = Die;
+  // An out-of-line copy of an inlined function points to the abstract one,
+  // which points to the declaration in the class like any other definition
+  if (Declaration.AbstractOrigin &&
+      !Info.ReadDie(Declaration.AbstractOrigin, Declaration)) {
+    return false;
+  }
+  if (Declaration.Specification &&
+      !Info.ReadDie(Declaration.Specification, Declaration)) {
+    return false;
+  }
+  return Declaration.Offset != Die.Offset && Declaration.IsDeclaration;
+}
+
+void DwarfIndex::AddFunction(const DwarfDie &Die, const DwarfDie &Declaration,
+                             std::vector<DwarfFunction> &Functions) {
+  // Tables may list a function under several names
+  auto Found = std::find_if(
+      Functions.begin(), Functions.end(),
+      [&](const DwarfFunction &F) { return F.Address == Die.LowPC; });
+  if (Found != Functions.end()) {
+    return;
+  }
+
+  DwarfFunction Function;
+  Function.Address = Die.LowPC;
+  for (auto Name : {Die.LinkageName, Declaration.LinkageName, Die.Name,
+                    Declaration.Name}) {
+    if (!Name.empty()) {
+      Function.Name = Name;
+      break;
+    }
+  }
+  Functions.push_back(Function);
+}
+
+void DwarfIndex::FindDefinitions(const DwarfDie &Declaration,
+                                 std::vector<DwarfFunction> &Functions) {
+  // Definitions are listed under both names, the linkage one is rarer
+  auto Key = Declaration.LinkageName.empty() ? Declaration.Name
+                                             : Declaration.LinkageName;
+  std::vector<uint64_t> Offsets;
+  if (Key.empty() || !LookupNames(Key, Offsets)) {
+    return;
+  }
+
+  for (auto Offset : Offsets) {
+    DwarfDie Die, Other;
+    if (!Info.ReadDie(Offset, Die) || Die.Tag != DW_TAG_subprogram ||
+        !Die.HasLowPC) {
+      continue;
+    }
+    if (ReadDeclaration(Die, Other) && Other.Offset == Declaration.Offset) {
+      AddFunction(Die, Declaration, Functions);
+    }
+  }
+}
+
+bool DwarfIndex::FindMethods(std::string_view Name,
+                             std::vector<DwarfFunction> &Functions) {
+  std::vector<uint64_t> Offsets;
+  if (!LookupNames(Name, Offsets)) {
+    return false;
+  }
+
+  auto Before = Functions.size();
+  for (auto Offset : Offsets) {
+    DwarfDie Die, Declaration;
+    if (!Info.ReadDie(Offset, Die) || Die.Tag != DW_TAG_subprogram ||
+        !Die.HasLowPC) {
+      continue;
+    }
+
+    // Free functions share the table, methods are told apart by their this
+    // pointer or by a declaration inside of a class
+    bool HasDeclaration = ReadDeclaration(Die, Declaration);
+    if (Die.HasObjectPointer || HasDeclaration || IsObjCMethodName(Die.Name)) {
+      AddFunction(Die, Declaration, Functions);
+    }
+  }
+
+  return Functions.size() != Before;
+}
+
+bool DwarfIndex::FindClassMethods(std::string_view Class,
+                                  std::vector<DwarfFunction> &Functions) {
+  auto Before = Functions.size();
+  auto Separator = Class.rfind("::");
+  bool IsQualified = Separator != std::string_view::npos;
+  auto Unqualified = IsQualified ? Class.substr(Separator + 2) : Class;
+  if (Unqualified.empty()) {
+    return false;
+  }
+
+  std::vector<uint64_t> Offsets;
+
+  // __apple_objc goes from a class straight to its method definitions
+  if (!IsQualified && AppleObjC.Lookup(Unqualified, Offsets)) {
+    for (auto Offset : Offsets) {
+      DwarfDie Die;
+      if (Info.ReadDie(Offset, Die) && Die.Tag == DW_TAG_subprogram &&
+          Die.HasLowPC) {
+        AddFunction(Die, Die, Functions);
+      }
+    }
+  }
+
+  // C++ needs two steps, the class lists declarations of its methods, each
+  // of them is then looked up for the definition that points back to it.
+  // Classes of the same name in other scopes are told apart by the mangled
+  // names of their methods.
+  std::string Scope = IsQualified ? GetMangledScope(Class) : "";
+  Offsets.clear();
+  LookupTypes(Unqualified, Offsets);
+
+  std::vector<DwarfDie> Children;
+  for (auto Offset : Offsets) {
+    DwarfDie Type;
+    if (!Info.ReadDie(Offset, Type) || !IsTypeWithMethods(Type) ||
+        Type.IsDeclaration || !Info.ReadChildren(Type, Children)) {
+      continue;
+    }
+
+    for (auto &Child : Children) {
+      if (Child.Tag != DW_TAG_subprogram ||
+          (IsQualified && !IsInMangledScope(Child.LinkageName, Scope))) {
+        continue;
+      }
+      FindDefinitions(Child, Functions);
+    }
+  }
+
+  return Functions.size() != Before;
+}
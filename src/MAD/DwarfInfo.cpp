@@ -0,0 +1,425 @@
+// Std
+#include <algorithm>
+
+// MAD
+#include "MAD/Debug.hpp"
+#include "MAD/DwarfInfo.hpp"
+#include "MAD/Error.hpp"
+
+using namespace mad;
+
+DwarfInfo::DwarfInfo(const DwarfSections &Sections) : Sections(Sections) {
+  // Only the lengths are read here, everything else waits for a lookup
+  DwarfCursor C(Sections.Info, 0);
+  while (!C.IsAtEnd()) {
+    auto Start = C.Tell();
+    bool Is64;
+    uint64_t Length = ReadDwarfUnitLength(C, Is64);
+    if (!C.Good() || !Sections.Info.Contains(C.Tell(), Length)) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Truncated debug info unit at", Start);
+      break;
+    }
+    Units.emplace_back(Start, C.Tell() + Length);
+    C.Skip(Length);
+  }
+}
+
+DwarfInfo::Unit *DwarfInfo::GetUnit(uint64_t Offset) {
+  auto It = std::upper_bound(
+      Units.begin(), Units.end(), Offset,
+      [](uint64_t O, const Unit &U) { return O < U.Offset; });
+  if (It == Units.begin() || Offset >= (It - 1)->End) {
+    return nullptr;
+  }
+
+  auto &U = *(It - 1);
+  if (!U.IsHeaderRead) {
+    ReadHeader(U);
+  }
+  return U.IsHeaderGood ? &U : nullptr;
+}
+
+const DwarfInfo::AbbreviationTable *
+DwarfInfo::ReadAbbreviations(uint64_t Offset) {
+  auto It = Abbreviations.find(Offset);
+  if (It != Abbreviations.end()) {
+    return It->second.empty() ? nullptr : &It->second;
+  }
+
+  // A failed table is kept empty so that it is not read again
+  auto &Table = Abbreviations[Offset];
+  AbbreviationTable Result;
+
+  DwarfCursor C(Sections.Abbrev, Offset);
+  for (uint64_t Code = C.ReadULEB128(); C.Good() && Code;
+       Code = C.ReadULEB128()) {
+    Abbreviation A;
+    A.Code = Code;
+    A.Tag = C.ReadULEB128();
+    A.HasChildren = C.Read<uint8_t>();
+
+    while (C.Good()) {
+      AttributeSpec Spec;
+      Spec.Attribute = C.ReadULEB128();
+      Spec.Form = C.ReadULEB128();
+      if (!Spec.Attribute && !Spec.Form) {
+        break;
+      }
+      Spec.ImplicitConst =
+          Spec.Form == DW_FORM_implicit_const ? C.ReadSLEB128() : 0;
+      A.Specs.push_back(Spec);
+    }
+
+    Result.push_back(std::move(A));
+  }
+
+  if (!C.Good()) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Malformed abbreviations at", Offset);
+    return nullptr;
+  }
+
+  Table = std::move(Result);
+  return Table.empty() ? nullptr : &Table;
+}
+
+bool DwarfInfo::ReadHeader(Unit &U) {
+  U.IsHeaderRead = true;
+
+  DwarfCursor C(Sections.Info.Slice(0, U.End), U.Offset);
+  ReadDwarfUnitLength(C, U.Is64);
+  U.Version = C.Read<uint16_t>();
+  if (U.Version < 2 || U.Version > 5) {
+    PRINT_DEBUG("Unsupported debug info version", U.Version, "at", U.Offset);
+    return false;
+  }
+
+  if (U.Version >= 5) {
+    uint8_t Type = C.Read<uint8_t>();
+    U.AddressSize = C.Read<uint8_t>();
+    U.AbbrevOffset = C.ReadOffset(U.Is64);
+    switch (Type) {
+    case DW_UT_skeleton:
+    case DW_UT_split_compile:
+      // DWO id
+      C.Skip(8);
+      break;
+    case DW_UT_type:
+    case DW_UT_split_type:
+      // Type signature and offset
+      C.Skip(8);
+      C.ReadOffset(U.Is64);
+      break;
+    }
+  } else {
+    U.AbbrevOffset = C.ReadOffset(U.Is64);
+    U.AddressSize = C.Read<uint8_t>();
+  }
+  U.FirstDie = C.Tell();
+
+  if (!C.Good() || (U.AddressSize != 4 && U.AddressSize != 8)) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Malformed debug info unit at", U.Offset);
+    return false;
+  }
+
+  U.Abbreviations = ReadAbbreviations(U.AbbrevOffset);
+  if (!U.Abbreviations) {
+    return false;
+  }
+
+  // The root DIE sets where indexed strings and addresses start. Its own
+  // indexed attributes may come before the bases, it is not handed out.
+  U.IsHeaderGood = true;
+  DwarfDie Root;
+  if (!ReadDie(U, U.FirstDie, Root)) {
+    U.IsHeaderGood = false;
+  }
+  return U.IsHeaderGood;
+}
+
+std::string_view DwarfInfo::GetIndexedString(const Unit &U,
+                                             uint64_t Index) const {
+  unsigned Size = U.Is64 ? 8 : 4;
+  DwarfCursor C(Sections.StrOffsets, U.StrOffsetsBase + Index * Size);
+  uint64_t Offset = C.ReadSized(Size);
+  return C.Good() ? Sections.Str.StringAt(Offset) : std::string_view();
+}
+
+uint64_t DwarfInfo::GetIndexedAddress(const Unit &U, uint64_t Index) const {
+  DwarfCursor C(Sections.Addr, U.AddrBase + Index * U.AddressSize);
+  return C.ReadSized(U.AddressSize);
+}
+
+bool DwarfInfo::ReadAttribute(Unit &U, DwarfCursor &C,
+                              const AttributeSpec &Spec, DwarfDie &Die) {
+  uint64_t Form = Spec.Form;
+  while (Form == DW_FORM_indirect) {
+    Form = C.ReadULEB128();
+  }
+
+  uint64_t Number = 0;
+  std::string_view String;
+  // Set for references, already made relative to the section
+  uint64_t Reference = 0;
+
+  switch (Form) {
+  case DW_FORM_addr:
+    Number = C.ReadSized(U.AddressSize);
+    break;
+  case DW_FORM_addrx:
+  case DW_FORM_GNU_addr_index:
+    Number = GetIndexedAddress(U, C.ReadULEB128());
+    break;
+  case DW_FORM_addrx1:
+  case DW_FORM_addrx2:
+  case DW_FORM_addrx3:
+  case DW_FORM_addrx4:
+    Number = GetIndexedAddress(U, C.ReadSized(Form - DW_FORM_addrx1 + 1));
+    break;
+  case DW_FORM_data1:
+  case DW_FORM_flag:
+    Number = C.ReadSized(1);
+    break;
+  case DW_FORM_data2:
+    Number = C.ReadSized(2);
+    break;
+  case DW_FORM_data4:
+  case DW_FORM_ref_sup4:
+    Number = C.ReadSized(4);
+    break;
+  case DW_FORM_data8:
+  case DW_FORM_ref_sig8:
+  case DW_FORM_ref_sup8:
+    Number = C.ReadSized(8);
+    break;
+  case DW_FORM_data16:
+    C.Skip(16);
+    break;
+  case DW_FORM_sdata:
+    Number = C.ReadSLEB128();
+    break;
+  case DW_FORM_udata:
+  case DW_FORM_loclistx:
+  case DW_FORM_rnglistx:
+    Number = C.ReadULEB128();
+    break;
+  case DW_FORM_ref1:
+    Reference = U.Offset + C.ReadSized(1);
+    break;
+  case DW_FORM_ref2:
+    Reference = U.Offset + C.ReadSized(2);
+    break;
+  case DW_FORM_ref4:
+    Reference = U.Offset + C.ReadSized(4);
+    break;
+  case DW_FORM_ref8:
+    Reference = U.Offset + C.ReadSized(8);
+    break;
+  case DW_FORM_ref_udata:
+    Reference = U.Offset + C.ReadULEB128();
+    break;
+  case DW_FORM_ref_addr:
+    // Version 2 got its size wrong
+    Reference = U.Version <= 2 ? C.ReadSized(U.AddressSize)
+                               : C.ReadOffset(U.Is64);
+    break;
+  case DW_FORM_string:
+    String = C.ReadString();
+    break;
+  case DW_FORM_strp:
+    String = Sections.Str.StringAt(C.ReadOffset(U.Is64));
+    break;
+  case DW_FORM_line_strp:
+    String = Sections.LineStr.StringAt(C.ReadOffset(U.Is64));
+    break;
+  case DW_FORM_strx:
+  case DW_FORM_GNU_str_index:
+    String = GetIndexedString(U, C.ReadULEB128());
+    break;
+  case DW_FORM_strx1:
+  case DW_FORM_strx2:
+  case DW_FORM_strx3:
+  case DW_FORM_strx4:
+    String = GetIndexedString(U, C.ReadSized(Form - DW_FORM_strx1 + 1));
+    break;
+  case DW_FORM_sec_offset:
+  case DW_FORM_strp_sup:
+  case DW_FORM_GNU_ref_alt:
+  case DW_FORM_GNU_strp_alt:
+    // Supplementary files are never read
+    Number = C.ReadOffset(U.Is64);
+    break;
+  case DW_FORM_block1:
+    C.Skip(C.ReadSized(1));
+    break;
+  case DW_FORM_block2:
+    C.Skip(C.ReadSized(2));
+    break;
+  case DW_FORM_block4:
+    C.Skip(C.ReadSized(4));
+    break;
+  case DW_FORM_block:
+  case DW_FORM_exprloc:
+    C.Skip(C.ReadULEB128());
+    break;
+  case DW_FORM_flag_present:
+    Number = 1;
+    break;
+  case DW_FORM_implicit_const:
+    Number = Spec.ImplicitConst;
+    break;
+  default:
+    // Without its size the rest of the DIE cannot be read
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Unknown form", HEX(Form), "in DIE at", HEX(Die.Offset));
+    return false;
+  }
+
+  switch (Spec.Attribute) {
+  case DW_AT_name:
+    Die.Name = String;
+    break;
+  case DW_AT_linkage_name:
+  case DW_AT_MIPS_linkage_name:
+    Die.LinkageName = String;
+    break;
+  case DW_AT_low_pc:
+    Die.LowPC = Number;
+    Die.HasLowPC = true;
+    break;
+  case DW_AT_declaration:
+    Die.IsDeclaration = Number;
+    break;
+  case DW_AT_object_pointer:
+    Die.HasObjectPointer = true;
+    break;
+  case DW_AT_specification:
+    Die.Specification = Reference;
+    break;
+  case DW_AT_abstract_origin:
+    Die.AbstractOrigin = Reference;
+    break;
+  case DW_AT_sibling:
+    Die.Sibling = Reference;
+    break;
+  case DW_AT_str_offsets_base:
+    U.StrOffsetsBase = Number;
+    break;
+  case DW_AT_addr_base:
+    U.AddrBase = Number;
+    break;
+  }
+
+  return C.Good();
+}
+
+bool DwarfInfo::ReadDie(Unit &U, uint64_t Offset, DwarfDie &Die) {
+  Die = DwarfDie();
+  Die.Offset = Offset;
+
+  DwarfCursor C(Sections.Info.Slice(0, U.End), Offset);
+  uint64_t Code = C.ReadULEB128();
+  if (!C.Good()) {
+    return false;
+  }
+
+  // A null entry ends a list of siblings, its tag stays 0
+  if (!Code) {
+    Die.End = C.Tell();
+    return true;
+  }
+
+  auto &Table = *U.Abbreviations;
+  const Abbreviation *A = nullptr;
+  // Codes are normally numbered from 1 in order
+  if (Code <= Table.size() && Table[Code - 1].Code == Code) {
+    A = &Table[Code - 1];
+  } else {
+    auto It =
+        std::find_if(Table.begin(), Table.end(),
+                     [&](const Abbreviation &E) { return E.Code == Code; });
+    A = It == Table.end() ? nullptr : &*It;
+  }
+
+  if (!A) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Unknown abbreviation", Code, "in DIE at", HEX(Offset));
+    return false;
+  }
+
+  Die.Tag = A->Tag;
+  Die.HasChildren = A->HasChildren;
+  for (auto &Spec : A->Specs) {
+    if (!ReadAttribute(U, C, Spec, Die)) {
+      return false;
+    }
+  }
+
+  Die.End = C.Tell();
+  return true;
+}
+
+bool DwarfInfo::ReadDie(uint64_t Offset, DwarfDie &Die) {
+  auto U = GetUnit(Offset);
+  if (!U || Offset < U->FirstDie) {
+    return false;
+  }
+  return ReadDie(*U, Offset, Die);
+}
+
+bool DwarfInfo::SkipSubtree(Unit &U, uint64_t Offset, uint64_t &End) {
+  // Every DIE moves the offset forward, so this ends at the unit end at most
+  unsigned Depth = 1;
+  while (Depth) {
+    DwarfDie Die;
+    if (!ReadDie(U, Offset, Die)) {
+      return false;
+    }
+    Offset = Die.End;
+    if (!Die.Tag) {
+      --Depth;
+    } else if (Die.HasChildren) {
+      ++Depth;
+    }
+  }
+  End = Offset;
+  return true;
+}
+
+bool DwarfInfo::ReadChildren(const DwarfDie &Parent,
+                             std::vector<DwarfDie> &Children) {
+  Children.clear();
+  if (!Parent.HasChildren) {
+    return true;
+  }
+
+  auto U = GetUnit(Parent.Offset);
+  if (!U) {
+    return false;
+  }
+
+  uint64_t Offset = Parent.End;
+  while (true) {
+    DwarfDie Child;
+    if (!ReadDie(*U, Offset, Child)) {
+      return false;
+    }
+    if (!Child.Tag) {
+      return true;
+    }
+
+    Offset = Child.End;
+    if (Child.HasChildren) {
+      // Producers may point straight to the next sibling
+      if (Child.Sibling > Offset && Child.Sibling < U->End) {
+        Offset = Child.Sibling;
+      } else if (!SkipSubtree(*U, Offset, Offset)) {
+        return false;
+      }
+    }
+
+    Children.push_back(Child);
+  }
+}
@@ -0,0 +1,516 @@
+// Std
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+// MAD
+#include "MAD/Debug.hpp"
+#include "MAD/Dwarf.hpp"
+#include "MAD/DwarfLineTable.hpp"
+#include "MAD/Error.hpp"
+#include "MAD/Utils.hpp"
+
+using namespace mad;
+
+namespace {
+
+// Standard opcodes
+enum : uint8_t {
+  DW_LNS_copy = 0x01,
+  DW_LNS_advance_pc = 0x02,
+  DW_LNS_advance_line = 0x03,
+  DW_LNS_set_file = 0x04,
+  DW_LNS_set_column = 0x05,
+  DW_LNS_negate_stmt = 0x06,
+  DW_LNS_set_basic_block = 0x07,
+  DW_LNS_const_add_pc = 0x08,
+  DW_LNS_fixed_advance_pc = 0x09,
+  DW_LNS_set_prologue_end = 0x0a,
+  DW_LNS_set_epilogue_begin = 0x0b,
+  DW_LNS_set_isa = 0x0c,
+};
+
+// Extended opcodes
+enum : uint8_t {
+  DW_LNE_end_sequence = 0x01,
+  DW_LNE_set_address = 0x02,
+  DW_LNE_define_file = 0x03,
+  DW_LNE_set_discriminator = 0x04,
+};
+
+// Version 5 entry formats
+enum : uint64_t {
+  DW_LNCT_path = 0x1,
+  DW_LNCT_directory_index = 0x2,
+};
+
+} // namespace
+
+static std::string JoinPath(const std::vector<std::string> &Directories,
+                            uint64_t Directory, std::string_view Name) {
+  if (Name.empty() || Name.front() == '/' ||
+      Directory >= Directories.size() || Directories[Directory].empty()) {
+    return std::string(Name);
+  }
+  auto &Prefix = Directories[Directory];
+  return Prefix + (Prefix.back() == '/' ? "" : "/") + std::string(Name);
+}
+
+DwarfLineTable::DwarfLineTable(ByteView DebugLine, ByteView LineStrings,
+                               ByteView Strings)
+    : DebugLine(DebugLine), LineStrings(LineStrings), Strings(Strings),
+      IsAddressIndexBuilt(false) {
+  // Only the lengths are read here, everything else waits for a lookup
+  DwarfCursor C(DebugLine, 0);
+  while (!C.IsAtEnd()) {
+    auto Start = C.Tell();
+    bool Is64;
+    uint64_t Length = ReadDwarfUnitLength(C, Is64);
+    if (!C.Good() || !DebugLine.Contains(C.Tell(), Length)) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Truncated line table unit at", Start);
+      break;
+    }
+    Units.emplace_back(Start, C.Tell() + Length);
+    C.Skip(Length);
+  }
+}
+
+bool DwarfLineTable::ReadEntryTable(Unit &U, DwarfCursor &C,
+                                    std::vector<std::string> &Paths) {
+  std::vector<std::pair<uint64_t, uint64_t>> Format(C.Read<uint8_t>());
+  for (auto &Entry : Format) {
+    Entry.first = C.ReadULEB128();
+    Entry.second = C.ReadULEB128();
+  }
+
+  uint64_t Count = C.ReadULEB128();
+  for (uint64_t i = 0; C.Good() && i < Count; ++i) {
+    std::string_view Path;
+    uint64_t Directory = 0;
+    bool HasDirectory = false;
+
+    for (auto &[Content, Form] : Format) {
+      std::string_view String;
+      uint64_t Number = 0;
+
+      switch (Form) {
+      case DW_FORM_string:
+        String = C.ReadString();
+        break;
+      case DW_FORM_line_strp:
+        String = LineStrings.StringAt(C.ReadOffset(U.Is64));
+        break;
+      case DW_FORM_strp:
+        String = Strings.StringAt(C.ReadOffset(U.Is64));
+        break;
+      case DW_FORM_data1:
+        Number = C.Read<uint8_t>();
+        break;
+      case DW_FORM_data2:
+        Number = C.Read<uint16_t>();
+        break;
+      case DW_FORM_data4:
+        Number = C.Read<uint32_t>();
+        break;
+      case DW_FORM_data8:
+        Number = C.Read<uint64_t>();
+        break;
+      case DW_FORM_udata:
+        Number = C.ReadULEB128();
+        break;
+      case DW_FORM_sdata:
+        C.ReadSLEB128();
+        break;
+      case DW_FORM_data16:
+        C.Skip(16);
+        break;
+      case DW_FORM_block:
+        C.Skip(C.ReadULEB128());
+        break;
+      default:
+        // E.g. DW_FORM_strx needs .debug_str_offsets and the unit's base
+        PRINT_DEBUG("Unsupported line table form", Form);
+        return false;
+      }
+
+      if (Content == DW_LNCT_path) {
+        Path = String;
+      } else if (Content == DW_LNCT_directory_index) {
+        Directory = Number;
+        HasDirectory = true;
+      }
+    }
+
+    // Only files have a directory
+    Paths.push_back(HasDirectory ? JoinPath(U.Directories, Directory, Path)
+                                 : std::string(Path));
+  }
+
+  return C.Good();
+}
+
+bool DwarfLineTable::ReadFileTable(Unit &U, DwarfCursor &C) {
+  if (U.Version >= 5) {
+    if (!ReadEntryTable(U, C, U.Directories)) {
+      return false;
+    }
+    // Other directories are relative to the compilation directory
+    for (size_t i = 1; i < U.Directories.size(); ++i) {
+      U.Directories[i] = JoinPath(U.Directories, 0, U.Directories[i]);
+    }
+    return ReadEntryTable(U, C, U.Files);
+  }
+
+  U.Directories.emplace_back();
+  for (auto Name = C.ReadString(); C.Good() && !Name.empty();
+       Name = C.ReadString()) {
+    U.Directories.emplace_back(Name);
+  }
+
+  U.Files.emplace_back();
+  for (auto Name = C.ReadString(); C.Good() && !Name.empty();
+       Name = C.ReadString()) {
+    uint64_t Directory = C.ReadULEB128();
+    // Modification time and length
+    C.ReadULEB128();
+    C.ReadULEB128();
+    U.Files.push_back(JoinPath(U.Directories, Directory, Name));
+  }
+
+  return C.Good();
+}
+
+bool DwarfLineTable::ReadHeader(Unit &U) {
+  U.IsHeaderRead = true;
+
+  DwarfCursor C(DebugLine.Slice(0, U.End), U.Offset);
+  ReadDwarfUnitLength(C, U.Is64);
+
+  U.Version = C.Read<uint16_t>();
+  if (U.Version < 2 || U.Version > 5) {
+    PRINT_DEBUG("Unsupported line table version", U.Version, "at", U.Offset);
+    return false;
+  }
+
+  // Address and segment selector sizes, set_address tells them anyway
+  if (U.Version >= 5) {
+    C.Skip(2);
+  }
+
+  uint64_t HeaderLength = C.ReadOffset(U.Is64);
+  U.ProgramOffset = C.Tell() + HeaderLength;
+
+  U.MinInstructionLength = C.Read<uint8_t>();
+  // Maximum operations per instruction only matters for VLIW
+  if (U.Version >= 4) {
+    C.Skip(1);
+  }
+  U.DefaultIsStatement = C.Read<uint8_t>();
+  U.LineBase = C.Read<int8_t>();
+  U.LineRange = C.Read<uint8_t>();
+  U.OpcodeBase = C.Read<uint8_t>();
+
+  U.StandardOpcodeLengths.resize(U.OpcodeBase ? U.OpcodeBase - 1 : 0);
+  for (auto &Length : U.StandardOpcodeLengths) {
+    Length = C.Read<uint8_t>();
+  }
+
+  if (!C.Good() || !U.LineRange || !U.OpcodeBase ||
+      U.ProgramOffset < C.Tell() || U.ProgramOffset > U.End ||
+      !ReadFileTable(U, C)) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Malformed line table header at", U.Offset);
+    return false;
+  }
+
+  U.IsHeaderGood = true;
+  return true;
+}
+
+bool DwarfLineTable::Decode(uint32_t Index) {
+  auto &U = Units[Index];
+  if (U.IsDecoded) {
+    return U.IsHeaderGood;
+  }
+  U.IsDecoded = true;
+
+  if (!U.IsHeaderRead) {
+    ReadHeader(U);
+  }
+  if (!U.IsHeaderGood) {
+    return false;
+  }
+
+  U.FirstSequence = Sequences.size();
+
+  // State machine registers, column, ISA and the like are not kept
+  uint64_t Address;
+  uint32_t Line;
+  uint16_t File;
+  bool IsStatement;
+
+  auto Reset = [&]() {
+    Address = 0;
+    Line = 1;
+    File = 1;
+    IsStatement = U.DefaultIsStatement;
+  };
+
+  uint64_t SequenceStart = 0;
+  size_t SequenceFirst = 0;
+  bool IsSequenceBroken = false;
+
+  // Rows store their address as a 32-bit offset from the sequence start,
+  // sequences with addresses going backwards are not valid DWARF, both kinds
+  // are dropped as a whole
+  auto Append = [&](bool IsEnd) {
+    if (U.Rows.size() == SequenceFirst) {
+      SequenceStart = Address;
+    }
+    if (Address < SequenceStart ||
+        Address - SequenceStart > std::numeric_limits<uint32_t>::max()) {
+      IsSequenceBroken = true;
+    }
+
+    uint8_t Flags = (IsStatement ? LT_ROW_STATEMENT : 0) |
+                    (IsEnd ? LT_ROW_END_SEQUENCE : 0);
+    U.Rows.push_back(
+        {uint32_t(Address - SequenceStart), Line, File, Flags});
+
+    if (!IsEnd) {
+      return;
+    }
+
+    if (IsSequenceBroken || Address == SequenceStart) {
+      U.Rows.resize(SequenceFirst);
+    } else {
+      Sequences.push_back({SequenceStart, Address, Index,
+                           uint32_t(SequenceFirst),
+                           uint32_t(U.Rows.size() - SequenceFirst)});
+    }
+    SequenceFirst = U.Rows.size();
+    IsSequenceBroken = false;
+    Reset();
+  };
+
+  auto AdvanceAddress = [&](uint64_t OperationAdvance) {
+    Address += OperationAdvance * U.MinInstructionLength;
+  };
+
+  Reset();
+  DwarfCursor C(DebugLine.Slice(0, U.End), U.ProgramOffset);
+  while (!C.IsAtEnd()) {
+    uint8_t Opcode = C.Read<uint8_t>();
+
+    // Special opcodes advance both address and line and append a row
+    if (Opcode >= U.OpcodeBase) {
+      uint8_t Adjusted = Opcode - U.OpcodeBase;
+      AdvanceAddress(Adjusted / U.LineRange);
+      Line += U.LineBase + Adjusted % U.LineRange;
+      Append(false);
+      continue;
+    }
+
+    switch (Opcode) {
+    case 0: {
+      uint64_t Length = C.ReadULEB128();
+      uint64_t Next = C.Tell() + Length;
+      if (!Length) {
+        break;
+      }
+
+      switch (C.Read<uint8_t>()) {
+      case DW_LNE_end_sequence:
+        Append(true);
+        break;
+      case DW_LNE_set_address:
+        Address = Length == 9 ? C.Read<uint64_t>() : C.Read<uint32_t>();
+        break;
+      case DW_LNE_define_file: {
+        auto Name = C.ReadString();
+        uint64_t Directory = C.ReadULEB128();
+        U.Files.push_back(JoinPath(U.Directories, Directory, Name));
+        break;
+      }
+      case DW_LNE_set_discriminator:
+      default:
+        break;
+      }
+
+      C.Seek(Next);
+      break;
+    }
+    case DW_LNS_copy:
+      Append(false);
+      break;
+    case DW_LNS_advance_pc:
+      AdvanceAddress(C.ReadULEB128());
+      break;
+    case DW_LNS_advance_line:
+      Line += C.ReadSLEB128();
+      break;
+    case DW_LNS_set_file:
+      File = C.ReadULEB128();
+      break;
+    case DW_LNS_negate_stmt:
+      IsStatement = !IsStatement;
+      break;
+    case DW_LNS_const_add_pc:
+      AdvanceAddress((255 - U.OpcodeBase) / U.LineRange);
+      break;
+    case DW_LNS_fixed_advance_pc:
+      Address += C.Read<uint16_t>();
+      break;
+    case DW_LNS_set_column:
+    case DW_LNS_set_basic_block:
+    case DW_LNS_set_prologue_end:
+    case DW_LNS_set_epilogue_begin:
+    case DW_LNS_set_isa:
+    default:
+      // Skipped by their operand counts, which covers opcodes of later
+      // versions and vendor ones too
+      for (unsigned i = 0; i < U.StandardOpcodeLengths[Opcode - 1]; ++i) {
+        C.ReadULEB128();
+      }
+      break;
+    }
+  }
+
+  if (!C.Good()) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Malformed line program at", U.Offset);
+  }
+
+  // Whatever a damaged program did not finish is not a sequence
+  U.Rows.resize(SequenceFirst);
+  U.Rows.shrink_to_fit();
+  U.SequenceCount = Sequences.size() - U.FirstSequence;
+  return true;
+}
+
+void DwarfLineTable::BuildAddressIndex() {
+  IsAddressIndexBuilt = true;
+  for (uint32_t i = 0; i < Units.size(); ++i) {
+    Decode(i);
+  }
+
+  ByAddress.resize(Sequences.size());
+  std::iota(ByAddress.begin(), ByAddress.end(), 0);
+  std::sort(ByAddress.begin(), ByAddress.end(), [&](uint32_t A, uint32_t B) {
+    return Sequences[A].Start < Sequences[B].Start;
+  });
+}
+
+bool DwarfLineTable::LookupAddress(uint64_t Address, LineInfo &Info) {
+  if (!IsAddressIndexBuilt) {
+    BuildAddressIndex();
+  }
+
+  // Sequences of a linked image do not overlap
+  auto It = std::upper_bound(
+      ByAddress.begin(), ByAddress.end(), Address,
+      [&](uint64_t A, uint32_t S) { return A < Sequences[S].Start; });
+  if (It == ByAddress.begin()) {
+    return false;
+  }
+
+  auto &S = Sequences[*(It - 1)];
+  if (Address >= S.End) {
+    return false;
+  }
+
+  auto &U = Units[S.Unit];
+  auto First = U.Rows.begin() + S.FirstRow;
+  auto Last = First + S.RowCount;
+  uint32_t Offset = Address - S.Start;
+  // The first row is at offset 0, so there always is one before
+  auto Row = std::upper_bound(First, Last, Offset,
+                              [](uint32_t O, const DwarfLineTable::Row &R) {
+                                return O < R.Offset;
+                              }) -
+             1;
+
+  Info.Address = S.Start + Row->Offset;
+  // Bound to the stored path, a conditional with "" would bind to a copy
+  Info.File = std::string_view();
+  if (Row->File < U.Files.size()) {
+    Info.File = U.Files[Row->File];
+  }
+  Info.Line = Row->Line;
+  Info.IsStatement = Row->Flags & LT_ROW_STATEMENT;
+  return true;
+}
+
+bool DwarfLineTable::LookupLine(std::string_view File, uint32_t Line,
+                                std::vector<uint64_t> &Addresses,
+                                uint32_t &ResolvedLine) {
+  Addresses.clear();
+  if (File.empty()) {
+    return false;
+  }
+
+  // Units that name the file along with which of their files it is
+  std::vector<std::pair<uint32_t, std::vector<bool>>> Matches;
+  for (uint32_t i = 0; i < Units.size(); ++i) {
+    auto &U = Units[i];
+    if (!U.IsHeaderRead) {
+      ReadHeader(U);
+    }
+    if (!U.IsHeaderGood) {
+      continue;
+    }
+
+    std::vector<bool> IsMatching(U.Files.size());
+    bool Any = false;
+    for (size_t f = 0; f < U.Files.size(); ++f) {
+      IsMatching[f] = IsPathMatching(U.Files[f], File);
+      Any |= IsMatching[f];
+    }
+    // Only these are ever decoded
+    if (Any && Decode(i)) {
+      Matches.emplace_back(i, std::move(IsMatching));
+    }
+  }
+
+  auto ForEachRow = [&](auto &&Callback) {
+    for (auto &[Index, IsMatching] : Matches) {
+      auto &U = Units[Index];
+      for (uint32_t s = 0; s < U.SequenceCount; ++s) {
+        auto &S = Sequences[U.FirstSequence + s];
+        for (uint32_t r = S.FirstRow; r < S.FirstRow + S.RowCount; ++r) {
+          auto &R = U.Rows[r];
+          if ((R.Flags & LT_ROW_STATEMENT) &&
+              !(R.Flags & LT_ROW_END_SEQUENCE) && R.File < IsMatching.size() &&
+              IsMatching[R.File]) {
+            Callback(S, r == S.FirstRow ? nullptr : &U.Rows[r - 1], R);
+          }
+        }
+      }
+    }
+  };
+
+  // The requested line or, if it has no code, the closest one after it
+  ResolvedLine = 0;
+  ForEachRow([&](const Sequence &, const Row *, const Row &R) {
+    if (R.Line >= Line && (!ResolvedLine || R.Line < ResolvedLine)) {
+      ResolvedLine = R.Line;
+    }
+  });
+  if (!ResolvedLine) {
+    return false;
+  }
+
+  // Only rows that begin the line, the ones after continue it
+  ForEachRow([&](const Sequence &S, const Row *Previous, const Row &R) {
+    if (R.Line == ResolvedLine &&
+        (!Previous || Previous->Line != R.Line || Previous->File != R.File)) {
+      Addresses.push_back(S.Start + R.Offset);
+    }
+  });
+
+  std::sort(Addresses.begin(), Addresses.end());
+  Addresses.erase(std::unique(Addresses.begin(), Addresses.end()),
+                  Addresses.end());
+  return !Addresses.empty();
+}
@@ -0,0 +1,399 @@
+// Std
+#include <algorithm>
+#include <string_view>
+
+// MAD
+#include "MAD/EhFrame.hpp"
+
+using namespace mad;
+
+bool EhFrame::ReadPointer(DwarfCursor &C, uint8_t Encoding,
+                          uint64_t &Value) const {
+  if (Encoding == DW_EH_PE_omit) {
+    Value = 0;
+    return true;
+  }
+
+  uint64_t Where = SectionAddress + C.Tell();
+  switch (Encoding & 0x0f) {
+  case DW_EH_PE_absptr:
+  case DW_EH_PE_udata8:
+  case DW_EH_PE_sdata8:
+    Value = C.Read<uint64_t>();
+    break;
+  case DW_EH_PE_uleb128:
+    Value = C.ReadULEB128();
+    break;
+  case DW_EH_PE_udata2:
+    Value = C.Read<uint16_t>();
+    break;
+  case DW_EH_PE_udata4:
+    Value = C.Read<uint32_t>();
+    break;
+  case DW_EH_PE_sleb128:
+    Value = C.ReadSLEB128();
+    break;
+  case DW_EH_PE_sdata2:
+    Value = int64_t(C.Read<int16_t>());
+    break;
+  case DW_EH_PE_sdata4:
+    Value = int64_t(C.Read<int32_t>());
+    break;
+  default:
+    return false;
+  }
+
+  // Nothing but pc-relative pointers is used on Darwin. Indirect ones, i.e.
+  // personalities, are never followed.
+  switch (Encoding & 0x70) {
+  case DW_EH_PE_absptr:
+    break;
+  case DW_EH_PE_pcrel:
+    Value += Where;
+    break;
+  default:
+    return false;
+  }
+
+  return C.Good();
+}
+
+bool EhFrame::ReadCie(uint64_t Offset, Cie &Info) const {
+  DwarfCursor C(Data, Offset);
+  bool Is64;
+  uint64_t Length = ReadDwarfUnitLength(C, Is64);
+  if (!C.Good() || !Length || !Data.Contains(C.Tell(), Length)) {
+    return false;
+  }
+  uint64_t End = C.Tell() + Length;
+  C = DwarfCursor(Data.Slice(0, End), C.Tell());
+
+  // CIEs of __eh_frame have a zero id, unlike the ones of .debug_frame
+  if (C.ReadOffset(Is64) || !C.Good()) {
+    return false;
+  }
+  uint8_t Version = C.Read<uint8_t>();
+  if (Version != 1 && Version != 3 && Version != 4) {
+    return false;
+  }
+
+  auto Augmentation = C.ReadString();
+  if (Version == 4) {
+    // Address and segment selector sizes
+    C.Skip(2);
+  }
+  if (Augmentation.find("eh") != std::string_view::npos) {
+    C.Skip(8);
+  }
+
+  Info = Cie();
+  Info.CodeAlign = C.ReadULEB128();
+  Info.DataAlign = C.ReadSLEB128();
+  Info.ReturnRegister = Version == 1 ? C.Read<uint8_t>() : C.ReadULEB128();
+
+  if (!Augmentation.empty() && Augmentation.front() == 'z') {
+    uint64_t AugmentationLength = C.ReadULEB128();
+    uint64_t AugmentationEnd = C.Tell() + AugmentationLength;
+    Info.HasAugmentationData = true;
+
+    for (auto Letter : Augmentation.substr(1)) {
+      uint64_t Personality;
+      if (Letter == 'L') {
+        // How the LSDA pointers of FDEs are encoded
+        C.Read<uint8_t>();
+      } else if (Letter == 'P') {
+        if (!ReadPointer(C, C.Read<uint8_t>(), Personality)) {
+          return false;
+        }
+      } else if (Letter == 'R') {
+        Info.PointerEncoding = C.Read<uint8_t>();
+      } else if (Letter != 'S') {
+        // Whatever is left is known to be of AugmentationLength
+        break;
+      }
+    }
+    C.Seek(AugmentationEnd);
+  }
+
+  Info.Instructions = C.Tell();
+  Info.InstructionsEnd = End;
+  return C.Good();
+}
+
+bool EhFrame::ReadFde(uint64_t Offset, Cie &Info, Fde &F,
+                      uint64_t &Instructions,
+                      uint64_t &InstructionsEnd) const {
+  DwarfCursor C(Data, Offset);
+  bool Is64;
+  uint64_t Length = ReadDwarfUnitLength(C, Is64);
+  if (!C.Good() || !Length || !Data.Contains(C.Tell(), Length)) {
+    return false;
+  }
+  uint64_t End = C.Tell() + Length;
+  C = DwarfCursor(Data.Slice(0, End), C.Tell());
+
+  // The CIE pointer is relative to itself
+  uint64_t Where = C.Tell();
+  uint64_t CiePointer = C.ReadOffset(Is64);
+  if (!C.Good() || !CiePointer || CiePointer > Where ||
+      !ReadCie(Where - CiePointer, Info)) {
+    return false;
+  }
+
+  // The range is a size, so never pc-relative
+  uint64_t Range;
+  if (!ReadPointer(C, Info.PointerEncoding, F.Start) ||
+      !ReadPointer(C, Info.PointerEncoding & 0x0f, Range)) {
+    return false;
+  }
+  if (Info.HasAugmentationData) {
+    C.Skip(C.ReadULEB128());
+  }
+
+  F.End = F.Start + Range;
+  F.Offset = Offset;
+  Instructions = C.Tell();
+  InstructionsEnd = End;
+  return C.Good();
+}
+
+bool EhFrame::Execute(const Cie &Info, uint64_t Offset, uint64_t End,
+                      const UnwindRow &Initial, UnwindRow &Row,
+                      UnwindPlan *Plan) const {
+  DwarfCursor C(Data.Slice(0, End), Offset);
+  std::vector<UnwindRow> Remembered;
+
+  // Rows for the instructions up to the new location are complete
+  auto Advance = [&](uint64_t Delta) {
+    if (!Plan) {
+      return false;
+    }
+    if (Delta) {
+      Plan->Rows.push_back(Row);
+      Row.Offset += Delta;
+    }
+    return true;
+  };
+
+  // Rules of the registers that do not matter for unwinding are dropped
+  auto SetRule = [&](uint64_t Register, UnwindRuleType Type, int64_t Value) {
+    if (Register < REG_X86_64_COUNT) {
+      Row.Rules[Register] = {Type, Value};
+    }
+  };
+
+  while (!C.IsAtEnd()) {
+    uint8_t Opcode = C.Read<uint8_t>();
+    uint8_t Operand = Opcode & 0x3f;
+    uint64_t Register, Value;
+
+    switch (Opcode & 0xc0) {
+    case DW_CFA_advance_loc:
+      if (!Advance(Operand * Info.CodeAlign)) {
+        return false;
+      }
+      continue;
+    case DW_CFA_offset:
+      SetRule(Operand, UnwindRuleType::AT_CFA,
+              int64_t(C.ReadULEB128()) * Info.DataAlign);
+      continue;
+    case DW_CFA_restore:
+      if (Operand < REG_X86_64_COUNT) {
+        Row.Rules[Operand] = Initial.Rules[Operand];
+      }
+      continue;
+    }
+
+    switch (Opcode) {
+    case DW_CFA_nop:
+      break;
+    case DW_CFA_set_loc:
+      if (!ReadPointer(C, Info.PointerEncoding, Value) || !Plan ||
+          Value < Plan->Start + Row.Offset ||
+          !Advance(Value - Plan->Start - Row.Offset)) {
+        return false;
+      }
+      break;
+    case DW_CFA_advance_loc1:
+      if (!Advance(C.Read<uint8_t>() * Info.CodeAlign)) {
+        return false;
+      }
+      break;
+    case DW_CFA_advance_loc2:
+      if (!Advance(C.Read<uint16_t>() * Info.CodeAlign)) {
+        return false;
+      }
+      break;
+    case DW_CFA_advance_loc4:
+      if (!Advance(C.Read<uint32_t>() * Info.CodeAlign)) {
+        return false;
+      }
+      break;
+    case DW_CFA_offset_extended:
+      Register = C.ReadULEB128();
+      SetRule(Register, UnwindRuleType::AT_CFA,
+              int64_t(C.ReadULEB128()) * Info.DataAlign);
+      break;
+    case DW_CFA_offset_extended_sf:
+      Register = C.ReadULEB128();
+      SetRule(Register, UnwindRuleType::AT_CFA,
+              C.ReadSLEB128() * Info.DataAlign);
+      break;
+    case DW_CFA_GNU_negative_offset_extended:
+      Register = C.ReadULEB128();
+      SetRule(Register, UnwindRuleType::AT_CFA,
+              -int64_t(C.ReadULEB128()) * Info.DataAlign);
+      break;
+    case DW_CFA_val_offset:
+      Register = C.ReadULEB128();
+      SetRule(Register, UnwindRuleType::IS_CFA,
+              int64_t(C.ReadULEB128()) * Info.DataAlign);
+      break;
+    case DW_CFA_val_offset_sf:
+      Register = C.ReadULEB128();
+      SetRule(Register, UnwindRuleType::IS_CFA,
+              C.ReadSLEB128() * Info.DataAlign);
+      break;
+    case DW_CFA_restore_extended:
+      Register = C.ReadULEB128();
+      if (Register < REG_X86_64_COUNT) {
+        Row.Rules[Register] = Initial.Rules[Register];
+      }
+      break;
+    case DW_CFA_undefined:
+      SetRule(C.ReadULEB128(), UnwindRuleType::UNDEFINED, 0);
+      break;
+    case DW_CFA_same_value:
+      SetRule(C.ReadULEB128(), UnwindRuleType::SAME, 0);
+      break;
+    case DW_CFA_register:
+      Register = C.ReadULEB128();
+      SetRule(Register, UnwindRuleType::IN_REGISTER, C.ReadULEB128());
+      break;
+    case DW_CFA_remember_state:
+      Remembered.push_back(Row);
+      break;
+    case DW_CFA_restore_state: {
+      if (Remembered.empty()) {
+        return false;
+      }
+      // The location is not part of the state
+      auto Location = Row.Offset;
+      Row = Remembered.back();
+      Row.Offset = Location;
+      Remembered.pop_back();
+      break;
+    }
+    case DW_CFA_def_cfa:
+      Row.CFARegister = C.ReadULEB128();
+      Row.CFAOffset = C.ReadULEB128();
+      break;
+    case DW_CFA_def_cfa_sf:
+      Row.CFARegister = C.ReadULEB128();
+      Row.CFAOffset = C.ReadSLEB128() * Info.DataAlign;
+      break;
+    case DW_CFA_def_cfa_register:
+      Row.CFARegister = C.ReadULEB128();
+      break;
+    case DW_CFA_def_cfa_offset:
+      Row.CFAOffset = C.ReadULEB128();
+      break;
+    case DW_CFA_def_cfa_offset_sf:
+      Row.CFAOffset = C.ReadSLEB128() * Info.DataAlign;
+      break;
+    case DW_CFA_expression:
+    case DW_CFA_val_expression:
+      // Expressions are not evaluated, the register is lost instead
+      Register = C.ReadULEB128();
+      SetRule(Register, UnwindRuleType::UNDEFINED, 0);
+      C.Skip(C.ReadULEB128());
+      break;
+    case DW_CFA_GNU_args_size:
+      C.ReadULEB128();
+      break;
+    default:
+      // Including DW_CFA_def_cfa_expression, there is no CFA without it
+      return false;
+    }
+
+    if (Row.CFARegister >= REG_X86_64_COUNT) {
+      return false;
+    }
+  }
+
+  if (Plan) {
+    Plan->Rows.push_back(Row);
+  }
+  return C.Good();
+}
+
+bool EhFrame::GetPlanAt(uint64_t Offset, UnwindPlan &Plan) const {
+  Cie Info;
+  Fde F;
+  uint64_t Instructions, InstructionsEnd;
+  if (!ReadFde(Offset, Info, F, Instructions, InstructionsEnd) ||
+      Info.ReturnRegister != REG_X86_64_RIP) {
+    return false;
+  }
+
+  // The CIE sets up the row the FDE starts with
+  UnwindRow Initial;
+  UnwindRow Row;
+  if (!Execute(Info, Info.Instructions, Info.InstructionsEnd, Initial, Row,
+               nullptr)) {
+    return false;
+  }
+  Initial = Row;
+
+  Plan.Start = F.Start;
+  Plan.End = F.End;
+  Plan.Rows.clear();
+  if (!Execute(Info, Instructions, InstructionsEnd, Initial, Row, &Plan)) {
+    Plan.Rows.clear();
+    return false;
+  }
+  return true;
+}
+
+void EhFrame::BuildIndex() {
+  IsIndexBuilt = true;
+
+  uint64_t Offset = 0;
+  while (Offset < Data.GetSize()) {
+    DwarfCursor C(Data, Offset);
+    bool Is64;
+    uint64_t Length = ReadDwarfUnitLength(C, Is64);
+    // A zero length ends the section
+    if (!C.Good() || !Length || !Data.Contains(C.Tell(), Length)) {
+      break;
+    }
+    uint64_t Next = C.Tell() + Length;
+
+    Cie Info;
+    Fde F;
+    uint64_t Instructions, InstructionsEnd;
+    if (C.ReadOffset(Is64) &&
+        ReadFde(Offset, Info, F, Instructions, InstructionsEnd) &&
+        F.End > F.Start) {
+      Index.push_back(F);
+    }
+    Offset = Next;
+  }
+
+  std::sort(Index.begin(), Index.end(),
+            [](const Fde &A, const Fde &B) { return A.Start < B.Start; });
+}
+
+bool EhFrame::GetPlan(uint64_t Address, UnwindPlan &Plan) {
+  if (!IsIndexBuilt) {
+    BuildIndex();
+  }
+
+  auto It = std::upper_bound(
+      Index.begin(), Index.end(), Address,
+      [](uint64_t A, const Fde &F) { return A < F.Start; });
+  if (It == Index.begin() || Address >= (It - 1)->End) {
+    return false;
+  }
+  return GetPlanAt((It - 1)->Offset, Plan);
+}
@@ -145,6 +145,22 @@ mach_vm_size_t MachMemory::Read(mach_vm_address_t Address, mach_vm_size_t Size,
   return ReadFromRegions(Regions, Address, (vm_offset_t)Data, Size);
 }
 
+mach_vm_size_t MachMemory::ReadAvailable(mach_vm_address_t Address,
+                                         mach_vm_size_t Size, void *Data) {
+  assert(Port);
+
+  std::vector<MachMemoryRegion> Regions = GetRegions(Address, Size);
+  if (!Regions.back().IsValid()) {
+    Regions.pop_back();
+    if (Regions.empty()) {
+      return 0;
+    }
+    Size = Regions.back().GetFollowingAddress() - Address;
+  }
+
+  return ReadFromRegions(Regions, Address, (vm_offset_t)Data, Size);
+}
+
 mach_vm_size_t MachMemory::Write(mach_vm_address_t Address, vm_offset_t Data,
                                  mach_msg_type_number_t Size) {
   assert(Port);
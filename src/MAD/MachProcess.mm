@@ -31,8 +31,29 @@ using namespace mad;
 
 typedef void *dyld_process_info;
 
+struct dyld_process_cache_info {
+  uuid_t cacheUUID;
+  uint64_t cacheBaseAddress;
+  bool noCache;
+  bool privateCache;
+};
+
+// Where different macOS versions keep the shared cache
+static const char *SharedCacheDirs[] = {
+    "/System/Volumes/Preboot/Cryptexes/OS/System/Library/dyld/",
+    "/System/Library/dyld/",
+    "/private/var/db/dyld/",
+};
+static const char *SharedCacheNames[] = {
+    "dyld_shared_cache_x86_64h",
+    "dyld_shared_cache_x86_64",
+    "dyld_shared_cache_arm64e",
+};
+
 MachProcess::MachProcess(std::string exec)
-  : Exec(exec), PID(0), Task(), Memory(Task.GetMemory()) {
+  : Exec(exec), PID(0), Task(), Memory(Task.GetMemory()),
+    SymbolIndex(SymbolIndexCache::GetDefaultDirectory()),
+    Imports(GlobalSymbols) {
     dyld_process_info_create = (dyld_process_info_create_t)dlsym(
         RTLD_DEFAULT, "_dyld_process_info_create");
     dyld_process_info_for_each_image = (dyld_process_info_for_each_image_t)dlsym(
@@ -43,39 +64,110 @@ MachProcess::MachProcess(std::string exec)
         RTLD_DEFAULT, "_dyld_process_info_get_cache");
   }
 
-void MachProcess::FindAllImages() {
+// Maps the shared cache the target uses, so images that come from it are
+// parsed out of the mapping instead of the target's memory. The cache stays
+// open across attaches as long as its UUID matches.
+void MachProcess::OpenSharedCache(void *Info) {
+  if (!dyld_process_info_get_cache) {
+    return;
+  }
+
+  dyld_process_cache_info CacheInfo;
+  dyld_process_info_get_cache(Info, &CacheInfo);
+  if (CacheInfo.noCache) {
+    Cache.Close();
+    return;
+  }
+
+  if (!Cache.HasUUID(CacheInfo.cacheUUID)) {
+    Cache.Close();
+    for (auto Dir : SharedCacheDirs) {
+      for (auto Name : SharedCacheNames) {
+        std::string Path = std::string(Dir) + Name;
+        if (access(Path.c_str(), R_OK)) {
+          continue;
+        }
+        if (Cache.Open(Path) && Cache.HasUUID(CacheInfo.cacheUUID)) {
+          break;
+        }
+        Cache.Close();
+      }
+      if (Cache.IsOpen()) {
+        break;
+      }
+    }
+  }
+
+  if (!Cache.IsOpen()) {
+    PRINT_DEBUG("Could not find the shared cache the target uses");
+    return;
+  }
+
+  Cache.SetSlide(CacheInfo.cacheBaseAddress - Cache.GetBaseAddress());
+}
+
+void MachProcess::UpdateImages(
+    std::vector<std::shared_ptr<MachImage64>> &Added,
+    std::vector<std::shared_ptr<MachImage64>> &Removed) {
   kern_return_t kern_ret;
   dyld_process_info Info =
     dyld_process_info_create(Task.GetPort(), 0, &kern_ret);
+  if (!Info) {
+    Error Err(MAD_ERROR_PROCESS);
+    Err.Log("Could not read the images of the target");
+    return;
+  }
+  OpenSharedCache(Info);
+
+  // An image stays at its mach header until it is unloaded, whatever dyld
+  // did not list is gone. Blocks capture by value, hence the pointers.
+  std::map<uint64_t, std::shared_ptr<MachImage64>> Known;
+  for (auto &Image : Images) {
+    Known.emplace(Image->GetAddress(), Image);
+  }
+  auto *Unseen = &Known;
+  auto *New = &Added;
   dyld_process_info_for_each_image(Info, ^(uint64_t mach_header_addr,
         const uuid_t, const char *path) {
+      if (Unseen->erase(mach_header_addr)) {
+        return;
+      }
       // N.B. Why the fuck I cannot use move-constructor here?
       PRINT_DEBUG("Process image", path, "at", HEX(mach_header_addr));
-      auto Image = std::make_shared<MachImage64>(path, Task, mach_header_addr);
-      Image->Scan();
-      ImagesByName.insert({path, Image});
-      auto Type = Image->GetType();
-      if (!ImagesByType.count(Type)) {
-      ImagesByType.insert({Type, {}});
+      auto InCache = Cache.Contains(mach_header_addr) ? &Cache : nullptr;
+      auto Image = std::make_shared<MachImage64>(path, Task, mach_header_addr,
+                                                 InCache, &SymbolIndex);
+      // Corrupted images are left out rather than half indexed
+      if (!Image->Scan()) {
+        Error Err(MAD_ERROR_PARSER);
+        Err.Log("Could not parse image", path);
+        return;
       }
-      ImagesByType[Type].push_back(Image);
-      Images.push_back(Image);
-
+      AddImage(Image);
+      New->push_back(Image);
       });
   dyld_process_info_release(Info);
   // for (auto &pair : ImagesByName) {
   //   auto &Image = pair.second;
   //   auto &SymbolTable = Image->GetSymbolTable();
-  //   for (auto Entry : SymbolTable.GetSymbols()) {
-  //     auto Section = Entry->Raw.n_sect ?
-  //     Image->GetSectionByIndex(Entry->Raw.n_sect) : nullptr;
-  //     PRINT_DEBUG("SYMBOL type: ", HEX(Entry->Raw.n_type),
+  //   auto &Symbols = SymbolTable.GetSymbols();
+  //   for (uint32_t i = 0; i < Symbols.GetSize(); ++i) {
+  //     SymbolRef Entry(&Symbols, i);
+  //     auto Section = Entry.GetSectionNumber() ?
+  //     Image->GetSectionByIndex(Entry.GetSectionNumber()) : nullptr;
+  //     PRINT_DEBUG("SYMBOL type: ", HEX(Entry.GetType()),
   //                      ", sect: ", (Section ? Section->Name : "-"),
-  //                      ", desc: ", HEX(Entry->Raw.n_desc),
-  //                     ", value: ", HEX(Entry->Raw.n_value),
-  //                             " ", Entry->Name);
+  //                      ", desc: ", HEX(Entry.GetDesc()),
+  //                     ", value: ", HEX(Entry.GetValue()),
+  //                             " ", Entry.GetName());
   //   }
   // }
+
+  for (auto &Entry : Known) {
+    PRINT_DEBUG("Process image", Entry.second->GetPath(), "unloaded");
+    RemoveImage(Entry.second);
+    Removed.push_back(Entry.second);
+  }
 }
 
 // TODO: ACTUALLY... use stream buffer here
@@ -87,6 +179,38 @@ vm_size_t MachProcess::ReadMemory(vm_address_t address, vm_size_t size,
   return bytes;
 }
 
+bool MachProcess::ReadPointer(uint64_t Address, uint64_t &Value) {
+  ChainedFixups::Fixup Fixup;
+  auto Image = ImagesByAddress.FindImage(Address);
+  if (Image && Image->GetFixup(Address, Fixup)) {
+    if (!Fixup.IsBind) {
+      Value = Fixup.GetRebased(Image->GetSlide());
+      return true;
+    }
+
+    auto Import = Image->GetImport(Fixup.Target);
+    uint64_t Target;
+    if (Import && Imports.Resolve(*Image, Import->LibraryOrdinal,
+                                  Import->Name, Target)) {
+      Value = Target + Import->Addend + Fixup.Addend;
+      return true;
+    }
+    // Weak imports no loaded image exports are null, dyld binds them to zero
+    if (Import && Import->IsWeak) {
+      Value = 0;
+      return true;
+    }
+  }
+
+  // Not a fixup, or one resolved to something the exports do not cover
+  uint64_t Raw = 0;
+  if (Memory.Read(Address, sizeof(Raw), &Raw) != sizeof(Raw)) {
+    return false;
+  }
+  Value = Raw;
+  return true;
+}
+
 // TODO: This method must not overwrite existing breakpoints. It will write
 // memory first then re apply enabled breakpoints
 vm_size_t MachProcess::WriteMemory(vm_address_t address, vm_offset_t data,
@@ -120,12 +244,14 @@ int MachProcess::Execute() {
 bool MachProcess::Attach() {
   assert(PID);
   Task.Attach(PID);
-  FindAllImages();
+  std::vector<std::shared_ptr<MachImage64>> Added, Removed;
+  UpdateImages(Added, Removed);
   return true;
 }
 
 void MachProcess::Detach() {
   assert(PID);
+  ClearImages();
   Task.Detach();
 }
 
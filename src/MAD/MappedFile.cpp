@@ -0,0 +1,80 @@
+// System
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// MAD
+#include "MAD/Error.hpp"
+#include "MAD/MappedFile.hpp"
+
+using namespace mad;
+
+MappedFile::MappedFile(MappedFile &&Other)
+    : Path(std::move(Other.Path)), FD(Other.FD), Data(Other.Data),
+      Size(Other.Size) {
+  Other.FD = -1;
+  Other.Data = nullptr;
+  Other.Size = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&Other) {
+  if (this != &Other) {
+    Close();
+    Path = std::move(Other.Path);
+    FD = Other.FD;
+    Data = Other.Data;
+    Size = Other.Size;
+    Other.FD = -1;
+    Other.Data = nullptr;
+    Other.Size = 0;
+  }
+  return *this;
+}
+
+bool MappedFile::Open(std::string FilePath) {
+  Close();
+
+  int File = open(FilePath.c_str(), O_RDONLY);
+  if (File < 0) {
+    Error::FromErrno().Log("Could not open", FilePath);
+    return false;
+  }
+
+  struct stat Stat;
+  if (fstat(File, &Stat) < 0) {
+    Error::FromErrno().Log("Could not stat", FilePath);
+    close(File);
+    return false;
+  }
+
+  // mmap refuses zero-length mappings, an empty file is just an empty view
+  void *Mapping = nullptr;
+  if (Stat.st_size) {
+    Mapping = mmap(nullptr, Stat.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+    if (Mapping == MAP_FAILED) {
+      Error::FromErrno().Log("Could not map", FilePath);
+      close(File);
+      return false;
+    }
+  }
+
+  Path = FilePath;
+  FD = File;
+  Data = Mapping;
+  Size = Stat.st_size;
+
+  return true;
+}
+
+void MappedFile::Close() {
+  if (Data) {
+    munmap(Data, Size);
+  }
+  if (FD >= 0) {
+    close(FD);
+  }
+  FD = -1;
+  Data = nullptr;
+  Size = 0;
+}
@@ -1,4 +1,5 @@
 #include "MAD/Debug.hpp"
+#include "MAD/Error.hpp"
 #include "MAD/ObjectFile.hpp"
 #include <MAD/MachOParser.hpp>
 
@@ -8,22 +9,44 @@ bool ObjectFile::Parse() {
   PRINT_DEBUG("Parsing MachO data from ", Path);
 
   uint64_t loadptr = 0;
-  Input.seekg(loadptr);
-  Input.read((char *)&Header, sizeof(mach_header_64));
+  if (!Input.ReadAt(loadptr, Header)) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("No MachO header in", Path);
+    return false;
+  }
   loadptr += sizeof(mach_header_64);
 
   // Remove capability bits
   Header.cpusubtype &= ~CPU_SUBTYPE_MASK;
 
+  // Commands are read only within sizeofcmds, however many ncmds claims
+  uint64_t CommandsEnd = loadptr + Header.sizeofcmds;
+  auto Commands = Input.Slice(0, CommandsEnd);
+  if (Commands.GetSize() != CommandsEnd) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Truncated load commands in", Path);
+    return false;
+  }
+
   for (uint32_t i = 0; i < Header.ncmds; ++i) {
     load_command loadcmd;
-    Input.seekg(loadptr);
-    Input.read((char *)&loadcmd, sizeof(load_command));
-    Input.seekg(loadptr);
+    if (!Commands.ReadAt(loadptr, loadcmd) ||
+        loadcmd.cmdsize < sizeof(load_command) ||
+        !Commands.Contains(loadptr, loadcmd.cmdsize)) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Faild to parse", Path, "at", loadptr);
+      return false;
+    }
+    // Whatever is read below has to be within the command
+    auto Command = Commands.Slice(loadptr, loadcmd.cmdsize);
 
     if (loadcmd.cmd == LC_SEGMENT_64) {
       segment_command_64 segcmd;
-      Input.read((char *)&segcmd, sizeof(segment_command_64));
+      if (!Command.ReadAt(0, segcmd)) {
+        Error Err(MAD_ERROR_PARSER);
+        Err.Log("Malformed segment in", Path, "at", loadptr);
+        return false;
+      }
       Segment segment;
       segment.name = std::string(segcmd.segname, 16);
       segment.vmaddr = segcmd.vmaddr;
@@ -40,7 +63,11 @@ bool ObjectFile::Parse() {
 
     if (loadcmd.cmd == LC_UUID) {
       uuid_command uuidcmd;
-      Input.read((char *)&uuidcmd, sizeof(uuid_command));
+      if (!Command.ReadAt(0, uuidcmd)) {
+        Error Err(MAD_ERROR_PARSER);
+        Err.Log("Malformed UUID in", Path, "at", loadptr);
+        return false;
+      }
       uuid_copy(UUID, uuidcmd.uuid);
     }
 
@@ -48,7 +75,11 @@ bool ObjectFile::Parse() {
                          loadcmd.cmd == LC_VERSION_MIN_MACOSX;
     if (loadcmd_known) {
       version_min_command vercmd;
-      Input.read((char *)&vercmd, sizeof(version_min_command));
+      if (!Command.ReadAt(0, vercmd)) {
+        Error Err(MAD_ERROR_PARSER);
+        Err.Log("Malformed version in", Path, "at", loadptr);
+        return false;
+      }
       switch (loadcmd.cmd) {
       case LC_VERSION_MIN_IPHONEOS:
         MinVersionOsName = "iphoneos";
@@ -30,6 +30,7 @@ Prompt::Prompt(std::string Name) : Name(Name) {
   AddCommand(std::make_shared<PromptCmdBreakpointSet>());
   AddCommand(std::make_shared<PromptCmdProcessRun>());
   AddCommand(std::make_shared<PromptCmdProcessContinue>());
+  AddCommand(std::make_shared<PromptCmdThreadBacktrace>());
 }
 
 static inline std::deque<std::string> Tokenize(std::string String,
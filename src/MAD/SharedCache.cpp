@@ -0,0 +1,340 @@
+// Std
+#include <algorithm>
+#include <cstring>
+
+// MAD
+#include "MAD/Error.hpp"
+#include "MAD/SharedCache.hpp"
+
+using namespace mad;
+
+static_assert(offsetof(SharedCacheHeader, LocalSymbolsOffset) == 72, "");
+static_assert(offsetof(SharedCacheHeader, Platform) == 216, "");
+static_assert(offsetof(SharedCacheHeader, SubCacheArrayOffset) == 392, "");
+static_assert(offsetof(SharedCacheHeader, ImagesOffset) == 448, "");
+static_assert(offsetof(SharedCacheHeader, CacheSubType) == 456, "");
+static_assert(sizeof(SharedCacheMappingInfo) == 32, "");
+static_assert(sizeof(SharedCacheImageInfo) == 32, "");
+static_assert(sizeof(SharedCacheLocalSymbolsEntry64) == 16, "");
+static_assert(sizeof(SharedCacheSubCacheEntry) == 56, "");
+
+#define SC_MAGIC_PREFIX "dyld_v1"
+
+SharedCache::SharedCache() : BaseAddress(0), Slide(0), NListSize(0) {
+  memset(&Header, 0, sizeof(Header));
+}
+
+//-----------------------------------------------------------------------------
+// Opening
+//-----------------------------------------------------------------------------
+bool SharedCache::ReadHeader(ByteView View, SharedCacheHeader &Result) {
+  memset(&Result, 0, sizeof(Result));
+
+  uint32_t Size;
+  if (!View.ReadAt(offsetof(SharedCacheHeader, MappingOffset), Size) ||
+      Size < offsetof(SharedCacheHeader, DyldBaseAddress)) {
+    return false;
+  }
+
+  // Newer caches have bigger headers, older ones smaller; whatever is not
+  // there stays zero
+  Size = std::min<uint32_t>(Size, sizeof(Result));
+  auto Bytes = View.At(0, Size);
+  if (!Bytes) {
+    return false;
+  }
+  memcpy(&Result, Bytes, Size);
+
+  return !strncmp(Result.Magic, SC_MAGIC_PREFIX, strlen(SC_MAGIC_PREFIX));
+}
+
+bool SharedCache::OpenFile(std::string FilePath,
+                           SharedCacheHeader &FileHeader) {
+  File Next;
+  if (!Next.Mapping.Open(FilePath)) {
+    return false;
+  }
+
+  auto View = Next.Mapping.GetView();
+  if (!ReadHeader(View, FileHeader)) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Not a shared cache:", FilePath);
+    return false;
+  }
+
+  uint64_t Offset = FileHeader.MappingOffset;
+  for (uint32_t i = 0; i < FileHeader.MappingCount; ++i) {
+    SharedCacheMappingInfo Mapping;
+    if (!View.ReadAt(Offset, Mapping) ||
+        !View.Contains(Mapping.FileOffset, Mapping.Size)) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed mapping", i, "in", FilePath);
+      return false;
+    }
+    Next.Mappings.push_back(Mapping);
+    Offset += sizeof(Mapping);
+  }
+
+  Files.push_back(std::move(Next));
+  return true;
+}
+
+bool SharedCache::OpenSubCaches() {
+  auto View = Files.front().Mapping.GetView();
+
+  // Before the entries got their own file suffix sub-caches were just
+  // numbered
+  bool IsV1 =
+      Header.MappingOffset <= offsetof(SharedCacheHeader, CacheSubType);
+  uint64_t EntrySize = IsV1 ? sizeof(SharedCacheSubCacheEntryV1)
+                            : sizeof(SharedCacheSubCacheEntry);
+
+  for (uint32_t i = 0; i < Header.SubCacheArrayCount; ++i) {
+    uint64_t Offset = Header.SubCacheArrayOffset + i * EntrySize;
+    SharedCacheSubCacheEntry Entry = {};
+    bool Good;
+    if (IsV1) {
+      SharedCacheSubCacheEntryV1 Old = {};
+      Good = View.ReadAt(Offset, Old);
+      if (Good) {
+        memcpy(Entry.UUID, Old.UUID, sizeof(Old.UUID));
+        Entry.CacheVMOffset = Old.CacheVMOffset;
+      }
+    } else {
+      Good = View.ReadAt(Offset, Entry);
+    }
+    if (!Good) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed sub-cache entry", i, "in", Path);
+      return false;
+    }
+
+    auto SuffixSize = strnlen(Entry.FileSuffix, sizeof(Entry.FileSuffix));
+    std::string Suffix = IsV1 ? "." + std::to_string(i + 1)
+                              : std::string(Entry.FileSuffix, SuffixSize);
+
+    SharedCacheHeader SubHeader;
+    if (!OpenFile(Path + Suffix, SubHeader)) {
+      return false;
+    }
+    if (memcmp(SubHeader.UUID, Entry.UUID, sizeof(Entry.UUID))) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Sub-cache UUID mismatch:", Path + Suffix);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool SharedCache::ReadImages() {
+  auto View = Files.front().Mapping.GetView();
+
+  // Since the header got the new fields the old ones are zero
+  uint64_t Offset = Header.ImagesCount ? Header.ImagesOffset
+                                       : Header.ImagesOffsetOld;
+  uint32_t Count = Header.ImagesCount ? Header.ImagesCount
+                                      : Header.ImagesCountOld;
+
+  Images.reserve(Count);
+  for (uint32_t i = 0; i < Count; ++i) {
+    SharedCacheImageInfo Info;
+    if (!View.ReadAt(Offset + i * sizeof(Info), Info) ||
+        Info.PathFileOffset >= View.GetSize()) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed image info", i, "in", Path);
+      return false;
+    }
+    Images.push_back({Info.Address, View.StringAt(Info.PathFileOffset)});
+  }
+
+  std::sort(Images.begin(), Images.end(), [](const Image &A, const Image &B) {
+    return A.Address < B.Address;
+  });
+
+  return true;
+}
+
+bool SharedCache::ReadLocalSymbols(const File &Source,
+                                   const SharedCacheHeader &Owner) {
+  auto Symbols = Source.Mapping.GetView().Slice(Owner.LocalSymbolsOffset,
+                                                Owner.LocalSymbolsSize);
+  SharedCacheLocalSymbolsInfo Info;
+  if (!Symbols.ReadAt(0, Info)) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Malformed local symbols in", Source.Mapping.GetPath());
+    return false;
+  }
+
+  LocalNList = Symbols.Slice(Info.NListOffset,
+                             uint64_t(Info.NListCount) * NListSize);
+  LocalStrings = Symbols.Slice(Info.StringsOffset, Info.StringsSize);
+
+  // Entries grew 64-bit dylib offsets together with split caches
+  bool Is64 = Owner.MappingOffset >= offsetof(SharedCacheHeader,
+                                              SymbolFileUUID);
+  LocalEntries.reserve(Info.EntriesCount);
+  for (uint32_t i = 0; i < Info.EntriesCount; ++i) {
+    LocalEntry Entry;
+    bool Good;
+    if (Is64) {
+      SharedCacheLocalSymbolsEntry64 Raw;
+      Good = Symbols.ReadAt(Info.EntriesOffset + i * sizeof(Raw), Raw);
+      Entry = {Raw.DylibOffset, Raw.NListStartIndex, Raw.NListCount};
+    } else {
+      SharedCacheLocalSymbolsEntry32 Raw;
+      Good = Symbols.ReadAt(Info.EntriesOffset + i * sizeof(Raw), Raw);
+      Entry = {Raw.DylibOffset, Raw.NListStartIndex, Raw.NListCount};
+    }
+    if (!Good) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed local symbols entry", i, "in",
+              Source.Mapping.GetPath());
+      return false;
+    }
+    LocalEntries.push_back(Entry);
+  }
+
+  std::sort(LocalEntries.begin(), LocalEntries.end());
+
+  return true;
+}
+
+bool SharedCache::Open(std::string CachePath) {
+  Close();
+  Path = CachePath;
+
+  if (!OpenFile(Path, Header) || Files.front().Mappings.empty()) {
+    Close();
+    return false;
+  }
+
+  BaseAddress = Files.front().Mappings.front().Address;
+
+  // Magic is "dyld_v1" followed by the right-aligned architecture name
+  std::string_view Arch(Header.Magic, strnlen(Header.Magic, 16));
+  Arch.remove_prefix(std::min(Arch.find_first_not_of(" ", 7), Arch.size()));
+  bool Is32 = Arch == "i386" || Arch == "arm64_32" ||
+              Arch.substr(0, 5) == "armv7";
+  NListSize = Is32 ? 12 : 16;
+
+  if (!OpenSubCaches() || !ReadImages()) {
+    Close();
+    return false;
+  }
+
+  // Local symbols either live in the cache itself or, with split caches, in
+  // a separate file
+  static const uint8_t NoUUID[16] = {};
+  if (memcmp(Header.SymbolFileUUID, NoUUID, sizeof(NoUUID))) {
+    SharedCacheHeader SymbolsHeader;
+    if (OpenFile(Path + ".symbols", SymbolsHeader) &&
+        !memcmp(SymbolsHeader.UUID, Header.SymbolFileUUID, 16)) {
+      ReadLocalSymbols(Files.back(), SymbolsHeader);
+    }
+  } else if (Header.LocalSymbolsSize) {
+    ReadLocalSymbols(Files.front(), Header);
+  }
+
+  return true;
+}
+
+void SharedCache::Close() {
+  Files.clear();
+  Images.clear();
+  LocalEntries.clear();
+  Indexes.clear();
+  LocalNList = ByteView();
+  LocalStrings = ByteView();
+  memset(&Header, 0, sizeof(Header));
+  BaseAddress = 0;
+  NListSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+// Lookups
+//-----------------------------------------------------------------------------
+bool SharedCache::HasUUID(const uint8_t *UUID) const {
+  return IsOpen() && !memcmp(Header.UUID, UUID, sizeof(Header.UUID));
+}
+
+const SharedCache::File *
+SharedCache::FindFile(uint64_t Address,
+                      const SharedCacheMappingInfo *&Mapping) const {
+  for (auto &F : Files) {
+    for (auto &M : F.Mappings) {
+      if (Address >= M.Address && Address - M.Address < M.Size) {
+        Mapping = &M;
+        return &F;
+      }
+    }
+  }
+  return nullptr;
+}
+
+const SharedCache::Image *
+SharedCache::GetImageByAddress(uint64_t Address) const {
+  Address -= Slide;
+  auto It = std::lower_bound(
+      Images.begin(), Images.end(), Address,
+      [](const Image &I, uint64_t Value) { return I.Address < Value; });
+  return It != Images.end() && It->Address == Address ? &*It : nullptr;
+}
+
+const SharedCache::Image *
+SharedCache::GetImageByPath(std::string_view ImagePath) const {
+  for (auto &I : Images) {
+    if (I.Path == ImagePath) {
+      return &I;
+    }
+  }
+  return nullptr;
+}
+
+bool SharedCache::Contains(uint64_t Address) const {
+  const SharedCacheMappingInfo *Mapping;
+  return FindFile(Address - Slide, Mapping);
+}
+
+ByteView SharedCache::GetViewToEnd(uint64_t Address) const {
+  Address -= Slide;
+  const SharedCacheMappingInfo *Mapping;
+  auto F = FindFile(Address, Mapping);
+  if (!F) {
+    return ByteView();
+  }
+  auto Offset = Address - Mapping->Address;
+  return F->Mapping.GetView().Slice(Mapping->FileOffset + Offset,
+                                    Mapping->Size - Offset);
+}
+
+ByteView SharedCache::GetView(uint64_t Address, uint64_t Size) const {
+  auto Tail = GetViewToEnd(Address);
+  return Tail.Contains(0, Size) ? Tail.Slice(0, Size) : ByteView();
+}
+
+bool SharedCache::GetLocalSymbols(uint64_t Address,
+                                  LocalSymbols &Result) const {
+  LocalEntry Key = {Address - Slide - BaseAddress, 0, 0};
+  auto It = std::lower_bound(LocalEntries.begin(), LocalEntries.end(), Key);
+  if (It == LocalEntries.end() || It->DylibOffset != Key.DylibOffset) {
+    return false;
+  }
+
+  Result.NList = LocalNList.Slice(uint64_t(It->NListStartIndex) * NListSize,
+                                  uint64_t(It->NListCount) * NListSize);
+  Result.Strings = LocalStrings;
+  return It->NListCount == 0 || !Result.NList.IsEmpty();
+}
+
+std::shared_ptr<const StringTableIndex>
+SharedCache::GetStringTableIndex(ByteView Strings) const {
+  std::lock_guard<std::mutex> Lock(IndexesMutex);
+  auto &Index = Indexes[{Strings.GetData(), Strings.GetSize()}];
+  if (!Index) {
+    auto Built = std::make_shared<StringTableIndex>();
+    Built->Build(Strings);
+    Index = std::move(Built);
+  }
+  return Index;
+}
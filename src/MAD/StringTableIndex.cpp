@@ -0,0 +1,160 @@
+// Std
+#include <algorithm>
+
+// MAD
+#include "MAD/StringTableIndex.hpp"
+#include "MAD/ThreadPool.hpp"
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#define MAD_STRINGS_X86 1
+#endif
+
+using namespace mad;
+
+// Tables at least this big are hashed on the shared ThreadPool, every chunk
+// covers this many bitmap words
+#define STI_PARALLEL_HASH_THRESHOLD (1u << 20)
+#define STI_PARALLEL_HASH_CHUNK 4096u
+
+//-----------------------------------------------------------------------------
+// Scan kernels
+//
+// Every kernel handles whole 64-byte blocks, i.e. whole bitmap words, starting
+// at the beginning of the table. The tail is left to the scalar kernel.
+//-----------------------------------------------------------------------------
+static void ScanScalar(const char *Data, uint64_t Begin, uint64_t End,
+                       uint64_t *Bitmap) {
+  // memchr is vectorized by libc on every platform we care about
+  const char *Cursor = Data + Begin;
+  const char *Last = Data + End;
+  while (Cursor < Last) {
+    auto Found = static_cast<const char *>(memchr(Cursor, 0, Last - Cursor));
+    if (!Found) {
+      break;
+    }
+    uint64_t Offset = Found - Data;
+    Bitmap[Offset / 64] |= 1ull << (Offset % 64);
+    Cursor = Found + 1;
+  }
+}
+
+#ifdef MAD_STRINGS_X86
+static uint64_t ScanSSE2(const char *Data, uint64_t Size, uint64_t *Bitmap) {
+  const __m128i Zero = _mm_setzero_si128();
+  uint64_t Blocks = Size / 64;
+  for (uint64_t b = 0; b < Blocks; ++b) {
+    const char *Block = Data + b * 64;
+    uint64_t M0 = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Block)), Zero));
+    uint64_t M1 = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Block + 16)), Zero));
+    uint64_t M2 = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Block + 32)), Zero));
+    uint64_t M3 = _mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(Block + 48)), Zero));
+    Bitmap[b] = M0 | (M1 << 16) | (M2 << 32) | (M3 << 48);
+  }
+  return Blocks * 64;
+}
+
+__attribute__((target("avx2"))) static uint64_t
+ScanAVX2(const char *Data, uint64_t Size, uint64_t *Bitmap) {
+  const __m256i Zero = _mm256_setzero_si256();
+  uint64_t Blocks = Size / 64;
+  for (uint64_t b = 0; b < Blocks; ++b) {
+    const char *Block = Data + b * 64;
+    uint32_t Low = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Block)), Zero));
+    uint32_t High = _mm256_movemask_epi8(_mm256_cmpeq_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Block + 32)),
+        Zero));
+    Bitmap[b] = uint64_t(Low) | (uint64_t(High) << 32);
+  }
+  return Blocks * 64;
+}
+#endif
+
+void StringTableIndex::ScanTerminators(const char *Data, uint64_t Size,
+                                       uint64_t *Bitmap,
+                                       StringScanKernel Kernel) {
+  uint64_t Done = 0;
+
+#ifdef MAD_STRINGS_X86
+  if (Kernel == StringScanKernel::BEST) {
+    Kernel = __builtin_cpu_supports("avx2") ? StringScanKernel::AVX2
+                                            : StringScanKernel::SSE2;
+  }
+  switch (Kernel) {
+  case StringScanKernel::AVX2:
+    Done = ScanAVX2(Data, Size, Bitmap);
+    break;
+  case StringScanKernel::SSE2:
+    Done = ScanSSE2(Data, Size, Bitmap);
+    break;
+  default:
+    break;
+  }
+#else
+  (void)Kernel;
+#endif
+
+  ScanScalar(Data, Done, Size, Bitmap);
+}
+
+//-----------------------------------------------------------------------------
+// Index
+//-----------------------------------------------------------------------------
+void StringTableIndex::Build(ByteView StringTable, StringScanKernel Kernel) {
+  Strings = StringTable;
+  Hashes.clear();
+
+  auto Words = (Strings.GetSize() + 63) / 64;
+  Terminators.assign(Words, 0);
+  ScanTerminators(Strings.GetData(), Strings.GetSize(), Terminators.data(),
+                  Kernel);
+
+  Ranks.resize(Words);
+  uint32_t Rank = 0;
+  for (uint64_t Word = 0; Word < Words; ++Word) {
+    Ranks[Word] = Rank;
+    Rank += __builtin_popcountll(Terminators[Word]);
+  }
+}
+
+void StringTableIndex::BuildHashes() {
+  Hashes.resize(GetStringCount());
+
+  // Every chunk hashes the strings whose terminators fall into its words. The
+  // start of the first one is found by looking back for the previous
+  // terminator, which may belong to another chunk.
+  auto HashWords = [this](uint64_t Begin, uint64_t End) {
+    uint64_t Start = 0;
+    for (uint64_t Word = Begin; Word-- > 0;) {
+      if (Terminators[Word]) {
+        Start = Word * 64 + 63 - __builtin_clzll(Terminators[Word]) + 1;
+        break;
+      }
+    }
+
+    auto Data = Strings.GetData();
+    for (uint64_t Word = Begin; Word < End; ++Word) {
+      auto Bits = Terminators[Word];
+      auto Rank = Ranks[Word];
+      while (Bits) {
+        uint64_t Terminator = Word * 64 + __builtin_ctzll(Bits);
+        Hashes[Rank++] =
+            Hash(std::string_view(Data + Start, Terminator - Start));
+        Start = Terminator + 1;
+        Bits &= Bits - 1;
+      }
+    }
+  };
+
+  if (Strings.GetSize() >= STI_PARALLEL_HASH_THRESHOLD) {
+    ThreadPool::GetShared().ParallelFor(Terminators.size(),
+                                        STI_PARALLEL_HASH_CHUNK, HashWords);
+  } else {
+    HashWords(0, Terminators.size());
+  }
+}
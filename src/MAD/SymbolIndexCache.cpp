@@ -0,0 +1,289 @@
+// System
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Std
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// MAD
+#include "MAD/Debug.hpp"
+#include "MAD/Error.hpp"
+#include "MAD/MappedFile.hpp"
+#include "MAD/SymbolIndexCache.hpp"
+
+using namespace mad;
+
+#define SI_MAGIC "MADSYMIX"
+#define SI_EXTENSION ".symidx"
+
+namespace {
+
+struct SymbolIndexHeader {
+  char Magic[8];
+  uint32_t Version;
+  uint32_t FunctionCount;
+  SymbolIndexKey Key;
+  // Distance from __TEXT to the end of the last function
+  uint64_t FunctionsLimit;
+};
+
+// Columns follow the header in this order, each aligned so that it can be
+// used in place
+enum SymbolIndexColumn {
+  SI_VALUES,
+  SI_NAME_OFFSETS,
+  SI_NAME_LENGTHS,
+  SI_FLAGS,
+  SI_DESCS,
+  SI_TYPES,
+  SI_SECTIONS,
+  SI_STRINGS,
+  SI_FUNCTIONS,
+  SI_END
+};
+
+struct SymbolIndexLayout {
+  uint64_t Sizes[SI_END];
+  uint64_t Offsets[SI_END + 1];
+
+  SymbolIndexLayout(uint64_t SymbolCount, uint64_t StringsSize,
+                    uint64_t FunctionCount)
+      : Sizes{SymbolCount * sizeof(uint64_t), SymbolCount * sizeof(uint32_t),
+              SymbolCount * sizeof(uint32_t), SymbolCount * sizeof(uint32_t),
+              SymbolCount * sizeof(uint16_t), SymbolCount * sizeof(uint8_t),
+              SymbolCount * sizeof(uint8_t),  StringsSize,
+              FunctionCount * sizeof(uint32_t)} {
+    uint64_t Offset = sizeof(SymbolIndexHeader);
+    for (unsigned i = 0; i < SI_END; ++i) {
+      Offset = (Offset + 7) & ~uint64_t(7);
+      Offsets[i] = Offset;
+      Offset += Sizes[i];
+    }
+    Offsets[SI_END] = Offset;
+  }
+};
+
+} // namespace
+
+static_assert(sizeof(SymbolIndexKey) == 40, "");
+static_assert(sizeof(SymbolIndexHeader) % 8 == 0, "");
+
+template <typename T>
+static void ViewColumn(Column<T> &Target, ByteView File, uint64_t Offset,
+                       uint64_t Count, std::shared_ptr<const void> Storage) {
+  Target.View(reinterpret_cast<const T *>(File.GetData() + Offset), Count,
+              std::move(Storage));
+}
+
+static bool WriteAll(int FD, const void *Data, uint64_t Size) {
+  auto Bytes = static_cast<const char *>(Data);
+  while (Size) {
+    auto Written = write(FD, Bytes, Size);
+    if (Written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    Bytes += Written;
+    Size -= Written;
+  }
+  return true;
+}
+
+// mkdir -p
+static bool MakeDirectories(const std::string &Path) {
+  for (size_t i = 1; i <= Path.size(); ++i) {
+    if (i != Path.size() && Path[i] != '/') {
+      continue;
+    }
+    auto Prefix = Path.substr(0, i);
+    if (mkdir(Prefix.c_str(), 0755) < 0 && errno != EEXIST) {
+      Error::FromErrno().Log("Could not create", Prefix);
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string SymbolIndexCache::GetDefaultDirectory() {
+  if (auto Dir = getenv("MAD_SYMBOL_INDEX_DIR")) {
+    return Dir;
+  }
+#ifdef __APPLE__
+  if (auto Home = getenv("HOME")) {
+    return std::string(Home) + "/Library/Caches/mad/symbols";
+  }
+#else
+  if (auto Caches = getenv("XDG_CACHE_HOME")) {
+    return std::string(Caches) + "/mad/symbols";
+  }
+  if (auto Home = getenv("HOME")) {
+    return std::string(Home) + "/.cache/mad/symbols";
+  }
+#endif
+  return "";
+}
+
+// The same form dwarfdump --uuid prints
+std::string SymbolIndexCache::GetPath(const SymbolIndexKey &Key) const {
+  char Name[37];
+  auto U = Key.UUID;
+  snprintf(Name, sizeof(Name),
+           "%02X%02X%02X%02X-%02X%02X-%02X%02X-%02X%02X-"
+           "%02X%02X%02X%02X%02X%02X",
+           U[0], U[1], U[2], U[3], U[4], U[5], U[6], U[7], U[8], U[9], U[10],
+           U[11], U[12], U[13], U[14], U[15]);
+  return Directory + "/" + Name + SI_EXTENSION;
+}
+
+bool SymbolIndexCache::Load(const SymbolIndexKey &Key, uint64_t Slide,
+                            SymbolStore &Store,
+                            FunctionStarts &Functions) const {
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  // Not having an index yet is the common case, nothing to complain about
+  auto Path = GetPath(Key);
+  if (access(Path.c_str(), R_OK)) {
+    return false;
+  }
+
+  auto Mapping = std::make_shared<MappedFile>();
+  if (!Mapping->Open(Path)) {
+    return false;
+  }
+  auto View = Mapping->GetView();
+
+  SymbolIndexHeader Header;
+  if (!View.ReadAt(0, Header) ||
+      memcmp(Header.Magic, SI_MAGIC, sizeof(Header.Magic)) ||
+      Header.Version != MO_SYMBOL_INDEX_VERSION) {
+    PRINT_DEBUG("Ignoring symbol index of another version", Path);
+    return false;
+  }
+
+  if (memcmp(&Header.Key, &Key, sizeof(Key))) {
+    PRINT_DEBUG("Ignoring symbol index of another build", Path);
+    return false;
+  }
+
+  uint64_t Count = Key.SymbolCount;
+  SymbolIndexLayout Layout(Count, Key.StringTableSize, Header.FunctionCount);
+  if (View.GetSize() < Layout.Offsets[SI_END]) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Truncated symbol index", Path);
+    return false;
+  }
+
+  // Names are handed out without further checks, so a damaged file must not
+  // point them outside of the strings
+  auto NameOffsets = reinterpret_cast<const uint32_t *>(
+      View.GetData() + Layout.Offsets[SI_NAME_OFFSETS]);
+  auto NameLengths = reinterpret_cast<const uint32_t *>(
+      View.GetData() + Layout.Offsets[SI_NAME_LENGTHS]);
+  for (uint64_t i = 0; i < Count; ++i) {
+    if (uint64_t(NameOffsets[i]) + NameLengths[i] > Key.StringTableSize) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed symbol index", Path);
+      return false;
+    }
+  }
+
+  ViewColumn(Store.Values, View, Layout.Offsets[SI_VALUES], Count, Mapping);
+  ViewColumn(Store.NameOffsets, View, Layout.Offsets[SI_NAME_OFFSETS], Count,
+             Mapping);
+  ViewColumn(Store.NameLengths, View, Layout.Offsets[SI_NAME_LENGTHS], Count,
+             Mapping);
+  ViewColumn(Store.Flags, View, Layout.Offsets[SI_FLAGS], Count, Mapping);
+  ViewColumn(Store.Descs, View, Layout.Offsets[SI_DESCS], Count, Mapping);
+  ViewColumn(Store.Types, View, Layout.Offsets[SI_TYPES], Count, Mapping);
+  ViewColumn(Store.Sections, View, Layout.Offsets[SI_SECTIONS], Count,
+             Mapping);
+  Store.Strings =
+      View.Slice(Layout.Offsets[SI_STRINGS], Key.StringTableSize);
+  Store.StringIndex = nullptr;
+  Store.Mapping = Mapping;
+  Store.Slide = Slide;
+  Store.IsTwoLevel = Key.Kind & MO_SYMBOL_INDEX_TWO_LEVEL;
+
+  Column<uint32_t> Starts;
+  ViewColumn(Starts, View, Layout.Offsets[SI_FUNCTIONS], Header.FunctionCount,
+             Mapping);
+  uint64_t Text = Key.TextAddress + Slide;
+  Functions.Assign(Text, Text + Header.FunctionsLimit, std::move(Starts));
+
+  return true;
+}
+
+bool SymbolIndexCache::Save(const SymbolIndexKey &Key,
+                            const SymbolStore &Store,
+                            const FunctionStarts &Functions) const {
+  if (!IsEnabled()) {
+    return false;
+  }
+
+  assert(Store.GetSize() == Key.SymbolCount &&
+         Store.Strings.GetSize() == Key.StringTableSize);
+
+  if (!MakeDirectories(Directory)) {
+    return false;
+  }
+
+  SymbolIndexHeader Header;
+  memset(&Header, 0, sizeof(Header));
+  memcpy(Header.Magic, SI_MAGIC, sizeof(Header.Magic));
+  Header.Version = MO_SYMBOL_INDEX_VERSION;
+  Header.FunctionCount = Functions.GetSize();
+  Header.Key = Key;
+  Header.FunctionsLimit =
+      Functions.IsEmpty() ? 0 : Functions.GetLimit() - Functions.GetBase();
+
+  uint64_t Count = Key.SymbolCount;
+  SymbolIndexLayout Layout(Count, Key.StringTableSize, Header.FunctionCount);
+
+  const void *Columns[SI_END] = {
+      Store.Values.GetData(), Store.NameOffsets.GetData(),
+      Store.NameLengths.GetData(), Store.Flags.GetData(),
+      Store.Descs.GetData(), Store.Types.GetData(),
+      Store.Sections.GetData(), Store.Strings.GetData(),
+      Functions.GetOffsets().GetData()};
+
+  // Readers only ever see a complete file, whoever renames last wins
+  static std::atomic<unsigned> Serial;
+  auto Path = GetPath(Key);
+  auto Temporary = Path + "." + std::to_string(getpid()) + "." +
+                   std::to_string(Serial++);
+
+  int FD = open(Temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (FD < 0) {
+    Error::FromErrno().Log("Could not create", Temporary);
+    return false;
+  }
+
+  static const char Padding[8] = {};
+  bool Good = WriteAll(FD, &Header, sizeof(Header));
+  uint64_t Position = sizeof(Header);
+  for (unsigned i = 0; Good && i < SI_END; ++i) {
+    Good = WriteAll(FD, Padding, Layout.Offsets[i] - Position) &&
+           WriteAll(FD, Columns[i], Layout.Sizes[i]);
+    Position = Layout.Offsets[i] + Layout.Sizes[i];
+  }
+
+  if (close(FD) < 0) {
+    Good = false;
+  }
+  if (!Good || rename(Temporary.c_str(), Path.c_str()) < 0) {
+    Error::FromErrno().Log("Could not write", Path);
+    unlink(Temporary.c_str());
+    return false;
+  }
+
+  return true;
+}
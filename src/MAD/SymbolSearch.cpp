@@ -0,0 +1,548 @@
+// Std
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+
+// MAD
+#include "MAD/Error.hpp"
+#include "MAD/SymbolSearch.hpp"
+#include "MAD/ThreadPool.hpp"
+
+#ifdef __SSE2__
+#include <immintrin.h>
+#define MAD_SEARCH_X86 1
+#endif
+
+using namespace mad;
+
+// Tables at least this big are searched on the shared ThreadPool, in chunks
+// of this many bytes; a chunk must cover whole bitmap words
+#define SS_PARALLEL_SCAN_THRESHOLD (1u << 22)
+#define SS_PARALLEL_SCAN_CHUNK (1u << 20)
+
+// Same for the symbols of all the stores together, every piece of a store is
+// this many rows
+#define SS_PARALLEL_ROWS_THRESHOLD 65536u
+#define SS_PARALLEL_ROWS_CHUNK 16384u
+
+//-----------------------------------------------------------------------------
+// Pattern
+//-----------------------------------------------------------------------------
+std::string SymbolPattern::GlobToRegex(std::string_view Glob) {
+  std::string Result = "^";
+  for (size_t i = 0; i < Glob.size(); ++i) {
+    char C = Glob[i];
+    switch (C) {
+    case '*':
+      Result += ".*";
+      break;
+    case '?':
+      Result += '.';
+      break;
+    case '[': {
+      // Copied as is but for the negation, an unterminated one is literal
+      auto Close = Glob.find(']', i + 2);
+      if (Close == std::string_view::npos) {
+        Result += "\\[";
+        break;
+      }
+      Result += '[';
+      auto Body = Glob.substr(i + 1, Close - i - 1);
+      if (Body[0] == '!') {
+        Result += '^';
+        Body.remove_prefix(1);
+      }
+      for (auto B : Body) {
+        if (B == '\\' || B == '[' || B == '^') {
+          Result += '\\';
+        }
+        Result += B;
+      }
+      Result += ']';
+      i = Close;
+      break;
+    }
+    case '\\':
+      if (i + 1 < Glob.size()) {
+        C = Glob[++i];
+      }
+      [[fallthrough]];
+    default:
+      if (strchr("\\^$.|+(){}[]*?", C)) {
+        Result += '\\';
+      }
+      Result += C;
+      break;
+    }
+  }
+  return Result + "$";
+}
+
+// Finds the longest literal of the top level of the expression and whether
+// the expression is nothing but literals and .*. Anything it does not know
+// ends the current literal and makes the expression not simple, which is
+// always safe.
+void SymbolPattern::Analyze(const std::string &Expression) {
+  std::string Run;
+  std::string Piece;
+  Literal.clear();
+  Pieces.clear();
+  IsSimple = true;
+  IsAnchoredBegin = false;
+  IsAnchoredEnd = false;
+
+  auto EndRun = [&]() {
+    if (Run.size() > Literal.size()) {
+      Literal = Run;
+    }
+    Run.clear();
+  };
+  auto NotSimple = [&]() {
+    IsSimple = false;
+    EndRun();
+  };
+  // Skips the quantifier at i, if any, including the lazy mark
+  auto SkipQuantifier = [&](size_t &i) {
+    if (i >= Expression.size()) {
+      return;
+    }
+    char Q = Expression[i];
+    if (Q == '{') {
+      auto Close = Expression.find('}', i);
+      i = Close == std::string::npos ? Expression.size() : Close + 1;
+    } else if (Q == '*' || Q == '+' || Q == '?') {
+      ++i;
+    } else {
+      return;
+    }
+    if (i < Expression.size() && Expression[i] == '?') {
+      ++i;
+    }
+  };
+
+  size_t Size = Expression.size();
+  for (size_t i = 0; i < Size;) {
+    char C = Expression[i];
+    switch (C) {
+    case '^':
+      if (i) {
+        NotSimple();
+      } else {
+        IsAnchoredBegin = true;
+      }
+      ++i;
+      continue;
+    case '$':
+      if (i + 1 != Size) {
+        NotSimple();
+      } else {
+        IsAnchoredEnd = true;
+      }
+      ++i;
+      continue;
+    case '|':
+      // Either side may match, neither has to
+      Literal.clear();
+      Pieces.clear();
+      IsSimple = false;
+      return;
+    case '(': {
+      NotSimple();
+      unsigned Depth = 0;
+      for (; i < Size; ++i) {
+        if (Expression[i] == '\\') {
+          ++i;
+        } else if (Expression[i] == '(') {
+          ++Depth;
+        } else if (Expression[i] == ')' && !--Depth) {
+          break;
+        }
+      }
+      ++i;
+      SkipQuantifier(i);
+      continue;
+    }
+    case '[': {
+      NotSimple();
+      // A leading ] is a member, not the end
+      ++i;
+      if (i < Size && Expression[i] == '^') {
+        ++i;
+      }
+      if (i < Size && Expression[i] == ']') {
+        ++i;
+      }
+      for (; i < Size && Expression[i] != ']'; ++i) {
+        if (Expression[i] == '\\') {
+          ++i;
+        }
+      }
+      ++i;
+      SkipQuantifier(i);
+      continue;
+    }
+    case '.':
+      ++i;
+      if (i < Size && Expression[i] == '*') {
+        SkipQuantifier(i);
+        Pieces.push_back(Piece);
+        Piece.clear();
+        EndRun();
+      } else {
+        NotSimple();
+        SkipQuantifier(i);
+      }
+      continue;
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+      NotSimple();
+      SkipQuantifier(i);
+      continue;
+    case '\\':
+      if (i + 1 < Size && isalnum(Expression[i + 1])) {
+        // Classes, boundaries, back references and escaped code points
+        NotSimple();
+        char E = Expression[i + 1];
+        i += 2;
+        size_t Digits = E == 'x' ? 2 : E == 'u' ? 4 : E == 'c' ? 1 : 0;
+        if (isdigit(E)) {
+          while (i < Size && isdigit(Expression[i])) {
+            ++i;
+          }
+        }
+        i = std::min(Size, i + Digits);
+        SkipQuantifier(i);
+        continue;
+      }
+      if (++i == Size) {
+        continue;
+      }
+      C = Expression[i];
+      break;
+    }
+
+    // A literal character, unless a quantifier makes it optional
+    ++i;
+    char Q = i < Size ? Expression[i] : 0;
+    bool IsRequired = Q == '+' || (Q == '{' && i + 1 < Size &&
+                                   Expression[i + 1] >= '1' &&
+                                   Expression[i + 1] <= '9');
+    if (Q == '*' || Q == '?' || (Q == '{' && !IsRequired)) {
+      NotSimple();
+      SkipQuantifier(i);
+    } else if (IsRequired) {
+      Run += C;
+      NotSimple();
+      SkipQuantifier(i);
+    } else {
+      Run += C;
+      Piece += C;
+    }
+  }
+
+  EndRun();
+  Pieces.push_back(Piece);
+}
+
+bool SymbolPattern::Compile(std::string Pattern, bool IsGlob) {
+  Source = Pattern;
+  auto Expression = IsGlob ? GlobToRegex(Pattern) : Pattern;
+
+  try {
+    Regex = std::regex(Expression, std::regex::ECMAScript |
+                                       std::regex::optimize);
+  } catch (const std::regex_error &E) {
+    Error Err(MAD_ERROR_ARGUMENTS);
+    Err.Log("Invalid pattern", Pattern, E.what());
+    return false;
+  }
+
+  Analyze(Expression);
+  return true;
+}
+
+bool SymbolPattern::MatchSimple(std::string_view Name) const {
+  if (Pieces.size() == 1 && IsAnchoredBegin && IsAnchoredEnd) {
+    return Name == Pieces[0];
+  }
+
+  // Whatever the anchors pin down first, then the rest left to right
+  size_t Begin = 0;
+  size_t End = Name.size();
+  size_t First = 0;
+  size_t Last = Pieces.size();
+  if (IsAnchoredBegin) {
+    auto &P = Pieces.front();
+    if (Name.substr(0, P.size()) != P) {
+      return false;
+    }
+    Begin = P.size();
+    ++First;
+  }
+  if (IsAnchoredEnd && Last > First) {
+    auto &P = Pieces.back();
+    if (End - Begin < P.size() || Name.substr(End - P.size()) != P) {
+      return false;
+    }
+    End -= P.size();
+    --Last;
+  }
+
+  auto Rest = Name.substr(0, End);
+  for (size_t i = First; i < Last; ++i) {
+    auto Found = Rest.find(Pieces[i], Begin);
+    if (Found == std::string_view::npos) {
+      return false;
+    }
+    Begin = Found + Pieces[i].size();
+  }
+  return true;
+}
+
+bool SymbolPattern::Match(std::string_view Name) const {
+  if (IsSimple) {
+    return MatchSimple(Name);
+  }
+  return std::regex_search(Name.begin(), Name.end(), Regex);
+}
+
+//-----------------------------------------------------------------------------
+// Literal kernels
+//
+// Every kernel reports the positions in [Begin, End) the literal starts at and
+// returns where it stopped, the rest is left to the scalar kernel. The literal
+// is at least one byte long and End leaves room for all of it.
+//
+// Vector kernels compare a block against the literal's first byte, the block
+// Length - 1 bytes further against its last byte, and check the bytes in
+// between only where both matched.
+//-----------------------------------------------------------------------------
+static void Mark(uint64_t *Hits, uint64_t Offset) {
+  Hits[Offset / 64] |= 1ull << (Offset % 64);
+}
+
+static void FindScalar(const char *Data, uint64_t Begin, uint64_t End,
+                       std::string_view Literal, uint64_t *Hits) {
+  // memchr is vectorized by libc on every platform we care about
+  const char *Cursor = Data + Begin;
+  const char *Last = Data + End;
+  while (Cursor < Last) {
+    auto Found =
+        static_cast<const char *>(memchr(Cursor, Literal[0], Last - Cursor));
+    if (!Found) {
+      break;
+    }
+    if (!memcmp(Found + 1, Literal.data() + 1, Literal.size() - 1)) {
+      Mark(Hits, Found - Data);
+    }
+    Cursor = Found + 1;
+  }
+}
+
+#ifdef MAD_SEARCH_X86
+static uint64_t FindSSE2(const char *Data, uint64_t Begin, uint64_t End,
+                         std::string_view Literal, uint64_t *Hits) {
+  auto Length = Literal.size();
+  const __m128i First = _mm_set1_epi8(Literal[0]);
+  const __m128i Last = _mm_set1_epi8(Literal[Length - 1]);
+  uint64_t Position = Begin;
+  for (; Position + 16 <= End; Position += 16) {
+    auto Block = reinterpret_cast<const __m128i *>(Data + Position);
+    auto Tail = reinterpret_cast<const __m128i *>(Data + Position + Length - 1);
+    uint32_t Mask = _mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128(Block), First),
+                      _mm_cmpeq_epi8(_mm_loadu_si128(Tail), Last)));
+    while (Mask) {
+      uint64_t Offset = Position + __builtin_ctz(Mask);
+      if (Length <= 2 ||
+          !memcmp(Data + Offset + 1, Literal.data() + 1, Length - 2)) {
+        Mark(Hits, Offset);
+      }
+      Mask &= Mask - 1;
+    }
+  }
+  return Position;
+}
+
+__attribute__((target("avx2"))) static uint64_t
+FindAVX2(const char *Data, uint64_t Begin, uint64_t End,
+         std::string_view Literal, uint64_t *Hits) {
+  auto Length = Literal.size();
+  const __m256i First = _mm256_set1_epi8(Literal[0]);
+  const __m256i Last = _mm256_set1_epi8(Literal[Length - 1]);
+  uint64_t Position = Begin;
+  for (; Position + 32 <= End; Position += 32) {
+    auto Block = reinterpret_cast<const __m256i *>(Data + Position);
+    auto Tail = reinterpret_cast<const __m256i *>(Data + Position + Length - 1);
+    uint32_t Mask = _mm256_movemask_epi8(
+        _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(Block), First),
+                         _mm256_cmpeq_epi8(_mm256_loadu_si256(Tail), Last)));
+    while (Mask) {
+      uint64_t Offset = Position + __builtin_ctz(Mask);
+      if (Length <= 2 ||
+          !memcmp(Data + Offset + 1, Literal.data() + 1, Length - 2)) {
+        Mark(Hits, Offset);
+      }
+      Mask &= Mask - 1;
+    }
+  }
+  return Position;
+}
+#endif
+
+static void FindRange(const char *Data, uint64_t Begin, uint64_t End,
+                      std::string_view Literal, uint64_t *Hits,
+                      StringScanKernel Kernel) {
+  uint64_t Done = Begin;
+
+#ifdef MAD_SEARCH_X86
+  switch (Kernel) {
+  case StringScanKernel::AVX2:
+    Done = FindAVX2(Data, Begin, End, Literal, Hits);
+    break;
+  case StringScanKernel::SSE2:
+    Done = FindSSE2(Data, Begin, End, Literal, Hits);
+    break;
+  default:
+    break;
+  }
+#else
+  (void)Kernel;
+#endif
+
+  FindScalar(Data, Done, End, Literal, Hits);
+}
+
+void SymbolSearch::FindLiteral(const char *Data, uint64_t Size,
+                               std::string_view Literal, uint64_t *Hits,
+                               StringScanKernel Kernel) {
+  if (Literal.empty() || Size < Literal.size()) {
+    return;
+  }
+
+#ifdef MAD_SEARCH_X86
+  if (Kernel == StringScanKernel::BEST) {
+    Kernel = __builtin_cpu_supports("avx2") ? StringScanKernel::AVX2
+                                            : StringScanKernel::SSE2;
+  }
+#endif
+
+  // Positions the whole literal fits after
+  uint64_t End = Size - Literal.size() + 1;
+  auto FindChunks = [&](uint64_t Begin, uint64_t Last) {
+    FindRange(Data, Begin * SS_PARALLEL_SCAN_CHUNK,
+              std::min(End, Last * SS_PARALLEL_SCAN_CHUNK), Literal, Hits,
+              Kernel);
+  };
+
+  uint64_t Chunks = (End + SS_PARALLEL_SCAN_CHUNK - 1) / SS_PARALLEL_SCAN_CHUNK;
+  if (Size >= SS_PARALLEL_SCAN_THRESHOLD) {
+    ThreadPool::GetShared().ParallelFor(Chunks, 1, FindChunks);
+  } else {
+    FindChunks(0, Chunks);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Search
+//-----------------------------------------------------------------------------
+
+// Whether any bit in [From, To] is set
+static bool HasHit(const uint64_t *Hits, uint64_t From, uint64_t To) {
+  auto Word = From / 64;
+  auto Last = To / 64;
+  auto Bits = Hits[Word] & (~0ull << (From % 64));
+  while (Word < Last) {
+    if (Bits) {
+      return true;
+    }
+    Bits = Hits[++Word];
+  }
+  return Bits & (~0ull >> (63 - To % 64));
+}
+
+std::vector<std::vector<uint32_t>>
+SymbolSearch::Search(const SymbolPattern &Pattern,
+                     const std::vector<const SymbolStore *> &Stores) {
+  std::vector<std::vector<uint32_t>> Result(Stores.size());
+  std::string_view Literal = Pattern.GetLiteral();
+
+  // Each table once, however many stores there are over it
+  std::map<std::pair<const char *, uint64_t>, std::vector<uint64_t>> Tables;
+  std::vector<const uint64_t *> Hits(Stores.size());
+  if (!Literal.empty()) {
+    for (size_t i = 0; i < Stores.size(); ++i) {
+      auto &Strings = Stores[i]->Strings;
+      auto Key = std::make_pair(Strings.GetData(), Strings.GetSize());
+      auto It = Tables.find(Key);
+      if (It == Tables.end()) {
+        It = Tables.emplace(Key, std::vector<uint64_t>()).first;
+        It->second.assign((Strings.GetSize() + 63) / 64, 0);
+        FindLiteral(Strings.GetData(), Strings.GetSize(), Literal,
+                    It->second.data());
+      }
+      Hits[i] = It->second.data();
+    }
+  }
+
+  struct Piece {
+    uint32_t Store;
+    uint32_t Begin;
+    uint32_t End;
+  };
+  std::vector<Piece> Pieces;
+  uint64_t Total = 0;
+  for (uint32_t i = 0; i < Stores.size(); ++i) {
+    uint32_t Size = Stores[i]->GetSize();
+    for (uint32_t Begin = 0; Begin < Size; Begin += SS_PARALLEL_ROWS_CHUNK) {
+      Pieces.push_back(
+          {i, Begin, std::min(Size, Begin + SS_PARALLEL_ROWS_CHUNK)});
+    }
+    Total += Size;
+  }
+
+  std::vector<std::vector<uint32_t>> Found(Pieces.size());
+  auto SearchPieces = [&](uint64_t Begin, uint64_t End) {
+    for (auto p = Begin; p < End; ++p) {
+      auto &P = Pieces[p];
+      auto &Store = *Stores[P.Store];
+      auto StoreHits = Hits[P.Store];
+      for (uint32_t Row = P.Begin; Row < P.End; ++Row) {
+        uint32_t Length = Store.NameLengths[Row];
+        if ((Store.Flags[Row] & (MO_SYMBOL_STAB | MO_SYMBOL_DEFINED)) !=
+                MO_SYMBOL_DEFINED ||
+            !Length || Length < Literal.size()) {
+          continue;
+        }
+        if (StoreHits) {
+          uint64_t Offset = Store.NameOffsets[Row];
+          if (!HasHit(StoreHits, Offset, Offset + Length - Literal.size())) {
+            continue;
+          }
+          if (Pattern.IsLiteral()) {
+            Found[p].push_back(Row);
+            continue;
+          }
+        }
+        if (Pattern.Match(Store.GetName(Row))) {
+          Found[p].push_back(Row);
+        }
+      }
+    }
+  };
+
+  if (Total >= SS_PARALLEL_ROWS_THRESHOLD) {
+    ThreadPool::GetShared().ParallelFor(Pieces.size(), 1, SearchPieces);
+  } else {
+    SearchPieces(0, Pieces.size());
+  }
+
+  for (size_t p = 0; p < Pieces.size(); ++p) {
+    auto &Rows = Result[Pieces[p].Store];
+    Rows.insert(Rows.end(), Found[p].begin(), Found[p].end());
+  }
+  return Result;
+}
@@ -0,0 +1,103 @@
+// Std
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+// MAD
+#include "MAD/ThreadPool.hpp"
+
+using namespace mad;
+
+ThreadPool::ThreadPool(unsigned Count) : Stopping(false) {
+  for (unsigned i = 0; i < Count; ++i) {
+    Workers.emplace_back([this] { Work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Stopping = true;
+  }
+  Condition.notify_all();
+  for (auto &Worker : Workers) {
+    Worker.join();
+  }
+}
+
+ThreadPool &ThreadPool::GetShared() {
+  static ThreadPool Shared;
+  return Shared;
+}
+
+void ThreadPool::Work() {
+  while (true) {
+    std::function<void()> Task;
+    {
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Condition.wait(Lock, [this] { return Stopping || !Tasks.empty(); });
+      if (Tasks.empty()) {
+        return;
+      }
+      Task = std::move(Tasks.front());
+      Tasks.pop_front();
+    }
+    Task();
+  }
+}
+
+void ThreadPool::Enqueue(std::function<void()> Task) {
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Tasks.push_back(std::move(Task));
+  }
+  Condition.notify_one();
+}
+
+void ThreadPool::ParallelFor(uint64_t Count, uint64_t ChunkSize,
+                             std::function<void(uint64_t, uint64_t)> Body) {
+  if (!Count) {
+    return;
+  }
+
+  ChunkSize = std::max<uint64_t>(ChunkSize, 1);
+  uint64_t Chunks = (Count + ChunkSize - 1) / ChunkSize;
+  if (Chunks == 1 || Workers.empty()) {
+    Body(0, Count);
+    return;
+  }
+
+  // Helpers may start after this call has returned, so everything they touch
+  // is shared rather than living on this stack frame.
+  struct State {
+    std::function<void(uint64_t, uint64_t)> Body;
+    std::atomic<uint64_t> Next{0};
+    uint64_t Done = 0;
+    std::mutex Mutex;
+    std::condition_variable Condition;
+  };
+  auto Shared = std::make_shared<State>();
+  Shared->Body = std::move(Body);
+
+  auto Run = [Shared, Count, ChunkSize, Chunks] {
+    uint64_t Chunk;
+    while ((Chunk = Shared->Next.fetch_add(1)) < Chunks) {
+      uint64_t Begin = Chunk * ChunkSize;
+      Shared->Body(Begin, std::min(Begin + ChunkSize, Count));
+      std::lock_guard<std::mutex> Lock(Shared->Mutex);
+      if (++Shared->Done == Chunks) {
+        Shared->Condition.notify_all();
+      }
+    }
+  };
+
+  auto Helpers = std::min<uint64_t>(Workers.size(), Chunks - 1);
+  for (uint64_t i = 0; i < Helpers; ++i) {
+    Enqueue(Run);
+  }
+
+  Run();
+
+  std::unique_lock<std::mutex> Lock(Shared->Mutex);
+  Shared->Condition.wait(Lock, [&] { return Shared->Done == Chunks; });
+}
@@ -5,37 +5,164 @@
 
 using namespace mad;
 
-bool UniversalBinary::Parse() {
+// Fat headers are always big-endian, on a little-endian host the magic reads
+// as its CIGAM
+template <typename S> static S Swap(S Value, bool IsSwapped) {
+  if (!IsSwapped) {
+    return Value;
+  }
+  if constexpr (sizeof(S) == 8) {
+    return __builtin_bswap64(Value);
+  } else {
+    return __builtin_bswap32(Value);
+  }
+}
+
+template <typename A>
+static bool ReadArch(ByteView Input, uint64_t Offset, bool IsSwapped,
+                     UniversalBinary::Slice &Result) {
+  A Arch;
+  if (!Input.ReadAt(Offset, Arch)) {
+    return false;
+  }
+  Result.CpuType = Swap(Arch.cputype, IsSwapped);
+  // Remove capability bits
+  Result.CpuSubType = Swap(Arch.cpusubtype, IsSwapped) & ~CPU_SUBTYPE_MASK;
+  Result.Offset = Swap(Arch.offset, IsSwapped);
+  Result.Size = Swap(Arch.size, IsSwapped);
+  Result.Align = Swap(Arch.align, IsSwapped);
+  return true;
+}
+
+static cpu_subtype_t GetAllSubType(cpu_type_t CpuType) {
+  switch (CpuType) {
+  case CPU_TYPE_X86:
+  case CPU_TYPE_X86_64:
+    return CPU_SUBTYPE_X86_ALL;
+  case CPU_TYPE_ARM:
+    return CPU_SUBTYPE_ARM_ALL;
+  case CPU_TYPE_ARM64:
+    return CPU_SUBTYPE_ARM64_ALL;
+  }
+  return CPU_SUBTYPE_MULTIPLE;
+}
+
+bool UniversalBinary::ReadSlices(ByteView Input) {
   fat_header header;
   uint64_t fatptr = 0;
-  Input.seekg(fatptr);
-  Input.read((char *)&header, sizeof(fat_header));
+  if (!Input.ReadAt(fatptr, header)) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Not a FAT binary", Path);
+    return false;
+  }
 
-  if (header.magic != FAT_MAGIC && header.magic != FAT_CIGAM) {
+  bool Is64 = header.magic == FAT_MAGIC_64 || header.magic == FAT_CIGAM_64;
+  bool IsSwapped = header.magic == FAT_CIGAM || header.magic == FAT_CIGAM_64;
+  if (!Is64 && !IsSwapped && header.magic != FAT_MAGIC) {
     Error Err(MAD_ERROR_PARSER);
     Err.Log("Not a FAT binary", Path);
     return false;
   }
 
+  uint32_t Count = Swap(header.nfat_arch, IsSwapped);
   fatptr += sizeof(fat_header);
-  PRINT_DEBUG("FOUND ", header.nfat_arch, " ARCHS");
+  PRINT_DEBUG("FOUND ", Count, " ARCHS");
 
-  for (uint32_t i = 0; i < header.nfat_arch; ++i) {
-    fat_arch arch;
-    Input.seekg(fatptr);
-    Input.read((char *)&arch, sizeof(fat_arch));
-    fatptr += sizeof(fat_arch);
+  // Whatever the header says, the table has to fit in the file
+  uint64_t ArchSize = Is64 ? sizeof(fat_arch_64) : sizeof(fat_arch);
+  if (!Input.Contains(fatptr, Count * ArchSize)) {
+    Error Err(MAD_ERROR_PARSER);
+    Err.Log("Truncated FAT header", Path);
+    return false;
+  }
 
-    PRINT_DEBUG("FOUND CPUTYPE: ", arch.cputype);
+  Slices.reserve(Count);
+  for (uint32_t i = 0; i < Count; ++i) {
+    Slice Arch;
+    bool Good = Is64 ? ReadArch<fat_arch_64>(Input, fatptr, IsSwapped, Arch)
+                     : ReadArch<fat_arch>(Input, fatptr, IsSwapped, Arch);
+    if (!Good || !Input.Contains(Arch.Offset, Arch.Size)) {
+      Error Err(MAD_ERROR_PARSER);
+      Err.Log("Malformed FAT arch", i, "in", Path);
+      return false;
+    }
+    fatptr += ArchSize;
 
-    // Remove capability bits
-    arch.cpusubtype &= ~CPU_SUBTYPE_MASK;
+    PRINT_DEBUG("FOUND CPUTYPE: ", Arch.CpuType, ", SUBTYPE: ",
+                Arch.CpuSubType);
+    Slices.push_back(Arch);
+  }
 
-    Input.seekg(arch.offset);
-    ObjectFile object(Path, Input);
-    object.Parse();
-    ObjectFiles.insert({arch.cputype, std::move(object)});
+  return true;
+}
+
+bool UniversalBinary::Parse() {
+  if (!File.Open(Path)) {
+    Slices.clear();
+    ObjectFiles.clear();
+    IsParsed.clear();
+    View = ByteView();
+    return false;
   }
+  return Parse(File.GetView());
+}
+
+bool UniversalBinary::Parse(ByteView Input) {
+  Slices.clear();
+  ObjectFiles.clear();
+  IsParsed.clear();
+  View = Input;
+
+  if (!ReadSlices(View)) {
+    Slices.clear();
+    View = ByteView();
+    return false;
+  }
+
+  ObjectFiles.resize(Slices.size());
+  IsParsed.resize(Slices.size(), false);
 
   return true;
 }
+
+const UniversalBinary::Slice *
+UniversalBinary::FindSlice(cpu_type_t CpuType,
+                           cpu_subtype_t CpuSubType) const {
+  const Slice *Fallback = nullptr;
+  auto AllSubType = GetAllSubType(CpuType);
+  bool IsAny = CpuSubType == CPU_SUBTYPE_MULTIPLE;
+  CpuSubType &= ~CPU_SUBTYPE_MASK;
+
+  for (auto &Arch : Slices) {
+    if (Arch.CpuType != CpuType) {
+      continue;
+    }
+    if (IsAny || Arch.CpuSubType == CpuSubType) {
+      return &Arch;
+    }
+    if (!Fallback && Arch.CpuSubType == AllSubType) {
+      Fallback = &Arch;
+    }
+  }
+
+  return Fallback;
+}
+
+ObjectFile *UniversalBinary::GetObjectFile(cpu_type_t CpuType,
+                                           cpu_subtype_t CpuSubType) {
+  auto Arch = FindSlice(CpuType, CpuSubType);
+  if (!Arch) {
+    return nullptr;
+  }
+
+  size_t Index = Arch - Slices.data();
+  if (!IsParsed[Index]) {
+    IsParsed[Index] = true;
+    auto Object = std::make_unique<ObjectFile>(Path, GetSliceView(*Arch));
+    if (Object->Parse()) {
+      ObjectFiles[Index] = std::move(Object);
+    }
+  }
+
+  return ObjectFiles[Index].get();
+}
@@ -0,0 +1,184 @@
+// Std
+#include <cassert>
+#include <cstring>
+
+// MAD
+#include "MAD/CompactUnwind.hpp"
+#include "MAD/EhFrame.hpp"
+#include "MAD/Unwinder.hpp"
+
+using namespace mad;
+
+namespace {
+
+// What rbp points to in a standard frame: the caller's rbp, then the return
+// address
+UnwindRow GetFramePointerRow() {
+  UnwindRow Row;
+  Row.CFARegister = REG_X86_64_RBP;
+  Row.CFAOffset = 16;
+  Row.SetSavedAt(REG_X86_64_RBP, -16);
+  return Row;
+}
+
+void ReadRegisters(const x86_thread_state64_t &State, UnwindRegisters &Regs) {
+  Regs = UnwindRegisters();
+  Regs.Set(REG_X86_64_RAX, State.__rax);
+  Regs.Set(REG_X86_64_RDX, State.__rdx);
+  Regs.Set(REG_X86_64_RCX, State.__rcx);
+  Regs.Set(REG_X86_64_RBX, State.__rbx);
+  Regs.Set(REG_X86_64_RSI, State.__rsi);
+  Regs.Set(REG_X86_64_RDI, State.__rdi);
+  Regs.Set(REG_X86_64_RBP, State.__rbp);
+  Regs.Set(REG_X86_64_RSP, State.__rsp);
+  Regs.Set(REG_X86_64_R8, State.__r8);
+  Regs.Set(REG_X86_64_R9, State.__r9);
+  Regs.Set(REG_X86_64_R10, State.__r10);
+  Regs.Set(REG_X86_64_R11, State.__r11);
+  Regs.Set(REG_X86_64_R12, State.__r12);
+  Regs.Set(REG_X86_64_R13, State.__r13);
+  Regs.Set(REG_X86_64_R14, State.__r14);
+  Regs.Set(REG_X86_64_R15, State.__r15);
+  Regs.Set(REG_X86_64_RIP, State.__rip);
+}
+
+} // namespace
+
+void Unwinder::Attach(std::shared_ptr<MachProcess> Proc) { Process = Proc; }
+
+void Unwinder::Detach() {
+  Process = nullptr;
+  Plans.clear();
+  Window.clear();
+}
+
+MachImage64 *Unwinder::FindImage(uint64_t Address) {
+  assert(Process);
+
+  ImageAddressMap<MachImage64>::Location Location;
+  if (!Process->GetImagesByAddress().Lookup(Address, Location) ||
+      Location.Segment->Name != SEG_TEXT) {
+    return nullptr;
+  }
+  return Location.Image.get();
+}
+
+bool Unwinder::ReadPlan(MachImage64 &Image, uint64_t Address,
+                        UnwindPlan &Plan) {
+  auto Unwind = Image.GetCompactUnwind();
+  auto Frames = Image.GetEhFrame();
+
+  CompactUnwind::Entry E;
+  if (Unwind && Unwind->Lookup(Address, E) && E.Encoding) {
+    if (CompactUnwind::IsDwarf(E.Encoding)) {
+      return Frames &&
+             Frames->GetPlanAt(CompactUnwind::GetDwarfOffset(E.Encoding), Plan);
+    }
+
+    uint64_t SizeAddress;
+    uint32_t Size = 0;
+    if (CompactUnwind::IsIndirect(E, SizeAddress) &&
+        Process->ReadMemory(SizeAddress, sizeof(Size), &Size) != sizeof(Size)) {
+      return false;
+    }
+    return CompactUnwind::GetPlan(E, Plan, Size);
+  }
+
+  // Images linked without compact unwind have FDEs for everything
+  return Frames && Frames->GetPlan(Address, Plan);
+}
+
+const UnwindPlan *Unwinder::FindPlan(uint64_t Address) {
+  auto It = Plans.upper_bound(Address);
+  if (It != Plans.begin() && std::prev(It)->second.Contains(Address)) {
+    return &std::prev(It)->second;
+  }
+
+  auto Image = FindImage(Address);
+  UnwindPlan Plan;
+  if (!Image || !ReadPlan(*Image, Address, Plan) || Plan.IsEmpty() ||
+      !Plan.Contains(Address)) {
+    return nullptr;
+  }
+
+  auto Start = Plan.Start;
+  return &(Plans[Start] = std::move(Plan));
+}
+
+bool Unwinder::ReadStack(uint64_t Address, uint64_t &Value) {
+  if (Address >= WindowAddress &&
+      Address - WindowAddress + sizeof(Value) <= Window.size()) {
+    memcpy(&Value, Window.data() + (Address - WindowAddress), sizeof(Value));
+    return true;
+  }
+
+  // Callers' frames are above, so the window starts right at the read. It
+  // is cut at the end of the stack, which is not known up front.
+  Window.resize(UNWIND_STACK_WINDOW);
+  auto Read = Process->GetTask().GetMemory().ReadAvailable(
+      Address, Window.size(), Window.data());
+  Window.resize(Read);
+  WindowAddress = Address;
+
+  if (Read < sizeof(Value)) {
+    return false;
+  }
+  memcpy(&Value, Window.data(), sizeof(Value));
+  return true;
+}
+
+bool Unwinder::Backtrace(MachThread &Thread, std::vector<StackFrame> &Frames,
+                         size_t MaxFrames) {
+  assert(Process);
+
+  Frames.clear();
+  Window.clear();
+  if (!Thread.GetStates()) {
+    return false;
+  }
+
+  static const UnwindRow FramePointerRow = GetFramePointerRow();
+  auto ReadWord = [this](uint64_t Address, uint64_t &Value) {
+    return ReadStack(Address, Value);
+  };
+
+  UnwindRegisters Regs, Caller;
+  ReadRegisters(*Thread.ThreadState64(), Regs);
+
+  while (Frames.size() < MaxFrames) {
+    uint64_t PC = Regs.Get(REG_X86_64_RIP);
+    // A return address may be past the end of its function if the call never
+    // returns, the call itself is not
+    uint64_t Address = Frames.empty() ? PC : PC - 1;
+    auto Plan = FindPlan(Address);
+    auto &Row = Plan ? Plan->GetRow(Address) : FramePointerRow;
+
+    bool IsStepped = Row.Step(Regs, Caller, ReadWord);
+    Frames.push_back({PC, IsStepped ? Caller.Get(REG_X86_64_RSP) : 0});
+
+    // Stacks grow down, a caller below its callee is garbage
+    if (!IsStepped || !Caller.Has(REG_X86_64_RIP) ||
+        !Caller.Get(REG_X86_64_RIP) ||
+        Caller.Get(REG_X86_64_RSP) <= Regs.Get(REG_X86_64_RSP)) {
+      break;
+    }
+    Regs = Caller;
+  }
+
+  return true;
+}
+
+bool Unwinder::BacktraceAll(std::vector<std::vector<StackFrame>> &Traces,
+                            size_t MaxFrames) {
+  assert(Process);
+
+  auto Threads = Process->GetTask().GetThreads();
+  Traces.resize(Threads.size());
+  for (size_t i = 0; i < Threads.size(); ++i) {
+    if (!Backtrace(Threads[i], Traces[i], MaxFrames)) {
+      Traces[i].clear();
+    }
+  }
+
+  return !Threads.empty();
+}
@@ -0,0 +1,163 @@
+// Std
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/BreakpointsControl.hpp"
+#include "MAD/MachProcess.hpp"
+
+#include "FakeMach.hpp"
+#include "Image.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+#define SYMBOL_COUNT 200
+
+// Every slot an image can be mapped at is this much further than the one
+// before
+#define SLOT_STRIDE 0x10000000ull
+
+// A process that loads and unloads images of the bench's fake Mach task while
+// a controller is attached to it. Image Id n has names of its own, e.g.
+// __ZN3mad2Image... for 2.
+class breakpoints_control : public ::testing::Test {
+protected:
+  std::shared_ptr<MachProcess> Process;
+  BreakpointsControl Control;
+
+  static std::string GetPath(uint32_t Id) {
+    return "/usr/lib/libImage" + std::to_string(Id) + ".dylib";
+  }
+
+  static uint64_t GetAddress(uint32_t Slot, uint32_t Symbol) {
+    return Image::GetSymbolAddress(Symbol) + Slot * SLOT_STRIDE;
+  }
+
+  void Load(uint32_t Id, uint32_t Slot) {
+    auto &I = GetImage(SYMBOL_COUNT, 2, Id);
+    fake::MapMemory(IMAGE_BASE + Slot * SLOT_STRIDE, I.Data.data(),
+                    I.Data.size());
+    fake::AddImage(GetPath(Id), IMAGE_BASE + Slot * SLOT_STRIDE);
+  }
+
+  bool IsTrapAt(uint64_t Address) {
+    uint8_t Byte = 0;
+    Process->ReadMemory(Address, 1, &Byte);
+    return Byte == 0xCC;
+  }
+
+  void SetUp() override {
+    Load(0, 0);
+    Load(1, 1);
+    Process = std::make_shared<MachProcess>("test");
+    Process->Execute();
+    Process->Attach();
+    Control.Attach(Process);
+  }
+
+  void TearDown() override {
+    Control.Detach(true);
+    Process->Detach();
+    fake::RemoveImages();
+    fake::UnmapMemory();
+  }
+};
+
+static BreakpointCallbackReturn Continue(std::string) {
+  return BreakpointCallbackReturn::CONTINUE;
+}
+
+TEST_F(breakpoints_control, AddsImagesDyldLoaded) {
+  auto Name = Image::GetSymbolName(2, 5);
+  ASSERT_TRUE(Control.AddBreakpointBySymbolName(Name, Continue));
+  ASSERT_TRUE(Control.AddBreakpointByRegex("^__ZN3mad2Image", false, Continue));
+  EXPECT_TRUE(Process->GetGlobalSymbols().Lookup(Name).empty());
+
+  Load(2, 2);
+  Control.UpdateImages();
+  EXPECT_EQ(Process->GetImagess().size(), 3u);
+  EXPECT_EQ(Process->GetGlobalSymbols().Lookup(Name).size(), 1u);
+  ImageAddressMap<MachImage64>::Location Location;
+  EXPECT_TRUE(
+      Process->GetImagesByAddress().Lookup(GetAddress(2, 5), Location));
+
+  // The symbol and every name of the image the pattern matches
+  EXPECT_TRUE(IsTrapAt(GetAddress(2, 5)));
+  EXPECT_TRUE(IsTrapAt(GetAddress(2, 6)));
+  EXPECT_FALSE(IsTrapAt(GetAddress(1, 6)));
+}
+
+TEST_F(breakpoints_control, ForgetsImagesDyldUnloaded) {
+  auto Name = Image::GetSymbolName(2, 5);
+  Load(2, 2);
+  Control.UpdateImages();
+  ASSERT_TRUE(Control.AddBreakpointBySymbolName(Name, Continue));
+  ASSERT_TRUE(Control.AddBreakpointByRegex("^__ZN3mad2Image", false, Continue));
+
+  // An image before the pattern's one goes too, which moves the others down
+  fake::RemoveImage(GetPath(0));
+  fake::RemoveImage(GetPath(2));
+  Control.UpdateImages();
+  EXPECT_EQ(Process->GetImagess().size(), 1u);
+  EXPECT_TRUE(Process->GetGlobalSymbols().Lookup(Name).empty());
+  ImageAddressMap<MachImage64>::Location Location;
+  EXPECT_FALSE(
+      Process->GetImagesByAddress().Lookup(GetAddress(2, 5), Location));
+
+  // Loaded again somewhere else, both breakpoints follow it
+  Load(2, 3);
+  Control.UpdateImages();
+  EXPECT_EQ(Process->GetImagess().size(), 2u);
+  EXPECT_TRUE(IsTrapAt(GetAddress(3, 5)));
+  EXPECT_TRUE(IsTrapAt(GetAddress(3, 6)));
+
+  // Nothing of the first load is left to remove
+  EXPECT_TRUE(Control.RemoveBreakpointBySymbolName(Name));
+  EXPECT_TRUE(Control.RemoveBreakpointByRegex("^__ZN3mad2Image"));
+  EXPECT_FALSE(IsTrapAt(GetAddress(3, 5)));
+  EXPECT_FALSE(IsTrapAt(GetAddress(3, 6)));
+}
+
+// Whatever the target has loaded is parsed, an image cut off right after its
+// header is left out rather than taking the debugger down
+TEST_F(breakpoints_control, SkipsImagesThatFailToParse) {
+  auto &I = GetImage(SYMBOL_COUNT, 2, 2);
+  auto Address = IMAGE_BASE + 2 * SLOT_STRIDE;
+  fake::MapMemory(Address, I.Data.data(), sizeof(mach_header_64) + 16);
+  fake::AddImage(GetPath(2), Address);
+  Control.UpdateImages();
+  EXPECT_EQ(Process->GetImagess().size(), 2u);
+  auto Name = Image::GetSymbolName(2, 5);
+  EXPECT_TRUE(Process->GetGlobalSymbols().Lookup(Name).empty());
+
+  // Nothing of an image that failed to parse is looked at past its header
+  MachImage64 Truncated(GetPath(2), Process->GetTask(), Address);
+  EXPECT_FALSE(Truncated.Scan());
+  auto &Table = Truncated.GetSymbolTable();
+  EXPECT_EQ(Table.GetSymbols().GetSize(), 0u);
+  EXPECT_FALSE(Table.GetSymbolByName(Name));
+  EXPECT_TRUE(Table.GetSymbolsByName(Name).empty());
+  EXPECT_FALSE(Table.GetSymbolByAddress(GetAddress(2, 5)));
+
+  // Not even a header
+  std::vector<char> Zeros(FAKE_PAGE_SIZE);
+  fake::MapMemory(IMAGE_BASE + 3 * SLOT_STRIDE, Zeros.data(), Zeros.size());
+  MachImage64 Garbage(GetPath(3), Process->GetTask(),
+                      IMAGE_BASE + 3 * SLOT_STRIDE);
+  EXPECT_FALSE(Garbage.Scan());
+  EXPECT_EQ(Garbage.GetType(), 0u);
+  EXPECT_EQ(Garbage.GetSymbolTable().GetSymbols().GetSize(), 0u);
+
+  // The images that did parse are unaffected
+  ASSERT_TRUE(
+      Control.AddBreakpointBySymbolName(Image::GetSymbolName(1, 5), Continue));
+  EXPECT_TRUE(IsTrapAt(GetAddress(1, 5)));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,222 @@
+// System
+#include <mach-o/loader.h>
+
+// Std
+#include <cstring>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/ChainedFixups.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+namespace {
+
+const uint64_t BaseAddress = 0x100000000;
+const uint64_t PageSize = 0x4000;
+
+template <typename T> uint64_t Encode(T Pointer) {
+  uint64_t Raw = 0;
+  memcpy(&Raw, &Pointer, sizeof(Pointer));
+  return Raw;
+}
+
+// LC_DYLD_CHAINED_FIXUPS of an image with __TEXT and __DATA_CONST, the latter
+// one page at 0x4000 with pointers in the given format
+class FixupsBuilder {
+public:
+  uint16_t Format;
+  uint32_t MaxValidPointer = 0;
+  std::vector<std::pair<uint8_t, std::string>> Imports;
+  std::vector<char> Page = std::vector<char>(PageSize);
+  uint16_t PageStart = DYLD_CHAINED_PTR_START_NONE;
+
+  explicit FixupsBuilder(uint16_t Format) : Format(Format) {}
+
+  void Put(uint64_t Offset, uint64_t Raw) {
+    memcpy(Page.data() + Offset, &Raw, sizeof(Raw));
+  }
+
+  std::vector<char> Build() const {
+    std::vector<char> Blob;
+    auto Append = [&](const auto &Value) {
+      auto Bytes = reinterpret_cast<const char *>(&Value);
+      Blob.insert(Blob.end(), Bytes, Bytes + sizeof(Value));
+      return Blob.size() - sizeof(Value);
+    };
+
+    dyld_chained_fixups_header Header = {};
+    Header.imports_format = DYLD_CHAINED_IMPORT;
+    Header.imports_count = Imports.size();
+    Append(Header);
+
+    // Starts of __TEXT are none, those of __DATA_CONST right after
+    Header.starts_offset = Append(uint32_t(2));
+    Append(uint32_t(0));
+    auto SegmentInfo = Append(uint32_t(0));
+
+    uint32_t Offset = Blob.size() - Header.starts_offset;
+    memcpy(Blob.data() + SegmentInfo, &Offset, sizeof(Offset));
+    dyld_chained_starts_in_segment Starts = {};
+    Starts.size = sizeof(Starts);
+    Starts.page_size = PageSize;
+    Starts.pointer_format = Format;
+    Starts.segment_offset = PageSize;
+    Starts.max_valid_pointer = MaxValidPointer;
+    Starts.page_count = 1;
+    Starts.page_start[0] = PageStart;
+    Append(Starts);
+
+    Header.imports_offset = Blob.size();
+    std::string Symbols(1, '\0');
+    for (auto &Import : Imports) {
+      dyld_chained_import Raw = {};
+      Raw.lib_ordinal = Import.first;
+      Raw.name_offset = Symbols.size();
+      Append(Raw);
+      Symbols += Import.second + '\0';
+    }
+
+    Header.symbols_offset = Blob.size();
+    Blob.insert(Blob.end(), Symbols.begin(), Symbols.end());
+    memcpy(Blob.data(), &Header, sizeof(Header));
+    return Blob;
+  }
+
+  ChainedFixups Decode(std::vector<char> &Blob) const {
+    Blob = Build();
+    std::vector<ByteView> Segments = {
+        ByteView(), ByteView(Page.data(), Page.size())};
+    return ChainedFixups(ByteView(Blob.data(), Blob.size()), BaseAddress,
+                         Segments);
+  }
+};
+
+} // namespace
+
+class chained_fixups_test : public ::testing::Test {
+protected:
+  std::vector<char> Blob;
+};
+
+TEST_F(chained_fixups_test, DecodesRebasesAndBinds) {
+  FixupsBuilder Builder(DYLD_CHAINED_PTR_64_OFFSET);
+  Builder.Imports = {{1, "_malloc"}, {0xFE, "_missing"}};
+  Builder.PageStart = 0x10;
+
+  // Strides are 4 bytes
+  dyld_chained_ptr_64_rebase Rebase = {};
+  Rebase.target = 0x1234;
+  Rebase.high8 = 0x80;
+  Rebase.next = 2;
+  Builder.Put(0x10, Encode(Rebase));
+  dyld_chained_ptr_64_bind Bind = {};
+  Bind.bind = 1;
+  Bind.ordinal = 1;
+  Bind.addend = 5;
+  Builder.Put(0x18, Encode(Bind));
+
+  auto Fixups = Builder.Decode(Blob);
+  ASSERT_EQ(Fixups.GetSize(), 2u);
+
+  ChainedFixups::Fixup Fixup;
+  ASSERT_TRUE(Fixups.Lookup(BaseAddress + PageSize + 0x10, Fixup));
+  EXPECT_FALSE(Fixup.IsBind);
+  EXPECT_EQ(Fixup.GetRebased(0x1000), 0x8000000100002234u);
+
+  ASSERT_TRUE(Fixups.Lookup(BaseAddress + PageSize + 0x18, Fixup));
+  EXPECT_TRUE(Fixup.IsBind);
+  EXPECT_EQ(Fixup.Addend, 5);
+  auto Import = Fixups.GetImport(Fixup.Target);
+  ASSERT_TRUE(Import);
+  EXPECT_EQ(Import->Name, "_missing");
+  EXPECT_EQ(Import->LibraryOrdinal, BIND_SPECIAL_DYLIB_FLAT_LOOKUP);
+
+  EXPECT_FALSE(Fixups.Lookup(BaseAddress + PageSize + 0x14, Fixup));
+  EXPECT_FALSE(Fixups.GetImport(2));
+}
+
+TEST_F(chained_fixups_test, DecodesArm64e) {
+  FixupsBuilder Builder(DYLD_CHAINED_PTR_ARM64E);
+  Builder.Imports = {{2, "_objc_msgSend"}};
+  Builder.PageStart = 0;
+
+  // Strides are 8 bytes, plain rebases have addresses, authenticated ones
+  // offsets
+  dyld_chained_ptr_arm64e_rebase Rebase = {};
+  Rebase.target = BaseAddress + 0x100;
+  Rebase.next = 1;
+  Builder.Put(0x0, Encode(Rebase));
+  dyld_chained_ptr_arm64e_auth_rebase AuthRebase = {};
+  AuthRebase.auth = 1;
+  AuthRebase.target = 0x200;
+  AuthRebase.diversity = 0xABCD;
+  AuthRebase.next = 1;
+  Builder.Put(0x8, Encode(AuthRebase));
+  dyld_chained_ptr_arm64e_bind Bind = {};
+  Bind.bind = 1;
+  Bind.ordinal = 0;
+  Bind.addend = 0x7FFF8; // -8
+  Bind.next = 1;
+  Builder.Put(0x10, Encode(Bind));
+  dyld_chained_ptr_arm64e_auth_bind AuthBind = {};
+  AuthBind.bind = 1;
+  AuthBind.auth = 1;
+  AuthBind.ordinal = 0;
+  AuthBind.diversity = 0xFFFF;
+  Builder.Put(0x18, Encode(AuthBind));
+
+  auto Fixups = Builder.Decode(Blob);
+  auto &All = Fixups.GetFixups();
+  ASSERT_EQ(All.size(), 4u);
+
+  EXPECT_EQ(All[0].GetRebased(0x10), BaseAddress + 0x110);
+  EXPECT_TRUE(All[1].IsAuth);
+  EXPECT_EQ(All[1].GetRebased(0x10), BaseAddress + 0x210);
+  EXPECT_TRUE(All[2].IsBind);
+  EXPECT_EQ(All[2].Addend, -8);
+  EXPECT_TRUE(All[3].IsBind && All[3].IsAuth);
+  EXPECT_EQ(All[3].Addend, 0);
+  EXPECT_EQ(Fixups.GetImport(All[3].Target)->LibraryOrdinal, 2);
+}
+
+TEST_F(chained_fixups_test, RejectsMalformedChains) {
+  // A chain that leaves its page
+  FixupsBuilder Builder(DYLD_CHAINED_PTR_64);
+  Builder.PageStart = PageSize - 8;
+  dyld_chained_ptr_64_rebase Rebase = {};
+  Rebase.next = 4;
+  Builder.Put(PageSize - 8, Encode(Rebase));
+  EXPECT_TRUE(Builder.Decode(Blob).IsEmpty());
+
+  // A bind of an import that is not there
+  Builder.PageStart = 0;
+  dyld_chained_ptr_64_bind Bind = {};
+  Bind.bind = 1;
+  Bind.ordinal = 1;
+  Builder.Put(0, Encode(Bind));
+  Builder.Imports = {{1, "_free"}};
+  EXPECT_TRUE(Builder.Decode(Blob).IsEmpty());
+
+  Bind.ordinal = 0;
+  Builder.Put(0, Encode(Bind));
+  EXPECT_FALSE(Builder.Decode(Blob).IsEmpty());
+
+  // Cut anywhere
+  auto Whole = Builder.Build();
+  for (size_t Size = 0; Size < Whole.size(); ++Size) {
+    std::vector<ByteView> Segments = {
+        ByteView(), ByteView(Builder.Page.data(), Builder.Page.size())};
+    ChainedFixups Fixups(ByteView(Whole.data(), Size), BaseAddress, Segments);
+    EXPECT_TRUE(Fixups.IsEmpty()) << Size;
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
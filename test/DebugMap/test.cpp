@@ -0,0 +1,153 @@
+// System
+#include <mach-o/nlist.h>
+#include <mach-o/stab.h>
+
+// Std
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/DebugMap.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// What ld64 writes for two object files, with the regular symbols after the
+// STABS like it does it
+class debug_map_test : public ::testing::Test {
+protected:
+  std::string Strings = std::string(1, '\0');
+  std::vector<struct nlist_64> Entries;
+  SymbolStore Store;
+  DebugMap Map;
+
+  void Add(uint8_t Type, std::string Name, uint64_t Value, uint8_t Sect = 0) {
+    struct nlist_64 Entry = {};
+    if (!Name.empty()) {
+      Entry.n_un.n_strx = Strings.size();
+      Strings += Name;
+      Strings += '\0';
+    }
+    Entry.n_type = Type;
+    Entry.n_sect = Sect;
+    Entry.n_value = Value;
+    Entries.push_back(Entry);
+  }
+
+  void AddFunction(std::string Name, uint64_t Address, uint64_t Size) {
+    Add(N_BNSYM, "", Address, 1);
+    Add(N_FUN, Name, Address, 1);
+    Add(N_FUN, "", Size);
+    Add(N_ENSYM, "", Address, 1);
+  }
+
+  void Build() {
+    Store.Reset(ByteView(Strings.data(), Strings.size()), Entries.size(),
+                0x1000);
+    for (uint32_t i = 0; i < Entries.size(); ++i) {
+      Store.Set(i, Entries[i], false, true);
+    }
+    Map.Build(Store);
+  }
+
+  void SetUp() override {
+    Add(N_SO, "/work/src/", 0);
+    Add(N_SO, "lines.c", 0x100000f00, 1);
+    Add(N_OSO, "/work/build/lines.o", 0x5f000000, 3);
+    // Out of order on purpose
+    AddFunction("_loop", 0x100000f40, 0x20);
+    AddFunction("_main", 0x100000f00, 0x40);
+    Add(N_STSYM, "_counter", 0x100001000, 2);
+    Add(N_SO, "", 0, 1);
+
+    Add(N_SO, "/work/lib/helper.c", 0x100000f60, 1);
+    Add(N_OSO, "/work/build/libhelper.a(helper.o)", 0x5f000001, 3);
+    AddFunction("_helper", 0x100000f60, 0x10);
+    Add(N_SO, "", 0, 1);
+
+    Add(N_SECT | N_EXT, "_main", 0x100000f00, 1);
+    Add(N_SECT, "_loop", 0x100000f40, 1);
+    Add(N_SECT | N_EXT, "_helper", 0x100000f60, 1);
+  }
+};
+
+TEST_F(debug_map_test, GroupsFunctionsBySource) {
+  Build();
+  ASSERT_EQ(Map.GetUnitCount(), 2u);
+
+  std::vector<const DebugMap::Unit *> Units;
+  ASSERT_TRUE(Map.FindSource("lines.c", Units));
+  ASSERT_EQ(Units.size(), 1u);
+  auto &U = *Units[0];
+  EXPECT_EQ(U.Source, "/work/src/lines.c");
+  EXPECT_EQ(U.ObjectFile, "/work/build/lines.o");
+  EXPECT_EQ(U.ModificationTime, 0x5f000000u);
+
+  // Sorted, with the sizes of the closing N_FUN and unslid
+  ASSERT_EQ(U.FunctionCount, 2u);
+  auto Functions = Map.GetFunctions(U);
+  EXPECT_EQ(Functions[0].Name, "_main");
+  EXPECT_EQ(Functions[0].Address, 0x100000f00u);
+  EXPECT_EQ(Functions[0].Size, 0x40u);
+  EXPECT_EQ(Functions[1].Name, "_loop");
+  EXPECT_EQ(Functions[1].Size, 0x20u);
+
+  ASSERT_TRUE(Map.FindSource("/work/lib/helper.c", Units));
+  ASSERT_EQ(Units.size(), 1u);
+  EXPECT_EQ(Units[0]->FunctionCount, 1u);
+  EXPECT_EQ(Map.GetFunctions(*Units[0])[0].Name, "_helper");
+
+  EXPECT_TRUE(Map.FindSource("src/lines.c", Units));
+  EXPECT_FALSE(Map.FindSource("/lines.c", Units));
+  EXPECT_FALSE(Map.FindSource("ines.c", Units));
+  EXPECT_FALSE(Map.FindSource("other.c", Units));
+}
+
+TEST_F(debug_map_test, LooksUpAddresses) {
+  Build();
+
+  const DebugMap::Unit *U;
+  const DebugMap::Function *F;
+  ASSERT_TRUE(Map.LookupAddress(0x100000f50, U, F));
+  EXPECT_EQ(F->Name, "_loop");
+  EXPECT_EQ(U->ObjectFile, "/work/build/lines.o");
+
+  ASSERT_TRUE(Map.LookupAddress(0x100000f60, U, F));
+  EXPECT_EQ(F->Name, "_helper");
+  EXPECT_EQ(U->Source, "/work/lib/helper.c");
+
+  EXPECT_FALSE(Map.LookupAddress(0x100000eff, U, F));
+  EXPECT_FALSE(Map.LookupAddress(0x100000f70, U, F));
+}
+
+TEST_F(debug_map_test, SurvivesIncompleteMaps) {
+  // A unit that never ends and a function without a size
+  Add(N_SO, "/work/tail.c", 0x100000f80, 1);
+  Add(N_FUN, "_tail", 0x100000f80, 1);
+  Build();
+
+  ASSERT_EQ(Map.GetUnitCount(), 3u);
+  std::vector<const DebugMap::Unit *> Units;
+  ASSERT_TRUE(Map.FindSource("tail.c", Units));
+  ASSERT_EQ(Units[0]->FunctionCount, 1u);
+  EXPECT_EQ(Map.GetFunctions(*Units[0])[0].Size, 0u);
+
+  // Only its start is known to be in it
+  const DebugMap::Unit *U;
+  const DebugMap::Function *F;
+  EXPECT_TRUE(Map.LookupAddress(0x100000f80, U, F));
+  EXPECT_FALSE(Map.LookupAddress(0x100000f81, U, F));
+}
+
+TEST_F(debug_map_test, IsEmptyWithoutStabs) {
+  Entries.clear();
+  Add(N_SECT | N_EXT, "_main", 0x100000f00, 1);
+  Build();
+  EXPECT_TRUE(Map.IsEmpty());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
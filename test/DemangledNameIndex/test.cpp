@@ -0,0 +1,167 @@
+// System
+#include <mach-o/nlist.h>
+
+// Std
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/DemangledNameIndex.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// Names as the symbol table has them, with the extra leading underscore
+static const std::vector<std::string> Names = {
+    "__ZN3geo6Circle4areaEv",      // geo::Circle::area()
+    "__ZNK3geo6Circle4areaEv",     // geo::Circle::area() const
+    "__ZN3geo6Circle4areaEd",      // geo::Circle::area(double)
+    "__ZN3geo6Square4areaEv",      // geo::Square::area()
+    "__ZN3geo4areaEi",             // geo::area(int)
+    "__ZN3geo3BoxIiE4areaEv",      // geo::Box<int>::area()
+    "__ZN3geo6CircleC1Ed",         // geo::Circle::Circle(double)
+    "__ZN3geo6CircleC2Ed",         // geo::Circle::Circle(double)
+    "__ZN3geo6CircleD1Ev",         // geo::Circle::~Circle()
+    "__ZN3geo6CircleplERKS0_",     // geo::Circle::operator+(...)
+    "__ZNK3geo6CircleclEv",        // geo::Circle::operator()() const
+    "__ZN3geo3maxIiEET_S1_S1_",    // int geo::max<int>(int, int)
+    "__ZN12_GLOBAL__N_15localEv",  // (anonymous namespace)::local()
+    "__ZN3geo6Circle5countE",      // geo::Circle::count
+    "__ZTVN3geo6CircleE",          // vtable for geo::Circle
+    "_main",
+    "__ZN3geo6Circle4areaEf",      // undefined
+};
+
+class demangled_name_index_test : public ::testing::Test {
+protected:
+  std::string Strings = std::string(1, '\0');
+  SymbolStore Store;
+
+  // The last name is an undefined symbol, the rest are defined
+  void Fill(uint32_t Count) {
+    std::vector<uint32_t> Offsets;
+    for (auto &Name : Names) {
+      Offsets.push_back(Strings.size());
+      Strings += Name + '\0';
+    }
+    Store.Reset(ByteView(Strings.data(), Strings.size()), Count, 0);
+    for (uint32_t i = 0; i < Count; ++i) {
+      struct nlist_64 Raw = {};
+      Raw.n_un.n_strx = Offsets[i % Names.size()];
+      Raw.n_type = i % Names.size() == Names.size() - 1 ? N_UNDF | N_EXT
+                                                        : N_SECT | N_EXT;
+      Raw.n_sect = 1;
+      Raw.n_value = 0x1000 + i;
+      Store.Set(i, Raw, false, true);
+    }
+  }
+
+  std::vector<uint32_t> Find(const DemangledNameIndex &Index,
+                             std::string_view Query) {
+    std::vector<uint32_t> Rows;
+    Index.Find(Query, Rows);
+    return Rows;
+  }
+};
+
+TEST_F(demangled_name_index_test, SplitsQualifiedNames) {
+  struct Case {
+    std::string Name;
+    std::string Scope;
+    std::string Basename;
+    std::string Parameters;
+  };
+  const Case Cases[] = {
+      {"area", "", "area", ""},
+      {"Circle::area", "Circle", "area", ""},
+      {"geo::Circle::area(double) const", "geo::Circle", "area",
+       "(double) const"},
+      {"int geo::max<int>(int, int)", "geo", "max", "(int, int)"},
+      {"geo::Circle::operator()() const", "geo::Circle", "operator()",
+       "() const"},
+      {"geo::Circle::operator<(geo::Circle const&)", "geo::Circle",
+       "operator<", "(geo::Circle const&)"},
+      {"geo::Circle::operator int() const", "geo::Circle", "operator int",
+       "() const"},
+      {"(anonymous namespace)::local()", "(anonymous namespace)", "local",
+       "()"},
+      {"std::__1::vector<int, std::__1::allocator<int> >::push_back(int&&)",
+       "std::__1::vector<int, std::__1::allocator<int> >", "push_back",
+       "(int&&)"},
+      {"run()::$_0::operator()() const", "run()::$_0", "operator()",
+       "() const"},
+  };
+
+  for (auto &C : Cases) {
+    QualifiedName Parts;
+    ASSERT_TRUE(QualifiedName::Split(C.Name, Parts)) << C.Name;
+    EXPECT_EQ(Parts.Scope, C.Scope) << C.Name;
+    EXPECT_EQ(Parts.Basename, C.Basename) << C.Name;
+    EXPECT_EQ(Parts.Parameters, C.Parameters) << C.Name;
+  }
+
+  QualifiedName Parts;
+  EXPECT_FALSE(QualifiedName::Split("", Parts));
+  EXPECT_FALSE(QualifiedName::Split("Circle::", Parts));
+  EXPECT_FALSE(QualifiedName::Split("area(double", Parts));
+}
+
+TEST_F(demangled_name_index_test, FindsEveryOverload) {
+  Fill(Names.size());
+  DemangledNameIndex Index;
+  Index.Build(Store);
+  // Neither data, the vtable, C names nor undefined symbols
+  EXPECT_EQ(Index.GetSize(), 13u);
+
+  using Rows = std::vector<uint32_t>;
+  EXPECT_EQ(Find(Index, "area"), Rows({0, 1, 2, 3, 4, 5}));
+  EXPECT_EQ(Find(Index, "Circle::area"), Rows({0, 1, 2}));
+  EXPECT_EQ(Find(Index, "geo::Circle::area"), Rows({0, 1, 2}));
+  EXPECT_EQ(Find(Index, "eo::Circle::area"), Rows());
+  EXPECT_EQ(Find(Index, "Circle::area(double)"), Rows({2}));
+  EXPECT_EQ(Find(Index, "Circle::area()"), Rows({0, 1}));
+  EXPECT_EQ(Find(Index, "Circle::area( ) const"), Rows({1}));
+  EXPECT_EQ(Find(Index, "Box::area"), Rows({5}));
+  EXPECT_EQ(Find(Index, "Box<int>::area"), Rows({5}));
+  EXPECT_EQ(Find(Index, "Box<char>::area"), Rows());
+  EXPECT_EQ(Find(Index, "max"), Rows({11}));
+  EXPECT_EQ(Find(Index, "Circle::Circle"), Rows({6, 7}));
+  EXPECT_EQ(Find(Index, "Circle::~Circle"), Rows({8}));
+  EXPECT_EQ(Find(Index, "Circle::operator+"), Rows({9}));
+  EXPECT_EQ(Find(Index, "Circle::operator()"), Rows({10}));
+  EXPECT_EQ(Find(Index, "local"), Rows({12}));
+  EXPECT_EQ(Find(Index, "count"), Rows());
+  EXPECT_EQ(Find(Index, "main"), Rows());
+
+  ASSERT_TRUE(Index.GetName(2));
+  EXPECT_EQ(Index.GetName(2)->GetFull(), "geo::Circle::area(double)");
+  EXPECT_EQ(Index.GetName(2)->GetParts().Scope, "geo::Circle");
+  EXPECT_FALSE(Index.GetName(13));
+  EXPECT_FALSE(Index.GetName(15));
+  EXPECT_FALSE(Index.GetName(16));
+}
+
+TEST_F(demangled_name_index_test, DemanglesInParallel) {
+  // Enough to be demangled on the thread pool, rows come out in order
+  Fill(100000);
+  DemangledNameIndex Index;
+  Index.Build(Store);
+
+  std::vector<uint32_t> Expected;
+  for (uint32_t Row = 0; Row < Store.GetSize(); ++Row) {
+    auto Which = Row % Names.size();
+    if (Which <= 2) {
+      Expected.push_back(Row);
+    }
+    auto Name = Index.GetName(Row);
+    EXPECT_EQ(bool(Name), Which < 13) << Row;
+  }
+  EXPECT_EQ(Find(Index, "Circle::area"), Expected);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+#
+# Regenerates the accelerator table fixtures. shapes.ll is compiled with llc
+# into a Mach-O object file twice, as DWARF 4 with the Apple tables and as
+# DWARF 5 with .debug_names. The __DWARF sections of the object are then
+# wrapped into a minimal 64-bit dSYM-like Mach-O:
+#
+#   mach_header_64 (MH_DSYM)
+#   LC_UUID
+#   LC_SEGMENT_64 __DWARF  every __DWARF section of the object
+#
+# Objects are not linked, so the addresses are those of the object's __text,
+# starting at 0. Expected values in test.cpp come from
+#
+#   llvm-dwarfdump --debug-info --apple-names --debug-names shapes-v<N>.o
+#
+# usage: make_fixtures.py  (run from this directory)
+
+import os
+import struct
+import subprocess
+import tempfile
+
+MH_MAGIC_64 = 0xFEEDFACF
+MH_DSYM = 0xA
+CPU_TYPE_X86_64 = 0x01000007
+CPU_SUBTYPE_X86_64_ALL = 3
+LC_SEGMENT_64 = 0x19
+LC_UUID = 0x1B
+
+
+def run(*args):
+    subprocess.run(args, check=True)
+
+
+def name16(name):
+    return name.encode().ljust(16, b"\0")
+
+
+def dwarf_sections(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic, _, _, _, ncmds, _, _, _ = struct.unpack_from("<IiiIIIII", data)
+    assert magic == MH_MAGIC_64
+    sections = []
+    offset = 32
+    for _ in range(ncmds):
+        cmd, size = struct.unpack_from("<II", data, offset)
+        if cmd == LC_SEGMENT_64:
+            nsects = struct.unpack_from("<I", data, offset + 64)[0]
+            for i in range(nsects):
+                record = struct.unpack_from("<16s16sQQI", data,
+                                            offset + 72 + 80 * i)
+                sect, seg, _, length, fileoff = record
+                if seg.rstrip(b"\0") == b"__DWARF":
+                    sections.append((sect.rstrip(b"\0").decode(),
+                                     data[fileoff:fileoff + length]))
+        offset += size
+    return sections
+
+
+def macho(version, sections):
+    header_size = 32
+    uuid_size = 24
+    dwarf_size = 72 + 80 * len(sections)
+    commands = uuid_size + dwarf_size
+
+    offset = header_size + commands
+    data = b""
+    records = b""
+    for name, contents in sections:
+        records += struct.pack("<16s16sQQIIIIIIII", name16(name),
+                               name16("__DWARF"), 0, len(contents), offset,
+                               0, 0, 0, 0, 0, 0, 0)
+        data += contents
+        offset += len(contents)
+
+    out = struct.pack("<IiiIIIII", MH_MAGIC_64, CPU_TYPE_X86_64,
+                      CPU_SUBTYPE_X86_64_ALL, MH_DSYM, 2, commands, 0, 0)
+    out += struct.pack("<II16s", LC_UUID, uuid_size,
+                       bytes([version] * 16))
+    out += struct.pack("<II16sQQQQiiII", LC_SEGMENT_64, dwarf_size,
+                       name16("__DWARF"), 0, 0, header_size + commands,
+                       len(data), 7, 3, len(sections), 0)
+    return out + records + data
+
+
+def main():
+    with open("shapes.ll") as f:
+        source = f.read()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        for version, tables in ((4, "Apple"), (5, "Dwarf")):
+            ll = os.path.join(tmp, "shapes-v%d.ll" % version)
+            obj = os.path.join(tmp, "shapes-v%d.o" % version)
+            with open(ll, "w") as f:
+                f.write(source.replace('"Dwarf Version", i32 4',
+                                       '"Dwarf Version", i32 %d' % version))
+            run("llc", "-O0", "-filetype=obj", "-accel-tables=" + tables,
+                "-o", obj, ll)
+            with open("shapes-v%d.dwarf" % version, "wb") as f:
+                f.write(macho(version, dwarf_sections(obj)))
+            run("llvm-dwarfdump", "--debug-info", obj)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,121 @@
+; Debug info of the following, written out as IR so that the fixtures can be
+; built with llc alone. See make_fixtures.py.
+;
+;   namespace geo {
+;   class Circle {
+;   public:
+;     int area();
+;     int radius();
+;     static int count();
+;     int diameter() const;
+;   };
+;   }
+;   class Square {
+;   public:
+;     int area();
+;   };
+;   int geo::Circle::area() { return 1; }
+;   int geo::Circle::radius() { return 2; }
+;   int geo::Circle::count() { return 3; }
+;   int Square::area() { return 4; }
+;   int area() { return 5; }
+;   - (void)draw {}     // @implementation Shape
+;   + (void)shared {}
+;   int geo::Circle::diameter() const { return 6; }
+;
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.15.0"
+
+%"class.geo::Circle" = type { i32 }
+%class.Square = type { i32 }
+
+define i32 @_ZN3geo6Circle4areaEv(%"class.geo::Circle"* %this) !dbg !30 {
+  call void @llvm.dbg.value(metadata %"class.geo::Circle"* %this, metadata !31, metadata !DIExpression()), !dbg !32
+  ret i32 1, !dbg !32
+}
+
+define i32 @_ZN3geo6Circle6radiusEv(%"class.geo::Circle"* %this) !dbg !33 {
+  call void @llvm.dbg.value(metadata %"class.geo::Circle"* %this, metadata !34, metadata !DIExpression()), !dbg !35
+  ret i32 2, !dbg !35
+}
+
+define i32 @_ZN3geo6Circle5countEv() !dbg !36 {
+  ret i32 3, !dbg !37
+}
+
+define i32 @_ZN6Square4areaEv(%class.Square* %this) !dbg !40 {
+  call void @llvm.dbg.value(metadata %class.Square* %this, metadata !41, metadata !DIExpression()), !dbg !42
+  ret i32 4, !dbg !42
+}
+
+define i32 @_Z4areav() !dbg !50 {
+  ret i32 5, !dbg !51
+}
+
+define void @"\01-[Shape draw]"() !dbg !60 {
+  ret void, !dbg !61
+}
+
+define void @"\01+[Shape shared]"() !dbg !62 {
+  ret void, !dbg !63
+}
+
+define i32 @_ZNK3geo6Circle8diameterEv(%"class.geo::Circle"* %this) !dbg !70 {
+  call void @llvm.dbg.value(metadata %"class.geo::Circle"* %this, metadata !71, metadata !DIExpression()), !dbg !72
+  ret i32 6, !dbg !72
+}
+
+declare void @llvm.dbg.value(metadata, metadata, metadata)
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!1, !2}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !3, producer: "shapes.ll", isOptimized: false, runtimeVersion: 0, emissionKind: FullDebug)
+!1 = !{i32 7, !"Dwarf Version", i32 4}
+!2 = !{i32 2, !"Debug Info Version", i32 3}
+!3 = !DIFile(filename: "shapes.cpp", directory: "/work")
+!4 = !DINamespace(name: "geo", scope: null)
+!5 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!6 = !DISubroutineType(types: !{!5})
+
+!10 = distinct !DICompositeType(tag: DW_TAG_class_type, name: "Circle", scope: !4, file: !3, line: 2, size: 32, flags: DIFlagTypePassByValue, elements: !11, identifier: "_ZTSN3geo6CircleE")
+!11 = !{!12, !13, !14, !18}
+!12 = !DISubprogram(name: "area", linkageName: "_ZN3geo6Circle4areaEv", scope: !10, file: !3, line: 4, type: !15, scopeLine: 4, flags: DIFlagPublic | DIFlagPrototyped, spFlags: 0)
+!13 = !DISubprogram(name: "radius", linkageName: "_ZN3geo6Circle6radiusEv", scope: !10, file: !3, line: 5, type: !15, scopeLine: 5, flags: DIFlagPublic | DIFlagPrototyped, spFlags: 0)
+!14 = !DISubprogram(name: "count", linkageName: "_ZN3geo6Circle5countEv", scope: !10, file: !3, line: 6, type: !6, scopeLine: 6, flags: DIFlagPublic | DIFlagPrototyped | DIFlagStaticMember, spFlags: 0)
+!15 = !DISubroutineType(types: !{!5, !16})
+!16 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !10, size: 64, flags: DIFlagArtificial | DIFlagObjectPointer)
+!17 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !10, size: 64)
+!18 = !DISubprogram(name: "diameter", linkageName: "_ZNK3geo6Circle8diameterEv", scope: !10, file: !3, line: 7, type: !26, scopeLine: 7, flags: DIFlagPublic | DIFlagPrototyped, spFlags: 0)
+!26 = !DISubroutineType(types: !{!5, !27})
+!27 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !28, size: 64, flags: DIFlagArtificial | DIFlagObjectPointer)
+!28 = !DIDerivedType(tag: DW_TAG_const_type, baseType: !10)
+!29 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !28, size: 64)
+
+!20 = distinct !DICompositeType(tag: DW_TAG_class_type, name: "Square", file: !3, line: 9, size: 32, flags: DIFlagTypePassByValue, elements: !21, identifier: "_ZTS6Square")
+!21 = !{!22}
+!22 = !DISubprogram(name: "area", linkageName: "_ZN6Square4areaEv", scope: !20, file: !3, line: 11, type: !23, scopeLine: 11, flags: DIFlagPublic | DIFlagPrototyped, spFlags: 0)
+!23 = !DISubroutineType(types: !{!5, !24})
+!24 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !20, size: 64, flags: DIFlagArtificial | DIFlagObjectPointer)
+!25 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !20, size: 64)
+
+!30 = distinct !DISubprogram(name: "area", linkageName: "_ZN3geo6Circle4areaEv", scope: !10, file: !3, line: 14, type: !15, scopeLine: 14, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, declaration: !12, retainedNodes: !{})
+!31 = !DILocalVariable(name: "this", arg: 1, scope: !30, type: !17, flags: DIFlagArtificial | DIFlagObjectPointer)
+!32 = !DILocation(line: 14, scope: !30)
+!33 = distinct !DISubprogram(name: "radius", linkageName: "_ZN3geo6Circle6radiusEv", scope: !10, file: !3, line: 15, type: !15, scopeLine: 15, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, declaration: !13, retainedNodes: !{})
+!34 = !DILocalVariable(name: "this", arg: 1, scope: !33, type: !17, flags: DIFlagArtificial | DIFlagObjectPointer)
+!35 = !DILocation(line: 15, scope: !33)
+!36 = distinct !DISubprogram(name: "count", linkageName: "_ZN3geo6Circle5countEv", scope: !10, file: !3, line: 16, type: !6, scopeLine: 16, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, declaration: !14, retainedNodes: !{})
+!37 = !DILocation(line: 16, scope: !36)
+!40 = distinct !DISubprogram(name: "area", linkageName: "_ZN6Square4areaEv", scope: !20, file: !3, line: 18, type: !23, scopeLine: 18, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, declaration: !22, retainedNodes: !{})
+!41 = !DILocalVariable(name: "this", arg: 1, scope: !40, type: !25, flags: DIFlagArtificial | DIFlagObjectPointer)
+!42 = !DILocation(line: 18, scope: !40)
+!50 = distinct !DISubprogram(name: "area", linkageName: "_Z4areav", scope: !3, file: !3, line: 20, type: !6, scopeLine: 20, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !{})
+!51 = !DILocation(line: 20, scope: !50)
+!60 = distinct !DISubprogram(name: "-[Shape draw]", scope: !3, file: !3, line: 22, type: !6, scopeLine: 22, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !{})
+!61 = !DILocation(line: 22, scope: !60)
+!62 = distinct !DISubprogram(name: "+[Shape shared]", scope: !3, file: !3, line: 23, type: !6, scopeLine: 23, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, retainedNodes: !{})
+!63 = !DILocation(line: 23, scope: !62)
+!70 = distinct !DISubprogram(name: "diameter", linkageName: "_ZNK3geo6Circle8diameterEv", scope: !10, file: !3, line: 24, type: !26, scopeLine: 24, flags: DIFlagPrototyped, spFlags: DISPFlagDefinition, unit: !0, declaration: !18, retainedNodes: !{})
+!71 = !DILocalVariable(name: "this", arg: 1, scope: !70, type: !29, flags: DIFlagArtificial | DIFlagObjectPointer)
+!72 = !DILocation(line: 24, scope: !70)
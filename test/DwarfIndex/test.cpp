@@ -0,0 +1,168 @@
+// Std
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/DwarfIndex.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/MappedFile.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// See fixtures/make_fixtures.py. Version 4 has the Apple tables, version 5
+// .debug_names, the functions are the same in both.
+static const char *Fixtures[] = {"shapes-v4.dwarf", "shapes-v5.dwarf"};
+
+class dwarf_index_test : public ::testing::Test {
+protected:
+  MappedFile File;
+  std::unique_ptr<MachOFileParser64> Parser;
+
+  DwarfIndex *Open(const char *Name) {
+    auto Path = std::string(FIXTURES_DIR) + "/" + Name;
+    if (!File.Open(Path)) {
+      return nullptr;
+    }
+    Parser = std::make_unique<MachOFileParser64>(Path, File.GetView(),
+                                                 MO_PARSE_FILE);
+    if (!Parser->Parse()) {
+      return nullptr;
+    }
+    return Parser->GetDwarfIndex();
+  }
+
+  ByteView GetSection(std::string Name) {
+    auto Section = Parser->GetSegmentByName("__DWARF")->GetSectionByName(Name);
+    return Section ? File.GetView().Slice(Section->FileOffset,
+                                          Section->VirtualSize)
+                   : ByteView();
+  }
+};
+
+static std::vector<uint64_t>
+GetAddresses(const std::vector<DwarfFunction> &Functions) {
+  std::vector<uint64_t> Result;
+  for (auto &Function : Functions) {
+    Result.push_back(Function.Address);
+  }
+  std::sort(Result.begin(), Result.end());
+  return Result;
+}
+
+TEST_F(dwarf_index_test, FindsMethods) {
+  for (auto Name : Fixtures) {
+    SCOPED_TRACE(Name);
+    auto Index = Open(Name);
+    ASSERT_TRUE(Index);
+
+    // Both classes have one, the free function is left out
+    std::vector<DwarfFunction> Functions;
+    ASSERT_TRUE(Index->FindMethods("area", Functions));
+    EXPECT_EQ(GetAddresses(Functions), std::vector<uint64_t>({0x0, 0x30}));
+    for (auto &Function : Functions) {
+      EXPECT_EQ(Function.Name, Function.Address ? "_ZN6Square4areaEv"
+                                                : "_ZN3geo6Circle4areaEv");
+    }
+
+    // Static, it has no this pointer but is declared in the class
+    Functions.clear();
+    ASSERT_TRUE(Index->FindMethods("count", Functions));
+    EXPECT_EQ(GetAddresses(Functions), std::vector<uint64_t>({0x20}));
+
+    Functions.clear();
+    ASSERT_TRUE(Index->FindMethods("diameter", Functions));
+    EXPECT_EQ(GetAddresses(Functions), std::vector<uint64_t>({0x70}));
+
+    Functions.clear();
+    EXPECT_FALSE(Index->FindMethods("perimeter", Functions));
+    EXPECT_TRUE(Functions.empty());
+  }
+}
+
+TEST_F(dwarf_index_test, FindsClassMethods) {
+  for (auto Name : Fixtures) {
+    SCOPED_TRACE(Name);
+    auto Index = Open(Name);
+    ASSERT_TRUE(Index);
+
+    // diameter is const, its linkage name starts with _ZNK
+    std::vector<DwarfFunction> Functions;
+    ASSERT_TRUE(Index->FindClassMethods("geo::Circle", Functions));
+    EXPECT_EQ(GetAddresses(Functions),
+              std::vector<uint64_t>({0x0, 0x10, 0x20, 0x70}));
+
+    // Unqualified names match the class in any scope
+    Functions.clear();
+    ASSERT_TRUE(Index->FindClassMethods("Circle", Functions));
+    EXPECT_EQ(GetAddresses(Functions),
+              std::vector<uint64_t>({0x0, 0x10, 0x20, 0x70}));
+
+    Functions.clear();
+    ASSERT_TRUE(Index->FindClassMethods("Square", Functions));
+    EXPECT_EQ(GetAddresses(Functions), std::vector<uint64_t>({0x30}));
+    EXPECT_EQ(Functions[0].Name, "_ZN6Square4areaEv");
+
+    Functions.clear();
+    EXPECT_FALSE(Index->FindClassMethods("other::Circle", Functions));
+    EXPECT_FALSE(Index->FindClassMethods("geo", Functions));
+    EXPECT_FALSE(Index->FindClassMethods("Triangle", Functions));
+    EXPECT_TRUE(Functions.empty());
+  }
+}
+
+TEST_F(dwarf_index_test, FindsObjCMethods) {
+  // Only the Apple tables know Objective-C classes
+  auto Index = Open("shapes-v4.dwarf");
+  ASSERT_TRUE(Index);
+
+  std::vector<DwarfFunction> Functions;
+  ASSERT_TRUE(Index->FindClassMethods("Shape", Functions));
+  EXPECT_EQ(GetAddresses(Functions), std::vector<uint64_t>({0x50, 0x60}));
+
+  // By selector and by the whole name
+  Functions.clear();
+  ASSERT_TRUE(Index->FindMethods("draw", Functions));
+  ASSERT_EQ(GetAddresses(Functions), std::vector<uint64_t>({0x50}));
+  EXPECT_EQ(Functions[0].Name, "-[Shape draw]");
+
+  Functions.clear();
+  ASSERT_TRUE(Index->FindMethods("+[Shape shared]", Functions));
+  EXPECT_EQ(GetAddresses(Functions), std::vector<uint64_t>({0x60}));
+}
+
+TEST_F(dwarf_index_test, SurvivesDamagedSections) {
+  ASSERT_TRUE(Open("shapes-v4.dwarf"));
+
+  DwarfSections Sections;
+  Sections.Info = GetSection("__debug_info");
+  Sections.Abbrev = GetSection("__debug_abbrev");
+  Sections.Str = GetSection("__debug_str");
+
+  // Nothing to probe
+  EXPECT_TRUE(DwarfIndex(Sections).IsEmpty());
+
+  // A bucket count of 0 makes the table unusable
+  auto Names = GetSection("__apple_names");
+  std::vector<char> Bytes(Names.GetData(), Names.GetData() + Names.GetSize());
+  Bytes[8] = Bytes[9] = Bytes[10] = Bytes[11] = 0;
+  Sections.AppleNames = ByteView(Bytes.data(), Bytes.size());
+  EXPECT_TRUE(DwarfIndex(Sections).IsEmpty());
+
+  // Abbreviations cut short, every DIE lookup fails
+  Sections.AppleNames = Names;
+  Sections.Abbrev = Sections.Abbrev.Slice(0, 8);
+  DwarfIndex Truncated(Sections);
+  ASSERT_FALSE(Truncated.IsEmpty());
+  std::vector<DwarfFunction> Functions;
+  EXPECT_FALSE(Truncated.FindMethods("area", Functions));
+  EXPECT_TRUE(Functions.empty());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,5 @@
+#include "util.h"
+
+int helper(int Value) {
+  return square(Value) + 1;
+}
@@ -0,0 +1,12 @@
+#include "util.h"
+
+int helper(int Value);
+
+int main(void) {
+  int Sum = 0;
+  for (int i = 0; i < 4; ++i) {
+    Sum += square(i);
+  }
+
+  return helper(Sum);
+}
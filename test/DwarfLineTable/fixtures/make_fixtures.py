@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+#
+# Regenerates the line table fixtures. The sources are compiled on any host
+# with gcc into an ELF executable, its line table sections are then wrapped
+# into a minimal 64-bit dSYM-like Mach-O:
+#
+#   mach_header_64 (MH_DSYM)
+#   LC_UUID
+#   LC_SEGMENT_64 __TEXT   no sections, vmaddr of the ELF .text
+#   LC_SEGMENT_64 __DWARF  __debug_line, __debug_line_str, __debug_str
+#
+# Expected values in test.cpp come from
+#
+#   readelf --debug-dump=decodedline lines-v<N>.elf
+#
+# usage: make_fixtures.py  (run from this directory)
+
+import os
+import struct
+import subprocess
+import tempfile
+
+MH_MAGIC_64 = 0xFEEDFACF
+MH_DSYM = 0xA
+CPU_TYPE_X86_64 = 0x01000007
+CPU_SUBTYPE_X86_64_ALL = 3
+LC_SEGMENT_64 = 0x19
+LC_UUID = 0x1B
+
+SOURCES = ["lines.c", "helper.c"]
+SECTIONS = [".debug_line", ".debug_line_str", ".debug_str"]
+
+
+def run(*args):
+    subprocess.run(args, check=True)
+
+
+def section(elf, name, tmp):
+    out = os.path.join(tmp, name.strip("."))
+    run("objcopy", "-O", "binary", "--only-section=" + name,
+        "--set-section-flags", name + "=alloc", elf, out)
+    with open(out, "rb") as f:
+        return f.read()
+
+
+def text_address(elf):
+    out = subprocess.run(["readelf", "-SW", elf], check=True,
+                         capture_output=True, text=True).stdout
+    for line in out.splitlines():
+        fields = line.replace("[ ", "[").split()
+        if len(fields) > 3 and fields[1] == ".text":
+            return int(fields[3], 16)
+    raise RuntimeError("no .text in " + elf)
+
+
+def name16(name):
+    return name.encode().ljust(16, b"\0")
+
+
+def macho(version, text, sections):
+    header_size = 32
+    uuid_size = 24
+    text_size = 72
+    dwarf_size = 72 + 80 * len(sections)
+    commands = uuid_size + text_size + dwarf_size
+
+    offset = header_size + commands
+    data = b""
+    records = b""
+    for name, contents in sections:
+        records += struct.pack("<16s16sQQIIIIIIII", name16(name),
+                               name16("__DWARF"), 0, len(contents), offset,
+                               0, 0, 0, 0, 0, 0, 0)
+        data += contents
+        offset += len(contents)
+
+    out = struct.pack("<IiiIIIII", MH_MAGIC_64, CPU_TYPE_X86_64,
+                      CPU_SUBTYPE_X86_64_ALL, MH_DSYM, 3, commands, 0, 0)
+    out += struct.pack("<II16s", LC_UUID, uuid_size,
+                       bytes([version] * 16))
+    out += struct.pack("<II16sQQQQiiII", LC_SEGMENT_64, text_size,
+                       name16("__TEXT"), text & ~0xFFF, 0x1000, 0, 0, 5, 5,
+                       0, 0)
+    out += struct.pack("<II16sQQQQiiII", LC_SEGMENT_64, dwarf_size,
+                       name16("__DWARF"), 0, 0, header_size + commands,
+                       len(data), 7, 3, len(sections), 0)
+    return out + records + data
+
+
+def main():
+    with tempfile.TemporaryDirectory() as tmp:
+        for version in (4, 5):
+            elf = "lines-v%d.elf" % version
+            # No C runtime, so the only units are our own
+            run("gcc", "-g", "-gdwarf-%d" % version, "-O0", "-nostdlib",
+                "-fdebug-prefix-map=%s=/work" % os.getcwd(),
+                "-static", "-Wl,-e,main", "-Wl,--build-id=none",
+                "-fno-asynchronous-unwind-tables", "-o",
+                os.path.join(tmp, elf), *SOURCES)
+            path = os.path.join(tmp, elf)
+            sections = [("__" + s.strip("."), section(path, s, tmp))
+                        for s in SECTIONS]
+            sections = [(n, c) for n, c in sections if c]
+            with open("lines-v%d.dwarf" % version, "wb") as f:
+                f.write(macho(version, text_address(path), sections))
+            run("readelf", "--debug-dump=decodedline", path)
+
+
+if __name__ == "__main__":
+    main()
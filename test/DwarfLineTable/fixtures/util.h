@@ -0,0 +1,3 @@
+static inline int square(int X) {
+  return X * X;
+}
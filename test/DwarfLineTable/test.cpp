@@ -0,0 +1,156 @@
+// Std
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/DwarfLineTable.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/MappedFile.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// See fixtures/make_fixtures.py, both versions are built from the same
+// sources, so they share the expected values
+static const char *Fixtures[] = {"lines-v4.dwarf", "lines-v5.dwarf"};
+
+class dwarf_line_table_test : public ::testing::Test {
+protected:
+  MappedFile File;
+  std::unique_ptr<MachOFileParser64> Parser;
+
+  DwarfLineTable *Open(const char *Name) {
+    auto Path = std::string(FIXTURES_DIR) + "/" + Name;
+    if (!File.Open(Path)) {
+      return nullptr;
+    }
+    Parser = std::make_unique<MachOFileParser64>(Path, File.GetView(),
+                                                 MO_PARSE_FILE);
+    if (!Parser->Parse()) {
+      return nullptr;
+    }
+    return Parser->GetLineTable();
+  }
+};
+
+TEST_F(dwarf_line_table_test, FindsSections) {
+  for (auto Name : Fixtures) {
+    SCOPED_TRACE(Name);
+    auto Table = Open(Name);
+    ASSERT_TRUE(Table);
+    // lines.c and helper.c
+    EXPECT_EQ(Table->GetUnitCount(), 2u);
+  }
+}
+
+TEST_F(dwarf_line_table_test, LooksUpAddresses) {
+  for (auto Name : Fixtures) {
+    SCOPED_TRACE(Name);
+    auto Table = Open(Name);
+    ASSERT_TRUE(Table);
+
+    LineInfo Info;
+    ASSERT_TRUE(Table->LookupAddress(0x40102a, Info));
+    EXPECT_EQ(Info.Address, 0x401027u);
+    EXPECT_EQ(Info.Line, 8u);
+    EXPECT_TRUE(Info.IsStatement);
+    EXPECT_TRUE(Info.File.size() >= 7 &&
+                Info.File.substr(Info.File.size() - 7) == "lines.c");
+
+    // The first row of the second unit, square() is in both
+    ASSERT_TRUE(Table->LookupAddress(0x40104a, Info));
+    EXPECT_EQ(Info.Line, 1u);
+    EXPECT_TRUE(Info.File.size() >= 6 &&
+                Info.File.substr(Info.File.size() - 6) == "util.h");
+
+    ASSERT_TRUE(Table->LookupAddress(0x401072, Info));
+    EXPECT_EQ(Info.Address, 0x401071u);
+    EXPECT_EQ(Info.Line, 5u);
+
+    // Outside of every sequence
+    EXPECT_FALSE(Table->LookupAddress(0x400fff, Info));
+    EXPECT_FALSE(Table->LookupAddress(0x401073, Info));
+  }
+}
+
+TEST_F(dwarf_line_table_test, LooksUpLines) {
+  for (auto Name : Fixtures) {
+    SCOPED_TRACE(Name);
+    auto Table = Open(Name);
+    ASSERT_TRUE(Table);
+
+    std::vector<uint64_t> Addresses;
+    uint32_t Line;
+
+    // Only where the line starts, not each of its rows
+    ASSERT_TRUE(Table->LookupLine("lines.c", 8, Addresses, Line));
+    EXPECT_EQ(Line, 8u);
+    EXPECT_EQ(Addresses, std::vector<uint64_t>({0x401027}));
+
+    // The loop condition is entered twice
+    ASSERT_TRUE(Table->LookupLine("lines.c", 7, Addresses, Line));
+    EXPECT_EQ(Addresses, std::vector<uint64_t>({0x40101e, 0x401034}));
+
+    // An empty line moves to the next one with code
+    ASSERT_TRUE(Table->LookupLine("lines.c", 10, Addresses, Line));
+    EXPECT_EQ(Line, 11u);
+    EXPECT_EQ(Addresses, std::vector<uint64_t>({0x40103e}));
+
+    // A header included by both units
+    ASSERT_TRUE(Table->LookupLine("util.h", 2, Addresses, Line));
+    EXPECT_EQ(Addresses, std::vector<uint64_t>({0x401007, 0x401051}));
+
+    ASSERT_TRUE(Table->LookupLine("helper.c", 4, Addresses, Line));
+    EXPECT_EQ(Addresses, std::vector<uint64_t>({0x401064}));
+
+    EXPECT_FALSE(Table->LookupLine("lines.c", 13, Addresses, Line));
+    EXPECT_FALSE(Table->LookupLine("ines.c", 8, Addresses, Line));
+    EXPECT_FALSE(Table->LookupLine("other.c", 1, Addresses, Line));
+    EXPECT_TRUE(Addresses.empty());
+  }
+}
+
+TEST_F(dwarf_line_table_test, MatchesWholePaths) {
+  // Only version 5 knows the compilation directory
+  auto Table = Open("lines-v5.dwarf");
+  ASSERT_TRUE(Table);
+
+  std::vector<uint64_t> Addresses;
+  uint32_t Line;
+  EXPECT_TRUE(Table->LookupLine("/work/lines.c", 8, Addresses, Line));
+  EXPECT_TRUE(Table->LookupLine("work/lines.c", 8, Addresses, Line));
+  EXPECT_FALSE(Table->LookupLine("/lines.c", 8, Addresses, Line));
+}
+
+TEST_F(dwarf_line_table_test, SurvivesDamagedSections) {
+  auto Table = Open("lines-v4.dwarf");
+  ASSERT_TRUE(Table);
+
+  auto Section = Parser->GetSegmentByName("__DWARF")->GetSectionByName(
+      "__debug_line");
+  ASSERT_TRUE(Section);
+  auto Lines = File.GetView().Slice(Section->FileOffset, Section->VirtualSize);
+
+  // Cut in the middle of the first unit's program, its complete sequences
+  // and the other unit are gone with it
+  DwarfLineTable Truncated(Lines.Slice(0, 60));
+  LineInfo Info;
+  EXPECT_FALSE(Truncated.LookupAddress(0x401000, Info));
+
+  // A bad header of one unit leaves the others usable
+  std::vector<char> Bytes(Lines.GetData(), Lines.GetData() + Lines.GetSize());
+  // Version of the first unit
+  Bytes[4] = 42;
+  DwarfLineTable Damaged(ByteView(Bytes.data(), Bytes.size()));
+  EXPECT_EQ(Damaged.GetUnitCount(), 2u);
+  EXPECT_FALSE(Damaged.LookupAddress(0x401000, Info));
+  ASSERT_TRUE(Damaged.LookupAddress(0x401064, Info));
+  EXPECT_EQ(Info.Line, 4u);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,148 @@
+// System
+#include <mach-o/loader.h>
+
+// Std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/ExportTrie.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// Tries are encoded by hand, every node on a line of its own after its offset
+// and the name it stands for. Edges sharing a prefix, _foo and _foobar or
+// _bar and _baz, go through the same nodes.
+static const uint8_t Exports[] = {
+    // 0: root, an edge _ to 5
+    0x00, 0x01, '_', 0x00, 0x05,
+    // 5: _, edges foo, ba, resolved and weak
+    0x00, 0x04, 'f', 'o', 'o', 0x00, 0x20, 'b', 'a', 0x00, 0x2e, 'r', 'e',
+    's', 'o', 'l', 'v', 'e', 'd', 0x00, 0x44, 'w', 'e', 'a', 'k', 0x00,
+    0x4b,
+    // 32: _foo, regular at 0x1000, an edge bar
+    0x03, 0x00, 0x80, 0x20, 0x01, 'b', 'a', 'r', 0x00, 0x2a,
+    // 42: _foobar, absolute 0x42
+    0x02, 0x02, 0x42, 0x00,
+    // 46: _ba, no terminal, edges r and z
+    0x00, 0x02, 'r', 0x00, 0x36, 'z', 0x00, 0x3f,
+    // 54: _bar, re-exported from library 2 as _baz
+    0x07, 0x08, 0x02, '_', 'b', 'a', 'z', 0x00, 0x00,
+    // 63: _baz, re-exported from library 1 under the same name
+    0x03, 0x08, 0x01, 0x00, 0x00,
+    // 68: _resolved, stub at 0x2000 and resolver at 0x3000
+    0x05, 0x10, 0x80, 0x40, 0x80, 0x60, 0x00,
+    // 75: _weak, weak definition at 0x10
+    0x02, 0x04, 0x10, 0x00};
+
+static const char *Names[] = {"_foo", "_foobar", "_bar",
+                              "_baz", "_resolved", "_weak"};
+
+class export_trie : public ::testing::Test {
+protected:
+  ExportTrie Trie = ExportTrie(ByteView(Exports, sizeof(Exports)));
+};
+
+TEST_F(export_trie, FindsRegularAndAbsoluteExports) {
+  ExportTrie::Export Export;
+  ASSERT_TRUE(Trie.Lookup("_foo", Export));
+  EXPECT_EQ(Export.GetKind(), uint64_t(EXPORT_SYMBOL_FLAGS_KIND_REGULAR));
+  EXPECT_EQ(Export.Address, 0x1000u);
+  EXPECT_FALSE(Export.IsReExport());
+  EXPECT_FALSE(Export.IsStubAndResolver());
+  EXPECT_FALSE(Export.IsWeakDefinition());
+
+  // Below a node that is an export itself
+  ASSERT_TRUE(Trie.Lookup("_foobar", Export));
+  EXPECT_EQ(Export.GetKind(), uint64_t(EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE));
+  EXPECT_EQ(Export.Address, 0x42u);
+
+  ASSERT_TRUE(Trie.Lookup("_weak", Export));
+  EXPECT_TRUE(Export.IsWeakDefinition());
+  EXPECT_EQ(Export.Address, 0x10u);
+}
+
+TEST_F(export_trie, FindsReExports) {
+  ExportTrie::Export Export;
+  ASSERT_TRUE(Trie.Lookup("_bar", Export));
+  EXPECT_TRUE(Export.IsReExport());
+  EXPECT_EQ(Export.Other, 2u);
+  EXPECT_EQ(Export.ImportName, "_baz");
+
+  ASSERT_TRUE(Trie.Lookup("_baz", Export));
+  EXPECT_TRUE(Export.IsReExport());
+  EXPECT_EQ(Export.Other, 1u);
+  EXPECT_TRUE(Export.ImportName.empty());
+}
+
+TEST_F(export_trie, FindsStubsAndResolvers) {
+  ExportTrie::Export Export;
+  ASSERT_TRUE(Trie.Lookup("_resolved", Export));
+  EXPECT_TRUE(Export.IsStubAndResolver());
+  EXPECT_EQ(Export.Address, 0x2000u);
+  EXPECT_EQ(Export.Other, 0x3000u);
+}
+
+TEST_F(export_trie, MissesAbsentNames) {
+  ExportTrie::Export Export;
+  // No edge, ends inside an edge, goes past a leaf, ends at a node that is
+  // no export
+  EXPECT_FALSE(Trie.Lookup("_qux", Export));
+  EXPECT_FALSE(Trie.Lookup("_fo", Export));
+  EXPECT_FALSE(Trie.Lookup("_foobarbaz", Export));
+  EXPECT_FALSE(Trie.Lookup("_ba", Export));
+  EXPECT_FALSE(Trie.Lookup("_", Export));
+  EXPECT_FALSE(Trie.Lookup("", Export));
+  EXPECT_FALSE(ExportTrie().Lookup("_foo", Export));
+}
+
+// Whatever is cut off, a lookup either fails or finds what the whole trie has
+TEST_F(export_trie, StaysInTruncatedTries) {
+  for (size_t Size = 0; Size < sizeof(Exports); ++Size) {
+    std::vector<uint8_t> Copy(Exports, Exports + Size);
+    ExportTrie Truncated(ByteView(Copy.data(), Copy.size()));
+    for (auto Name : Names) {
+      ExportTrie::Export Expected, Export;
+      ASSERT_TRUE(Trie.Lookup(Name, Expected));
+      if (!Truncated.Lookup(Name, Export)) {
+        continue;
+      }
+      EXPECT_EQ(Export.Flags, Expected.Flags) << Name << " in " << Size;
+      EXPECT_EQ(Export.Address, Expected.Address) << Name << " in " << Size;
+      EXPECT_EQ(Export.Other, Expected.Other) << Name << " in " << Size;
+      EXPECT_EQ(Export.ImportName, Expected.ImportName)
+          << Name << " in " << Size;
+    }
+  }
+
+  // Cut inside the import name of _bar
+  ExportTrie Truncated(ByteView(Exports, 59));
+  ExportTrie::Export Export;
+  EXPECT_FALSE(Truncated.Lookup("_bar", Export));
+  EXPECT_TRUE(Truncated.Lookup("_foobar", Export));
+}
+
+TEST_F(export_trie, StopsOnCycles) {
+  // 0: root, an edge a back to itself, and an edge b to 8
+  // 8: b, an edge c back to the root
+  static const uint8_t Cyclic[] = {0x00, 0x02, 'a', 0x00, 0x00, 'b', 0x00,
+                                   0x08, 0x00, 0x01, 'c', 0x00, 0x00};
+  ExportTrie Cycle(ByteView(Cyclic, sizeof(Cyclic)));
+  ExportTrie::Export Export;
+  EXPECT_FALSE(Cycle.Lookup(std::string(100000, 'a'), Export));
+
+  std::string Name;
+  for (int i = 0; i < 10000; ++i) {
+    Name += "bc";
+  }
+  EXPECT_FALSE(Cycle.Lookup(Name, Export));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,245 @@
+// System
+#include <mach-o/loader.h>
+#include <mach-o/nlist.h>
+
+// Std
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/GlobalSymbolIndex.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// An image with a few symbols, the libraries it links against and an install
+// name
+class FakeImage {
+public:
+  struct Library {
+    std::string Name;
+  };
+
+  class FakeSymbolTable {
+  public:
+    SymbolStore Store;
+    const SymbolStore &GetSymbols() { return Store; }
+  };
+
+  struct Entry {
+    std::string Name;
+    uint8_t Type;
+    uint8_t Ordinal;
+  };
+
+  std::string InstallName;
+  uint32_t Type;
+  std::vector<std::shared_ptr<Library>> Libraries;
+  std::string Strings;
+  FakeSymbolTable Table;
+
+  FakeImage(std::string InstallName, uint32_t Type,
+            std::vector<std::string> Linked, std::vector<Entry> Entries,
+            bool IsTwoLevel = true)
+      : InstallName(InstallName), Type(Type), Strings(1, '\0') {
+    for (auto &Name : Linked) {
+      Libraries.push_back(std::make_shared<Library>(Library{Name}));
+    }
+
+    std::vector<uint32_t> Offsets;
+    for (auto &E : Entries) {
+      Offsets.push_back(Strings.size());
+      Strings += E.Name + '\0';
+    }
+
+    // Values are rows
+    Table.Store.Reset(ByteView(Strings.data(), Strings.size()), Entries.size(),
+                      0);
+    Table.Store.IsTwoLevel = IsTwoLevel;
+    for (uint32_t i = 0; i < Entries.size(); ++i) {
+      struct nlist_64 Raw = {};
+      Raw.n_un.n_strx = Offsets[i];
+      Raw.n_type = Entries[i].Type;
+      Raw.n_sect = (Entries[i].Type & N_TYPE) == N_SECT ? 1 : 0;
+      Raw.n_value = i;
+      SET_LIBRARY_ORDINAL(Raw.n_desc, Entries[i].Ordinal);
+      Table.Store.Set(i, Raw, false, true);
+    }
+  }
+
+  auto &GetSymbolTable() { return Table; }
+  auto &GetInstallName() { return InstallName; }
+  auto &GetDyLibraries() { return Libraries; }
+  auto GetType() { return Type; }
+
+  SymbolRef GetSymbol(uint32_t Row) { return SymbolRef(&Table.Store, Row); }
+};
+
+class global_symbol_index_test : public ::testing::Test {
+protected:
+  GlobalSymbolIndex<FakeImage> Index;
+
+  std::shared_ptr<FakeImage> App = std::make_shared<FakeImage>(
+      "/bin/app", MH_EXECUTE,
+      std::vector<std::string>{"/usr/lib/libA.dylib", "/usr/lib/libB.dylib"},
+      std::vector<FakeImage::Entry>{
+          {"_main", N_SECT | N_EXT, 0},
+          {"_helper", N_SECT, 0},
+          {"_shared", N_UNDF | N_EXT, 2},
+          {"_callback", N_SECT | N_EXT, 0},
+          {"_lookup", N_UNDF | N_EXT, DYNAMIC_LOOKUP_ORDINAL},
+          {"_callback", N_UNDF | N_EXT, SELF_LIBRARY_ORDINAL},
+          {"_helper", N_UNDF | N_EXT, 1},
+          {"_late", N_UNDF | N_EXT, DYNAMIC_LOOKUP_ORDINAL}});
+
+  std::shared_ptr<FakeImage> LibA = std::make_shared<FakeImage>(
+      "/usr/lib/libA.dylib", MH_DYLIB, std::vector<std::string>{},
+      std::vector<FakeImage::Entry>{{"_shared", N_SECT | N_EXT, 0},
+                                    {"_lookup", N_SECT | N_EXT, 0},
+                                    {"_helper", N_SECT, 0},
+                                    {"_late", N_SECT, 0}});
+
+  std::shared_ptr<FakeImage> LibB = std::make_shared<FakeImage>(
+      "/usr/lib/libB.dylib", MH_DYLIB, std::vector<std::string>{},
+      std::vector<FakeImage::Entry>{
+          {"_shared", N_SECT | N_EXT, 0},
+          {"_callback", N_UNDF | N_EXT, EXECUTABLE_ORDINAL},
+          {"_stab", N_FUN, 0},
+          {"_late", N_SECT | N_EXT, 0}});
+
+  void AddAll() {
+    Index.AddImage(App);
+    Index.AddImage(LibA);
+    Index.AddImage(LibB);
+  }
+};
+
+TEST_F(global_symbol_index_test, FindsDefinitionsInLoadOrder) {
+  AddAll();
+
+  auto Shared = Index.Lookup("_shared");
+  ASSERT_EQ(Shared.size(), 2u);
+  EXPECT_EQ(Shared[0].Image, LibA);
+  EXPECT_EQ(Shared[1].Image, LibB);
+  EXPECT_EQ(Shared[1].Symbol, LibB->GetSymbol(0));
+
+  // Locals too, but neither undefined symbols nor STABs
+  auto Helper = Index.Lookup("_helper");
+  ASSERT_EQ(Helper.size(), 2u);
+  EXPECT_EQ(Helper[0].Symbol, App->GetSymbol(1));
+  EXPECT_EQ(Helper[1].Symbol, LibA->GetSymbol(2));
+  EXPECT_EQ(Index.Lookup("_callback").size(), 1u);
+  EXPECT_TRUE(Index.Lookup("_stab").empty());
+  EXPECT_TRUE(Index.Lookup("_missing").empty());
+}
+
+TEST_F(global_symbol_index_test, UpdatesAsImagesComeAndGo) {
+  EXPECT_TRUE(Index.Lookup("_shared").empty());
+
+  Index.AddImage(App);
+  EXPECT_TRUE(Index.Lookup("_shared").empty());
+  EXPECT_EQ(Index.Lookup("_main").size(), 1u);
+
+  Index.AddImage(LibA);
+  EXPECT_EQ(Index.FindImage("/usr/lib/libB.dylib"), nullptr);
+  Index.AddImage(LibB);
+  EXPECT_EQ(Index.FindImage("/usr/lib/libB.dylib"), LibB.get());
+
+  Index.RemoveImage(LibA);
+  auto Shared = Index.Lookup("_shared");
+  ASSERT_EQ(Shared.size(), 1u);
+  EXPECT_EQ(Shared[0].Image, LibB);
+  EXPECT_TRUE(Index.Lookup("_lookup").empty());
+
+  // Enough symbols to grow the table past its tombstones
+  std::vector<FakeImage::Entry> Entries;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    Entries.push_back({"_symbol" + std::to_string(i), N_SECT | N_EXT, 0});
+  }
+  Entries.push_back({"_shared", N_SECT | N_EXT, 0});
+  auto Big = std::make_shared<FakeImage>("/usr/lib/libBig.dylib", MH_DYLIB,
+                                         std::vector<std::string>{}, Entries);
+  Index.AddImage(Big);
+  for (uint32_t i = 0; i < 1000; i += 7) {
+    auto Found = Index.Lookup("_symbol" + std::to_string(i));
+    ASSERT_EQ(Found.size(), 1u);
+    EXPECT_EQ(Found[0].Symbol, Big->GetSymbol(i));
+  }
+  Shared = Index.Lookup("_shared");
+  ASSERT_EQ(Shared.size(), 2u);
+  EXPECT_EQ(Shared[0].Image, LibB);
+  EXPECT_EQ(Shared[1].Image, Big);
+
+  Index.Clear();
+  EXPECT_TRUE(Index.IsEmpty());
+  EXPECT_TRUE(Index.Lookup("_main").empty());
+}
+
+// dlclose and a dlopen of another copy of the library
+TEST_F(global_symbol_index_test, PromotesImagesOfTheSameInstallName) {
+  AddAll();
+  auto Decoy = std::make_shared<FakeImage>(
+      "/usr/lib/libDecoy.dylib", MH_DYLIB, std::vector<std::string>{},
+      std::vector<FakeImage::Entry>{{"_helper", N_SECT | N_EXT, 0}});
+  auto CopyA = std::make_shared<FakeImage>(
+      "/usr/lib/libA.dylib", MH_DYLIB, std::vector<std::string>{},
+      std::vector<FakeImage::Entry>{{"_helper", N_SECT | N_EXT, 0}});
+  Index.AddImage(Decoy);
+  Index.AddImage(CopyA);
+  EXPECT_EQ(Index.FindImage("/usr/lib/libA.dylib"), LibA.get());
+
+  Index.RemoveImage(LibA);
+  EXPECT_EQ(Index.FindImage("/usr/lib/libA.dylib"), CopyA.get());
+  auto Helper = Index.Lookup("_helper");
+  ASSERT_EQ(Helper.size(), 3u);
+  EXPECT_EQ(Helper[2].Image, CopyA);
+
+  Index.RemoveImage(CopyA);
+  EXPECT_EQ(Index.FindImage("/usr/lib/libA.dylib"), nullptr);
+  EXPECT_EQ(Index.FindImage("/usr/lib/libB.dylib"), LibB.get());
+}
+
+// A long session opens and closes the same plugin over and over
+TEST_F(global_symbol_index_test, ReclaimsRemovedImages) {
+  AddAll();
+  std::vector<FakeImage::Entry> Entries;
+  for (uint32_t i = 0; i < 100; ++i) {
+    Entries.push_back({"_plugin" + std::to_string(i), N_SECT | N_EXT, 0});
+  }
+  Entries.push_back({"_shared", N_SECT | N_EXT, 0});
+
+  size_t Capacity = 0;
+  for (int Round = 0; Round < 50; ++Round) {
+    auto Plugin = std::make_shared<FakeImage>(
+        "/usr/lib/libPlugin.dylib", MH_BUNDLE, std::vector<std::string>{},
+        Entries);
+    Index.AddImage(Plugin);
+    auto Shared = Index.Lookup("_shared");
+    ASSERT_EQ(Shared.size(), 3u);
+    EXPECT_EQ(Shared[0].Image, LibA);
+    EXPECT_EQ(Shared[2].Image, Plugin);
+    ASSERT_EQ(Index.Lookup("_plugin42").size(), 1u);
+    EXPECT_EQ(Index.FindImage("/usr/lib/libPlugin.dylib"), Plugin.get());
+    Index.RemoveImage(Plugin);
+    EXPECT_TRUE(Index.Lookup("_plugin42").empty());
+
+    if (!Round) {
+      Capacity = Index.GetCapacity();
+    }
+    EXPECT_EQ(Index.GetCapacity(), Capacity) << Round;
+    EXPECT_LE(Index.GetPositionCount(), 6u) << Round;
+  }
+
+  // Renumbered along the way, the images left are still found
+  EXPECT_EQ(Index.FindImage("/usr/lib/libB.dylib"), LibB.get());
+  EXPECT_EQ(Index.FindImage("/bin/app"), App.get());
+  EXPECT_EQ(Index.Lookup("_main").size(), 1u);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,162 @@
+// Std
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/ImageAddressMap.hpp"
+#include "MAD/MachOParser.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// Just the segments of an image, already slid
+class FakeImage {
+public:
+  using Segment_t = MachOFileParser64::MachOSegment;
+  using Section_t = MachOFileParser64::MachOSection;
+
+  std::vector<std::shared_ptr<Segment_t>> Segments;
+
+  auto &GetSegments() { return Segments; }
+
+  std::shared_ptr<Segment_t> AddSegment(std::string Name, uint64_t Address,
+                                        uint64_t Size,
+                                        vm_prot_t Protection = VM_PROT_READ) {
+    auto Segment = std::make_shared<Segment_t>();
+    Segment->Name = Name;
+    Segment->VirtualAddress = Address;
+    Segment->VirtualSize = Size;
+    Segment->FileSize = Size;
+    Segment->Raw.maxprot = Protection;
+    Segment->Raw.initprot = Protection;
+    Segments.push_back(Segment);
+    return Segment;
+  }
+
+  std::shared_ptr<Section_t> AddSection(Segment_t &Segment, std::string Name,
+                                        uint64_t Address, uint64_t Size) {
+    auto Section = std::make_shared<Section_t>();
+    Section->Name = Name;
+    Section->SegmentName = Segment.Name;
+    Section->VirtualAddress = Address;
+    Section->VirtualSize = Size;
+    Segment.Sections.push_back(Section);
+    return Section;
+  }
+};
+
+using FakeAddressMap = ImageAddressMap<FakeImage>;
+
+class image_address_map_test : public ::testing::Test {
+protected:
+  FakeAddressMap Map;
+
+  // __PAGEZERO, __TEXT with __text and __stubs, __DATA and __LINKEDIT
+  std::shared_ptr<FakeImage> MakeImage(uint64_t Base) {
+    auto Image = std::make_shared<FakeImage>();
+    auto PageZero = Image->AddSegment("__PAGEZERO", 0, Base, VM_PROT_NONE);
+    PageZero->FileSize = 0;
+    auto Text = Image->AddSegment("__TEXT", Base, 0x4000,
+                                  VM_PROT_READ | VM_PROT_EXECUTE);
+    Image->AddSection(*Text, "__text", Base + 0x1000, 0x2000);
+    Image->AddSection(*Text, "__stubs", Base + 0x3000, 0x100);
+    auto Data = Image->AddSegment("__DATA", Base + 0x4000, 0x1000,
+                                  VM_PROT_READ | VM_PROT_WRITE);
+    Image->AddSection(*Data, "__data", Base + 0x4000, 0x800);
+    Image->AddSegment("__LINKEDIT", Base + 0x5000, 0x1000);
+    return Image;
+  }
+};
+
+TEST_F(image_address_map_test, FindsSegmentsAndSections) {
+  auto Image = MakeImage(0x100000000);
+  Map.AddImage(Image);
+
+  FakeAddressMap::Location Location;
+  ASSERT_TRUE(Map.Lookup(0x100001000, Location));
+  EXPECT_EQ(Location.Image, Image);
+  EXPECT_EQ(Location.Segment->Name, "__TEXT");
+  ASSERT_TRUE(Location.Section);
+  EXPECT_EQ(Location.Section->Name, "__text");
+
+  ASSERT_TRUE(Map.Lookup(0x1000030ff, Location));
+  ASSERT_TRUE(Location.Section);
+  EXPECT_EQ(Location.Section->Name, "__stubs");
+
+  // The mach header is in __TEXT, but in none of its sections
+  ASSERT_TRUE(Map.Lookup(0x100000000, Location));
+  EXPECT_EQ(Location.Segment->Name, "__TEXT");
+  EXPECT_FALSE(Location.Section);
+
+  ASSERT_TRUE(Map.Lookup(0x100004fff, Location));
+  EXPECT_EQ(Location.Segment->Name, "__DATA");
+  EXPECT_FALSE(Location.Section);
+
+  // Ends are not in the range, __PAGEZERO is not in the map at all
+  EXPECT_FALSE(Map.Lookup(0x100006000, Location));
+  EXPECT_FALSE(Map.Lookup(0x1000, Location));
+}
+
+TEST_F(image_address_map_test, AddsAndRemovesImages) {
+  std::vector<std::shared_ptr<FakeImage>> Images;
+  for (uint64_t i = 0; i < 64; ++i) {
+    Images.push_back(MakeImage(0x100000000 + i * 0x10000));
+    Map.AddImage(Images.back());
+  }
+  EXPECT_EQ(Map.GetImageCount(), 64u);
+
+  for (uint64_t i = 0; i < 64; i += 2) {
+    Map.RemoveImage(Images[i]);
+  }
+  EXPECT_EQ(Map.GetImageCount(), 32u);
+
+  for (uint64_t i = 0; i < 64; ++i) {
+    auto Found = Map.FindImage(0x100002000 + i * 0x10000);
+    EXPECT_EQ(Found, i % 2 ? Images[i] : nullptr);
+  }
+
+  // The place of a removed image can be taken by another one
+  auto Other = MakeImage(0x100000000);
+  Map.AddImage(Other);
+  EXPECT_EQ(Map.FindImage(0x100002000), Other);
+
+  Map.Clear();
+  EXPECT_TRUE(Map.IsEmpty());
+  EXPECT_FALSE(Map.FindImage(0x100012000));
+}
+
+TEST_F(image_address_map_test, SharesRangesClaimedByMoreImages) {
+  // Images of the shared cache have their own __TEXT and one __LINKEDIT
+  auto First = std::make_shared<FakeImage>();
+  First->AddSegment("__TEXT", 0x7ff800000000, 0x1000);
+  First->AddSegment("__LINKEDIT", 0x7ff900000000, 0x100000);
+  auto Second = std::make_shared<FakeImage>();
+  Second->AddSegment("__TEXT", 0x7ff800001000, 0x1000);
+  Second->AddSegment("__LINKEDIT", 0x7ff900000000, 0x100000);
+  Map.AddImage(First);
+  Map.AddImage(Second);
+
+  EXPECT_EQ(Map.FindImage(0x7ff900000010), First);
+  EXPECT_EQ(Map.FindImage(0x7ff800001010), Second);
+
+  Map.RemoveImage(First);
+  EXPECT_EQ(Map.FindImage(0x7ff900000010), Second);
+  EXPECT_FALSE(Map.FindImage(0x7ff800000010));
+
+  // Partially overlapping ranges are left out
+  auto Bogus = std::make_shared<FakeImage>();
+  Bogus->AddSegment("__TEXT", 0x7ff800001800, 0x1000);
+  Map.AddImage(Bogus);
+  EXPECT_EQ(Map.FindImage(0x7ff800001800), Second);
+  EXPECT_FALSE(Map.FindImage(0x7ff800002000));
+  Map.RemoveImage(Bogus);
+  EXPECT_EQ(Map.FindImage(0x7ff800001800), Second);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
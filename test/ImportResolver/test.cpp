@@ -0,0 +1,273 @@
+// System
+#include <mach-o/loader.h>
+
+// Std
+#include <cassert>
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/GlobalSymbolIndex.hpp"
+#include "MAD/ImportResolver.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+static void AppendULEB128(std::vector<char> &Bytes, uint64_t Value) {
+  do {
+    uint8_t Byte = Value & 0x7F;
+    Value >>= 7;
+    Bytes.push_back(char(Byte | (Value ? 0x80 : 0)));
+  } while (Value);
+}
+
+// An image that exports a few names through a trie and links against a few
+// libraries
+class FakeImage {
+public:
+  struct Library {
+    std::string Name;
+    dylib_command Raw;
+  };
+
+  struct Entry {
+    std::string Name;
+    uint64_t Flags;
+    // Offset from Base, the address or the library ordinal of a re-export
+    uint64_t Value;
+    // Name in the library of a re-export, if another
+    std::string ImportName;
+  };
+
+  class FakeSymbolTable {
+  public:
+    std::vector<char> Bytes;
+    ExportTrie Trie;
+    uint64_t Base;
+    // The index is not searched by name here
+    SymbolStore NoSymbols;
+
+    const SymbolStore &GetSymbols() { return NoSymbols; }
+    const ExportTrie &GetExports() { return Trie; }
+
+    bool GetExportAddress(const ExportTrie::Export &Export,
+                          uint64_t &Address) {
+      if (Export.IsReExport()) {
+        return false;
+      }
+      Address = Export.GetKind() == EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE
+                    ? Export.Address
+                    : Base + Export.Address;
+      return true;
+    }
+  };
+
+  std::string InstallName;
+  uint32_t Type;
+  std::vector<std::shared_ptr<Library>> Libraries;
+  FakeSymbolTable Table;
+
+  // Linked are install names, prefixed with ! for LC_REEXPORT_DYLIB. Names
+  // of the entries must not share their first character, every one is an
+  // edge of the root.
+  FakeImage(std::string InstallName, uint32_t Type, uint64_t Base,
+            std::vector<std::string> Linked, std::vector<Entry> Entries)
+      : InstallName(InstallName), Type(Type) {
+    for (auto &Name : Linked) {
+      auto L = std::make_shared<Library>();
+      L->Raw.cmd = Name[0] == '!' ? LC_REEXPORT_DYLIB : LC_LOAD_DYLIB;
+      L->Name = Name[0] == '!' ? Name.substr(1) : Name;
+      Libraries.push_back(L);
+    }
+
+    // Root: no terminal, then an edge to a leaf per entry
+    size_t RootSize = 2;
+    for (auto &E : Entries) {
+      RootSize += E.Name.size() + 2;
+    }
+    std::vector<std::vector<char>> Leaves;
+    for (auto &E : Entries) {
+      std::vector<char> Terminal;
+      AppendULEB128(Terminal, E.Flags);
+      AppendULEB128(Terminal, E.Value);
+      if (E.Flags & EXPORT_SYMBOL_FLAGS_REEXPORT) {
+        Terminal.insert(Terminal.end(), E.ImportName.begin(),
+                        E.ImportName.end());
+        Terminal.push_back('\0');
+      }
+      std::vector<char> Leaf;
+      AppendULEB128(Leaf, Terminal.size());
+      Leaf.insert(Leaf.end(), Terminal.begin(), Terminal.end());
+      Leaf.push_back(0);
+      Leaves.push_back(Leaf);
+    }
+
+    auto &Bytes = Table.Bytes;
+    Bytes.push_back(0);
+    Bytes.push_back(char(Entries.size()));
+    size_t Offset = RootSize;
+    for (size_t i = 0; i < Entries.size(); ++i) {
+      Bytes.insert(Bytes.end(), Entries[i].Name.begin(),
+                   Entries[i].Name.end());
+      Bytes.push_back('\0');
+      assert(Offset < 0x80);
+      Bytes.push_back(char(Offset));
+      Offset += Leaves[i].size();
+    }
+    for (auto &Leaf : Leaves) {
+      Bytes.insert(Bytes.end(), Leaf.begin(), Leaf.end());
+    }
+    Table.Trie = ExportTrie(ByteView(Bytes.data(), Bytes.size()));
+    Table.Base = Base;
+  }
+
+  auto &GetSymbolTable() { return Table; }
+  auto &GetInstallName() { return InstallName; }
+  auto &GetDyLibraries() { return Libraries; }
+  auto GetType() { return Type; }
+};
+
+#define REGULAR EXPORT_SYMBOL_FLAGS_KIND_REGULAR
+#define ABSOLUTE EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE
+#define REEXPORT EXPORT_SYMBOL_FLAGS_REEXPORT
+
+// libSystem re-exports strlen and bzero, under another name, from libsystem_c
+// and all of libsystem_m. An unrelated library loaded before them exports
+// strlen and sqrt too.
+class import_resolver : public ::testing::Test {
+protected:
+  std::shared_ptr<FakeImage> App;
+  std::shared_ptr<FakeImage> Decoy;
+  std::shared_ptr<FakeImage> System;
+  std::shared_ptr<FakeImage> LibC;
+  std::shared_ptr<FakeImage> LibM;
+  GlobalSymbolIndex<FakeImage> Images;
+  ImportResolver<FakeImage> Resolver{Images};
+
+  void SetUp() override {
+    App = std::make_shared<FakeImage>(
+        "/bin/app", MH_EXECUTE, 0x100000000,
+        std::vector<std::string>{"/usr/lib/libSystem.B.dylib",
+                                 "/usr/lib/libmissing.dylib"},
+        std::vector<FakeImage::Entry>{{"main", REGULAR, 0x10, ""},
+                                      {"_mh", ABSOLUTE, 0x42, ""}});
+    Decoy = std::make_shared<FakeImage>(
+        "/usr/lib/libdecoy.dylib", MH_DYLIB, 0x7000,
+        std::vector<std::string>{},
+        std::vector<FakeImage::Entry>{{"strlen", REGULAR, 0x10, ""},
+                                      {"qsort", REGULAR, 0x20, ""},
+                                      {"sqrt", REGULAR, 0x30, ""}});
+    System = std::make_shared<FakeImage>(
+        "/usr/lib/libSystem.B.dylib", MH_DYLIB, 0x1000,
+        std::vector<std::string>{"/usr/lib/system/libsystem_c.dylib",
+                                 "!/usr/lib/system/libsystem_m.dylib"},
+        std::vector<FakeImage::Entry>{{"strlen", REEXPORT, 1, ""},
+                                      {"bzero", REEXPORT, 1, "platform_bzero"},
+                                      {"gone", REEXPORT, 3, ""}});
+    LibC = std::make_shared<FakeImage>(
+        "/usr/lib/system/libsystem_c.dylib", MH_DYLIB, 0x2000,
+        std::vector<std::string>{},
+        std::vector<FakeImage::Entry>{{"strlen", REGULAR, 0x10, ""},
+                                      {"platform_bzero", REGULAR, 0x20, ""}});
+    LibM = std::make_shared<FakeImage>(
+        "/usr/lib/system/libsystem_m.dylib", MH_DYLIB, 0x3000,
+        std::vector<std::string>{},
+        std::vector<FakeImage::Entry>{{"sqrt", REGULAR, 0x10, ""}});
+
+    for (auto &Image : {App, Decoy, System, LibC, LibM}) {
+      Images.AddImage(Image);
+    }
+  }
+};
+
+TEST_F(import_resolver, FollowsReExportedSymbols) {
+  uint64_t Address = 0;
+  EXPECT_TRUE(Resolver.Resolve(*App, 1, "strlen", Address));
+  EXPECT_EQ(Address, 0x2010u);
+  EXPECT_TRUE(Resolver.Resolve(*App, 1, "bzero", Address));
+  EXPECT_EQ(Address, 0x2020u);
+}
+
+TEST_F(import_resolver, FollowsReExportedLibraries) {
+  uint64_t Address = 0;
+  EXPECT_TRUE(Resolver.Resolve(*App, 1, "sqrt", Address));
+  EXPECT_EQ(Address, 0x3010u);
+}
+
+TEST_F(import_resolver, ResolvesSpecialOrdinals) {
+  uint64_t Address = 0;
+  EXPECT_TRUE(
+      Resolver.Resolve(*LibC, BIND_SPECIAL_DYLIB_SELF, "strlen", Address));
+  EXPECT_EQ(Address, 0x2010u);
+  EXPECT_TRUE(Resolver.Resolve(*LibC, BIND_SPECIAL_DYLIB_MAIN_EXECUTABLE,
+                               "main", Address));
+  EXPECT_EQ(Address, 0x100000010u);
+  EXPECT_TRUE(Resolver.Resolve(*LibC, BIND_SPECIAL_DYLIB_MAIN_EXECUTABLE,
+                               "_mh", Address));
+  EXPECT_EQ(Address, 0x42u);
+}
+
+// Flat lookups, names a library does not export and libraries that are not
+// loaded take the first image that exports the name
+TEST_F(import_resolver, FallsBackToFirstExportingImage) {
+  uint64_t Address = 0;
+  EXPECT_TRUE(Resolver.Resolve(*App, BIND_SPECIAL_DYLIB_FLAT_LOOKUP,
+                               "strlen", Address));
+  EXPECT_EQ(Address, 0x7010u);
+  EXPECT_TRUE(Resolver.Resolve(*App, 1, "qsort", Address));
+  EXPECT_EQ(Address, 0x7020u);
+  EXPECT_TRUE(Resolver.Resolve(*App, 2, "sqrt", Address));
+  EXPECT_EQ(Address, 0x7030u);
+}
+
+// What decides whether a weak import is bound or zero
+TEST_F(import_resolver, FailsOnlyIfNoImageExportsTheName) {
+  uint64_t Address = 0;
+  EXPECT_FALSE(Resolver.Resolve(*App, 1, "nowhere", Address));
+  EXPECT_FALSE(Resolver.Resolve(*App, BIND_SPECIAL_DYLIB_WEAK_LOOKUP,
+                                "nowhere", Address));
+  // Re-exported from a library System does not link against
+  EXPECT_FALSE(Resolver.Resolve(*App, 1, "gone", Address));
+}
+
+TEST_F(import_resolver, StopsOnReExportCycles) {
+  auto Ping = std::make_shared<FakeImage>(
+      "/usr/lib/libping.dylib", MH_DYLIB, 0x4000,
+      std::vector<std::string>{"/usr/lib/libpong.dylib"},
+      std::vector<FakeImage::Entry>{{"loop", REEXPORT, 1, ""}});
+  auto Pong = std::make_shared<FakeImage>(
+      "/usr/lib/libpong.dylib", MH_DYLIB, 0x5000,
+      std::vector<std::string>{"!/usr/lib/libping.dylib"},
+      std::vector<FakeImage::Entry>{});
+  Images.AddImage(Ping);
+  Images.AddImage(Pong);
+
+  uint64_t Address = 0;
+  EXPECT_FALSE(Resolver.Resolve(*Ping, BIND_SPECIAL_DYLIB_SELF, "loop",
+                                Address));
+}
+
+TEST_F(import_resolver, ForgetsRemovedImages) {
+  Images.RemoveImage(LibC);
+  uint64_t Address = 0;
+  EXPECT_TRUE(Resolver.Resolve(*App, 1, "strlen", Address));
+  EXPECT_EQ(Address, 0x7010u);
+  EXPECT_FALSE(Resolver.Resolve(*App, 1, "bzero", Address));
+
+  // Another copy loaded under the same install name takes over
+  auto Copy = std::make_shared<FakeImage>(
+      "/usr/lib/system/libsystem_c.dylib", MH_DYLIB, 0x6000,
+      std::vector<std::string>{},
+      std::vector<FakeImage::Entry>{{"strlen", REGULAR, 0x10, ""}});
+  Images.AddImage(Copy);
+  EXPECT_TRUE(Resolver.Resolve(*App, 1, "strlen", Address));
+  EXPECT_EQ(Address, 0x6010u);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
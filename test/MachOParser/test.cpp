@@ -0,0 +1,551 @@
+// Std
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/StreamInput.hpp"
+#include "MAD/SymbolTable.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// Images are put together by hand, one load command at a time. Whatever the
+// commands claim, the parser must not read outside of them or the input.
+class macho_parser_test : public ::testing::Test {
+protected:
+  std::vector<char> Bytes;
+  uint32_t CommandCount = 0;
+  size_t HeaderSize = 0;
+
+  template <typename T> void Put(T Value) {
+    auto At = Bytes.size();
+    Bytes.resize(At + sizeof(T));
+    memcpy(&Bytes[At], &Value, sizeof(T));
+  }
+  template <typename T> void PutAt(size_t At, T Value) {
+    memcpy(&Bytes[At], &Value, sizeof(T));
+  }
+
+  // ncmds and sizeofcmds are filled in by EndCommands
+  void PutHeader(bool Is64, uint32_t Flags = 0) {
+    mach_header_64 Header = {};
+    Header.magic = Is64 ? MH_MAGIC_64 : MH_MAGIC;
+    Header.filetype = MH_EXECUTE;
+    Header.flags = Flags;
+    HeaderSize = Is64 ? sizeof(mach_header_64) : sizeof(mach_header);
+    Bytes.resize(HeaderSize);
+    memcpy(Bytes.data(), &Header, HeaderSize);
+  }
+
+  void PutSegment(const char *Name, uint64_t Address, uint64_t FileOffset,
+                  uint64_t FileSize, uint32_t SectionCount = 0) {
+    segment_command_64 Segment = {};
+    Segment.cmd = LC_SEGMENT_64;
+    Segment.cmdsize = sizeof(Segment) + SectionCount * sizeof(section_64);
+    strncpy(Segment.segname, Name, sizeof(Segment.segname));
+    Segment.vmaddr = Address;
+    Segment.vmsize = FileSize;
+    Segment.fileoff = FileOffset;
+    Segment.filesize = FileSize;
+    Segment.nsects = SectionCount;
+    Put(Segment);
+    for (uint32_t i = 0; i < SectionCount; ++i) {
+      section_64 Section = {};
+      strncpy(Section.sectname, "__text", sizeof(Section.sectname));
+      strncpy(Section.segname, Name, sizeof(Section.segname));
+      Section.addr = Address;
+      Put(Section);
+    }
+    ++CommandCount;
+  }
+
+  void PutSymbolTable(uint32_t SymbolOffset, uint32_t SymbolCount,
+                      uint32_t StringOffset, uint32_t StringSize) {
+    Put(symtab_command{LC_SYMTAB, sizeof(symtab_command), SymbolOffset,
+                       SymbolCount, StringOffset, StringSize});
+    ++CommandCount;
+  }
+
+  void PutDyLibrary(const char *Name, uint32_t NameOffset) {
+    dylib_command Command = {};
+    Command.cmd = LC_LOAD_DYLIB;
+    Command.cmdsize = sizeof(Command) + 32;
+    Command.dylib.name.offset = NameOffset;
+    Put(Command);
+    char Padded[32] = {};
+    strncpy(Padded, Name, sizeof(Padded));
+    for (auto Char : Padded) {
+      Put(Char);
+    }
+    ++CommandCount;
+  }
+
+  void EndCommands() {
+    PutAt<uint32_t>(16, CommandCount);
+    PutAt<uint32_t>(20, Bytes.size() - HeaderSize);
+  }
+
+  // An executable with Count symbols of every kind, names shared, tail-merged
+  // or out of the string table among them
+  void PutSymbols(uint32_t Count) {
+    PutHeader(true);
+    PutSegment("__TEXT", 0x100000000, 0, 0x1000, 1);
+    std::string Strings(" ", 1);
+    std::vector<uint32_t> Offsets;
+    for (uint32_t i = 0; i < Count / 2; ++i) {
+      Offsets.push_back(Strings.size());
+      Strings += "_symbol" + std::to_string(i);
+      Strings += '\0';
+    }
+    uint32_t SymbolsSize = Count * sizeof(nlist_64);
+    PutSegment("__LINKEDIT", 0x100001000, 0x1000, SymbolsSize + Strings.size());
+    PutSymbolTable(0x1000, Count, 0x1000 + SymbolsSize, Strings.size());
+    EndCommands();
+
+    static const uint8_t Types[] = {N_SECT | N_EXT, N_SECT, N_UNDF | N_EXT,
+                                    N_ABS, N_INDR | N_EXT, N_FUN};
+    Bytes.resize(0x1000);
+    for (uint32_t i = 0; i < Count; ++i) {
+      nlist_64 Symbol = {};
+      auto Name = Offsets[i % Offsets.size()];
+      switch (i % 7) {
+      case 5:
+        Name += 1;
+        break;
+      case 6:
+        Name = i % 2 ? 0 : Strings.size() + i;
+        break;
+      }
+      Symbol.n_un.n_strx = Name;
+      Symbol.n_type = Types[i % sizeof(Types)];
+      Symbol.n_sect = Symbol.n_type & N_SECT ? 1 : 0;
+      Symbol.n_desc = uint16_t(i * 0x9E37);
+      Symbol.n_value = 0x100000000 + i * 4;
+      Put(Symbol);
+    }
+    for (auto Char : Strings) {
+      Put(Char);
+    }
+  }
+
+  static void ExpectSameStore(const SymbolStore &Store,
+                              const SymbolStore &Expected) {
+    ASSERT_EQ(Store.GetSize(), Expected.GetSize());
+    for (uint32_t i = 0; i < Store.GetSize(); ++i) {
+      ASSERT_EQ(Store.Values[i], Expected.Values[i]) << i;
+      ASSERT_EQ(Store.NameOffsets[i], Expected.NameOffsets[i]) << i;
+      ASSERT_EQ(Store.NameLengths[i], Expected.NameLengths[i]) << i;
+      ASSERT_EQ(Store.Flags[i], Expected.Flags[i]) << i;
+      ASSERT_EQ(Store.Descs[i], Expected.Descs[i]) << i;
+      ASSERT_EQ(Store.Types[i], Expected.Types[i]) << i;
+      ASSERT_EQ(Store.Sections[i], Expected.Sections[i]) << i;
+      ASSERT_EQ(Store.GetName(i), Expected.GetName(i)) << i;
+    }
+  }
+
+  template <typename T>
+  std::unique_ptr<MachOParser<T, ByteView>> Parse(bool &IsParsed) {
+    auto Parser = std::make_unique<MachOParser<T, ByteView>>(
+        "test", ByteView(Bytes.data(), Bytes.size()), MO_PARSE_FILE);
+    IsParsed = Parser->Parse();
+    return Parser;
+  }
+};
+
+TEST_F(macho_parser_test, ParsesLoadCommands) {
+  PutHeader(true);
+  PutSegment("__TEXT", 0x100000000, 0, 0x1000, 1);
+  PutSegment("__LINKEDIT", 0x100001000, 0x1000, 0x100);
+  PutSymbolTable(0x1000, 2, 0x1020, 16);
+  PutDyLibrary("/usr/lib/libSystem.B.dylib", sizeof(dylib_command));
+  EndCommands();
+
+  Bytes.resize(0x1000);
+  nlist_64 Main = {};
+  Main.n_un.n_strx = 2;
+  Main.n_type = N_SECT | N_EXT;
+  Main.n_sect = 1;
+  Main.n_value = 0x100000f00;
+  nlist_64 Foo = Main;
+  Foo.n_un.n_strx = 8;
+  Put(Main);
+  Put(Foo);
+  for (auto Char : std::string(" \0_main\0_foo\0\0\0\0\0", 16)) {
+    Put(Char);
+  }
+  Bytes.resize(0x1100);
+
+  bool IsParsed;
+  auto Parser = Parse<MachSystem64_t>(IsParsed);
+  ASSERT_TRUE(IsParsed);
+  EXPECT_EQ(Parser->Segments.size(), 2u);
+  EXPECT_EQ(Parser->Sections.size(), 1u);
+  ASSERT_EQ(Parser->DyLibraries.size(), 1u);
+  EXPECT_EQ(Parser->DyLibraries[0]->Name, "/usr/lib/libSystem.B.dylib");
+
+  auto &Store = Parser->SymbolTable->GetStore();
+  ASSERT_EQ(Store.GetSize(), 2u);
+  EXPECT_EQ(Store.GetName(0), "_main");
+  EXPECT_EQ(Store.GetName(1), "_foo");
+
+  // Symbols without a section, e.g. undefined ones, have none to look up
+  EXPECT_FALSE(Parser->GetSectionByIndex(0));
+  EXPECT_TRUE(Parser->GetSectionByIndex(1));
+}
+
+TEST_F(macho_parser_test, ParsesCommandsAfter32BitHeaders) {
+  PutHeader(false);
+  segment_command Segment = {};
+  Segment.cmd = LC_SEGMENT;
+  Segment.cmdsize = sizeof(Segment);
+  strncpy(Segment.segname, "__TEXT", sizeof(Segment.segname));
+  Put(Segment);
+  ++CommandCount;
+  EndCommands();
+
+  bool IsParsed;
+  auto Parser = Parse<MachSystem32_t>(IsParsed);
+  ASSERT_TRUE(IsParsed);
+  EXPECT_TRUE(Parser->GetSegmentByName(SEG_TEXT));
+}
+
+TEST_F(macho_parser_test, RejectsCommandsOutsideSizeofcmds) {
+  // Without a check on cmdsize this one command is parsed forever
+  PutHeader(true);
+  Put(load_command{LC_UUID, 0});
+  EndCommands();
+  PutAt<uint32_t>(16, 0xffffffff);
+
+  bool IsParsed;
+  Parse<MachSystem64_t>(IsParsed);
+  EXPECT_FALSE(IsParsed);
+
+  Bytes.clear();
+  CommandCount = 0;
+  PutHeader(true);
+  PutSegment("__TEXT", 0, 0, 0x1000);
+  EndCommands();
+  // The command is all there, sizeofcmds says it is not
+  PutAt<uint32_t>(20, sizeof(segment_command_64) - 8);
+
+  Parse<MachSystem64_t>(IsParsed);
+  EXPECT_FALSE(IsParsed);
+}
+
+TEST_F(macho_parser_test, RejectsSectionsOutsideSegment) {
+  PutHeader(true);
+  PutSegment("__TEXT", 0, 0, 0x1000, 1);
+  EndCommands();
+  PutAt<uint32_t>(HeaderSize + offsetof(segment_command_64, nsects),
+                  0x10000000);
+
+  bool IsParsed;
+  Parse<MachSystem64_t>(IsParsed);
+  EXPECT_FALSE(IsParsed);
+}
+
+TEST_F(macho_parser_test, RejectsStringsOutsideCommand) {
+  PutHeader(true);
+  PutDyLibrary("/usr/lib/libSystem.B.dylib", sizeof(dylib_command) + 32);
+  EndCommands();
+
+  bool IsParsed;
+  Parse<MachSystem64_t>(IsParsed);
+  EXPECT_FALSE(IsParsed);
+}
+
+TEST_F(macho_parser_test, KeepsSymbolTableInLinkEdit) {
+  PutHeader(true);
+  PutSegment("__TEXT", 0x100000000, 0, 0x1000);
+  // A huge __LINKEDIT is as good as any to a stream, it cannot tell how much
+  // is there until it reads
+  PutSegment("__LINKEDIT", 0x100001000, 0x1000, 0x40000000);
+  PutSymbolTable(0x1000, 0x1000000, 0x1000, 0x100);
+  EndCommands();
+  Bytes.resize(0x1100);
+
+  bool IsParsed;
+  auto Parser = Parse<MachSystem64_t>(IsParsed);
+  ASSERT_TRUE(IsParsed);
+  EXPECT_EQ(Parser->SymbolTable->GetStore().GetSize(), 0u);
+
+  std::istringstream Stream(std::string(Bytes.data(), Bytes.size()));
+  MachOParser64 Streamed("test", StreamInput(Stream), MO_PARSE_FILE);
+  ASSERT_TRUE(Streamed.Parse());
+  EXPECT_EQ(Streamed.SymbolTable->GetStore().GetSize(), 0u);
+
+  // Past __LINKEDIT no matter what the input has
+  PutAt<uint32_t>(HeaderSize + 2 * sizeof(segment_command_64) +
+                      offsetof(symtab_command, nsyms),
+                  0x4000001);
+  Parser = Parse<MachSystem64_t>(IsParsed);
+  ASSERT_TRUE(IsParsed);
+  EXPECT_EQ(Parser->SymbolTable->GetStore().GetSize(), 0u);
+}
+
+TEST_F(macho_parser_test, RejectsImagesWithoutText) {
+  PutHeader(true, MH_PIE);
+  PutSegment("__LINKEDIT", 0x100001000, 0x1000, 0x100);
+  EndCommands();
+
+  std::istringstream Stream(std::string(Bytes.data(), Bytes.size()));
+  MachOParser64 Parser("test", StreamInput(Stream), MO_PARSE_IMAGE,
+                       0x100000000);
+  EXPECT_FALSE(Parser.Parse());
+}
+
+TEST_F(macho_parser_test, SlidesDyLibraries) {
+  // Dylibs have no MH_PIE and are slid all the same
+  PutHeader(true);
+  PutAt<uint32_t>(offsetof(mach_header_64, filetype), MH_DYLIB);
+  PutSegment("__TEXT", 0x100000000, 0, 0x1000, 1);
+  PutSegment("__LINKEDIT", 0x100001000, 0x1000, 0x100);
+  PutSymbolTable(0x1000, 1, 0x1010, 8);
+  EndCommands();
+
+  Bytes.resize(0x1000);
+  nlist_64 Main = {};
+  Main.n_un.n_strx = 2;
+  Main.n_type = N_SECT | N_EXT;
+  Main.n_sect = 1;
+  Main.n_value = 0x100000f00;
+  Put(Main);
+  for (auto Char : std::string(" \0_main\0", 8)) {
+    Put(Char);
+  }
+  Bytes.resize(0x1100);
+
+  std::istringstream Stream(std::string(Bytes.data(), Bytes.size()));
+  MachOParser64 Parser("test", StreamInput(Stream), MO_PARSE_IMAGE,
+                       0x200000000);
+  ASSERT_TRUE(Parser.Parse());
+  EXPECT_EQ(Parser.GetImageSlide(), 0x100000000u);
+  auto &Store = Parser.SymbolTable->GetStore();
+  ASSERT_EQ(Store.GetSize(), 1u);
+  EXPECT_EQ(Store.GetName(0), "_main");
+  EXPECT_EQ(Store.GetValue(0), 0x200000f00u);
+}
+
+TEST_F(macho_parser_test, ResolvesExportAddresses) {
+  PutHeader(true);
+  PutAt<uint32_t>(offsetof(mach_header_64, filetype), MH_DYLIB);
+  PutSegment("__TEXT", 0x100000000, 0, 0x1000, 1);
+  PutSegment("__LINKEDIT", 0x100001000, 0x1000, 0x100);
+  // The trie below, right at the start of __LINKEDIT
+  Put(linkedit_data_command{LC_DYLD_EXPORTS_TRIE,
+                            sizeof(linkedit_data_command), 0x1000, 59});
+  ++CommandCount;
+  EndCommands();
+
+  Bytes.resize(0x1000);
+  static const uint8_t Trie[] = {
+      // 0: root, an edge _ to 5
+      0x00, 0x01, '_', 0x00, 0x05,
+      // 5: _, edges text, abs, reexport and resolver
+      0x00, 0x04, 't', 'e', 'x', 't', 0x00, 0x26, 'a', 'b', 's', 0x00, 0x2b,
+      'r', 'e', 'e', 'x', 'p', 'o', 'r', 't', 0x00, 0x2f, 'r', 'e', 's', 'o',
+      'l', 'v', 'e', 'r', 0x00, 0x34,
+      // 38: _text, regular at 0x800
+      0x03, 0x00, 0x80, 0x10, 0x00,
+      // 43: _abs, absolute 0x42
+      0x02, 0x02, 0x42, 0x00,
+      // 47: _reexport, from library 1
+      0x03, 0x08, 0x01, 0x00, 0x00,
+      // 52: _resolver, stub at 0x900 and resolver at 0xa00
+      0x05, 0x10, 0x80, 0x12, 0x80, 0x14, 0x00};
+  for (auto Byte : Trie) {
+    Put(Byte);
+  }
+  Bytes.resize(0x1100);
+
+  std::istringstream Stream(std::string(Bytes.data(), Bytes.size()));
+  MachOParser64 Parser("test", StreamInput(Stream), MO_PARSE_IMAGE,
+                       0x200000000);
+  ASSERT_TRUE(Parser.Parse());
+
+  // Offsets are from the slid mach header, absolute values are not slid
+  uint64_t Address = 0;
+  ASSERT_TRUE(Parser.GetExportAddress("_text", Address));
+  EXPECT_EQ(Address, 0x200000800u);
+  ASSERT_TRUE(Parser.GetExportAddress("_abs", Address));
+  EXPECT_EQ(Address, 0x42u);
+  // Where the stub is, callers go through it to whatever the resolver picks
+  ASSERT_TRUE(Parser.GetExportAddress("_resolver", Address));
+  EXPECT_EQ(Address, 0x200000900u);
+
+  // Defined elsewhere, see ImportResolver
+  EXPECT_FALSE(Parser.GetExportAddress("_reexport", Address));
+  ExportTrie::Export Export;
+  ASSERT_TRUE(Parser.GetExports().Lookup("_reexport", Export));
+  EXPECT_TRUE(Export.IsReExport());
+
+  EXPECT_FALSE(Parser.GetExportAddress("_missing", Address));
+  EXPECT_FALSE(Parser.GetExportAddress("_", Address));
+}
+
+TEST_F(macho_parser_test, CountsUnknownCommands) {
+  PutHeader(true);
+  rpath_command RPath = {LC_RPATH, sizeof(rpath_command) + 16, {}};
+  RPath.path.offset = sizeof(rpath_command);
+  Put(RPath);
+  for (auto Char : std::string("@loader_path\0\0\0\0", 16)) {
+    Put(Char);
+  }
+  Put(build_version_command{LC_BUILD_VERSION,
+                            sizeof(build_version_command) +
+                                sizeof(build_tool_version),
+                            PLATFORM_MACOS, 0xb0000, 0xc0000, 1});
+  Put(build_tool_version{TOOL_LD, 0x2610000});
+  Put(entry_point_command{LC_MAIN, sizeof(entry_point_command), 0xf00, 0});
+  // Known and skipped
+  Put(sub_client_command{LC_SUB_CLIENT, sizeof(sub_client_command), {}});
+  // Newer than the parser, with and without LC_REQ_DYLD
+  Put(load_command{0x3f, sizeof(load_command)});
+  Put(load_command{0x12345 | LC_REQ_DYLD, sizeof(load_command)});
+  CommandCount = 6;
+  EndCommands();
+
+  auto Check = [](auto &Parser) {
+    ASSERT_EQ(Parser.RPaths.size(), 1u);
+    EXPECT_EQ(Parser.RPaths[0]->Path, "@loader_path");
+    ASSERT_TRUE(Parser.BuildVersion);
+    EXPECT_EQ(Parser.BuildVersion->Raw.platform, uint32_t(PLATFORM_MACOS));
+    ASSERT_EQ(Parser.BuildVersion->Tools.size(), 1u);
+    EXPECT_EQ(Parser.BuildVersion->Tools[0].tool, uint32_t(TOOL_LD));
+    ASSERT_TRUE(Parser.EntryPoint);
+    EXPECT_EQ(Parser.EntryPoint->Raw.entryoff, 0xf00u);
+    EXPECT_EQ(Parser.GetUnknownCommandCount(), 2u);
+  };
+
+  bool IsParsed;
+  auto Parser = Parse<MachSystem64_t>(IsParsed);
+  ASSERT_TRUE(IsParsed);
+  Check(*Parser);
+
+  // Streams cannot be sliced, the commands are read into the parser
+  std::istringstream Stream(std::string(Bytes.data(), Bytes.size()));
+  MachOParser64 Streamed("test", StreamInput(Stream), MO_PARSE_FILE);
+  ASSERT_TRUE(Streamed.Parse());
+  Check(Streamed);
+
+  // More tools than the command has room for
+  PutAt<uint32_t>(HeaderSize + RPath.cmdsize +
+                      offsetof(build_version_command, ntools),
+                  2);
+  Parse<MachSystem64_t>(IsParsed);
+  EXPECT_FALSE(IsParsed);
+}
+
+// Big enough to be decoded on the ThreadPool, whose chunks must fill the same
+// rows one loop over the nlist array does
+TEST_F(macho_parser_test, DecodesLargeSymbolTablesLikeSerially) {
+  auto Count = MO_PARALLEL_SYMBOLS_THRESHOLD + MO_PARALLEL_SYMBOLS_CHUNK / 2;
+  PutSymbols(Count);
+
+  bool IsParsed;
+  auto Parser = Parse<MachSystem64_t>(IsParsed);
+  ASSERT_TRUE(IsParsed);
+  auto &Table = *Parser->SymbolTable;
+  auto &Store = Table.GetStore();
+  ASSERT_EQ(Store.GetSize(), Count);
+
+  SymbolStore Serial;
+  Serial.Reset(Table.StringData, Count, 0);
+  for (uint32_t i = 0; i < Count; ++i) {
+    Serial.Set(i, Table.GetRawSymbol(i), false, false);
+  }
+  ExpectSameStore(Store, Serial);
+  EXPECT_EQ(Store.GetName(0), "_symbol0");
+  EXPECT_EQ(Store.GetName(5), "symbol5");
+  EXPECT_EQ(Store.GetName(6), "");
+}
+
+// A lazy parse leaves the store empty until the first query, which fills it
+// with what an eager parse has right away
+TEST_F(macho_parser_test, BuildsLazySymbolsOnFirstAccess) {
+  PutSymbols(1000);
+  ByteView View(Bytes.data(), Bytes.size());
+  MachOParser<MachSystem64_t, ByteView> Eager("test", View, MO_PARSE_FILE);
+  MachOParser<MachSystem64_t, ByteView> Lazy(
+      "test", View, MO_PARSE_FILE | MO_PARSE_LAZY_SYMBOLS);
+  ASSERT_TRUE(Eager.Parse());
+  ASSERT_TRUE(Lazy.Parse());
+
+  EXPECT_FALSE(Eager.HasLazySymbols());
+  EXPECT_TRUE(Eager.SymbolTable->HasStore());
+  EXPECT_TRUE(Lazy.HasLazySymbols());
+  EXPECT_FALSE(Lazy.SymbolTable->HasStore());
+  EXPECT_EQ(Lazy.SymbolTable->GetSymbolCount(), 1000u);
+
+  auto Symbol = Lazy.SymbolTable->GetSymbol(0);
+  EXPECT_TRUE(Lazy.SymbolTable->HasStore());
+  EXPECT_EQ(Symbol.GetName(), "_symbol0");
+  ExpectSameStore(Lazy.SymbolTable->GetStore(),
+                  Eager.SymbolTable->GetStore());
+}
+
+// Locals the shared cache keeps apart are looked at once the image's own
+// table has nothing
+TEST_F(macho_parser_test, LooksUpLocalSymbolsLast) {
+  PutSymbols(20);
+  bool IsParsed;
+  auto Parser = Parse<MachSystem64_t>(IsParsed);
+  ASSERT_TRUE(IsParsed);
+  SymbolTable<MachSystem64_t, ByteView> Table(*Parser);
+  Table.Init();
+
+  static const char Strings[] = "\0_hidden\0_symbol3";
+  SymbolStore Locals;
+  Locals.Reset(ByteView(Strings, sizeof(Strings)), 2, 0);
+  nlist_64 Hidden = {};
+  Hidden.n_un.n_strx = 1;
+  Hidden.n_type = N_SECT;
+  Hidden.n_sect = 1;
+  Hidden.n_value = 0x100000100;
+  nlist_64 Symbol3 = Hidden;
+  Symbol3.n_un.n_strx = 9;
+  Symbol3.n_value = 0x100000200;
+  Locals.Set(0, Hidden, false, true);
+  Locals.Set(1, Symbol3, false, true);
+  uint32_t Calls = 0;
+  Table.SetLocalSymbols([&]() -> const SymbolStore & {
+    ++Calls;
+    return Locals;
+  });
+
+  auto Found = Table.GetSymbolByName("_symbol0");
+  ASSERT_TRUE(Found);
+  EXPECT_EQ(Found.GetStore(), &Table.GetSymbols());
+  EXPECT_EQ(Calls, 0u);
+
+  Found = Table.GetSymbolByName("_hidden");
+  ASSERT_TRUE(Found);
+  EXPECT_EQ(Found.GetValue(), 0x100000100u);
+  EXPECT_FALSE(Table.GetSymbolByName("_nowhere"));
+
+  // The table's own first
+  auto Symbol3s = Table.GetSymbolsByName("_symbol3");
+  ASSERT_EQ(Symbol3s.size(), 2u);
+  EXPECT_EQ(Symbol3s[0].GetStore(), &Table.GetSymbols());
+  EXPECT_EQ(Symbol3s[1].GetValue(), 0x100000200u);
+
+  // Whichever is closer
+  Found = Table.GetSymbolByAddress(0x100000110);
+  ASSERT_TRUE(Found);
+  EXPECT_EQ(Found.GetName(), "_hidden");
+  Found = Table.GetSymbolByAddress(0x100000020);
+  ASSERT_TRUE(Found);
+  EXPECT_EQ(Found.GetStore(), &Table.GetSymbols());
+  EXPECT_GT(Calls, 0u);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
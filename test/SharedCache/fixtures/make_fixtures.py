@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+# Generates the tiny dyld shared cache fixtures the SharedCache tests read.
+#
+#   legacy_x86_64         single file cache, old header, local symbols inside,
+#                         32-bit local symbols entries
+#   split_arm64e          split cache main file, new header
+#   split_arm64e.01       its only sub-cache
+#   split_arm64e.symbols  local symbols with 64-bit entries
+import os
+import struct
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+MH_MAGIC_64 = struct.pack("<I", 0xFEEDFACF)
+
+
+class Blob:
+    def __init__(self):
+        self.data = bytearray()
+
+    def put(self, offset, raw):
+        if len(self.data) < offset + len(raw):
+            self.data.extend(b"\0" * (offset + len(raw) - len(self.data)))
+        self.data[offset:offset + len(raw)] = raw
+
+    def write(self, name):
+        with open(os.path.join(HERE, name), "wb") as out:
+            out.write(self.data)
+
+
+def header(blob, magic, mapping_offset, mappings, **fields):
+    # Offsets of the dyld_cache_header fields used by the tests
+    layout = {
+        "images_offset_old": (24, "<I"), "images_count_old": (28, "<I"),
+        "local_symbols_offset": (72, "<Q"), "local_symbols_size": (80, "<Q"),
+        "uuid": (88, "16s"), "subcache_offset": (392, "<I"),
+        "subcache_count": (396, "<I"), "symbol_file_uuid": (400, "16s"),
+        "images_offset": (448, "<I"), "images_count": (452, "<I"),
+    }
+    blob.put(0, magic.encode().ljust(16, b"\0"))
+    blob.put(16, struct.pack("<II", mapping_offset, len(mappings)))
+    for name, value in fields.items():
+        offset, fmt = layout[name]
+        assert offset + struct.calcsize(fmt) <= mapping_offset
+        blob.put(offset, struct.pack(fmt, value))
+    for i, (address, size, file_offset) in enumerate(mappings):
+        blob.put(mapping_offset + i * 32,
+                 struct.pack("<QQQII", address, size, file_offset, 5, 5))
+
+
+def images(blob, offset, strings_offset, entries):
+    for i, (address, path) in enumerate(entries):
+        blob.put(offset + i * 32,
+                 struct.pack("<QQQII", address, 0, 0, strings_offset, 0))
+        blob.put(strings_offset, path.encode() + b"\0")
+        strings_offset += len(path) + 1
+
+
+def local_symbols(blob, offset, entries, entry_fmt):
+    # entries: [(dylib offset, [(name, value)])]
+    nlist = bytearray()
+    strings = bytearray(b"\0")
+    table = bytearray()
+    index = 0
+    for dylib_offset, symbols in entries:
+        table += struct.pack(entry_fmt, dylib_offset, index, len(symbols))
+        for name, value in symbols:
+            nlist += struct.pack("<IBBHQ", len(strings), 0x0E, 1, 0, value)
+            strings += name.encode() + b"\0"
+            index += 1
+    info_size = 24
+    nlist_offset = info_size
+    strings_offset = nlist_offset + len(nlist)
+    entries_offset = strings_offset + len(strings)
+    blob.put(offset, struct.pack("<IIIIII", nlist_offset, index,
+                                 strings_offset, len(strings),
+                                 entries_offset, len(entries)))
+    blob.put(offset + nlist_offset, bytes(nlist))
+    blob.put(offset + strings_offset, bytes(strings))
+    blob.put(offset + entries_offset, bytes(table))
+    return info_size + len(nlist) + len(strings) + len(table)
+
+
+def legacy():
+    blob = Blob()
+    header(blob, "dyld_v1   x86_64", 0x98,
+           [(0x7FFF20000000, 0x2000, 0), (0x7FFF30000000, 0x1000, 0x2000)],
+           images_offset_old=0x100, images_count_old=2,
+           local_symbols_offset=0x3000, uuid=bytes(range(16)))
+    images(blob, 0x100, 0x180, [(0x7FFF20001800, "/usr/lib/libB.dylib"),
+                                (0x7FFF20001000, "/usr/lib/libA.dylib")])
+    blob.put(0x1000, MH_MAGIC_64)
+    blob.put(0x1800, MH_MAGIC_64)
+    blob.put(0x2000, b"LINKEDIT")
+    size = local_symbols(blob, 0x3000, [
+        (0x1000, [("_a_local", 0x7FFF20001100), ("_a_other", 0x7FFF20001200)]),
+        (0x1800, [("_b_local", 0x7FFF20001900)]),
+    ], "<III")
+    blob.put(80, struct.pack("<Q", size))
+    blob.write("legacy_x86_64")
+
+
+def split():
+    main_uuid = bytes([0xA0 + i for i in range(16)])
+    sub_uuid = bytes([0xB0 + i for i in range(16)])
+    symbols_uuid = bytes([0xC0 + i for i in range(16)])
+
+    blob = Blob()
+    header(blob, "dyld_v1  arm64e", 0x200, [(0x180000000, 0x2000, 0)],
+           uuid=main_uuid, subcache_offset=0x300, subcache_count=1,
+           symbol_file_uuid=symbols_uuid, images_offset=0x240,
+           images_count=2)
+    images(blob, 0x240, 0x380, [(0x180001000, "/usr/lib/libC.dylib"),
+                                (0x190000000, "/usr/lib/libD.dylib")])
+    blob.put(0x300, sub_uuid + struct.pack("<Q", 0x10000000) +
+             b".01".ljust(32, b"\0"))
+    blob.put(0x1000, MH_MAGIC_64)
+    blob.put(0x1FFF, b"\0")
+    blob.write("split_arm64e")
+
+    blob = Blob()
+    header(blob, "dyld_v1  arm64e", 0x200, [(0x190000000, 0x1000, 0x1000)],
+           uuid=sub_uuid)
+    blob.put(0x1000, MH_MAGIC_64)
+    blob.put(0x1FFF, b"\0")
+    blob.write("split_arm64e.01")
+
+    blob = Blob()
+    header(blob, "dyld_v1  arm64e", 0x200, [], uuid=symbols_uuid,
+           local_symbols_offset=0x200)
+    size = local_symbols(blob, 0x200, [
+        (0x10000000, [("_d_local", 0x190000100)]),
+        (0x1000, [("_c_local", 0x180001100)]),
+    ], "<QII")
+    blob.put(80, struct.pack("<Q", size))
+    blob.write("split_arm64e.symbols")
+
+
+if __name__ == "__main__":
+    legacy()
+    split()
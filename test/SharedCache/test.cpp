@@ -0,0 +1,142 @@
+// Std
+#include <cstring>
+#include <string>
+
+// MAD
+#include "MAD/SharedCache.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+static std::string Fixture(std::string Name) {
+  return std::string(FIXTURES_DIR) + "/" + Name;
+}
+
+struct LocalNList {
+  uint32_t Strx;
+  uint8_t Type;
+  uint8_t Sect;
+  uint16_t Desc;
+  uint64_t Value;
+};
+
+static std::string_view GetLocalName(const SharedCache::LocalSymbols &Symbols,
+                                     uint32_t Index, uint64_t *Value) {
+  LocalNList Entry;
+  if (!Symbols.NList.ReadAt(Index * sizeof(Entry), Entry)) {
+    return {};
+  }
+  *Value = Entry.Value;
+  return Symbols.Strings.StringAt(Entry.Strx);
+}
+
+TEST(shared_cache_test, OpenFailsOnGarbage) {
+  SharedCache Cache;
+  EXPECT_FALSE(Cache.Open(Fixture("does_not_exist")));
+  EXPECT_FALSE(Cache.Open(Fixture("make_fixtures.py")));
+  EXPECT_FALSE(Cache.IsOpen());
+}
+
+TEST(shared_cache_test, LegacyImages) {
+  SharedCache Cache;
+  ASSERT_TRUE(Cache.Open(Fixture("legacy_x86_64")));
+  EXPECT_EQ(Cache.GetBaseAddress(), 0x7FFF20000000u);
+  EXPECT_EQ(Cache.GetNListSize(), 16u);
+  EXPECT_EQ(Cache.GetUUID()[15], 15);
+
+  auto &Images = Cache.GetImages();
+  ASSERT_EQ(Images.size(), 2u);
+  EXPECT_EQ(Images[0].Path, "/usr/lib/libA.dylib");
+  EXPECT_EQ(Images[1].Path, "/usr/lib/libB.dylib");
+
+  auto Image = Cache.GetImageByAddress(0x7FFF20001800);
+  ASSERT_TRUE(Image);
+  EXPECT_EQ(Image->Path, "/usr/lib/libB.dylib");
+  EXPECT_EQ(Cache.GetImageByPath("/usr/lib/libA.dylib"), &Images[0]);
+  EXPECT_FALSE(Cache.GetImageByAddress(0x7FFF20001801));
+}
+
+TEST(shared_cache_test, LegacyViews) {
+  SharedCache Cache;
+  ASSERT_TRUE(Cache.Open(Fixture("legacy_x86_64")));
+
+  auto Header = Cache.GetView(0x7FFF20001000, 4);
+  ASSERT_EQ(Header.GetSize(), 4u);
+  uint32_t Magic;
+  ASSERT_TRUE(Header.ReadAt(0, Magic));
+  EXPECT_EQ(Magic, 0xFEEDFACFu);
+
+  EXPECT_EQ(Cache.GetViewToEnd(0x7FFF20001000).GetSize(), 0x1000u);
+  EXPECT_EQ(Cache.GetView(0x7FFF30000000, 8).StringAt(0), "LINKEDIT");
+  // Views never span mappings
+  EXPECT_TRUE(Cache.GetView(0x7FFF20001000, 0x1001).IsEmpty());
+  EXPECT_FALSE(Cache.Contains(0x7FFF20002000));
+
+  Cache.SetSlide(0x10000);
+  EXPECT_TRUE(Cache.Contains(0x7FFF20011FFF));
+  EXPECT_TRUE(Cache.GetImageByAddress(0x7FFF20011000));
+  EXPECT_FALSE(Cache.GetView(0x7FFF20001000, 4).GetSize());
+}
+
+TEST(shared_cache_test, LegacyLocalSymbols) {
+  SharedCache Cache;
+  ASSERT_TRUE(Cache.Open(Fixture("legacy_x86_64")));
+
+  SharedCache::LocalSymbols Symbols;
+  ASSERT_TRUE(Cache.GetLocalSymbols(0x7FFF20001000, Symbols));
+  ASSERT_EQ(Symbols.NList.GetSize(), 2 * sizeof(LocalNList));
+  uint64_t Value;
+  EXPECT_EQ(GetLocalName(Symbols, 0, &Value), "_a_local");
+  EXPECT_EQ(Value, 0x7FFF20001100u);
+  EXPECT_EQ(GetLocalName(Symbols, 1, &Value), "_a_other");
+
+  ASSERT_TRUE(Cache.GetLocalSymbols(0x7FFF20001800, Symbols));
+  EXPECT_EQ(GetLocalName(Symbols, 0, &Value), "_b_local");
+
+  EXPECT_FALSE(Cache.GetLocalSymbols(0x7FFF20001400, Symbols));
+}
+
+TEST(shared_cache_test, SplitCache) {
+  SharedCache Cache;
+  ASSERT_TRUE(Cache.Open(Fixture("split_arm64e")));
+
+  auto &Images = Cache.GetImages();
+  ASSERT_EQ(Images.size(), 2u);
+  EXPECT_EQ(Images[1].Path, "/usr/lib/libD.dylib");
+
+  // libD lives in the sub-cache
+  uint32_t Magic = 0;
+  ASSERT_TRUE(Cache.GetView(0x190000000, 4).ReadAt(0, Magic));
+  EXPECT_EQ(Magic, 0xFEEDFACFu);
+  ASSERT_TRUE(Cache.GetView(0x180001000, 4).ReadAt(0, Magic));
+  EXPECT_EQ(Magic, 0xFEEDFACFu);
+
+  // Local symbols come from the .symbols file with 64-bit entries
+  SharedCache::LocalSymbols Symbols;
+  uint64_t Value;
+  ASSERT_TRUE(Cache.GetLocalSymbols(0x190000000, Symbols));
+  EXPECT_EQ(GetLocalName(Symbols, 0, &Value), "_d_local");
+  EXPECT_EQ(Value, 0x190000100u);
+  ASSERT_TRUE(Cache.GetLocalSymbols(0x180001000, Symbols));
+  EXPECT_EQ(GetLocalName(Symbols, 0, &Value), "_c_local");
+}
+
+TEST(shared_cache_test, SharedStringTableIndex) {
+  SharedCache Cache;
+  ASSERT_TRUE(Cache.Open(Fixture("legacy_x86_64")));
+
+  SharedCache::LocalSymbols A, B;
+  ASSERT_TRUE(Cache.GetLocalSymbols(0x7FFF20001000, A));
+  ASSERT_TRUE(Cache.GetLocalSymbols(0x7FFF20001800, B));
+
+  auto Index = Cache.GetStringTableIndex(A.Strings);
+  EXPECT_EQ(Index, Cache.GetStringTableIndex(B.Strings));
+  EXPECT_EQ(Index->GetStringCount(), 4u);
+  EXPECT_EQ(Index->GetString(1), "_a_local");
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
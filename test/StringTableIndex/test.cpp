@@ -0,0 +1,196 @@
+// Std
+#include <cstdint>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/StringTableIndex.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// Tables at least this big are hashed on the ThreadPool, see
+// STI_PARALLEL_HASH_THRESHOLD
+#define PARALLEL_HASH_THRESHOLD (1u << 20)
+
+// Strings of every length up to a little more than a 64-byte block, one after
+// the other, so that terminators fall on and around every 16- and 32-byte
+// chunk boundary. Runs of empty strings put several terminators in a row.
+static std::string MakeTable() {
+  std::string Table;
+  for (uint32_t Length = 0; Length <= 80; ++Length) {
+    for (uint32_t i = 0; i < Length; ++i) {
+      Table += char('a' + (Length + i) % 26);
+    }
+    Table += '\0';
+  }
+  Table.append(20, '\0');
+  return Table;
+}
+
+// Random bytes, about one in Density of which are NUL
+static std::string MakeRandomTable(size_t Size, uint32_t Density,
+                                   uint32_t Seed) {
+  std::mt19937 Random(Seed);
+  std::string Table(Size, '\0');
+  for (auto &C : Table) {
+    C = Random() % Density ? char('a' + Random() % 26) : '\0';
+  }
+  return Table;
+}
+
+// What the scalar kernel and the index are checked against
+static std::vector<uint64_t> ScanNaive(std::string_view Table) {
+  std::vector<uint64_t> Bitmap((Table.size() + 63) / 64);
+  for (size_t i = 0; i < Table.size(); ++i) {
+    if (!Table[i]) {
+      Bitmap[i / 64] |= 1ull << (i % 64);
+    }
+  }
+  return Bitmap;
+}
+
+static std::vector<uint64_t> Scan(std::string_view Table,
+                                   StringScanKernel Kernel) {
+  std::vector<uint64_t> Bitmap((Table.size() + 63) / 64);
+  StringTableIndex::ScanTerminators(Table.data(), Table.size(),
+                                    Bitmap.data(), Kernel);
+  return Bitmap;
+}
+
+// Every kernel against the scalar one, SIMD kernels the CPU lacks are skipped
+class string_table_index
+    : public ::testing::TestWithParam<StringScanKernel> {
+protected:
+  void SetUp() override {
+#ifdef __SSE2__
+    if (GetParam() == StringScanKernel::AVX2 &&
+        !__builtin_cpu_supports("avx2")) {
+      GTEST_SKIP() << "No AVX2";
+    }
+#endif
+  }
+
+  // Checks an index built with the kernel under test against one built with
+  // the scalar kernel and against the table itself
+  void ExpectSameIndex(std::string_view Table) {
+    ByteView View(Table.data(), Table.size());
+    StringTableIndex Index, Scalar;
+    Index.Build(View, GetParam());
+    Scalar.Build(View, StringScanKernel::SCALAR);
+    Index.BuildHashes();
+    Scalar.BuildHashes();
+
+    uint32_t Count = 0;
+    for (auto C : Table) {
+      Count += !C;
+    }
+    ASSERT_EQ(Index.GetStringCount(), Count) << Table.size();
+    ASSERT_EQ(Scalar.GetStringCount(), Count) << Table.size();
+
+    for (uint64_t Offset = 0; Offset < Table.size(); ++Offset) {
+      // An unterminated tail runs up to the end of the table
+      auto End = Table.find('\0', Offset);
+      auto Length = (End == std::string_view::npos ? Table.size() : End) -
+                    Offset;
+      ASSERT_EQ(Index.GetLength(Offset), Length) << Offset;
+      ASSERT_EQ(Scalar.GetLength(Offset), Length) << Offset;
+      ASSERT_EQ(Index.IsStringStart(Offset), Scalar.IsStringStart(Offset))
+          << Offset;
+
+      // Bulk hashes are addressed by the rank of the string, a wrong one
+      // hands out the hash of another string
+      auto Expected = StringTableIndex::Hash(Table.substr(Offset, Length));
+      ASSERT_EQ(Index.GetHash(Offset), Expected) << Offset;
+      ASSERT_EQ(Scalar.GetHash(Offset), Expected) << Offset;
+    }
+    EXPECT_EQ(Index.GetLength(Table.size()), 0u);
+  }
+};
+
+TEST_P(string_table_index, ScansLikeScalarKernel) {
+  auto Table = MakeTable();
+  // Every size, i.e. every tail the SIMD kernels leave to the scalar one
+  for (size_t Size = 0; Size <= Table.size(); ++Size) {
+    std::string_view Prefix(Table.data(), Size);
+    auto Expected = ScanNaive(Prefix);
+    ASSERT_EQ(Scan(Prefix, StringScanKernel::SCALAR), Expected) << Size;
+    ASSERT_EQ(Scan(Prefix, GetParam()), Expected) << Size;
+  }
+
+  // From every misaligned start within a block
+  for (size_t Start = 1; Start < 64; ++Start) {
+    std::string_view Suffix(Table.data() + Start, Table.size() - Start);
+    ASSERT_EQ(Scan(Suffix, GetParam()), ScanNaive(Suffix)) << Start;
+  }
+
+  // Terminators everywhere, and nowhere
+  std::string Zeros(300, '\0'), Letters(300, 'x');
+  EXPECT_EQ(Scan(Zeros, GetParam()), ScanNaive(Zeros));
+  EXPECT_EQ(Scan(Letters, GetParam()), ScanNaive(Letters));
+}
+
+TEST_P(string_table_index, IndexesLikeScalarKernel) {
+  auto Table = MakeTable();
+  ExpectSameIndex(Table);
+  ExpectSameIndex(MakeRandomTable(4096, 8, 1));
+  ExpectSameIndex(std::string(130, '\0'));
+}
+
+// The last string runs up to the end of the table without a terminator
+TEST_P(string_table_index, IndexesUnterminatedTables) {
+  auto Table = MakeTable();
+  for (auto Size : {1u, 15u, 16u, 17u, 31u, 32u, 33u, 63u, 64u, 65u, 200u,
+                    1000u}) {
+    std::string Unterminated = Table.substr(0, Size);
+    while (!Unterminated.empty() && !Unterminated.back()) {
+      Unterminated.pop_back();
+    }
+    Unterminated += "tail";
+    ExpectSameIndex(Unterminated);
+  }
+  ExpectSameIndex(std::string(200, 'x'));
+}
+
+// Big enough to be hashed on the ThreadPool, where chunks find the start of
+// their first string in another chunk
+TEST_P(string_table_index, HashesLargeTablesInParallel) {
+  auto Table = MakeRandomTable(PARALLEL_HASH_THRESHOLD + 1000, 40, 2);
+  // A string that spans a whole chunk of bitmap words
+  Table.replace(300000, 4096 * 64 + 100, 4096 * 64 + 100, 'y');
+  Table.back() = 'z';
+  ByteView View(Table.data(), Table.size());
+  StringTableIndex Index;
+  Index.Build(View, GetParam());
+  Index.BuildHashes();
+  ASSERT_TRUE(Index.HasHashes());
+
+  uint32_t Strings = 0;
+  uint64_t Start = 0;
+  for (uint64_t Offset = 0; Offset < Table.size(); ++Offset) {
+    if (Table[Offset]) {
+      continue;
+    }
+    std::string_view String(Table.data() + Start, Offset - Start);
+    ASSERT_EQ(Index.GetHash(Start), StringTableIndex::Hash(String)) << Start;
+    Start = Offset + 1;
+    ++Strings;
+  }
+  EXPECT_EQ(Index.GetStringCount(), Strings);
+  EXPECT_EQ(Index.GetLength(Start), Table.size() - Start);
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, string_table_index,
+                         ::testing::Values(StringScanKernel::SCALAR,
+                                           StringScanKernel::SSE2,
+                                           StringScanKernel::AVX2,
+                                           StringScanKernel::BEST));
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
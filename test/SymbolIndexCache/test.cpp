@@ -0,0 +1,189 @@
+// System
+#include <mach-o/nlist.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Std
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/SymbolIndexCache.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+static const char Strings[] = "\0_main\0_helper\0_data";
+
+class symbol_index_cache_test : public ::testing::Test {
+protected:
+  std::string Directory;
+  SymbolIndexKey Key;
+  SymbolStore Store;
+  FunctionStarts Functions;
+
+  void SetUp() override {
+    char Template[] = "/tmp/mad_symbol_index_XXXXXX";
+    ASSERT_TRUE(mkdtemp(Template));
+    // Saving creates whatever is missing
+    Directory = std::string(Template) + "/nested";
+
+    memset(&Key, 0, sizeof(Key));
+    for (unsigned i = 0; i < sizeof(Key.UUID); ++i) {
+      Key.UUID[i] = i;
+    }
+    Key.Kind = MO_SYMBOL_INDEX_64 | MO_SYMBOL_INDEX_IMAGE;
+    Key.SymbolCount = 3;
+    Key.StringTableSize = sizeof(Strings);
+    Key.FunctionStartsSize = 8;
+    Key.TextAddress = 0x100000000;
+
+    struct nlist_64 Entries[3] = {};
+    Entries[0].n_un.n_strx = 1;
+    Entries[0].n_type = N_SECT | N_EXT;
+    Entries[0].n_sect = 1;
+    Entries[0].n_value = 0x100000400;
+    Entries[1].n_un.n_strx = 7;
+    Entries[1].n_type = N_SECT;
+    Entries[1].n_sect = 1;
+    Entries[1].n_value = 0x100000480;
+    Entries[2].n_un.n_strx = 15;
+    Entries[2].n_type = N_SECT | N_EXT;
+    Entries[2].n_sect = 2;
+    Entries[2].n_desc = N_WEAK_DEF;
+    Entries[2].n_value = 0x100001000;
+
+    Store.Reset(ByteView(Strings, sizeof(Strings)), 3, 0x1000);
+    for (uint32_t i = 0; i < 3; ++i) {
+      Store.Set(i, Entries[i], false, true);
+    }
+
+    // Starts at 0x400 and 0x480 with __text ending at 0x500
+    const uint8_t Starts[] = {0x80, 0x08, 0x80, 0x01, 0x00};
+    ASSERT_TRUE(Functions.Decode(
+        ByteView(reinterpret_cast<const char *>(Starts), sizeof(Starts)),
+        0x100001000));
+    Functions.SetLimit(0x100001500);
+  }
+
+  void TearDown() override {
+    system(("rm -rf " + Directory.substr(0, Directory.rfind('/'))).c_str());
+  }
+};
+
+TEST_F(symbol_index_cache_test, RoundTrip) {
+  SymbolIndexCache Cache(Directory);
+  ASSERT_TRUE(Cache.Save(Key, Store, Functions));
+
+  SymbolStore Loaded;
+  FunctionStarts LoadedFunctions;
+  ASSERT_TRUE(Cache.Load(Key, 0x1000, Loaded, LoadedFunctions));
+  ASSERT_EQ(Loaded.GetSize(), 3u);
+  EXPECT_TRUE(Loaded.Values.IsView());
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    SymbolRef A(&Store, i), B(&Loaded, i);
+    EXPECT_EQ(A.GetName(), B.GetName());
+    EXPECT_EQ(A.GetValue(), B.GetValue());
+    EXPECT_EQ(A.GetFlags(), B.GetFlags());
+    EXPECT_EQ(A.GetDesc(), B.GetDesc());
+    EXPECT_EQ(A.GetType(), B.GetType());
+    EXPECT_EQ(A.GetSectionNumber(), B.GetSectionNumber());
+  }
+  EXPECT_EQ(SymbolRef(&Loaded, 1).GetName(), "_helper");
+  EXPECT_TRUE(SymbolRef(&Loaded, 2).Is(MO_SYMBOL_WEAK_DEFINITION));
+
+  uint64_t Start, End;
+  ASSERT_TRUE(LoadedFunctions.Lookup(0x1000014A0, Start, End));
+  EXPECT_EQ(Start, 0x100001480u);
+  EXPECT_EQ(End, 0x100001500u);
+}
+
+TEST_F(symbol_index_cache_test, AppliesSlideOnLoad) {
+  SymbolIndexCache Cache(Directory);
+  ASSERT_TRUE(Cache.Save(Key, Store, Functions));
+
+  SymbolStore Loaded;
+  FunctionStarts LoadedFunctions;
+  ASSERT_TRUE(Cache.Load(Key, 0x20000, Loaded, LoadedFunctions));
+  EXPECT_EQ(SymbolRef(&Loaded, 0).GetValue(), 0x100020400u);
+
+  uint64_t Start, End;
+  ASSERT_TRUE(LoadedFunctions.Lookup(0x100020410, Start, End));
+  EXPECT_EQ(Start, 0x100020400u);
+  EXPECT_EQ(End, 0x100020480u);
+}
+
+TEST_F(symbol_index_cache_test, MissesOtherBuilds) {
+  SymbolIndexCache Cache(Directory);
+  ASSERT_TRUE(Cache.Save(Key, Store, Functions));
+
+  SymbolStore Loaded;
+  FunctionStarts LoadedFunctions;
+
+  // Same UUID, but stripped
+  auto Stripped = Key;
+  Stripped.SymbolCount = 1;
+  EXPECT_FALSE(Cache.Load(Stripped, 0, Loaded, LoadedFunctions));
+
+  auto Other = Key;
+  Other.UUID[0] = 0xFF;
+  EXPECT_FALSE(Cache.Load(Other, 0, Loaded, LoadedFunctions));
+
+  EXPECT_EQ(Loaded.GetSize(), 0u);
+  EXPECT_TRUE(LoadedFunctions.IsEmpty());
+}
+
+TEST_F(symbol_index_cache_test, RejectsDamagedFiles) {
+  SymbolIndexCache Cache(Directory);
+  ASSERT_TRUE(Cache.Save(Key, Store, Functions));
+
+  auto Path = Directory + "/00010203-0405-0607-0809-0A0B0C0D0E0F.symidx";
+  std::vector<char> Bytes;
+  {
+    std::ifstream In(Path, std::ios::binary);
+    ASSERT_TRUE(In.good());
+    Bytes.assign(std::istreambuf_iterator<char>(In), {});
+  }
+
+  SymbolStore Loaded;
+  FunctionStarts LoadedFunctions;
+
+  // Truncated
+  std::ofstream(Path, std::ios::binary).write(Bytes.data(), 100);
+  EXPECT_FALSE(Cache.Load(Key, 0, Loaded, LoadedFunctions));
+
+  // Another version
+  auto Newer = Bytes;
+  Newer[8] += 1;
+  std::ofstream(Path, std::ios::binary).write(Newer.data(), Newer.size());
+  EXPECT_FALSE(Cache.Load(Key, 0, Loaded, LoadedFunctions));
+
+  // A name pointing past the strings
+  auto Broken = Bytes;
+  uint32_t Offset = 0xFFFF;
+  memcpy(Broken.data() + 64 + 3 * sizeof(uint64_t), &Offset, sizeof(Offset));
+  std::ofstream(Path, std::ios::binary).write(Broken.data(), Broken.size());
+  EXPECT_FALSE(Cache.Load(Key, 0, Loaded, LoadedFunctions));
+
+  // The next save replaces whatever is there
+  ASSERT_TRUE(Cache.Save(Key, Store, Functions));
+  EXPECT_TRUE(Cache.Load(Key, 0, Loaded, LoadedFunctions));
+}
+
+TEST_F(symbol_index_cache_test, DisabledWithoutDirectory) {
+  SymbolIndexCache Cache;
+  SymbolStore Loaded;
+  FunctionStarts LoadedFunctions;
+  EXPECT_FALSE(Cache.IsEnabled());
+  EXPECT_FALSE(Cache.Save(Key, Store, Functions));
+  EXPECT_FALSE(Cache.Load(Key, 0, Loaded, LoadedFunctions));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,202 @@
+// System
+#include <mach-o/nlist.h>
+
+// Std
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/SymbolSearch.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+static const std::vector<std::string> Names = {
+    "_main",
+    "__ZN5myapp6Engine5startEv",
+    "__ZN5myapp6Engine4stopEv",
+    "__ZN5myapp4initEv",
+    "__ZN6myapp24initEv",
+    "__ZNK5myapp6Engine4sizeEv",
+    "_objc_msgSend",
+    "_malloc",
+    "_malloc_zone_malloc",
+    "a.b",
+    "axb",
+    "",
+};
+
+class symbol_search_test : public ::testing::Test {
+protected:
+  // Two string tables, both start with the empty name
+  std::string Strings = std::string(1, '\0');
+  std::string Other = std::string(1, '\0');
+
+  static uint32_t AddString(std::string &Table, const std::string &Name) {
+    auto Offset = Table.size();
+    Table += Name + '\0';
+    return Offset;
+  }
+
+  // Every symbol is defined unless its type says otherwise
+  static void Fill(SymbolStore &Store, const std::string &Table,
+                   const std::vector<uint32_t> &Offsets,
+                   const std::vector<uint8_t> &Types = {}) {
+    Store.Reset(ByteView(Table.data(), Table.size()), Offsets.size(), 0);
+    for (uint32_t i = 0; i < Offsets.size(); ++i) {
+      struct nlist_64 Raw = {};
+      Raw.n_un.n_strx = Offsets[i];
+      Raw.n_type = i < Types.size() ? Types[i] : N_SECT | N_EXT;
+      Raw.n_sect = 1;
+      Store.Set(i, Raw, false, true);
+    }
+  }
+};
+
+TEST_F(symbol_search_test, MatchesLikeTheRegexEngine) {
+  struct Case {
+    std::string Pattern;
+    std::string Literal;
+  };
+  const Case Cases[] = {
+      {"^__ZN5myapp.*", "__ZN5myapp"},
+      {"myapp", "myapp"},
+      {"^_malloc$", "_malloc"},
+      {"^_ma.*oc$", "_ma"},
+      {"Engine.*Ev$", "Engine"},
+      {"^__ZN\\d+myapp", "myapp"},
+      {"_(main|malloc)", "_"},
+      {"main|init", ""},
+      {"a\\.b", "a.b"},
+      {"a.b", "a"},
+      {"^__ZNK?5myapp", "5myapp"},
+      {"s+t", "s"},
+      {"_mal{1,}oc", "_mal"},
+      {"_mal{0,2}oc", "_ma"},
+      {"_[a-z]+_zone", "_zone"},
+      {"Engine\\x34", "Engine"},
+      {".*", ""},
+      {"^$", ""},
+  };
+
+  for (auto &C : Cases) {
+    SymbolPattern Pattern;
+    ASSERT_TRUE(Pattern.Compile(C.Pattern)) << C.Pattern;
+    EXPECT_EQ(Pattern.GetLiteral(), C.Literal) << C.Pattern;
+
+    std::regex Regex(C.Pattern);
+    for (auto &Name : Names) {
+      EXPECT_EQ(Pattern.Match(Name), std::regex_search(Name, Regex))
+          << C.Pattern << " " << Name;
+    }
+  }
+
+  SymbolPattern Pattern;
+  EXPECT_FALSE(Pattern.Compile("_(main"));
+}
+
+TEST_F(symbol_search_test, MatchesGlobs) {
+  SymbolPattern Pattern;
+  ASSERT_TRUE(Pattern.Compile("__ZN5myapp*", true));
+  EXPECT_EQ(Pattern.GetLiteral(), "__ZN5myapp");
+  EXPECT_TRUE(Pattern.Match("__ZN5myapp4initEv"));
+  EXPECT_FALSE(Pattern.Match("___ZN5myapp4initEv"));
+
+  ASSERT_TRUE(Pattern.Compile("_malloc", true));
+  EXPECT_TRUE(Pattern.Match("_malloc"));
+  EXPECT_FALSE(Pattern.Match("_malloc_zone_malloc"));
+
+  ASSERT_TRUE(Pattern.Compile("?*[!a-z]Engine*", true));
+  EXPECT_TRUE(Pattern.Match("__ZN5myapp6Engine4stopEv"));
+  EXPECT_FALSE(Pattern.Match("xEngine"));
+
+  ASSERT_TRUE(Pattern.Compile("a.b", true));
+  EXPECT_TRUE(Pattern.Match("a.b"));
+  EXPECT_FALSE(Pattern.Match("axb"));
+}
+
+TEST_F(symbol_search_test, KernelsFindEveryOccurrence) {
+  // Short and long literals, overlapping ones, and ones right at both ends
+  std::mt19937 Random(7);
+  std::string Table;
+  for (uint32_t i = 0; i < 5000; ++i) {
+    Table.push_back("abc\0"[Random() % 4]);
+  }
+  const std::string Literals[] = {"a", "ab", "abca", "aaa", "cab\0c", "b"};
+
+  for (auto Literal : Literals) {
+    Literal = Literal.c_str();
+    for (uint64_t Size : {0ul, 3ul, 31ul, 64ul, 100ul, 5000ul}) {
+      std::vector<uint64_t> Expected((Size + 63) / 64);
+      for (uint64_t i = 0; i + Literal.size() <= Size; ++i) {
+        if (!Table.compare(i, Literal.size(), Literal)) {
+          Expected[i / 64] |= 1ull << (i % 64);
+        }
+      }
+      for (auto Kernel : {StringScanKernel::SCALAR, StringScanKernel::SSE2,
+                          StringScanKernel::AVX2, StringScanKernel::BEST}) {
+        std::vector<uint64_t> Hits((Size + 63) / 64);
+        SymbolSearch::FindLiteral(Table.data(), Size, Literal, Hits.data(),
+                                  Kernel);
+        EXPECT_EQ(Hits, Expected) << Literal << " " << Size;
+      }
+    }
+  }
+}
+
+TEST_F(symbol_search_test, SearchesEveryStore) {
+  // Enough to be searched on the thread pool, every tenth name is a suffix
+  // of the previous one
+  std::vector<uint32_t> Offsets;
+  std::vector<uint8_t> Types;
+  for (uint32_t i = 0; i < 100000; ++i) {
+    if (i % 10 == 9) {
+      Offsets.push_back(Offsets.back() + 4);
+    } else {
+      Offsets.push_back(
+          AddString(Strings, Names[i % Names.size()] + std::to_string(i)));
+    }
+    Types.push_back(i % 7 == 3 ? N_UNDF | N_EXT : i % 13 ? N_SECT : N_FUN);
+  }
+
+  // Two stores over the same table and one over a table of its own
+  SymbolStore First;
+  SymbolStore Second;
+  Fill(First, Strings, Offsets, Types);
+  Fill(Second, Strings,
+       std::vector<uint32_t>(Offsets.rbegin(), Offsets.rend()));
+  SymbolStore Third;
+  Fill(Third, Other,
+       {AddString(Other, "__ZN5myapp3runEv"), AddString(Other, "_main")});
+
+  const std::string Patterns[] = {"^__ZN5myapp.*", "myapp", "Engine.*9$",
+                                  "main|init", "^a.b"};
+  for (auto &Source : Patterns) {
+    SymbolPattern Pattern;
+    ASSERT_TRUE(Pattern.Compile(Source));
+    auto Rows = SymbolSearch::Search(Pattern, {&First, &Second, &Third});
+    ASSERT_EQ(Rows.size(), 3u);
+
+    uint32_t StoreIndex = 0;
+    for (auto Store : {&First, &Second, &Third}) {
+      std::vector<uint32_t> Expected;
+      for (uint32_t Row = 0; Row < Store->GetSize(); ++Row) {
+        SymbolRef Symbol(Store, Row);
+        if (Symbol.IsDefined() && !Symbol.IsStab() &&
+            !Symbol.GetName().empty() && Pattern.Match(Symbol.GetName())) {
+          Expected.push_back(Row);
+        }
+      }
+      EXPECT_EQ(Rows[StoreIndex++], Expected) << Source;
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,157 @@
+// System
+#include <mach-o/nlist.h>
+
+// Std
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/SymbolStore.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+class symbol_store_test : public ::testing::Test {
+protected:
+  std::string Strings;
+  std::vector<uint32_t> Offsets;
+  SymbolStore Store;
+
+  // The string table starts with the empty name, which is offset 0
+  void SetUp() override { Strings.assign(1, '\0'); }
+
+  uint32_t AddString(const std::string &Name) {
+    auto Offset = Strings.size();
+    Strings += Name + '\0';
+    return Offset;
+  }
+
+  // One symbol per offset, its value is its row
+  void Fill() {
+    Store.Reset(ByteView(Strings.data(), Strings.size()), Offsets.size(), 0);
+    for (uint32_t i = 0; i < Offsets.size(); ++i) {
+      struct nlist_64 Raw = {};
+      Raw.n_un.n_strx = Offsets[i];
+      Raw.n_type = N_SECT;
+      Raw.n_sect = 1;
+      Raw.n_value = i;
+      Store.Set(i, Raw, false, true);
+    }
+  }
+};
+
+TEST_F(symbol_store_test, NameIndexKeepsEveryDuplicate) {
+  auto Main = AddString("_main");
+  auto Helper = AddString("_helper");
+  Offsets = {Helper, Main, 0, Helper, Main, Helper};
+  Fill();
+
+  SymbolNameIndex Index;
+  Index.Build(Store);
+
+  uint32_t Row;
+  ASSERT_TRUE(Index.Lookup(Store, "_main", Row));
+  EXPECT_EQ(Row, 1u);
+  ASSERT_TRUE(Index.Lookup(Store, "_helper", Row));
+  EXPECT_EQ(Row, 0u);
+  EXPECT_FALSE(Index.Lookup(Store, "_mai", Row));
+  EXPECT_FALSE(Index.Lookup(Store, "", Row));
+
+  std::vector<uint32_t> Rows;
+  Index.ForEach(Store, "_helper", [&](uint32_t Row) { Rows.push_back(Row); });
+  EXPECT_EQ(Rows, std::vector<uint32_t>({0, 3, 5}));
+}
+
+TEST_F(symbol_store_test, NameIndexOfManySymbols) {
+  // Enough to be hashed on the thread pool, every tenth name twice
+  const uint32_t Count = 100000;
+  for (uint32_t i = 0; i < Count; ++i) {
+    Offsets.push_back(AddString("_symbol" + std::to_string(i)));
+  }
+  for (uint32_t i = 0; i < Count; i += 10) {
+    Offsets.push_back(Offsets[i]);
+  }
+  Fill();
+
+  SymbolNameIndex Index;
+  Index.Build(Store);
+
+  for (uint32_t i = 0; i < Count; ++i) {
+    auto Name = "_symbol" + std::to_string(i);
+    uint32_t Row;
+    ASSERT_TRUE(Index.Lookup(Store, Name, Row)) << Name;
+    ASSERT_EQ(Row, i);
+
+    uint32_t Matches = 0;
+    Index.ForEach(Store, Name, [&](uint32_t) { ++Matches; });
+    ASSERT_EQ(Matches, i % 10 ? 1u : 2u) << Name;
+
+    ASSERT_FALSE(Index.Lookup(Store, "_other" + std::to_string(i), Row));
+  }
+}
+
+TEST_F(symbol_store_test, EmptyNameIndex) {
+  SymbolNameIndex Index;
+  uint32_t Row;
+  EXPECT_FALSE(Index.Lookup(Store, "_main", Row));
+
+  Fill();
+  Index.Build(Store);
+  EXPECT_FALSE(Index.Lookup(Store, "_main", Row));
+}
+
+TEST_F(symbol_store_test, AddressIndexFindsTheClosestSymbolBelow) {
+  // All of them are _main, the index leaves nameless symbols out
+  auto Main = AddString("_main");
+
+  // Every shape of the tree, from empty to a few levels deep
+  std::mt19937 Random(42);
+  for (uint32_t Count = 0; Count < 100; ++Count) {
+    std::vector<uint64_t> Values;
+    for (uint32_t i = 0; i < Count; ++i) {
+      Values.push_back(0x100000000 + (Random() % 0x10000) * 4);
+    }
+
+    Store.Reset(ByteView(Strings.data(), Strings.size()), Count, 0x4000);
+    for (uint32_t i = 0; i < Count; ++i) {
+      struct nlist_64 Raw = {};
+      Raw.n_un.n_strx = Main;
+      Raw.n_type = N_SECT;
+      Raw.n_sect = 1;
+      Raw.n_value = Values[i];
+      Store.Set(i, Raw, false, true);
+    }
+    SymbolAddressIndex Index;
+    Index.Build(Store);
+
+    std::sort(Values.begin(), Values.end());
+    Values.erase(std::unique(Values.begin(), Values.end()), Values.end());
+    ASSERT_EQ(Index.GetSize(), Values.size());
+
+    for (uint32_t i = 0; i < 200; ++i) {
+      uint64_t Value = 0x100000000 + (Random() % 0x10002) * 4 - 4;
+      auto Expected =
+          std::upper_bound(Values.begin(), Values.end(), Value) -
+          Values.begin();
+      ASSERT_EQ(Index.UpperBound(Value + 0x4000), size_t(Expected));
+
+      uint32_t Found = 0;
+      ASSERT_EQ(Index.Lookup(Value + 0x4000, Found), Expected > 0);
+      if (Expected) {
+        EXPECT_EQ(Store.GetValue(Found), Values[Expected - 1] + 0x4000);
+      }
+    }
+
+    // Addresses below the slide are below every symbol
+    EXPECT_EQ(Index.UpperBound(0x100), 0u);
+  }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
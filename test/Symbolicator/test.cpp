@@ -0,0 +1,230 @@
+// System
+#include <mach-o/nlist.h>
+#include <mach-o/stab.h>
+
+// Std
+#include <memory>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/ByteView.hpp"
+#include "MAD/MachOParser.hpp"
+#include "MAD/Symbolicator.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+static const char Strings[] =
+    "\0_main\0_helper\0_main_alias\0_data\0_printf\0_stab";
+
+// Locals of the shared cache's .symbols file
+static const char LocalStrings[] = "\0_static\0_main_local";
+
+// Symbols of an image linked at 0x100000000, loaded at Base
+class FakeImage {
+public:
+  using Segment_t = MachOFileParser64::MachOSegment;
+  using Section_t = MachOFileParser64::MachOSection;
+
+  class FakeSymbolTable {
+  public:
+    SymbolStore Store;
+    SymbolAddressIndex Index;
+    SymbolStore Locals;
+    SymbolAddressIndex LocalIndex;
+    FunctionStarts Functions;
+
+    const SymbolStore &GetSymbols() { return Store; }
+    const SymbolAddressIndex &GetAddressIndex() { return Index; }
+    const SymbolStore &GetLocalSymbols() { return Locals; }
+    const SymbolAddressIndex &GetLocalAddressIndex() { return LocalIndex; }
+    const FunctionStarts &GetFunctionStarts() { return Functions; }
+  };
+
+  std::vector<std::shared_ptr<Segment_t>> Segments;
+  FakeSymbolTable Table;
+  uint64_t Slide;
+
+  explicit FakeImage(uint64_t Base) : Slide(Base - 0x100000000) {
+    AddSegment("__TEXT", Base, 0x4000);
+    AddSegment("__DATA", Base + 0x4000, 0x1000);
+
+    struct Entry {
+      uint32_t Strx;
+      uint8_t Type;
+      uint64_t Value;
+    };
+    // _main_alias is at the same address as _main, but comes after it
+    const Entry Entries[] = {
+        {1, N_SECT | N_EXT, 0x100000400}, {7, N_SECT, 0x100000480},
+        {15, N_SECT, 0x100000400},        {27, N_SECT, 0x100004010},
+        {33, N_UNDF | N_EXT, 0},          {41, N_FUN, 0x100000480}};
+    const uint32_t Count = sizeof(Entries) / sizeof(Entries[0]);
+
+    Table.Store.Reset(ByteView(Strings, sizeof(Strings)), Count, Slide);
+    for (uint32_t i = 0; i < Count; ++i) {
+      struct nlist_64 Raw = {};
+      Raw.n_un.n_strx = Entries[i].Strx;
+      Raw.n_type = Entries[i].Type;
+      Raw.n_sect = Entries[i].Type & N_SECT ? 1 : 0;
+      Raw.n_value = Entries[i].Value;
+      Table.Store.Set(i, Raw, false, true);
+    }
+    Table.Index.Build(Table.Store);
+
+    // 0x400 and 0x480 have symbols, 0x600 does not, __text ends at 0x700
+    const uint8_t Starts[] = {0x80, 0x08, 0x80, 0x01, 0x80, 0x03, 0x00};
+    Table.Functions.Decode(
+        ByteView(reinterpret_cast<const char *>(Starts), sizeof(Starts)),
+        Base);
+    Table.Functions.SetLimit(Base + 0x700);
+  }
+
+  // _static between _main and _helper, _main_local at _main
+  void AddLocals() {
+    const uint64_t Values[] = {0x100000440, 0x100000400};
+    const uint32_t Strx[] = {1, 9};
+    Table.Locals.Reset(ByteView(LocalStrings, sizeof(LocalStrings)), 2, Slide);
+    for (uint32_t i = 0; i < 2; ++i) {
+      struct nlist_64 Raw = {};
+      Raw.n_un.n_strx = Strx[i];
+      Raw.n_type = N_SECT;
+      Raw.n_sect = 1;
+      Raw.n_value = Values[i];
+      Table.Locals.Set(i, Raw, false, true);
+    }
+    Table.LocalIndex.Build(Table.Locals);
+  }
+
+  void AddSegment(std::string Name, uint64_t Address, uint64_t Size) {
+    auto Segment = std::make_shared<Segment_t>();
+    Segment->Name = Name;
+    Segment->VirtualAddress = Address;
+    Segment->VirtualSize = Size;
+    Segment->FileSize = Size;
+    Segment->Raw.maxprot = VM_PROT_READ;
+    Segments.push_back(Segment);
+  }
+
+  auto &GetSegments() { return Segments; }
+  auto &GetSymbolTable() { return Table; }
+  uint64_t GetSlide() { return Slide; }
+  DwarfLineTable *GetLineTable() { return nullptr; }
+};
+
+class symbolicator_test : public ::testing::Test {
+protected:
+  ImageAddressMap<FakeImage> Map;
+  Symbolicator<FakeImage> Resolver{Map};
+};
+
+TEST_F(symbolicator_test, ResolvesSymbolsAndFunctions) {
+  auto Image = std::make_shared<FakeImage>(0x100010000);
+  Map.AddImage(Image);
+
+  const uint64_t Addresses[] = {
+      0x100010410, // _main + 0x10
+      0x100010480, // _helper
+      0x100010610, // a function without a symbol
+      0x100014020, // _data + 0x10
+      0x100010100, // before any symbol
+      0x1000,      // in no image
+  };
+  auto Results = Resolver.Symbolicate(Addresses, 6);
+  ASSERT_EQ(Results.size(), 6u);
+
+  EXPECT_EQ(Results[0].Image, Image);
+  ASSERT_TRUE(Results[0].Symbol);
+  EXPECT_EQ(Results[0].Symbol.GetName(), "_main");
+  EXPECT_EQ(Results[0].Offset, 0x10u);
+
+  ASSERT_TRUE(Results[1].Symbol);
+  EXPECT_EQ(Results[1].Symbol.GetName(), "_helper");
+  EXPECT_EQ(Results[1].Start, 0x100010480u);
+  EXPECT_EQ(Results[1].Offset, 0u);
+
+  EXPECT_FALSE(Results[2].Symbol);
+  EXPECT_EQ(Results[2].Start, 0x100010600u);
+  EXPECT_EQ(Results[2].Offset, 0x10u);
+
+  // Symbols of __TEXT say nothing about __DATA
+  ASSERT_TRUE(Results[3].Symbol);
+  EXPECT_EQ(Results[3].Symbol.GetName(), "_data");
+  EXPECT_EQ(Results[3].Offset, 0x10u);
+
+  EXPECT_EQ(Results[4].Image, Image);
+  EXPECT_FALSE(Results[4].Symbol);
+  EXPECT_EQ(Results[4].Start, 0u);
+
+  EXPECT_EQ(Results[5].Address, 0x1000u);
+  EXPECT_FALSE(Results[5].Image);
+  EXPECT_FALSE(Results[5].HasLine);
+}
+
+TEST_F(symbolicator_test, ResolvesLocalSymbols) {
+  auto Image = std::make_shared<FakeImage>(0x100010000);
+  Image->AddLocals();
+  Map.AddImage(Image);
+
+  const uint64_t Addresses[] = {
+      0x100010410, // _main + 0x10, not the local at the same address
+      0x100010450, // _static + 0x10
+      0x100010480, // _helper
+  };
+  auto Results = Resolver.Symbolicate(Addresses, 3);
+  ASSERT_TRUE(Results[0].Symbol);
+  EXPECT_EQ(Results[0].Symbol.GetName(), "_main");
+  ASSERT_TRUE(Results[1].Symbol);
+  EXPECT_EQ(Results[1].Symbol.GetName(), "_static");
+  EXPECT_EQ(Results[1].Start, 0x100010440u);
+  EXPECT_EQ(Results[1].Offset, 0x10u);
+  ASSERT_TRUE(Results[2].Symbol);
+  EXPECT_EQ(Results[2].Symbol.GetName(), "_helper");
+}
+
+TEST_F(symbolicator_test, KeepsTheOrderOfABatch) {
+  std::vector<std::shared_ptr<FakeImage>> Images;
+  for (uint64_t i = 0; i < 8; ++i) {
+    Images.push_back(std::make_shared<FakeImage>(0x100000000 + i * 0x10000));
+    Map.AddImage(Images.back());
+  }
+
+  // Every image, backwards and with duplicates
+  std::vector<uint64_t> Addresses;
+  for (uint64_t Round = 0; Round < 3; ++Round) {
+    for (uint64_t i = 8; i--;) {
+      Addresses.push_back(0x100000000 + i * 0x10000 + 0x400 + Round * 0x10);
+      Addresses.push_back(0x100000000 + i * 0x10000 + 0x480);
+    }
+  }
+
+  auto Results = Resolver.Symbolicate(Addresses.data(), Addresses.size());
+  ASSERT_EQ(Results.size(), Addresses.size());
+  for (size_t i = 0; i < Results.size(); ++i) {
+    auto &Result = Results[i];
+    uint64_t Image = (Addresses[i] - 0x100000000) / 0x10000;
+    EXPECT_EQ(Result.Address, Addresses[i]);
+    EXPECT_EQ(Result.Image, Images[Image]);
+    ASSERT_TRUE(Result.Symbol);
+    EXPECT_EQ(Result.Symbol.GetName(), i % 2 ? "_helper" : "_main");
+    EXPECT_EQ(Result.Start + Result.Offset, Addresses[i]);
+  }
+}
+
+TEST_F(symbolicator_test, IndexesDefinedSymbolsOnly) {
+  FakeImage Image(0x100000000);
+  auto &Index = Image.Table.Index;
+  auto &Store = Image.Table.Store;
+  // Neither the alias, the undefined symbol nor the STAB
+  ASSERT_EQ(Index.GetSize(), 3u);
+  EXPECT_EQ(Store.GetName(Index[0]), "_main");
+  EXPECT_EQ(Store.GetName(Index[1]), "_helper");
+  EXPECT_EQ(Store.GetName(Index[2]), "_data");
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,129 @@
+// Std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// MAD
+#include "MAD/ThreadPool.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+#define CHUNK_SIZE 16u
+
+// Counts the visits of every index ParallelFor hands out
+class Visits {
+  std::unique_ptr<std::atomic<uint32_t>[]> Counts;
+  uint64_t Count;
+  std::atomic<uint32_t> BadChunks{0};
+
+public:
+  Visits(uint64_t Count)
+      : Counts(new std::atomic<uint32_t>[Count + 1]()), Count(Count) {}
+
+  void operator()(uint64_t Begin, uint64_t End) {
+    if (Begin >= End || End > Count) {
+      ++BadChunks;
+      return;
+    }
+    for (auto i = Begin; i < End; ++i) {
+      ++Counts[i];
+    }
+  }
+
+  void ExpectEachOnce() const {
+    EXPECT_EQ(BadChunks, 0u) << Count;
+    for (uint64_t i = 0; i < Count; ++i) {
+      ASSERT_EQ(Counts[i], 1u) << i << " of " << Count;
+    }
+  }
+};
+
+// Below a chunk and at it the body runs once on the calling thread, above it
+// the chunks are spread over the pool. Sizes around every chunk boundary leave
+// a short last chunk, or none.
+static const uint64_t Counts[] = {0,
+                                  1,
+                                  CHUNK_SIZE - 1,
+                                  CHUNK_SIZE,
+                                  CHUNK_SIZE + 1,
+                                  2 * CHUNK_SIZE,
+                                  2 * CHUNK_SIZE + 1,
+                                  100 * CHUNK_SIZE - 1,
+                                  100 * CHUNK_SIZE,
+                                  100 * CHUNK_SIZE + 1};
+
+TEST(thread_pool, VisitsEveryIndexOnce) {
+  for (unsigned Workers : {0u, 1u, 4u}) {
+    ThreadPool Pool(Workers);
+    for (auto Count : Counts) {
+      Visits V(Count);
+      Pool.ParallelFor(Count, CHUNK_SIZE,
+                       [&](uint64_t Begin, uint64_t End) { V(Begin, End); });
+      V.ExpectEachOnce();
+    }
+  }
+}
+
+TEST(thread_pool, RunsSingleChunkOnCaller) {
+  ThreadPool Pool(4);
+  auto Caller = std::this_thread::get_id();
+  uint32_t Calls = 0;
+  Pool.ParallelFor(CHUNK_SIZE, CHUNK_SIZE, [&](uint64_t Begin, uint64_t End) {
+    EXPECT_EQ(std::this_thread::get_id(), Caller);
+    EXPECT_EQ(Begin, 0u);
+    EXPECT_EQ(End, CHUNK_SIZE);
+    ++Calls;
+  });
+  EXPECT_EQ(Calls, 1u);
+}
+
+// A zero chunk size is taken as one
+TEST(thread_pool, VisitsEveryIndexWithZeroChunks) {
+  ThreadPool Pool(2);
+  Visits V(100);
+  Pool.ParallelFor(100, 0,
+                   [&](uint64_t Begin, uint64_t End) { V(Begin, End); });
+  V.ExpectEachOnce();
+}
+
+// Every worker is busy with an outer chunk when the inner calls come, which
+// must not wait for a worker to free up
+TEST(thread_pool, NestsInPoolTasks) {
+  ThreadPool Pool(2);
+  const uint64_t Outer = 8, Inner = 10 * CHUNK_SIZE + 3;
+  std::vector<std::unique_ptr<Visits>> Inners;
+  for (uint64_t i = 0; i < Outer; ++i) {
+    Inners.push_back(std::make_unique<Visits>(Inner));
+  }
+  Pool.ParallelFor(Outer, 1, [&](uint64_t Begin, uint64_t End) {
+    for (auto i = Begin; i < End; ++i) {
+      auto &V = *Inners[i];
+      Pool.ParallelFor(Inner, CHUNK_SIZE,
+                       [&](uint64_t B, uint64_t E) { V(B, E); });
+    }
+  });
+  for (auto &V : Inners) {
+    V->ExpectEachOnce();
+  }
+}
+
+TEST(thread_pool, RunsEnqueuedTasks) {
+  std::atomic<uint32_t> Runs{0};
+  {
+    ThreadPool Pool(2);
+    for (int i = 0; i < 100; ++i) {
+      Pool.Enqueue([&] { ++Runs; });
+    }
+  }
+  // The destructor drains the queue before it joins the workers
+  EXPECT_EQ(Runs, 100u);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,201 @@
+// System
+#include <mach-o/fat.h>
+#include <mach-o/loader.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Std
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// MAD
+#include "MAD/UniversalBinary.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+struct Arch {
+  cpu_type_t CpuType;
+  cpu_subtype_t CpuSubType;
+};
+
+static const Arch Archs[] = {
+    {CPU_TYPE_X86_64, CPU_SUBTYPE_X86_64_ALL},
+    {CPU_TYPE_X86_64, CPU_SUBTYPE_X86_64_H},
+    {CPU_TYPE_ARM64, CPU_SUBTYPE_ARM64_ALL},
+    // Capability bits are set on arm64e binaries
+    {CPU_TYPE_ARM64, int(CPU_SUBTYPE_ARM64E | 0x80000000)},
+};
+
+#define SLICE_SIZE 0x100u
+#define SLICE_ALIGN 12u
+
+static uint32_t BE32(uint32_t Value) { return __builtin_bswap32(Value); }
+static uint64_t BE64(uint64_t Value) { return __builtin_bswap64(Value); }
+
+template <typename S>
+static void Put(std::vector<char> &Bytes, uint64_t Offset, const S &Thing) {
+  if (Bytes.size() < Offset + sizeof(S)) {
+    Bytes.resize(Offset + sizeof(S));
+  }
+  memcpy(Bytes.data() + Offset, &Thing, sizeof(S));
+}
+
+// Every slice is a mach header with just LC_UUID, the UUID tells which slice
+// was picked
+static std::vector<char> MakeFat(bool Is64) {
+  std::vector<char> Bytes;
+  unsigned Count = sizeof(Archs) / sizeof(Archs[0]);
+
+  fat_header Header;
+  Header.magic = BE32(Is64 ? FAT_MAGIC_64 : FAT_MAGIC);
+  Header.nfat_arch = BE32(Count);
+  Put(Bytes, 0, Header);
+
+  for (unsigned i = 0; i < Count; ++i) {
+    uint64_t Offset = uint64_t(i + 1) << SLICE_ALIGN;
+    if (Is64) {
+      fat_arch_64 Entry = {};
+      Entry.cputype = BE32(Archs[i].CpuType);
+      Entry.cpusubtype = BE32(Archs[i].CpuSubType);
+      Entry.offset = BE64(Offset);
+      Entry.size = BE64(SLICE_SIZE);
+      Entry.align = BE32(SLICE_ALIGN);
+      Put(Bytes, sizeof(Header) + i * sizeof(Entry), Entry);
+    } else {
+      fat_arch Entry = {};
+      Entry.cputype = BE32(Archs[i].CpuType);
+      Entry.cpusubtype = BE32(Archs[i].CpuSubType);
+      Entry.offset = BE32(Offset);
+      Entry.size = BE32(SLICE_SIZE);
+      Entry.align = BE32(SLICE_ALIGN);
+      Put(Bytes, sizeof(Header) + i * sizeof(Entry), Entry);
+    }
+
+    mach_header_64 Mach = {};
+    Mach.magic = MH_MAGIC_64;
+    Mach.cputype = Archs[i].CpuType;
+    Mach.cpusubtype = Archs[i].CpuSubType;
+    Mach.filetype = MH_EXECUTE;
+    Mach.ncmds = 1;
+    Mach.sizeofcmds = sizeof(uuid_command);
+    Put(Bytes, Offset, Mach);
+
+    uuid_command UUID = {};
+    UUID.cmd = LC_UUID;
+    UUID.cmdsize = sizeof(UUID);
+    memset(UUID.uuid, i + 1, sizeof(UUID.uuid));
+    Put(Bytes, Offset + sizeof(Mach), UUID);
+  }
+
+  Bytes.resize((Count + 1) << SLICE_ALIGN);
+  return Bytes;
+}
+
+class universal_binary_test : public ::testing::Test {
+protected:
+  std::string Path;
+
+  void SetUp() override {
+    char Template[] = "/tmp/mad_universal_binary_XXXXXX";
+    int FD = mkstemp(Template);
+    ASSERT_GE(FD, 0);
+    close(FD);
+    Path = Template;
+  }
+
+  void TearDown() override { unlink(Path.c_str()); }
+
+  void Write(const std::vector<char> &Bytes) {
+    std::ofstream(Path, std::ios::binary).write(Bytes.data(), Bytes.size());
+  }
+};
+
+TEST_F(universal_binary_test, ReadsBigEndianTable) {
+  Write(MakeFat(false));
+  UniversalBinary Binary(Path);
+  ASSERT_TRUE(Binary.Parse());
+
+  auto &Slices = Binary.GetSlices();
+  ASSERT_EQ(Slices.size(), 4u);
+  EXPECT_EQ(Slices[0].CpuType, CPU_TYPE_X86_64);
+  EXPECT_EQ(Slices[1].CpuSubType, CPU_SUBTYPE_X86_64_H);
+  EXPECT_EQ(Slices[2].Offset, 3u << SLICE_ALIGN);
+  EXPECT_EQ(Slices[2].Size, SLICE_SIZE);
+  EXPECT_EQ(Slices[3].CpuSubType, CPU_SUBTYPE_ARM64E);
+  EXPECT_EQ(Slices[3].Align, SLICE_ALIGN);
+}
+
+TEST_F(universal_binary_test, ReadsFat64Table) {
+  Write(MakeFat(true));
+  UniversalBinary Binary(Path);
+  ASSERT_TRUE(Binary.Parse());
+  ASSERT_EQ(Binary.GetSlices().size(), 4u);
+  EXPECT_EQ(Binary.GetSlices()[3].Offset, 4u << SLICE_ALIGN);
+}
+
+TEST_F(universal_binary_test, PicksMatchingSlice) {
+  Write(MakeFat(false));
+  UniversalBinary Binary(Path);
+  ASSERT_TRUE(Binary.Parse());
+
+  auto Object = Binary.GetObjectFile(CPU_TYPE_X86_64, CPU_SUBTYPE_X86_64_H);
+  ASSERT_TRUE(Object);
+  EXPECT_EQ(Object->GetUUID()[0], 2);
+  EXPECT_EQ(Object->GetHeader().cputype, CPU_TYPE_X86_64);
+  // Parsed once
+  EXPECT_EQ(Binary.GetObjectFile(CPU_TYPE_X86_64, CPU_SUBTYPE_X86_64_H),
+            Object);
+
+  Object = Binary.GetObjectFile(CPU_TYPE_ARM64, CPU_SUBTYPE_ARM64E);
+  ASSERT_TRUE(Object);
+  EXPECT_EQ(Object->GetUUID()[0], 4);
+
+  EXPECT_FALSE(Binary.GetObjectFile(CPU_TYPE_ARM, CPU_SUBTYPE_ARM_ALL));
+}
+
+TEST_F(universal_binary_test, FallsBackToAllSubType) {
+  Write(MakeFat(false));
+  UniversalBinary Binary(Path);
+  ASSERT_TRUE(Binary.Parse());
+
+  // E.g. an arm64 slice runs on an arm64e machine without its own slice
+  auto Slice = Binary.FindSlice(CPU_TYPE_ARM64, 5);
+  ASSERT_TRUE(Slice);
+  EXPECT_EQ(Slice->CpuSubType, CPU_SUBTYPE_ARM64_ALL);
+
+  Slice = Binary.FindSlice(CPU_TYPE_X86_64);
+  ASSERT_TRUE(Slice);
+  EXPECT_EQ(Slice->CpuSubType, CPU_SUBTYPE_X86_64_ALL);
+}
+
+TEST_F(universal_binary_test, RejectsMalformedTables) {
+  auto Bytes = MakeFat(false);
+
+  // More archs than the file holds
+  auto Huge = Bytes;
+  fat_header Header;
+  memcpy(&Header, Huge.data(), sizeof(Header));
+  Header.nfat_arch = BE32(0x10000000);
+  Put(Huge, 0, Header);
+  Write(Huge);
+  EXPECT_FALSE(UniversalBinary(Path).Parse());
+
+  // A slice past the end of the file
+  auto Past = Bytes;
+  Past.resize(3u << SLICE_ALIGN);
+  Write(Past);
+  EXPECT_FALSE(UniversalBinary(Path).Parse());
+
+  // A thin binary
+  Write(std::vector<char>(Bytes.begin() + (1u << SLICE_ALIGN), Bytes.end()));
+  EXPECT_FALSE(UniversalBinary(Path).Parse());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,294 @@
+// Std
+#include <cstring>
+#include <map>
+#include <vector>
+
+// MAD
+#include "MAD/CompactUnwind.hpp"
+#include "MAD/EhFrame.hpp"
+
+#include "gtest/gtest.h"
+
+using namespace mad;
+
+// Sections are put together by hand, the way ld64 lays them out
+class unwind_test : public ::testing::Test {
+protected:
+  std::vector<char> Bytes;
+  std::map<uint64_t, uint64_t> Stack;
+
+  template <typename T> void Put(T Value) {
+    auto At = Bytes.size();
+    Bytes.resize(At + sizeof(T));
+    memcpy(&Bytes[At], &Value, sizeof(T));
+  }
+  template <typename T> void PutAt(size_t At, T Value) {
+    memcpy(&Bytes[At], &Value, sizeof(T));
+  }
+  void PutBytes(std::initializer_list<uint8_t> Values) {
+    for (auto Value : Values) {
+      Put<uint8_t>(Value);
+    }
+  }
+
+  ByteView GetView() { return ByteView(Bytes.data(), Bytes.size()); }
+
+  bool ReadWord(uint64_t Address, uint64_t &Value) {
+    auto It = Stack.find(Address);
+    if (It == Stack.end()) {
+      return false;
+    }
+    Value = It->second;
+    return true;
+  }
+
+  bool Step(const UnwindRow &Row, const UnwindRegisters &Callee,
+            UnwindRegisters &Caller) {
+    return Row.Step(Callee, Caller, [this](uint64_t A, uint64_t &V) {
+      return ReadWord(A, V);
+    });
+  }
+};
+
+static const uint64_t Base = 0x100000000;
+
+// rbp frame, rbx and r12 saved 16 bytes below rbp
+static const uint32_t RBPFrame = UNWIND_X86_64_MODE_RBP_FRAME | (2 << 16) |
+                                 UNWIND_X86_64_REG_RBX |
+                                 (UNWIND_X86_64_REG_R12 << 3);
+// 32 bytes of frame with r12 and rbx pushed in that order, permutation 1 * 5
+static const uint32_t Frameless =
+    UNWIND_X86_64_MODE_STACK_IMMD | (4 << 16) | (2 << 10) | 5;
+static const uint32_t Dwarf = UNWIND_X86_64_MODE_DWARF | 0x10;
+
+TEST_F(unwind_test, LooksUpCompactUnwind) {
+  // Header with two common encodings and three index entries
+  Put<uint32_t>(UNWIND_SECTION_VERSION);
+  Put<uint32_t>(28);
+  Put<uint32_t>(2);
+  Put<uint32_t>(36);
+  Put<uint32_t>(0);
+  Put<uint32_t>(36);
+  Put<uint32_t>(3);
+  Put<uint32_t>(RBPFrame);
+  Put<uint32_t>(Frameless);
+
+  Put<uint32_t>(0x1000);
+  Put<uint32_t>(72);
+  Put<uint32_t>(0);
+  Put<uint32_t>(0x2000);
+  Put<uint32_t>(96);
+  Put<uint32_t>(0);
+  // The sentinel ends the last function
+  Put<uint32_t>(0x3000);
+  Put<uint32_t>(0);
+  Put<uint32_t>(0);
+
+  // Regular page
+  ASSERT_EQ(Bytes.size(), 72u);
+  Put<uint32_t>(UNWIND_SECOND_LEVEL_REGULAR);
+  Put<uint16_t>(8);
+  Put<uint16_t>(2);
+  Put<uint32_t>(0x1000);
+  Put<uint32_t>(RBPFrame);
+  Put<uint32_t>(0x1800);
+  Put<uint32_t>(0);
+
+  // Compressed page, the last entry uses the page's own encoding
+  ASSERT_EQ(Bytes.size(), 96u);
+  Put<uint32_t>(UNWIND_SECOND_LEVEL_COMPRESSED);
+  Put<uint16_t>(12);
+  Put<uint16_t>(3);
+  Put<uint16_t>(24);
+  Put<uint16_t>(1);
+  Put<uint32_t>(0x000 | (0 << 24));
+  Put<uint32_t>(0x100 | (1 << 24));
+  Put<uint32_t>(0x400 | (2 << 24));
+  Put<uint32_t>(Dwarf);
+
+  CompactUnwind Unwind(GetView(), Base);
+  ASSERT_FALSE(Unwind.IsEmpty());
+
+  CompactUnwind::Entry E;
+  ASSERT_TRUE(Unwind.Lookup(Base + 0x1010, E));
+  EXPECT_EQ(E.Start, Base + 0x1000);
+  EXPECT_EQ(E.End, Base + 0x1800);
+  EXPECT_EQ(E.Encoding, RBPFrame);
+
+  ASSERT_TRUE(Unwind.Lookup(Base + 0x1900, E));
+  EXPECT_EQ(E.Start, Base + 0x1800);
+  EXPECT_EQ(E.End, Base + 0x2000);
+  EXPECT_EQ(E.Encoding, 0u);
+
+  ASSERT_TRUE(Unwind.Lookup(Base + 0x2000, E));
+  EXPECT_EQ(E.End, Base + 0x2100);
+  EXPECT_EQ(E.Encoding, RBPFrame);
+
+  ASSERT_TRUE(Unwind.Lookup(Base + 0x23ff, E));
+  EXPECT_EQ(E.Start, Base + 0x2100);
+  EXPECT_EQ(E.End, Base + 0x2400);
+  EXPECT_EQ(E.Encoding, Frameless);
+
+  ASSERT_TRUE(Unwind.Lookup(Base + 0x2fff, E));
+  EXPECT_EQ(E.Start, Base + 0x2400);
+  EXPECT_EQ(E.End, Base + 0x3000);
+  EXPECT_TRUE(CompactUnwind::IsDwarf(E.Encoding));
+  EXPECT_EQ(CompactUnwind::GetDwarfOffset(E.Encoding), 0x10u);
+
+  EXPECT_FALSE(Unwind.Lookup(Base + 0xfff, E));
+  EXPECT_FALSE(Unwind.Lookup(Base + 0x3000, E));
+
+  // Not a valid section at all
+  Bytes.resize(20);
+  EXPECT_TRUE(CompactUnwind(GetView(), Base).IsEmpty());
+}
+
+TEST_F(unwind_test, UnwindsRBPFrames) {
+  UnwindPlan Plan;
+  ASSERT_TRUE(
+      CompactUnwind::GetPlan({Base + 0x1000, Base + 0x1100, RBPFrame}, Plan));
+  ASSERT_EQ(Plan.Rows.size(), 3u);
+
+  // Stopped on the first instruction, nothing is pushed yet
+  UnwindRegisters Callee, Caller;
+  Callee.Set(REG_X86_64_RIP, Base + 0x1000);
+  Callee.Set(REG_X86_64_RSP, 0x6000);
+  Callee.Set(REG_X86_64_RBP, 0x7100);
+  Callee.Set(REG_X86_64_RAX, 1);
+  Stack[0x6000] = Base + 0x5555;
+  ASSERT_TRUE(Step(Plan.GetRow(Base + 0x1000), Callee, Caller));
+  EXPECT_EQ(Caller.Get(REG_X86_64_RIP), Base + 0x5555);
+  EXPECT_EQ(Caller.Get(REG_X86_64_RSP), 0x6008u);
+  EXPECT_EQ(Caller.Get(REG_X86_64_RBP), 0x7100u);
+  EXPECT_FALSE(Caller.Has(REG_X86_64_RAX));
+
+  // In the body, the frame is set up and the registers are saved
+  Stack.clear();
+  Callee.Set(REG_X86_64_RIP, Base + 0x1040);
+  Callee.Set(REG_X86_64_RSP, 0x6f00);
+  Callee.Set(REG_X86_64_RBP, 0x7000);
+  Callee.Set(REG_X86_64_R13, 0xd);
+  Stack[0x7008] = Base + 0x5555;
+  Stack[0x7000] = 0x7100;
+  Stack[0x6ff0] = 0xb;
+  Stack[0x6ff8] = 0xc;
+  ASSERT_TRUE(Step(Plan.GetRow(Base + 0x1040), Callee, Caller));
+  EXPECT_EQ(Caller.Get(REG_X86_64_RIP), Base + 0x5555);
+  EXPECT_EQ(Caller.Get(REG_X86_64_RSP), 0x7010u);
+  EXPECT_EQ(Caller.Get(REG_X86_64_RBP), 0x7100u);
+  EXPECT_EQ(Caller.Get(REG_X86_64_RBX), 0xbu);
+  EXPECT_EQ(Caller.Get(REG_X86_64_R12), 0xcu);
+  EXPECT_EQ(Caller.Get(REG_X86_64_R13), 0xdu);
+
+  // Nothing to read, nothing to unwind
+  Stack.clear();
+  EXPECT_FALSE(Step(Plan.GetRow(Base + 0x1040), Callee, Caller));
+}
+
+TEST_F(unwind_test, UnwindsFramelessFunctions) {
+  UnwindPlan Plan;
+  ASSERT_TRUE(
+      CompactUnwind::GetPlan({Base + 0x2100, Base + 0x2400, Frameless}, Plan));
+  ASSERT_EQ(Plan.Rows.size(), 2u);
+  auto &Body = Plan.GetRow(Base + 0x2180);
+  EXPECT_EQ(Body.CFARegister, REG_X86_64_RSP);
+  EXPECT_EQ(Body.CFAOffset, 32);
+  EXPECT_EQ(Body.Rules[REG_X86_64_R12].Type, UnwindRuleType::AT_CFA);
+  EXPECT_EQ(Body.Rules[REG_X86_64_R12].Value, -24);
+  EXPECT_EQ(Body.Rules[REG_X86_64_RBX].Value, -16);
+  EXPECT_EQ(Body.Rules[REG_X86_64_RBP].Type, UnwindRuleType::SAME);
+
+  // The stack size is in the sub instruction 0x1d bytes into the function
+  uint32_t Indirect = UNWIND_X86_64_MODE_STACK_IND | (0x1d << 16) | (1 << 13);
+  CompactUnwind::Entry E = {Base + 0x2100, Base + 0x2400, Indirect};
+  uint64_t SizeAddress;
+  ASSERT_TRUE(CompactUnwind::IsIndirect(E, SizeAddress));
+  EXPECT_EQ(SizeAddress, Base + 0x211d);
+  ASSERT_TRUE(CompactUnwind::GetPlan(E, Plan, 0x1000));
+  EXPECT_EQ(Plan.Rows.back().CFAOffset, 0x1008);
+
+  // DWARF is for EhFrame
+  EXPECT_FALSE(CompactUnwind::GetPlan({Base, Base + 1, Dwarf}, Plan));
+}
+
+TEST_F(unwind_test, RunsCallFrameInstructions) {
+  const uint64_t Section = Base + 0x4000;
+
+  // CIE, pc-relative pointers, the return address right below the CFA
+  Put<uint32_t>(0);
+  Put<uint32_t>(0);
+  PutBytes({1, 'z', 'R', 0, 1, 0x78, 16, 1, DW_EH_PE_pcrel});
+  PutBytes({DW_CFA_def_cfa, REG_X86_64_RSP, 8});
+  PutBytes({DW_CFA_offset | REG_X86_64_RIP, 1});
+  PutBytes({DW_CFA_nop, DW_CFA_nop, DW_CFA_nop});
+  PutAt<uint32_t>(0, Bytes.size() - 4);
+
+  // FDE of a function with a standard prologue and an early return
+  size_t First = Bytes.size();
+  Put<uint32_t>(0);
+  Put<uint32_t>(Bytes.size());
+  Put<uint64_t>(Base + 0x1000 - (Section + Bytes.size()));
+  Put<uint64_t>(0x40);
+  PutBytes({0});
+  PutBytes({DW_CFA_advance_loc | 1, DW_CFA_def_cfa_offset, 16});
+  PutBytes({DW_CFA_offset | REG_X86_64_RBP, 2});
+  PutBytes({DW_CFA_advance_loc | 3, DW_CFA_def_cfa_register, REG_X86_64_RBP});
+  PutBytes({DW_CFA_advance_loc | 0x20, DW_CFA_remember_state});
+  PutBytes({DW_CFA_def_cfa, REG_X86_64_RSP, 8});
+  PutBytes({DW_CFA_advance_loc | 1, DW_CFA_restore_state});
+  PutAt<uint32_t>(First, Bytes.size() - First - 4);
+
+  // A function further down, with the rows of the CIE only
+  size_t Second = Bytes.size();
+  Put<uint32_t>(0);
+  Put<uint32_t>(Bytes.size());
+  Put<uint64_t>(Base + 0x800 - (Section + Bytes.size()));
+  Put<uint64_t>(0x10);
+  PutBytes({0, DW_CFA_nop, DW_CFA_nop, DW_CFA_nop});
+  PutAt<uint32_t>(Second, Bytes.size() - Second - 4);
+  Put<uint32_t>(0);
+
+  EhFrame Frames(GetView(), Section);
+  UnwindPlan Plan;
+  ASSERT_TRUE(Frames.GetPlan(Base + 0x1002, Plan));
+  EXPECT_EQ(Plan.Start, Base + 0x1000);
+  EXPECT_EQ(Plan.End, Base + 0x1040);
+  ASSERT_EQ(Plan.Rows.size(), 5u);
+
+  auto &Entry = Plan.GetRow(Base + 0x1000);
+  EXPECT_EQ(Entry.CFARegister, REG_X86_64_RSP);
+  EXPECT_EQ(Entry.CFAOffset, 8);
+  EXPECT_EQ(Entry.Rules[REG_X86_64_RIP].Value, -8);
+
+  auto &Pushed = Plan.GetRow(Base + 0x1002);
+  EXPECT_EQ(Pushed.CFAOffset, 16);
+  EXPECT_EQ(Pushed.Rules[REG_X86_64_RBP].Type, UnwindRuleType::AT_CFA);
+  EXPECT_EQ(Pushed.Rules[REG_X86_64_RBP].Value, -16);
+
+  EXPECT_EQ(Plan.GetRow(Base + 0x1010).CFARegister, REG_X86_64_RBP);
+  EXPECT_EQ(Plan.GetRow(Base + 0x1024).CFARegister, REG_X86_64_RSP);
+  // Back to the remembered frame after the return
+  auto &Restored = Plan.GetRow(Base + 0x1030);
+  EXPECT_EQ(Restored.CFARegister, REG_X86_64_RBP);
+  EXPECT_EQ(Restored.CFAOffset, 16);
+  EXPECT_EQ(Restored.Offset, 0x25u);
+
+  // Compact unwind points to the FDE itself
+  UnwindPlan Other;
+  ASSERT_TRUE(Frames.GetPlanAt(First, Other));
+  EXPECT_EQ(Other.Rows.size(), Plan.Rows.size());
+
+  ASSERT_TRUE(Frames.GetPlan(Base + 0x80f, Plan));
+  EXPECT_EQ(Plan.Start, Base + 0x800);
+  EXPECT_EQ(Plan.Rows.size(), 1u);
+
+  EXPECT_FALSE(Frames.GetPlan(Base + 0x1040, Plan));
+  EXPECT_FALSE(Frames.GetPlan(Base + 0x7ff, Plan));
+  // A CIE is not an FDE
+  EXPECT_FALSE(Frames.GetPlanAt(0, Plan));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}